@@ -6,14 +6,16 @@ endif()
 function(compile_shader)
     set(options)
     set(oneValueArgs SHADER SPIRV)
-    set(multiValueArgs)
+    set(multiValueArgs DEFINES)
     cmake_parse_arguments(
         GLSLC_SHADER "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN}
     )
 
+    list(TRANSFORM GLSLC_SHADER_DEFINES PREPEND -D)
+
     add_custom_command(
         OUTPUT ${GLSLC_SHADER_SPIRV}
-        COMMAND ${GLSLC_EXE} ${GLSLC_SHADER_SHADER} -o ${GLSLC_SHADER_SPIRV}
+        COMMAND ${GLSLC_EXE} ${GLSLC_SHADER_DEFINES} ${GLSLC_SHADER_SHADER} -o ${GLSLC_SHADER_SPIRV}
         DEPENDS ${GLSLC_SHADER_SHADER}
     )
 endfunction()
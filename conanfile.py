@@ -8,6 +8,9 @@ class SoilConan(ConanFile):
     settings = "os", "compiler", "build_type", "arch"
     version = "0.1"
 
+    options = {"bullet_multithreaded": [True, False]}
+    default_options = {"bullet_multithreaded": False}
+
     exports_sources = "cmake", "src", "CMakeLists.txt", "LICENSE"
 
     def requirements(self):
@@ -18,7 +21,6 @@ class SoilConan(ConanFile):
         self.requires("freetype/2.13.2")
         self.requires("glm/cci.20230113")
         self.requires("imgui/1.90.8-docking")
-        self.requires("perlinnoise/3.0.0")
         self.requires("sdl/2.30.4")
         self.requires("spdlog/1.14.1")
         self.requires("stb/cci.20240213")
@@ -27,6 +29,10 @@ class SoilConan(ConanFile):
         self.requires("vulkan-loader/1.3.268.0")
         self.requires("vulkan-memory-allocator/3.1.0")
 
+    def configure(self):
+        if self.options.bullet_multithreaded:
+            self.options["bullet3"].bt2_thread_locks = True
+
     def build_requirements(self):
         self.tool_requires("cmake/[^3.27]")
         self.test_requires("catch2/[^3.6.0]")
@@ -37,6 +43,8 @@ class SoilConan(ConanFile):
     def generate(self):
         tc = CMakeToolchain(self)
         tc.user_presets_path = "ConanPresets.json"
+        tc.cache_variables["SOIL_BULLET_MULTITHREADED"] = bool(
+            self.options.bullet_multithreaded)
         tc.generate()
 
         cmake = CMakeDeps(self)
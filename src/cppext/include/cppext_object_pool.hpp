@@ -0,0 +1,142 @@
+#ifndef CPPEXT_OBJECT_POOL_INCLUDED
+#define CPPEXT_OBJECT_POOL_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace cppext
+{
+    // Allocates objects of a single type from blocks of BlockSize slots.
+    // Destroyed slots are reused before a new block is allocated and blocks
+    // are only released with the pool. Not thread safe.
+    template<typename T, size_t BlockSize = 256>
+    class [[nodiscard]] object_pool final
+    {
+        static_assert(BlockSize > 0);
+
+    public:
+        object_pool() = default;
+
+        object_pool(object_pool const&) = delete;
+
+        object_pool(object_pool&&) noexcept = delete;
+
+    public:
+        // Objects have to be destroyed before the pool
+        ~object_pool();
+
+    public:
+        template<typename... Args>
+        [[nodiscard]] T* create(Args&&... args);
+
+        void destroy(T* object);
+
+        // Live objects
+        [[nodiscard]] size_t size() const;
+
+        // Slots in allocated blocks
+        [[nodiscard]] size_t capacity() const;
+
+    public:
+        object_pool& operator=(object_pool const&) = delete;
+
+        object_pool& operator=(object_pool&&) noexcept = delete;
+
+    private:
+        union [[nodiscard]] slot
+        {
+            slot* next;
+            alignas(T) std::byte storage[sizeof(T)]; // NOLINT
+        };
+
+    private:
+        void grow();
+
+    private:
+        std::vector<std::unique_ptr<slot[]>> blocks_; // NOLINT
+        slot* free_{};
+        size_t size_{};
+    };
+
+    template<typename T, size_t BlockSize>
+    object_pool<T, BlockSize>::~object_pool()
+    {
+        assert(size_ == 0);
+    }
+
+    template<typename T, size_t BlockSize>
+    template<typename... Args>
+    T* object_pool<T, BlockSize>::create(Args&&... args)
+    {
+        if (!free_)
+        {
+            grow();
+        }
+
+        slot* const s{free_};
+        free_ = s->next;
+
+        try
+        {
+            T* const rv{::new (static_cast<void*>(s->storage))
+                    T(std::forward<Args>(args)...)};
+            ++size_;
+            return rv;
+        }
+        catch (...)
+        {
+            s->next = free_;
+            free_ = s;
+            throw;
+        }
+    }
+
+    template<typename T, size_t BlockSize>
+    void object_pool<T, BlockSize>::destroy(T* const object)
+    {
+        if (!object)
+        {
+            return;
+        }
+
+        assert(size_ > 0);
+        std::destroy_at(object);
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        auto* const s{reinterpret_cast<slot*>(object)};
+        s->next = free_;
+        free_ = s;
+        --size_;
+    }
+
+    template<typename T, size_t BlockSize>
+    size_t object_pool<T, BlockSize>::size() const
+    {
+        return size_;
+    }
+
+    template<typename T, size_t BlockSize>
+    size_t object_pool<T, BlockSize>::capacity() const
+    {
+        return blocks_.size() * BlockSize;
+    }
+
+    template<typename T, size_t BlockSize>
+    void object_pool<T, BlockSize>::grow()
+    {
+        auto& block{blocks_.emplace_back(std::make_unique<slot[]>(BlockSize))};
+
+        // Lowest addresses are handed out first
+        for (size_t i{BlockSize}; i != 0; --i)
+        {
+            block[i - 1].next = free_;
+            free_ = &block[i - 1];
+        }
+    }
+} // namespace cppext
+
+#endif
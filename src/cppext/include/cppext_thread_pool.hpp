@@ -0,0 +1,461 @@
+#ifndef CPPEXT_THREAD_POOL_INCLUDED
+#define CPPEXT_THREAD_POOL_INCLUDED
+
+#include <cppext_work_stealing_deque.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cppext
+{
+    class task_group;
+
+    // Fixed number of workers, each with its own deque of tasks. Tasks
+    // submitted from a worker go to its deque, others go to a shared queue.
+    // Idle workers steal from the other deques before going to sleep.
+    class [[nodiscard]] thread_pool final
+    {
+    public:
+        explicit thread_pool(
+            size_t threads = std::max(1u, std::thread::hardware_concurrency()));
+
+        thread_pool(thread_pool const&) = delete;
+
+        thread_pool(thread_pool&&) noexcept = delete;
+
+    public:
+        // Tasks which didn't start are discarded, wait for task groups first
+        ~thread_pool();
+
+    public:
+        [[nodiscard]] size_t thread_count() const;
+
+        // Index of the worker executing the calling thread
+        [[nodiscard]] std::optional<size_t> current_worker() const;
+
+    public:
+        thread_pool& operator=(thread_pool const&) = delete;
+
+        thread_pool& operator=(thread_pool&&) noexcept = delete;
+
+    private:
+        struct [[nodiscard]] task final
+        {
+            std::move_only_function<void()> function;
+            task_group* group;
+        };
+
+        struct [[nodiscard]] worker_context final
+        {
+            thread_pool const* pool{};
+            size_t index{};
+        };
+
+    private:
+        void submit(task* item);
+
+        // Runs a single queued task on the calling worker
+        bool run_one(size_t worker);
+
+        [[nodiscard]] task* find_task(size_t worker);
+
+        void execute(task* item);
+
+        void work(size_t worker);
+
+    private:
+        static thread_local worker_context current_;
+
+        std::vector<std::unique_ptr<work_stealing_deque<task*>>> deques_;
+
+        std::mutex shared_mutex_;
+        std::deque<task*> shared_;
+
+        // Tasks in all queues, idle workers sleep while it is zero
+        std::atomic<size_t> queued_{};
+        std::atomic<size_t> sleepers_{};
+        std::mutex sleep_mutex_;
+        std::condition_variable sleep_condition_;
+        bool stopping_{};
+
+        std::vector<std::jthread> workers_;
+
+        friend class task_group;
+    };
+
+    // Tracks tasks run on a pool. A worker waiting for a group executes other
+    // tasks in the meantime, any other thread blocks.
+    class [[nodiscard]] task_group final
+    {
+    public:
+        explicit task_group(thread_pool& pool);
+
+        task_group(task_group const&) = delete;
+
+        task_group(task_group&&) noexcept = delete;
+
+    public:
+        // Waits for outstanding tasks, their exceptions are discarded
+        ~task_group();
+
+    public:
+        template<typename Function>
+        void run(Function&& function);
+
+        // Runs function as a task of next once all tasks of this group have
+        // finished, immediately if there are none. Waiting for next includes
+        // the continuation.
+        template<typename Function>
+        void then(task_group& next, Function&& function);
+
+        // Rethrows the first exception thrown by a task since the last wait
+        void wait();
+
+    public:
+        task_group& operator=(task_group const&) = delete;
+
+        task_group& operator=(task_group&&) noexcept = delete;
+
+    private:
+        void complete();
+
+        void fail(std::exception_ptr exception);
+
+        void wait_for_tasks();
+
+    private:
+        thread_pool* pool_;
+
+        // Modified only while holding mutex_, read without it while helping
+        std::atomic<size_t> pending_{};
+        std::mutex mutex_;
+        std::condition_variable finished_;
+        std::vector<thread_pool::task*> continuations_;
+        std::exception_ptr exception_;
+
+        friend class thread_pool;
+    };
+
+    // Calls function(first, last) for consecutive subranges of [begin, end)
+    // with at most grain indices, the calling thread takes the last one
+    template<typename Function>
+    void parallel_for(thread_pool& pool,
+        size_t begin,
+        size_t end,
+        size_t grain,
+        Function const& function);
+
+    // Pool shared by the whole process, started on first use
+    [[nodiscard]] thread_pool& default_thread_pool();
+
+    inline thread_local thread_pool::worker_context thread_pool::current_{};
+
+    inline thread_pool::thread_pool(size_t const threads)
+    {
+        assert(threads > 0);
+
+        deques_.reserve(threads);
+        for (size_t i{}; i != threads; ++i)
+        {
+            deques_.push_back(std::make_unique<work_stealing_deque<task*>>());
+        }
+
+        workers_.reserve(threads);
+        for (size_t i{}; i != threads; ++i)
+        {
+            workers_.emplace_back([this, i]() { work(i); });
+        }
+    }
+
+    inline thread_pool::~thread_pool()
+    {
+        {
+            std::lock_guard const lock{sleep_mutex_};
+            stopping_ = true;
+        }
+        sleep_condition_.notify_all();
+        workers_.clear();
+
+        for (auto const& deque : deques_)
+        {
+            while (std::optional<task*> const remaining{deque->steal()})
+            {
+                delete *remaining;
+            }
+        }
+
+        for (task* const remaining : shared_)
+        {
+            delete remaining;
+        }
+    }
+
+    inline size_t thread_pool::thread_count() const { return deques_.size(); }
+
+    inline std::optional<size_t> thread_pool::current_worker() const
+    {
+        if (current_.pool == this)
+        {
+            return current_.index;
+        }
+        return std::nullopt;
+    }
+
+    inline void thread_pool::submit(task* const item)
+    {
+        if (current_.pool == this)
+        {
+            deques_[current_.index]->push(item);
+        }
+        else
+        {
+            std::lock_guard const lock{shared_mutex_};
+            shared_.push_back(item);
+        }
+
+        queued_.fetch_add(1);
+        if (sleepers_.load() != 0)
+        {
+            // Sleeping worker either observes the task before waiting or is
+            // already waiting when the lock is acquired
+            std::lock_guard const lock{sleep_mutex_};
+            sleep_condition_.notify_one();
+        }
+    }
+
+    inline bool thread_pool::run_one(size_t const worker)
+    {
+        if (task* const item{find_task(worker)})
+        {
+            execute(item);
+            return true;
+        }
+        return false;
+    }
+
+    inline thread_pool::task* thread_pool::find_task(size_t const worker)
+    {
+        std::optional<task*> found{deques_[worker]->pop()};
+
+        for (size_t i{1}; !found && i != deques_.size(); ++i)
+        {
+            found = deques_[(worker + i) % deques_.size()]->steal();
+        }
+
+        if (!found)
+        {
+            std::lock_guard const lock{shared_mutex_};
+            if (!shared_.empty())
+            {
+                found = shared_.front();
+                shared_.pop_front();
+            }
+        }
+
+        if (found)
+        {
+            queued_.fetch_sub(1);
+            return *found;
+        }
+        return nullptr;
+    }
+
+    inline void thread_pool::execute(task* const item)
+    {
+        task_group* const group{item->group};
+        try
+        {
+            item->function();
+        }
+        catch (...)
+        {
+            group->fail(std::current_exception());
+        }
+        delete item;
+
+        group->complete();
+    }
+
+    inline void thread_pool::work(size_t const worker)
+    {
+        current_ = {.pool = this, .index = worker};
+
+        while (true)
+        {
+            if (run_one(worker))
+            {
+                continue;
+            }
+
+            std::unique_lock lock{sleep_mutex_};
+            sleepers_.fetch_add(1);
+            sleep_condition_.wait(lock,
+                [this]() { return stopping_ || queued_.load() != 0; });
+            sleepers_.fetch_sub(1);
+
+            if (stopping_)
+            {
+                return;
+            }
+        }
+    }
+
+    inline task_group::task_group(thread_pool& pool) : pool_{&pool} { }
+
+    inline task_group::~task_group() { wait_for_tasks(); }
+
+    template<typename Function>
+    void task_group::run(Function&& function)
+    {
+        {
+            std::lock_guard const lock{mutex_};
+            pending_.fetch_add(1);
+        }
+
+        pool_->submit(new thread_pool::task{
+            .function = std::forward<Function>(function),
+            .group = this});
+    }
+
+    template<typename Function>
+    void task_group::then(task_group& next, Function&& function)
+    {
+        // Group would never finish while its continuation is pending
+        assert(&next != this);
+
+        {
+            std::lock_guard const lock{next.mutex_};
+            next.pending_.fetch_add(1);
+        }
+
+        auto* const continuation{new thread_pool::task{
+            .function = std::forward<Function>(function),
+            .group = &next}};
+
+        {
+            std::lock_guard const lock{mutex_};
+            if (pending_.load() != 0)
+            {
+                continuations_.push_back(continuation);
+                return;
+            }
+        }
+
+        next.pool_->submit(continuation);
+    }
+
+    inline void task_group::wait()
+    {
+        wait_for_tasks();
+
+        std::exception_ptr exception;
+        {
+            std::lock_guard const lock{mutex_};
+            std::swap(exception, exception_);
+        }
+
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    inline void task_group::complete()
+    {
+        std::vector<thread_pool::task*> continuations;
+        {
+            std::lock_guard const lock{mutex_};
+            if (pending_.fetch_sub(1) == 1)
+            {
+                std::swap(continuations, continuations_);
+                finished_.notify_all();
+            }
+        }
+
+        // Group may already be destroyed by a waiter, only continuations
+        // which belong to other groups are touched
+        for (thread_pool::task* const continuation : continuations)
+        {
+            continuation->group->pool_->submit(continuation);
+        }
+    }
+
+    inline void task_group::fail(std::exception_ptr exception)
+    {
+        std::lock_guard const lock{mutex_};
+        if (!exception_)
+        {
+            exception_ = std::move(exception);
+        }
+    }
+
+    inline void task_group::wait_for_tasks()
+    {
+        if (std::optional<size_t> const worker{pool_->current_worker()})
+        {
+            // Blocking a worker could leave tasks of this group without a
+            // thread to run them
+            while (pending_.load() != 0)
+            {
+                if (!pool_->run_one(*worker))
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            // Last task is done with the group once it releases the lock
+            std::lock_guard const lock{mutex_};
+            return;
+        }
+
+        std::unique_lock lock{mutex_};
+        finished_.wait(lock, [this]() { return pending_.load() == 0; });
+    }
+
+    template<typename Function>
+    void parallel_for(thread_pool& pool,
+        size_t const begin,
+        size_t const end,
+        size_t const grain,
+        Function const& function)
+    {
+        assert(grain > 0);
+
+        if (begin >= end)
+        {
+            return;
+        }
+
+        task_group group{pool};
+
+        size_t first{begin};
+        for (; end - first > grain; first += grain)
+        {
+            group.run([&function, first, last = first + grain]()
+                { function(first, last); });
+        }
+        function(first, end);
+
+        group.wait();
+    }
+
+    inline thread_pool& default_thread_pool()
+    {
+        static thread_pool pool;
+        return pool;
+    }
+} // namespace cppext
+
+#endif
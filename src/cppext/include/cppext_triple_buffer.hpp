@@ -0,0 +1,100 @@
+#ifndef CPPEXT_TRIPLE_BUFFER_INCLUDED
+#define CPPEXT_TRIPLE_BUFFER_INCLUDED
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace cppext
+{
+    // Lock-free exchange of the latest value between a single writer and
+    // a single reader. Writer and reader each own one buffer, the third is
+    // swapped with them on publish and update.
+    template<typename T>
+    class [[nodiscard]] triple_buffer final
+    {
+    public:
+        triple_buffer() = default;
+
+        triple_buffer(triple_buffer const&) = delete;
+
+        triple_buffer(triple_buffer&&) noexcept = delete;
+
+    public:
+        ~triple_buffer() = default;
+
+    public:
+        // Writer thread only, holds the value of an earlier publish
+        [[nodiscard]] T& write_buffer();
+
+        // Writer thread only, makes the write buffer available to the reader
+        void publish();
+
+        // Reader thread only, returns true if a newer value was published
+        // since the last update
+        bool update();
+
+        // Reader thread only, value as of the last update
+        [[nodiscard]] T& read_buffer();
+
+        [[nodiscard]] T const& read_buffer() const;
+
+    public:
+        triple_buffer& operator=(triple_buffer const&) = delete;
+
+        triple_buffer& operator=(triple_buffer&&) noexcept = delete;
+
+    private:
+        static constexpr uint8_t index_mask{0b011};
+        static constexpr uint8_t dirty_bit{0b100};
+
+    private:
+        std::array<T, 3> buffers_{};
+        uint8_t write_{0};
+        std::atomic<uint8_t> middle_{1};
+        uint8_t read_{2};
+    };
+
+    template<typename T>
+    T& triple_buffer<T>::write_buffer()
+    {
+        return buffers_[write_];
+    }
+
+    template<typename T>
+    void triple_buffer<T>::publish()
+    {
+        auto const previous{middle_.exchange(
+            static_cast<uint8_t>(write_ | dirty_bit),
+            std::memory_order_acq_rel)};
+        write_ = previous & index_mask;
+    }
+
+    template<typename T>
+    bool triple_buffer<T>::update()
+    {
+        if ((middle_.load(std::memory_order_relaxed) & dirty_bit) == 0)
+        {
+            return false;
+        }
+
+        auto const previous{
+            middle_.exchange(read_, std::memory_order_acq_rel)};
+        read_ = previous & index_mask;
+        return true;
+    }
+
+    template<typename T>
+    T& triple_buffer<T>::read_buffer()
+    {
+        return buffers_[read_];
+    }
+
+    template<typename T>
+    T const& triple_buffer<T>::read_buffer() const
+    {
+        return buffers_[read_];
+    }
+} // namespace cppext
+
+#endif
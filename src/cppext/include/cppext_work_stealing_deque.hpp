@@ -0,0 +1,229 @@
+#ifndef CPPEXT_WORK_STEALING_DEQUE_INCLUDED
+#define CPPEXT_WORK_STEALING_DEQUE_INCLUDED
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace cppext
+{
+    // Chase-Lev deque, with memory orderings from "Correct and Efficient
+    // Work-Stealing for Weak Memory Models" (Le et al., 2013). Only the owner
+    // thread may push and pop at the bottom, other threads steal from the top.
+    template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+    class [[nodiscard]] work_stealing_deque final
+    {
+    public:
+        explicit work_stealing_deque(size_t capacity = 64);
+
+        work_stealing_deque(work_stealing_deque const&) = delete;
+
+        work_stealing_deque(work_stealing_deque&&) noexcept = delete;
+
+    public:
+        ~work_stealing_deque() = default;
+
+    public:
+        // Approximate when called concurrently with other operations
+        [[nodiscard]] bool empty() const;
+
+        // Owner thread only, storage is grown when full
+        void push(T value);
+
+        // Owner thread only, takes the most recently pushed value
+        [[nodiscard]] std::optional<T> pop();
+
+        // Any thread, takes the least recently pushed value
+        [[nodiscard]] std::optional<T> steal();
+
+    public:
+        work_stealing_deque& operator=(work_stealing_deque const&) = delete;
+
+        work_stealing_deque& operator=(
+            work_stealing_deque&&) noexcept = delete;
+
+    private:
+        struct [[nodiscard]] ring final
+        {
+            explicit ring(int64_t size);
+
+            [[nodiscard]] T load(int64_t index) const;
+
+            void store(int64_t index, T value);
+
+            int64_t capacity;
+            int64_t mask;
+            std::unique_ptr<std::atomic<T>[]> values;
+        };
+
+    private:
+        [[nodiscard]] ring* grow(ring* current, int64_t top, int64_t bottom);
+
+    private:
+        std::atomic<int64_t> top_{};
+        std::atomic<int64_t> bottom_{};
+        std::atomic<ring*> ring_;
+        // Replaced rings may still be read by concurrent steals, they are
+        // kept until the deque is destroyed
+        std::vector<std::unique_ptr<ring>> rings_;
+    };
+
+    template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+    work_stealing_deque<T>::ring::ring(int64_t const size)
+        : capacity{size}
+        , mask{size - 1}
+        , values{std::make_unique<std::atomic<T>[]>(
+              static_cast<size_t>(size))}
+    {
+        assert(capacity > 0 && (capacity & mask) == 0);
+    }
+
+    template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+    T work_stealing_deque<T>::ring::load(int64_t const index) const
+    {
+        return values[static_cast<size_t>(index & mask)].load(
+            std::memory_order_relaxed);
+    }
+
+    template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+    void work_stealing_deque<T>::ring::store(int64_t const index,
+        T const value)
+    {
+        values[static_cast<size_t>(index & mask)].store(value,
+            std::memory_order_relaxed);
+    }
+
+    template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+    work_stealing_deque<T>::work_stealing_deque(size_t const capacity)
+    {
+        size_t rounded{1};
+        while (rounded < capacity)
+        {
+            rounded *= 2;
+        }
+
+        rings_.push_back(
+            std::make_unique<ring>(static_cast<int64_t>(rounded)));
+        ring_.store(rings_.back().get(), std::memory_order_relaxed);
+    }
+
+    template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+    bool work_stealing_deque<T>::empty() const
+    {
+        int64_t const bottom{bottom_.load(std::memory_order_relaxed)};
+        int64_t const top{top_.load(std::memory_order_relaxed)};
+        return bottom <= top;
+    }
+
+    template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+    void work_stealing_deque<T>::push(T const value)
+    {
+        int64_t const bottom{bottom_.load(std::memory_order_relaxed)};
+        int64_t const top{top_.load(std::memory_order_acquire)};
+        ring* current{ring_.load(std::memory_order_relaxed)};
+
+        if (bottom - top > current->capacity - 1)
+        {
+            current = grow(current, top, bottom);
+        }
+
+        current->store(bottom, value);
+        // Release store instead of the release fence of the paper, same
+        // guarantee but visible to thread sanitizer
+        bottom_.store(bottom + 1, std::memory_order_release);
+    }
+
+    template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+    std::optional<T> work_stealing_deque<T>::pop()
+    {
+        int64_t const bottom{bottom_.load(std::memory_order_relaxed) - 1};
+        ring* const current{ring_.load(std::memory_order_relaxed)};
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top{top_.load(std::memory_order_relaxed)};
+
+        if (top > bottom)
+        {
+            // Deque was empty
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        std::optional<T> rv{current->load(bottom)};
+        if (top == bottom)
+        {
+            // Last value, race against steals for it
+            if (!top_.compare_exchange_strong(top,
+                    top + 1,
+                    std::memory_order_seq_cst,
+                    std::memory_order_relaxed))
+            {
+                rv.reset();
+            }
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return rv;
+    }
+
+    template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+    std::optional<T> work_stealing_deque<T>::steal()
+    {
+        int64_t top{top_.load(std::memory_order_acquire)};
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t const bottom{bottom_.load(std::memory_order_acquire)};
+
+        if (top >= bottom)
+        {
+            return std::nullopt;
+        }
+
+        ring const* const current{ring_.load(std::memory_order_acquire)};
+        T const value{current->load(top)};
+        if (!top_.compare_exchange_strong(top,
+                top + 1,
+                std::memory_order_seq_cst,
+                std::memory_order_relaxed))
+        {
+            // Lost the race to the owner or another thief
+            return std::nullopt;
+        }
+
+        return value;
+    }
+
+    template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+    work_stealing_deque<T>::ring* work_stealing_deque<T>::grow(
+        ring* const current,
+        int64_t const top,
+        int64_t const bottom)
+    {
+        auto bigger{std::make_unique<ring>(current->capacity * 2)};
+        for (int64_t i{top}; i != bottom; ++i)
+        {
+            bigger->store(i, current->load(i));
+        }
+
+        ring* const rv{bigger.get()};
+        rings_.push_back(std::move(bigger));
+        ring_.store(rv, std::memory_order_release);
+        return rv;
+    }
+} // namespace cppext
+
+#endif
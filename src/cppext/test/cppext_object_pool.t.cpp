@@ -0,0 +1,117 @@
+#include <cppext_object_pool.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("object_pool", "[cppext][memory]")
+{
+    cppext::object_pool<int, 4> pool;
+
+    CHECK(pool.size() == 0);
+    CHECK(pool.capacity() == 0);
+
+    int* const first{pool.create(1)};
+    int* const second{pool.create(2)};
+    CHECK(*first == 1);
+    CHECK(*second == 2);
+    CHECK(pool.size() == 2);
+    CHECK(pool.capacity() == 4);
+
+    // Freed slot is reused
+    pool.destroy(first);
+    CHECK(pool.size() == 1);
+    int* const third{pool.create(3)};
+    CHECK(third == first);
+    CHECK(*third == 3);
+
+    // Grows by whole blocks
+    std::vector<int*> objects{second, third};
+    for (int i{}; i != 5; ++i)
+    {
+        objects.push_back(pool.create(i));
+    }
+    CHECK(pool.size() == 7);
+    CHECK(pool.capacity() == 8);
+
+    for (int* const object : objects)
+    {
+        pool.destroy(object);
+    }
+    CHECK(pool.size() == 0);
+    CHECK(pool.capacity() == 8);
+
+    pool.destroy(nullptr);
+    CHECK(pool.size() == 0);
+}
+
+TEST_CASE("object_pool lifetime", "[cppext][memory]")
+{
+    struct alignas(32) tracked final
+    {
+        explicit tracked(int* const counter) : counter_{counter}
+        {
+            ++*counter_;
+        }
+
+        tracked(tracked const&) = delete;
+
+        tracked(tracked&&) noexcept = delete;
+
+        ~tracked() { --*counter_; }
+
+        tracked& operator=(tracked const&) = delete;
+
+        tracked& operator=(tracked&&) noexcept = delete;
+
+        int* counter_;
+    };
+
+    int live{};
+    cppext::object_pool<tracked, 2> pool;
+
+    tracked* const first{pool.create(&live)};
+    tracked* const second{pool.create(&live)};
+    tracked* const third{pool.create(&live)};
+    CHECK(live == 3);
+
+    CHECK(reinterpret_cast<uintptr_t>(first) % 32 == 0);
+    CHECK(reinterpret_cast<uintptr_t>(second) % 32 == 0);
+    CHECK(reinterpret_cast<uintptr_t>(third) % 32 == 0);
+
+    pool.destroy(second);
+    CHECK(live == 2);
+
+    pool.destroy(first);
+    pool.destroy(third);
+    CHECK(live == 0);
+}
+
+TEST_CASE("object_pool throwing constructor", "[cppext][memory]")
+{
+    struct throwing final
+    {
+        explicit throwing(bool const fail)
+        {
+            if (fail)
+            {
+                throw std::runtime_error{"fail"};
+            }
+        }
+    };
+
+    cppext::object_pool<throwing, 2> pool;
+
+    CHECK_THROWS_AS(pool.create(true), std::runtime_error);
+    CHECK(pool.size() == 0);
+
+    // Slot of the failed construction is still available
+    throwing* const first{pool.create(false)};
+    throwing* const second{pool.create(false)};
+    CHECK(pool.capacity() == 2);
+
+    pool.destroy(first);
+    pool.destroy(second);
+}
@@ -0,0 +1,145 @@
+#include <cppext_thread_pool.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("parallel_for visits every index once", "[cppext][thread]")
+{
+    cppext::thread_pool pool{4};
+
+    // Assertions aren't thread safe, results are checked after the loop
+    std::vector<std::atomic<int>> visits(10007);
+    std::atomic<bool> oversized{};
+    cppext::parallel_for(pool,
+        0,
+        visits.size(),
+        64,
+        [&visits, &oversized](size_t const first, size_t const last)
+        {
+            if (last - first > 64)
+            {
+                oversized = true;
+            }
+            for (size_t i{first}; i != last; ++i)
+            {
+                ++visits[i];
+            }
+        });
+
+    CHECK_FALSE(oversized);
+    CHECK(std::ranges::all_of(visits,
+        [](std::atomic<int> const& count) { return count.load() == 1; }));
+
+    // Empty range doesn't call the function
+    cppext::parallel_for(pool,
+        5,
+        5,
+        1,
+        [](size_t, size_t) { FAIL("called for empty range"); });
+}
+
+TEST_CASE("task_group waits for nested tasks", "[cppext][thread]")
+{
+    // Single worker has to run nested groups while waiting for them
+    cppext::thread_pool pool{1};
+
+    std::atomic<size_t> count{};
+    cppext::task_group group{pool};
+    for (int i{}; i != 32; ++i)
+    {
+        group.run(
+            [&pool, &count]()
+            {
+                cppext::parallel_for(pool,
+                    0,
+                    100,
+                    10,
+                    [&count](size_t const first, size_t const last)
+                    { count += last - first; });
+            });
+    }
+    group.wait();
+
+    CHECK(count == 3200);
+    CHECK_FALSE(pool.current_worker());
+}
+
+TEST_CASE("task_group continuation", "[cppext][thread]")
+{
+    cppext::thread_pool pool{4};
+
+    std::atomic<int> finished{};
+    int observed{-1};
+
+    cppext::task_group first{pool};
+    cppext::task_group second{pool};
+    for (int i{}; i != 16; ++i)
+    {
+        first.run(
+            [&finished]()
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds{100});
+                ++finished;
+            });
+    }
+    first.then(second, [&]() { observed = finished.load(); });
+    second.wait();
+
+    CHECK(observed == 16);
+
+    // Continuation of a group without tasks runs right away
+    bool ran{};
+    first.then(second, [&ran]() { ran = true; });
+    second.wait();
+    CHECK(ran);
+}
+
+TEST_CASE("task_group rethrows exceptions", "[cppext][thread]")
+{
+    cppext::thread_pool pool{2};
+
+    cppext::task_group group{pool};
+    group.run([]() { throw std::runtime_error{"task failed"}; });
+    group.run([]() { });
+    CHECK_THROWS_AS(group.wait(), std::runtime_error);
+
+    // Exception is reported once
+    group.run([]() { });
+    CHECK_NOTHROW(group.wait());
+}
+
+TEST_CASE("thread_pool scaling", "[cppext][thread][.benchmark]")
+{
+    constexpr size_t count{1 << 22};
+    std::vector<float> values(count);
+
+    auto const work = [&values](size_t const first, size_t const last)
+    {
+        for (size_t i{first}; i != last; ++i)
+        {
+            auto const x{static_cast<float>(i)};
+            values[i] = std::sin(x) * std::cos(x) + std::sqrt(x);
+        }
+    };
+
+    size_t const hardware{std::max(1u, std::thread::hardware_concurrency())};
+    for (size_t threads{1}; threads <= hardware; threads *= 2)
+    {
+        cppext::thread_pool pool{threads};
+        BENCHMARK(std::to_string(threads) + " threads")
+        {
+            cppext::parallel_for(pool, 0, count, count / 256, work);
+            return values[count / 2];
+        };
+    }
+}
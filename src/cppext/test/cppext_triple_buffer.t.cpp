@@ -0,0 +1,74 @@
+#include <cppext_triple_buffer.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+TEST_CASE("triple_buffer", "[cppext][container]")
+{
+    cppext::triple_buffer<int> buffer;
+
+    CHECK_FALSE(buffer.update());
+    CHECK(buffer.read_buffer() == 0);
+
+    buffer.write_buffer() = 1;
+    buffer.publish();
+
+    CHECK(buffer.update());
+    CHECK(buffer.read_buffer() == 1);
+    CHECK_FALSE(buffer.update());
+    CHECK(buffer.read_buffer() == 1);
+
+    buffer.write_buffer() = 2;
+    buffer.publish();
+    buffer.write_buffer() = 3;
+    buffer.publish();
+
+    // Only the latest value is observed
+    CHECK(buffer.update());
+    CHECK(buffer.read_buffer() == 3);
+    CHECK_FALSE(buffer.update());
+}
+
+TEST_CASE("triple_buffer concurrent", "[cppext][container]")
+{
+    struct value final
+    {
+        uint64_t first{};
+        uint64_t second{};
+    };
+
+    cppext::triple_buffer<value> buffer;
+
+    constexpr uint64_t count{100000};
+
+    std::jthread writer{[&buffer]()
+        {
+            for (uint64_t i{1}; i <= count; ++i)
+            {
+                value& written{buffer.write_buffer()};
+                written.first = i;
+                written.second = i * 2;
+                buffer.publish();
+            }
+        }};
+
+    bool torn{false};
+    bool ordered{true};
+    uint64_t last{};
+    while (last != count)
+    {
+        if (buffer.update())
+        {
+            value const& read{buffer.read_buffer()};
+            torn = torn || read.second != read.first * 2;
+            ordered = ordered && read.first > last;
+            last = read.first;
+        }
+    }
+
+    CHECK_FALSE(torn);
+    CHECK(ordered);
+}
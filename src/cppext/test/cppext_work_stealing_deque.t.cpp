@@ -0,0 +1,98 @@
+#include <cppext_work_stealing_deque.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <thread>
+#include <vector>
+
+TEST_CASE("work_stealing_deque", "[cppext][container][thread]")
+{
+    cppext::work_stealing_deque<int> deque{2};
+
+    CHECK(deque.empty());
+    CHECK_FALSE(deque.pop());
+    CHECK_FALSE(deque.steal());
+
+    // Grows past the initial capacity
+    for (int i{}; i != 10; ++i)
+    {
+        deque.push(i);
+    }
+    CHECK_FALSE(deque.empty());
+
+    // Owner takes from the bottom, thieves from the top
+    CHECK(deque.pop() == 9);
+    CHECK(deque.steal() == 0);
+    CHECK(deque.pop() == 8);
+    CHECK(deque.steal() == 1);
+
+    for (int i{2}; i != 8; ++i)
+    {
+        CHECK(deque.steal() == i);
+    }
+
+    CHECK(deque.empty());
+    CHECK_FALSE(deque.pop());
+    CHECK_FALSE(deque.steal());
+}
+
+TEST_CASE("work_stealing_deque concurrent steals",
+    "[cppext][container][thread]")
+{
+    constexpr int values{100000};
+    constexpr size_t thieves{4};
+
+    cppext::work_stealing_deque<int> deque;
+    std::vector<std::atomic<int>> taken(values);
+    std::atomic<bool> done{};
+
+    {
+        std::vector<std::jthread> threads;
+        for (size_t i{}; i != thieves; ++i)
+        {
+            threads.emplace_back(
+                [&]()
+                {
+                    while (!done.load() || !deque.empty())
+                    {
+                        if (std::optional<int> const value{deque.steal()})
+                        {
+                            ++taken[static_cast<size_t>(*value)];
+                        }
+                    }
+                });
+        }
+
+        for (int i{}; i != values; ++i)
+        {
+            deque.push(i);
+            if (i % 3 == 0)
+            {
+                if (std::optional<int> const value{deque.pop()})
+                {
+                    ++taken[static_cast<size_t>(*value)];
+                }
+            }
+        }
+
+        while (std::optional<int> const value{deque.pop()})
+        {
+            ++taken[static_cast<size_t>(*value)];
+        }
+        done = true;
+    }
+
+    // Every value is taken exactly once
+    size_t mismatched{};
+    for (std::atomic<int> const& count : taken)
+    {
+        if (count.load() != 1)
+        {
+            ++mismatched;
+        }
+    }
+    CHECK(mismatched == 0);
+}
@@ -54,10 +54,26 @@ namespace niku
 
         [[nodiscard]] float fixed_update_interval() const;
 
+        // Limits fixed updates per frame, remaining time is dropped so slow
+        // frames don't accumulate further work
+        void max_fixed_updates(int count);
+
+        [[nodiscard]] int max_fixed_updates() const;
+
+        // Fraction of the fixed update interval elapsed since the last fixed
+        // update, for interpolation between fixed updates in update
+        [[nodiscard]] float interpolation_alpha() const;
+
         void debug_layer(bool enable);
 
         [[nodiscard]] bool debug_layer() const;
 
+        // Records and submits frames on a separate thread, overlapping them
+        // with the update of the next frame. Takes effect when run is called.
+        void render_thread(bool enable);
+
+        [[nodiscard]] bool render_thread() const;
+
         [[nodiscard]] vkrndr::vulkan_device* vulkan_device();
 
         [[nodiscard]] vkrndr::vulkan_renderer* vulkan_renderer();
@@ -78,6 +94,10 @@ namespace niku
 
         virtual void update([[maybe_unused]] float const delta_time) { }
 
+        // Called after update, render thread is idle for the duration of the
+        // call. State read while rendering should be published here.
+        virtual void publish_frame() { }
+
         [[nodiscard]] virtual vkrndr::scene* render_scene() = 0;
 
         virtual void end_frame() { }
@@ -35,6 +35,9 @@ namespace niku
 
         void set_near_far(glm::vec2 const& near_far);
 
+        // Vertical field of view in degrees
+        [[nodiscard]] float fov() const;
+
         [[nodiscard]] glm::vec3 const& up_direction() const;
 
         [[nodiscard]] glm::vec3 const& front_direction() const;
@@ -17,9 +17,17 @@
 #include <SDL2/SDL_timer.h>
 #include <SDL2/SDL_video.h>
 
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
 
 namespace
 {
@@ -46,6 +54,15 @@ public:
 public:
     [[nodiscard]] bool is_current_window_event(SDL_Event const& event) const;
 
+    void render(vkrndr::scene* scene);
+
+    void render_loop(std::stop_token const& stop_token);
+
+    // Waits until the previously requested frame is submitted
+    void wait_for_render();
+
+    void request_render(vkrndr::scene* scene);
+
 public:
     impl& operator=(impl const&) = delete;
 
@@ -60,8 +77,15 @@ public:
     std::unique_ptr<vkrndr::vulkan_renderer> renderer;
 
     std::optional<float> fixed_update_interval;
-    uint64_t last_tick{};
-    uint64_t last_fixed_tick{};
+    int max_fixed_updates{5};
+    float fixed_update_accumulator{};
+    float interpolation_alpha{};
+
+    bool render_thread{};
+    std::mutex render_mutex;
+    std::condition_variable_any render_condition;
+    vkrndr::scene* render_request{};
+    std::exception_ptr render_exception;
 };
 
 niku::application::impl::impl(startup_params const& params)
@@ -97,6 +121,69 @@ bool niku::application::impl::is_current_window_event(
     return true;
 }
 
+void niku::application::impl::render(vkrndr::scene* const scene)
+{
+    if (renderer->begin_frame(scene))
+    {
+        renderer->draw(scene);
+        renderer->end_frame();
+    }
+}
+
+void niku::application::impl::render_loop(std::stop_token const& stop_token)
+{
+    while (true)
+    {
+        vkrndr::scene* scene; // NOLINT
+        {
+            std::unique_lock lock{render_mutex};
+            render_condition.wait(lock,
+                stop_token,
+                [this]() { return render_request != nullptr; });
+            if (!render_request)
+            {
+                return;
+            }
+            scene = render_request;
+        }
+
+        try
+        {
+            render(scene);
+        }
+        catch (...)
+        {
+            render_exception = std::current_exception();
+        }
+
+        {
+            std::lock_guard const lock{render_mutex};
+            render_request = nullptr;
+        }
+        render_condition.notify_all();
+    }
+}
+
+void niku::application::impl::wait_for_render()
+{
+    std::unique_lock lock{render_mutex};
+    render_condition.wait(lock, [this]() { return !render_request; });
+
+    if (render_exception)
+    {
+        std::rethrow_exception(std::exchange(render_exception, nullptr));
+    }
+}
+
+void niku::application::impl::request_render(vkrndr::scene* const scene)
+{
+    {
+        std::lock_guard const lock{render_mutex};
+        render_request = scene;
+    }
+    render_condition.notify_all();
+}
+
 niku::application::application(startup_params const& params)
     : impl_{std::make_unique<impl>(params)}
 {
@@ -109,7 +196,15 @@ void niku::application::run()
     on_startup();
 
     uint64_t last_tick{SDL_GetPerformanceCounter()};
-    uint64_t last_fixed_tick{last_tick};
+
+    // Render thread consumes the frame published in the previous iteration
+    // while the main thread updates the next one
+    std::jthread render_worker;
+    if (impl_->render_thread)
+    {
+        render_worker = std::jthread{[this](std::stop_token const& stop_token)
+            { impl_->render_loop(stop_token); }};
+    }
 
     bool done{false};
     while (!done && should_run())
@@ -146,36 +241,59 @@ void niku::application::run()
 
         float const delta{cppext::as_fp(current_tick - last_tick) / frequency};
 
-        float const fixed_delta{
-            cppext::as_fp(current_tick - last_fixed_tick) / frequency};
-
-        // NOLINTBEGIN(bugprone-unchecked-optional-access)
-        bool const do_fixed_update{impl_->fixed_update_interval.has_value() &&
-            fixed_delta >= *impl_->fixed_update_interval};
-        // NOLINTEND(bugprone-unchecked-optional-access)
-
         last_tick = current_tick;
 
         begin_frame();
 
-        if (do_fixed_update)
+        if (impl_->fixed_update_interval)
         {
-            last_fixed_tick = current_tick;
-            fixed_update(fixed_delta);
+            float const interval{*impl_->fixed_update_interval};
+
+            impl_->fixed_update_accumulator += delta;
+            int steps{};
+            while (steps != impl_->max_fixed_updates &&
+                impl_->fixed_update_accumulator >= interval)
+            {
+                fixed_update(interval);
+                impl_->fixed_update_accumulator -= interval;
+                ++steps;
+            }
+
+            // Simulation falls behind real time instead of spiraling
+            impl_->fixed_update_accumulator =
+                std::min(impl_->fixed_update_accumulator, interval);
+            impl_->interpolation_alpha =
+                impl_->fixed_update_accumulator / interval;
         }
 
         update(delta);
 
-        if (vkrndr::scene* const scene{render_scene()};
-            impl_->renderer->begin_frame(scene))
+        if (render_worker.joinable())
         {
-            impl_->renderer->draw(scene);
-            impl_->renderer->end_frame();
+            impl_->wait_for_render();
+            publish_frame();
+            // ImGui frame is built here, render thread records only its
+            // copied draw data
+            impl_->renderer->build_imgui_frame(render_scene());
+            impl_->request_render(render_scene());
+        }
+        else
+        {
+            publish_frame();
+            impl_->renderer->build_imgui_frame(render_scene());
+            impl_->render(render_scene());
         }
 
         end_frame();
     }
 
+    if (render_worker.joinable())
+    {
+        impl_->wait_for_render();
+        render_worker.request_stop();
+        render_worker.join();
+    }
+
     vkDeviceWaitIdle(impl_->device.logical);
 
     on_shutdown();
@@ -191,6 +309,8 @@ void niku::application::fixed_update_interval(float const delta_time)
     {
         impl_->fixed_update_interval.reset();
     }
+    impl_->fixed_update_accumulator = 0.0f;
+    impl_->interpolation_alpha = 0.0f;
 }
 
 float niku::application::fixed_update_interval() const
@@ -198,6 +318,22 @@ float niku::application::fixed_update_interval() const
     return impl_->fixed_update_interval.value_or(0.0f);
 }
 
+void niku::application::max_fixed_updates(int const count)
+{
+    assert(count > 0);
+    impl_->max_fixed_updates = count;
+}
+
+int niku::application::max_fixed_updates() const
+{
+    return impl_->max_fixed_updates;
+}
+
+float niku::application::interpolation_alpha() const
+{
+    return impl_->interpolation_alpha;
+}
+
 void niku::application::debug_layer(bool const enable)
 {
     impl_->renderer->imgui_layer(enable);
@@ -208,6 +344,16 @@ bool niku::application::debug_layer() const
     return impl_->renderer->imgui_layer();
 }
 
+void niku::application::render_thread(bool const enable)
+{
+    impl_->render_thread = enable;
+}
+
+bool niku::application::render_thread() const
+{
+    return impl_->render_thread;
+}
+
 vkrndr::vulkan_device* niku::application::vulkan_device()
 {
     return &impl_->device;
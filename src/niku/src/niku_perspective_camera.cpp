@@ -51,6 +51,8 @@ void niku::perspective_camera::set_near_far(glm::vec2 const& near_far)
     near_far_planes_ = near_far;
 }
 
+float niku::perspective_camera::fov() const { return fov_; }
+
 glm::vec3 const& niku::perspective_camera::up_direction() const
 {
     return up_direction_;
@@ -109,5 +111,5 @@ void niku::perspective_camera::calculate_view_projection_matrices()
 
     projection_matrix_[1][1] *= -1;
 
-    view_projection_matrix_ = view_matrix_ * projection_matrix_;
+    view_projection_matrix_ = projection_matrix_ * view_matrix_;
 }
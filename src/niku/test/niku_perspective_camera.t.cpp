@@ -0,0 +1,61 @@
+#include <niku_perspective_camera.hpp>
+
+#include <glm/mat4x4.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+
+namespace
+{
+    [[nodiscard]] glm::vec3 project(glm::mat4 const& view_projection,
+        glm::vec3 const& point)
+    {
+        glm::vec4 const clip{view_projection * glm::vec4{point, 1.0f}};
+        return glm::vec3{clip} / clip.w;
+    }
+} // namespace
+
+TEST_CASE("perspective_camera view projection", "[niku][camera]")
+{
+    constexpr float aspect_ratio{2.0f};
+    constexpr float fov{90.0f};
+
+    // Looking down negative Z
+    niku::perspective_camera camera{{0.0f, 0.0f, 0.0f},
+        aspect_ratio,
+        fov,
+        {0.0f, 1.0f, 0.0f},
+        {1.0f, 100.0f},
+        {-90.0f, 0.0f}};
+    camera.update();
+
+    glm::mat4 const& view_projection{camera.view_projection_matrix()};
+
+    glm::vec3 const point{2.0f, 1.0f, -10.0f};
+    glm::vec4 const expected_clip{camera.projection_matrix() *
+        camera.view_matrix() * glm::vec4{point, 1.0f}};
+    glm::vec4 const clip{view_projection * glm::vec4{point, 1.0f}};
+    for (int i{}; i != 4; ++i)
+    {
+        CHECK(clip[i] == Catch::Approx(expected_clip[i]).margin(1e-5));
+    }
+
+    float const focal_length{1.0f / std::tan(glm::radians(fov) / 2.0f)};
+    glm::vec3 const ndc{project(view_projection, point)};
+    CHECK(ndc.x == Catch::Approx(2.0f * focal_length / aspect_ratio / 10.0f));
+    // Vulkan NDC Y points down
+    CHECK(ndc.y == Catch::Approx(-1.0f * focal_length / 10.0f));
+    CHECK(ndc.z > 0.0f);
+    CHECK(ndc.z < 1.0f);
+
+    // Depth is in [0, 1] between the near and far planes
+    CHECK(project(view_projection, {0.0f, 0.0f, -1.0f}).z ==
+        Catch::Approx(0.0f).margin(1e-5));
+    CHECK(project(view_projection, {0.0f, 0.0f, -100.0f}).z ==
+        Catch::Approx(1.0f).margin(1e-5));
+}
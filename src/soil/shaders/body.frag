@@ -0,0 +1,14 @@
+#version 460
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in vec3 inColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec3 lightDirection = normalize(vec3(0.5, 1.0, 0.3));
+
+    float diff = max(dot(normalize(inNormal), lightDirection), 0.1);
+
+    outColor = vec4(diff * inColor, 1.0);
+}
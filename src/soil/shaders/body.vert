@@ -0,0 +1,36 @@
+#version 460
+
+// Unit cube, normalized for spheres
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+
+layout(location = 2) in vec4 inRotation;
+layout(location = 3) in vec3 inOffset;
+layout(location = 4) in float inSphere;
+layout(location = 5) in vec3 inHalfExtents;
+
+layout(binding = 0) uniform Transform {
+    mat4 view;
+    mat4 projection;
+} transform;
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec3 outColor;
+
+vec3 rotate(vec4 q, vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    vec3 localPosition = inSphere > 0.5 ? normalize(inPosition) : inPosition;
+    vec3 localNormal = inSphere > 0.5 ? localPosition : inNormal;
+
+    vec3 position = inOffset + rotate(inRotation, localPosition * inHalfExtents);
+    gl_Position = transform.projection * transform.view * vec4(position, 1.0);
+
+    outNormal = rotate(inRotation, localNormal);
+
+    // Tells neighbouring bodies apart
+    uint hash = uint(gl_InstanceIndex) * 2654435761u;
+    outColor = vec3((hash >> 8) & 0xFFu, (hash >> 16) & 0xFFu, (hash >> 24) & 0xFFu) / 255.0 * 0.6 + 0.4;
+}
@@ -0,0 +1,21 @@
+#version 460
+
+layout(location = 0) in vec3 inFragPosition;
+layout(location = 1) in vec3 inNormal;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec3 colorLow = vec3(0.0, 0.2, 0.0);
+    vec3 colorHigh = vec3(1.0, 1.0, 1.0);
+
+    float bias = clamp((inFragPosition.y - 50) / 125, 0.0, 1.0);
+    vec3 color = mix(colorLow, colorHigh, bias);
+
+    vec3 lightDirection = normalize(vec3(0.5, 1.0, 0.3));
+
+    float diff = max(dot(normalize(inNormal), lightDirection), 0.1);
+    vec3 result = diff * color;
+
+    outColor = vec4(result, 1.);
+}
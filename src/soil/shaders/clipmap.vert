@@ -0,0 +1,86 @@
+#version 460
+
+layout(location = 0) in uvec2 inPatchPosition;
+
+// Must match clipmap_renderer.cpp
+const int gridCells = 128;
+const uint levelTexels = gridCells + 1;
+const float transitionWidth = gridCells / 10.0;
+
+struct Level {
+    ivec2 origin;
+    uvec2 wrappedOrigin;
+};
+
+layout(binding = 0) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 origin;
+    uint levelCount;
+    Level levels[8];
+} frame;
+
+layout(std430, binding = 1) readonly buffer PatchBuffer {
+    uvec4 patches[];
+} patches;
+
+layout(std430, binding = 2) readonly buffer Heights {
+    float heights[];
+} clipmap;
+
+layout(location = 0) out vec3 outFragPosition;
+layout(location = 1) out vec3 outNormal;
+
+float texelHeight(uint level, uvec2 texel) {
+    uvec2 wrapped = (frame.levels[level].wrappedOrigin + texel) % levelTexels;
+    return clipmap.heights[level * levelTexels * levelTexels + wrapped.y * levelTexels + wrapped.x];
+}
+
+// Bilinear height at sample position, clamped to the level window
+float levelHeight(uint level, vec2 position) {
+    vec2 texel = clamp(position / float(1 << level) - vec2(frame.levels[level].origin), vec2(0.0), vec2(gridCells));
+    uvec2 base = uvec2(min(floor(texel), vec2(gridCells - 1)));
+    vec2 weight = texel - vec2(base);
+
+    return mix(mix(texelHeight(level, base), texelHeight(level, base + uvec2(1, 0)), weight.x),
+        mix(texelHeight(level, base + uvec2(0, 1)), texelHeight(level, base + uvec2(1, 1)), weight.x),
+        weight.y);
+}
+
+vec3 levelNormal(uint level, vec2 position) {
+    float spacing = float(1 << level);
+    float left = levelHeight(level, position - vec2(spacing, 0.0));
+    float right = levelHeight(level, position + vec2(spacing, 0.0));
+    float top = levelHeight(level, position - vec2(0.0, spacing));
+    float bottom = levelHeight(level, position + vec2(0.0, spacing));
+
+    return normalize(vec3(left - right, 2.0 * spacing, top - bottom));
+}
+
+void main() {
+    uvec4 patchData = patches.patches[gl_InstanceIndex];
+    uint level = patchData.z;
+
+    ivec2 texel = ivec2(patchData.xy + inPatchPosition);
+    vec2 position = vec2((frame.levels[level].origin + texel) * (1 << level));
+
+    float height = levelHeight(level, position);
+    vec3 norm = levelNormal(level, position);
+
+    // Blend into the coarser level towards the outer edge so that edge
+    // vertices lie on the coarser level triangles
+    if (level + 1 < frame.levelCount) {
+        int edgeDistance = min(min(texel.x, gridCells - texel.x), min(texel.y, gridCells - texel.y));
+        float blend = clamp(1.0 - float(edgeDistance) / transitionWidth, 0.0, 1.0);
+        if (blend > 0.0) {
+            height = mix(height, levelHeight(level + 1, position), blend);
+            norm = normalize(mix(norm, levelNormal(level + 1, position), blend));
+        }
+    }
+
+    vec3 localPosition = vec3(position.x, height, position.y);
+    gl_Position = frame.projection * frame.view * vec4(frame.origin.xyz + localPosition, 1.0);
+
+    outFragPosition = localPosition;
+    outNormal = norm;
+}
@@ -1,7 +1,5 @@
 #version 460
 
-layout(location = 0) in uvec2 inChunkPosition;
-
 layout(push_constant) uniform PushConsts {
     uint lod;
     uint chunk;
@@ -31,23 +29,38 @@ layout(std430, binding = 3) readonly buffer NormalBuffer {
     vec4 normals[];
 } normal;
 
+#ifndef VERTEX_PULLING
+layout(location = 0) in uvec2 inChunkPosition;
+#endif
+
 layout(location = 0) out vec3 outFragPosition;
 layout(location = 1) out vec3 outNormal;
 layout(location = 2) out vec2 outGlobalUV;
 layout(location = 3) out vec2 outUV;
 
-uvec2 globalPosition() {
+uvec2 chunkPosition() {
+#ifdef VERTEX_PULLING
+    // Vertices of the chunk grid are laid out row by row
+    uint index = uint(gl_VertexIndex);
+    return uvec2(index % pushConsts.chunkDimension, index / pushConsts.chunkDimension);
+#else
+    return inChunkPosition;
+#endif
+}
+
+uvec2 globalPosition(uvec2 chunkPosition) {
     uint chunkY = pushConsts.chunk / pushConsts.chunksPerDimension;
     uint chunkX = pushConsts.chunk % pushConsts.chunksPerDimension;
 
-    return uvec2(chunkX * (pushConsts.chunkDimension - 1) + inChunkPosition.x, chunkY * (pushConsts.chunkDimension - 1) + inChunkPosition.y);
+    return uvec2(chunkX * (pushConsts.chunkDimension - 1) + chunkPosition.x, chunkY * (pushConsts.chunkDimension - 1) + chunkPosition.y);
 }
 
 void main() {
-    uvec2 globalPos = globalPosition();
+    uvec2 chunkPos = chunkPosition();
+    uvec2 globalPos = globalPosition(chunkPos);
 
     uint vertexIndex = globalPos.y * pushConsts.terrainDimension + globalPos.x;
-    vec4 vertex = vec4(inChunkPosition.x, heightmap.heights[vertexIndex], inChunkPosition.y, 1.0);
+    vec4 vertex = vec4(chunkPos.x, heightmap.heights[vertexIndex], chunkPos.y, 1.0);
 
     mat4 model = chunks.chunks[pushConsts.chunk].model;
     vec4 worldPosition = model * vertex;
@@ -57,6 +70,6 @@ void main() {
     outFragPosition = vec3(globalPos.x, vertex.y, globalPos.y);
     outNormal = (model * normal.normals[vertexIndex]).xyz;
     outGlobalUV = vec2(float(globalPos.x) / pushConsts.terrainDimension, float(globalPos.y) / pushConsts.terrainDimension);
-    outUV = vec2(float(inChunkPosition.x) / (pushConsts.chunkDimension - 1), float(inChunkPosition.y) / (pushConsts.chunkDimension - 1));
+    outUV = vec2(float(chunkPos.x) / (pushConsts.chunkDimension - 1), float(chunkPos.y) / (pushConsts.chunkDimension - 1));
 }
 
@@ -0,0 +1,81 @@
+#version 460
+
+layout(location = 0) in uvec2 inChunkPosition;
+
+layout(push_constant) uniform PushConsts {
+    uint lod;
+    uint chunk;
+    uint chunkDimension;
+    uint terrainDimension;
+    uint chunksPerDimension;
+    uint nodeScale;
+    uvec2 nodeOrigin;
+    vec2 morphRange;
+    vec3 cameraPosition;
+    vec3 origin;
+} pushConsts;
+
+layout(binding = 0) uniform Camera {
+    mat4 view;
+    mat4 projection;
+} camera;
+
+layout(std430, binding = 2) readonly buffer Heightmap {
+    float heights[];
+} heightmap;
+
+layout(std430, binding = 3) readonly buffer NormalBuffer {
+    vec4 normals[];
+} normal;
+
+layout(location = 0) out vec3 outFragPosition;
+layout(location = 1) out vec3 outNormal;
+layout(location = 2) out vec2 outGlobalUV;
+layout(location = 3) out vec2 outUV;
+
+uint vertexIndex(uvec2 position) {
+    return position.y * pushConsts.terrainDimension + position.x;
+}
+
+vec2 nodePosition(vec2 gridPosition) {
+    float last = float(pushConsts.terrainDimension - 1);
+    return min(vec2(pushConsts.nodeOrigin) + gridPosition * float(pushConsts.nodeScale), vec2(last));
+}
+
+void main() {
+    vec2 gridPosition = vec2(inChunkPosition);
+
+    vec2 position = nodePosition(gridPosition);
+    vec3 unmorphed = vec3(position.x, heightmap.heights[vertexIndex(uvec2(position))], position.y);
+
+    float distance = length(unmorphed - pushConsts.cameraPosition);
+    float morph = clamp((distance - pushConsts.morphRange.x) / max(pushConsts.morphRange.y - pushConsts.morphRange.x, 0.001), 0.0, 1.0);
+
+    // Odd grid vertices slide onto even ones, at full morph the node matches
+    // the grid of the next coarser level
+    position = nodePosition(gridPosition - mod(gridPosition, 2.0) * morph);
+
+    uvec2 base = uvec2(floor(position));
+    uvec2 next = min(base + 1, uvec2(pushConsts.terrainDimension - 1));
+    vec2 weight = fract(position);
+
+    uint i00 = vertexIndex(base);
+    uint i10 = vertexIndex(uvec2(next.x, base.y));
+    uint i01 = vertexIndex(uvec2(base.x, next.y));
+    uint i11 = vertexIndex(next);
+
+    float height = mix(mix(heightmap.heights[i00], heightmap.heights[i10], weight.x),
+        mix(heightmap.heights[i01], heightmap.heights[i11], weight.x),
+        weight.y);
+    vec3 norm = mix(mix(normal.normals[i00].xyz, normal.normals[i10].xyz, weight.x),
+        mix(normal.normals[i01].xyz, normal.normals[i11].xyz, weight.x),
+        weight.y);
+
+    vec3 localPosition = vec3(position.x, height, position.y);
+    gl_Position = camera.projection * camera.view * vec4(pushConsts.origin + localPosition, 1.0);
+
+    outFragPosition = localPosition;
+    outNormal = norm;
+    outGlobalUV = position / float(pushConsts.terrainDimension);
+    outUV = position / float(pushConsts.chunkDimension - 1);
+}
@@ -0,0 +1,39 @@
+#version 460
+
+layout(location = 0) in uvec2 inChunkPosition;
+
+layout(push_constant) uniform PushConsts {
+    uint lod;
+    uint chunk;
+    uint chunkDimension;
+    uint terrainDimension;
+    uint chunksPerDimension;
+    float edgePixels;
+    float viewportHeight;
+} pushConsts;
+
+struct Chunk {
+    mat4 model;
+};
+
+layout(std140, binding = 1) readonly buffer ChunkBuffer {
+    Chunk chunks[];
+} chunks;
+
+layout(std430, binding = 2) readonly buffer Heightmap {
+    float heights[];
+} heightmap;
+
+layout(location = 0) out vec2 outChunkPosition;
+layout(location = 1) out vec3 outWorldPosition;
+
+void main() {
+    uint chunkY = pushConsts.chunk / pushConsts.chunksPerDimension;
+    uint chunkX = pushConsts.chunk % pushConsts.chunksPerDimension;
+    uvec2 globalPos = uvec2(chunkX * (pushConsts.chunkDimension - 1) + inChunkPosition.x, chunkY * (pushConsts.chunkDimension - 1) + inChunkPosition.y);
+
+    float height = heightmap.heights[globalPos.y * pushConsts.terrainDimension + globalPos.x];
+
+    outChunkPosition = vec2(inChunkPosition);
+    outWorldPosition = (chunks.chunks[pushConsts.chunk].model * vec4(inChunkPosition.x, height, inChunkPosition.y, 1.0)).xyz;
+}
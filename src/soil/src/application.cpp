@@ -1,11 +1,15 @@
 #include <application.hpp>
 
+#include <body_renderer.hpp>
+#include <bullet_adapter.hpp>
 #include <bullet_debug_renderer.hpp>
 #include <free_camera_controller.hpp>
 #include <heightmap.hpp>
 #include <mouse_controller.hpp>
+#include <noise.hpp>
 #include <perspective_camera.hpp>
 #include <physics_engine.hpp>
+#include <procedural_heightmap.hpp>
 #include <terrain.hpp>
 
 #include <cppext_numeric.hpp>
@@ -18,15 +22,37 @@
 #include <vulkan_image.hpp>
 #include <vulkan_renderer.hpp>
 
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
+#include <BulletCollision/CollisionShapes/btSphereShape.h>
+#include <LinearMath/btQuaternion.h>
+#include <LinearMath/btTransform.h>
+#include <LinearMath/btVector3.h>
+
+#include <imgui.h>
+
+#include <glm/vec3.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <SDL2/SDL_scancode.h>
 #include <SDL_events.h>
 #include <SDL_video.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 
 // IWYU pragma: no_include <BulletCollision/CollisionShapes/btConcaveShape.h>
 // IWYU pragma: no_include <glm/detail/qualifier.hpp>
 
-soil::application::application(bool const debug)
+soil::application::application(bool const debug,
+    bool const procedural,
+    bool const render_thread,
+    bool const physics_thread,
+    uint32_t const spawn_count)
     : niku::application(niku::startup_params{
           .init_subsystems = {.video = true, .audio = false, .debug = debug},
           .title = "soil",
@@ -38,10 +64,19 @@ soil::application::application(bool const debug)
     , mouse_{!debug}
     , camera_controller_{&camera_, &mouse_}
     , mouse_controller_{&mouse_, &camera_, &physics_}
+    , procedural_{procedural}
+    , physics_thread_{physics_thread}
+    , spawn_on_startup_{spawn_count > 0}
 {
+    if (spawn_on_startup_)
+    {
+        spawn_count_ = cppext::narrow<int>(spawn_count);
+    }
+
     vulkan_renderer()->imgui_layer(true);
 
     fixed_update_interval(1.0f / 60.0f);
+    this->render_thread(render_thread);
 
     camera_.resize({512, 512});
     camera_.set_position({-512.0f, 200.0f, 512.0f});
@@ -58,6 +93,19 @@ bool soil::application::handle_event(SDL_Event const& event)
     camera_controller_.handle_event(event);
     mouse_controller_.handle_event(event);
 
+    if (event.type == SDL_KEYDOWN)
+    {
+        auto const& keyboard{event.key};
+        if (keyboard.keysym.scancode == SDL_SCANCODE_F5)
+        {
+            spawn_requested_ = true;
+        }
+        else if (keyboard.keysym.scancode == SDL_SCANCODE_F6)
+        {
+            clear_requested_ = true;
+        }
+    }
+
     return true;
 }
 
@@ -70,10 +118,29 @@ void soil::application::update(float const delta_time)
 {
     camera_controller_.update(delta_time);
 
-    terrain_->update(camera_, delta_time);
+    if (clear_requested_.exchange(false))
+    {
+        clear_bodies();
+    }
+    if (spawn_requested_.exchange(false))
+    {
+        spawn_bodies();
+    }
+
+    physics_.update(camera_.position(), interpolation_alpha());
+
+    update_delta_ = delta_time;
+}
+
+void soil::application::publish_frame()
+{
+    // Terrain uploads chunks and updates per frame buffers read by the
+    // render thread, it can't overlap with rendering
+    terrain_->update(camera_, update_delta_);
+
+    physics_.debug_renderer()->update(camera_, update_delta_);
 
-    physics_.update(camera_.position());
-    physics_.debug_renderer()->update(camera_, delta_time);
+    body_renderer_->update(camera_, physics_.body_transforms());
 }
 
 vkrndr::scene* soil::application::render_scene() { return this; }
@@ -81,7 +148,29 @@ vkrndr::scene* soil::application::render_scene() { return this; }
 void soil::application::on_startup()
 {
     physics_.set_gravity({0.0f, -9.81f, 0.0f});
+    if (physics_thread_)
+    {
+        physics_.start_thread(fixed_update_interval());
+    }
     // Add heightfield
+    if (procedural_)
+    {
+        procedural_heightmap_ = std::make_unique<procedural_heightmap>(
+            noise_settings{.scale = 256.0f,
+                .octaves = 6,
+                .warp_strength = 0.5f},
+            65,
+            512);
+
+        terrain_ = std::make_unique<terrain>(procedural_heightmap_.get(),
+            16,
+            &physics_,
+            this->vulkan_device(),
+            this->vulkan_renderer(),
+            &color_image_,
+            &depth_buffer_);
+    }
+    else
     {
         heightmap_ = std::make_unique<heightmap>("heightmap.png");
 
@@ -97,11 +186,27 @@ void soil::application::on_startup()
         this->vulkan_renderer(),
         &color_image_,
         &depth_buffer_);
+
+    body_renderer_ = std::make_unique<body_renderer>(this->vulkan_device(),
+        this->vulkan_renderer(),
+        &color_image_,
+        &depth_buffer_);
+
+    if (spawn_on_startup_)
+    {
+        spawn_bodies();
+    }
 }
 
 void soil::application::on_shutdown()
 {
+    physics_.stop_thread();
+
+    clear_bodies();
+    body_renderer_.reset();
+
     terrain_.reset();
+    procedural_heightmap_.reset();
 
     physics_.detach_renderer(this->vulkan_device(), this->vulkan_renderer());
 
@@ -124,8 +229,11 @@ void soil::application::resize(VkExtent2D extent)
         VK_IMAGE_ASPECT_COLOR_BIT);
 
     destroy(this->vulkan_device(), &depth_buffer_);
-    depth_buffer_ =
-        vkrndr::create_depth_buffer(this->vulkan_device(), extent, false);
+    // Sampled when building the occlusion depth pyramid
+    depth_buffer_ = vkrndr::create_depth_buffer(this->vulkan_device(),
+        extent,
+        false,
+        VK_IMAGE_USAGE_SAMPLED_BIT);
 }
 
 void soil::application::draw(VkImageView target_image,
@@ -144,11 +252,119 @@ void soil::application::draw(VkImageView target_image,
     vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 
     terrain_->draw(target_image, command_buffer, scissor);
+    body_renderer_->draw(target_image, command_buffer, scissor);
     physics_.debug_renderer()->draw(target_image, command_buffer, scissor);
 }
 
 void soil::application::draw_imgui()
 {
     terrain_->draw_imgui();
-    physics_.debug_renderer()->draw_imgui();
+    physics_.draw_imgui();
+
+    ImGui::Begin("Body spawner");
+    if (int count{spawn_count_}; ImGui::SliderInt("Count", &count, 1, 20000))
+    {
+        spawn_count_ = count;
+    }
+    if (bool spheres{spawn_spheres_}; ImGui::Checkbox("Spheres", &spheres))
+    {
+        spawn_spheres_ = spheres;
+    }
+    if (ImGui::Button("Spawn (F5)"))
+    {
+        spawn_requested_ = true;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear (F6)"))
+    {
+        clear_requested_ = true;
+    }
+    ImGui::Text("Spawned bodies: %zu", spawned_body_count_.load());
+    ImGui::End();
+}
+
+void soil::application::spawn_bodies()
+{
+    constexpr float spacing{2.0f};
+    constexpr float drop_height{10.0f};
+    constexpr float half_extent{0.5f};
+
+    // Terrain creates colliders under the ray when the frame is published,
+    // a missed ray is cast again on next update. The lattice starts above
+    // the first hit.
+    glm::vec3 const& camera_position{camera_.position()};
+    auto const& [ground, hit] = physics_.raycast(camera_position,
+        camera_position - glm::vec3{0.0f, 10000.0f, 0.0f});
+    if (!ground && !spawn_retried_)
+    {
+        spawn_retried_ = true;
+        spawn_requested_ = true;
+        return;
+    }
+    spawn_retried_ = false;
+    glm::vec3 const base{ground ? hit : camera_position};
+
+    // Bodies which the renderer can't draw aren't spawned
+    auto const requested{cppext::narrow<size_t>(spawn_count_.load())};
+    size_t const available{body_renderer_->capacity() -
+        std::min(body_renderer_->body_count(), body_renderer_->capacity())};
+    size_t const count{std::min(requested, available)};
+    if (count != requested)
+    {
+        spdlog::warn("Spawning {} of {} bodies, at most {} bodies are drawn",
+            count,
+            requested,
+            body_renderer_->capacity());
+    }
+    bool const spheres{spawn_spheres_};
+    auto const side{static_cast<size_t>(
+        std::ceil(std::cbrt(cppext::as_fp<double>(count))))};
+    float const center_offset{cppext::as_fp(side - 1) * spacing / 2.0f};
+
+    spawned_bodies_.reserve(spawned_bodies_.size() + count);
+    for (size_t i{}; i != count; ++i)
+    {
+        btVector3 const offset{
+            cppext::as_fp(i % side) * spacing - center_offset,
+            cppext::as_fp(i / (side * side)) * spacing + drop_height,
+            cppext::as_fp((i / side) % side) * spacing - center_offset};
+
+        // Same orientations on every run so that benchmarks are comparable
+        auto const angle{cppext::as_fp(i % 16) * 0.4f};
+        btTransform const transform{btQuaternion{angle, angle * 0.5f, 0.0f},
+            to_bullet(base) + offset};
+
+        if (spheres)
+        {
+            btRigidBody* const body{physics_.add_rigid_body(
+                std::make_unique<btSphereShape>(half_extent),
+                1.0f,
+                transform)};
+            body_renderer_->add_sphere(body, half_extent);
+            spawned_bodies_.push_back(body);
+        }
+        else
+        {
+            btRigidBody* const body{physics_.add_rigid_body(
+                std::make_unique<btBoxShape>(btVector3{half_extent,
+                    half_extent,
+                    half_extent}),
+                1.0f,
+                transform)};
+            body_renderer_->add_box(body, glm::vec3{half_extent});
+            spawned_bodies_.push_back(body);
+        }
+    }
+    spawned_body_count_ = spawned_bodies_.size();
+}
+
+void soil::application::clear_bodies()
+{
+    for (btRigidBody* const body : spawned_bodies_)
+    {
+        body_renderer_->remove_body(body);
+        physics_.remove_rigid_body(body);
+    }
+    spawned_bodies_.clear();
+    spawned_body_count_ = 0;
 }
@@ -16,11 +16,19 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <vector>
+
+class btRigidBody;
 
 namespace soil
 {
+    class body_renderer;
     class heightmap;
+    class procedural_heightmap;
     class terrain;
 } // namespace soil
 
@@ -31,7 +39,11 @@ namespace soil
         , private vkrndr::scene
     {
     public:
-        explicit application(bool debug);
+        application(bool debug,
+            bool procedural,
+            bool render_thread,
+            bool physics_thread,
+            uint32_t spawn_count);
 
         application(application const&) = delete;
 
@@ -54,6 +66,8 @@ namespace soil
 
         void update(float delta_time) override;
 
+        void publish_frame() override;
+
         [[nodiscard]] vkrndr::scene* render_scene() override;
 
         void on_startup() override;
@@ -69,6 +83,13 @@ namespace soil
 
         void draw_imgui() override;
 
+    private:
+        // Drops spawn_count_ bodies in a lattice above the terrain below
+        // the camera
+        void spawn_bodies();
+
+        void clear_bodies();
+
     private:
         physics_engine physics_;
         perspective_camera camera_;
@@ -77,9 +98,27 @@ namespace soil
         free_camera_controller camera_controller_;
         mouse_controller mouse_controller_;
 
+        float update_delta_{};
+
+        bool procedural_;
+        bool physics_thread_;
         std::unique_ptr<heightmap> heightmap_;
+        std::unique_ptr<procedural_heightmap> procedural_heightmap_;
         std::unique_ptr<terrain> terrain_;
 
+        std::unique_ptr<body_renderer> body_renderer_;
+        std::vector<btRigidBody*> spawned_bodies_;
+        bool spawn_on_startup_;
+        bool spawn_retried_{};
+
+        // Edited and requested from the debug window, bodies are spawned
+        // and cleared on next update
+        std::atomic<int> spawn_count_{1000};
+        std::atomic_bool spawn_spheres_{};
+        std::atomic_bool spawn_requested_{};
+        std::atomic_bool clear_requested_{};
+        std::atomic<size_t> spawned_body_count_{};
+
         vkrndr::vulkan_image color_image_;
         vkrndr::vulkan_image depth_buffer_;
     };
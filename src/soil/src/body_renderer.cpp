@@ -0,0 +1,435 @@
+#include <body_renderer.hpp>
+
+#include <physics_engine.hpp>
+
+#include <cppext_cycled_buffer.hpp>
+#include <cppext_numeric.hpp>
+
+#include <vkrndr_camera.hpp>
+#include <vkrndr_render_pass.hpp>
+#include <vulkan_buffer.hpp>
+#include <vulkan_descriptors.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_memory.hpp>
+#include <vulkan_pipeline.hpp>
+#include <vulkan_renderer.hpp>
+#include <vulkan_utility.hpp>
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+// IWYU pragma: no_include <filesystem>
+
+namespace
+{
+    constexpr uint32_t max_instance_count{65536};
+
+    // Quads along each edge of a cube face, enough for a round sphere
+    constexpr uint32_t face_segments{8};
+
+    struct [[nodiscard]] vertex final
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+    };
+
+    struct [[nodiscard]] instance final
+    {
+        glm::vec4 rotation;
+        glm::vec3 position;
+        float sphere;
+        glm::vec3 half_extents;
+    };
+
+    struct [[nodiscard]] camera_uniform final
+    {
+        glm::mat4 view;
+        glm::mat4 projection;
+    };
+
+    consteval auto binding_description()
+    {
+        constexpr std::array descriptions{
+            VkVertexInputBindingDescription{.binding = 0,
+                .stride = sizeof(vertex),
+                .inputRate = VK_VERTEX_INPUT_RATE_VERTEX},
+            VkVertexInputBindingDescription{.binding = 1,
+                .stride = sizeof(instance),
+                .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE}};
+
+        return descriptions;
+    }
+
+    consteval auto attribute_descriptions()
+    {
+        constexpr std::array descriptions{
+            VkVertexInputAttributeDescription{.location = 0,
+                .binding = 0,
+                .format = VK_FORMAT_R32G32B32_SFLOAT,
+                .offset = offsetof(vertex, position)},
+            VkVertexInputAttributeDescription{.location = 1,
+                .binding = 0,
+                .format = VK_FORMAT_R32G32B32_SFLOAT,
+                .offset = offsetof(vertex, normal)},
+            VkVertexInputAttributeDescription{.location = 2,
+                .binding = 1,
+                .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+                .offset = offsetof(instance, rotation)},
+            VkVertexInputAttributeDescription{.location = 3,
+                .binding = 1,
+                .format = VK_FORMAT_R32G32B32_SFLOAT,
+                .offset = offsetof(instance, position)},
+            VkVertexInputAttributeDescription{.location = 4,
+                .binding = 1,
+                .format = VK_FORMAT_R32_SFLOAT,
+                .offset = offsetof(instance, sphere)},
+            VkVertexInputAttributeDescription{.location = 5,
+                .binding = 1,
+                .format = VK_FORMAT_R32G32B32_SFLOAT,
+                .offset = offsetof(instance, half_extents)},
+        };
+
+        return descriptions;
+    }
+
+    [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(
+        vkrndr::vulkan_device const* const device)
+    {
+        VkDescriptorSetLayoutBinding vertex_uniform_binding{};
+        vertex_uniform_binding.binding = 0;
+        vertex_uniform_binding.descriptorType =
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        vertex_uniform_binding.descriptorCount = 1;
+        vertex_uniform_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        std::array const bindings{vertex_uniform_binding};
+
+        VkDescriptorSetLayoutCreateInfo layout_info{};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.bindingCount = vkrndr::count_cast(bindings.size());
+        layout_info.pBindings = bindings.data();
+
+        VkDescriptorSetLayout rv; // NOLINT
+        vkrndr::check_result(vkCreateDescriptorSetLayout(device->logical,
+            &layout_info,
+            nullptr,
+            &rv));
+
+        return rv;
+    }
+
+    void bind_descriptor_set(vkrndr::vulkan_device const* const device,
+        VkDescriptorSet const& descriptor_set,
+        VkDescriptorBufferInfo const vertex_uniform_info)
+    {
+        VkWriteDescriptorSet vertex_uniform_write{};
+        vertex_uniform_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        vertex_uniform_write.dstSet = descriptor_set;
+        vertex_uniform_write.dstBinding = 0;
+        vertex_uniform_write.dstArrayElement = 0;
+        vertex_uniform_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        vertex_uniform_write.descriptorCount = 1;
+        vertex_uniform_write.pBufferInfo = &vertex_uniform_info;
+
+        std::array const descriptor_writes{vertex_uniform_write};
+
+        vkUpdateDescriptorSets(device->logical,
+            vkrndr::count_cast(descriptor_writes.size()),
+            descriptor_writes.data(),
+            0,
+            nullptr);
+    }
+
+    // Cube from -1 to 1 with subdivided faces, each face has its own
+    // vertices so that boxes are flat shaded
+    void generate_cube(std::vector<vertex>& vertices,
+        std::vector<uint32_t>& indices)
+    {
+        // Outward normal and first tangent of each face
+        std::array<std::pair<glm::vec3, glm::vec3>, 6> const faces{
+            std::pair{glm::vec3{1, 0, 0}, glm::vec3{0, 1, 0}},
+            std::pair{glm::vec3{-1, 0, 0}, glm::vec3{0, 0, 1}},
+            std::pair{glm::vec3{0, 1, 0}, glm::vec3{0, 0, 1}},
+            std::pair{glm::vec3{0, -1, 0}, glm::vec3{1, 0, 0}},
+            std::pair{glm::vec3{0, 0, 1}, glm::vec3{1, 0, 0}},
+            std::pair{glm::vec3{0, 0, -1}, glm::vec3{0, 1, 0}}};
+
+        constexpr uint32_t face_vertices{face_segments + 1};
+        float const step{2.0f / cppext::as_fp(face_segments)};
+        for (auto const& [normal, u] : faces)
+        {
+            glm::vec3 const v{glm::cross(normal, u)};
+
+            auto const base_vertex{cppext::narrow<uint32_t>(vertices.size())};
+            for (uint32_t j{}; j != face_vertices; ++j)
+            {
+                for (uint32_t i{}; i != face_vertices; ++i)
+                {
+                    float const s{cppext::as_fp(i) * step - 1.0f};
+                    float const t{cppext::as_fp(j) * step - 1.0f};
+                    vertices.push_back({normal + u * s + v * t, normal});
+                }
+            }
+
+            for (uint32_t j{}; j != face_segments; ++j)
+            {
+                for (uint32_t i{}; i != face_segments; ++i)
+                {
+                    uint32_t const corner{base_vertex + j * face_vertices + i};
+                    indices.push_back(corner);
+                    indices.push_back(corner + 1);
+                    indices.push_back(corner + face_vertices);
+                    indices.push_back(corner + face_vertices);
+                    indices.push_back(corner + 1);
+                    indices.push_back(corner + face_vertices + 1);
+                }
+            }
+        }
+    }
+} // namespace
+
+soil::body_renderer::body_renderer(vkrndr::vulkan_device* const device,
+    vkrndr::vulkan_renderer* const renderer,
+    vkrndr::vulkan_image* const color_image,
+    vkrndr::vulkan_image* const depth_buffer)
+    : device_{device}
+    , renderer_{renderer}
+    , color_image_{color_image}
+    , depth_buffer_{depth_buffer}
+    , descriptor_set_layout_{create_descriptor_set_layout(device_)}
+{
+    std::vector<vertex> vertices;
+    std::vector<uint32_t> indices;
+    generate_cube(vertices, indices);
+    index_count_ = cppext::narrow<uint32_t>(indices.size());
+
+    auto const upload = [this](std::span<std::byte const> const data,
+                            VkBufferUsageFlags const usage)
+    {
+        vkrndr::vulkan_buffer staging_buffer{vkrndr::create_buffer(device_,
+            data.size(),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)};
+
+        vkrndr::mapped_memory staging_map{
+            vkrndr::map_memory(device_, staging_buffer.allocation)};
+        std::ranges::copy(data, staging_map.as<std::byte>());
+        unmap_memory(device_, &staging_map);
+
+        vkrndr::vulkan_buffer rv{create_buffer(device_,
+            data.size(),
+            usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)};
+        renderer_->transfer_buffer(staging_buffer, rv);
+
+        destroy(device_, &staging_buffer);
+
+        return rv;
+    };
+
+    vertex_buffer_ = upload(std::as_bytes(std::span{vertices}),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    index_buffer_ = upload(std::as_bytes(std::span{indices}),
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+    pipeline_ = std::make_unique<vkrndr::vulkan_pipeline>(
+        vkrndr::vulkan_pipeline_builder{device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(descriptor_set_layout_)
+                .build(),
+            renderer->image_format()}
+            .add_shader(VK_SHADER_STAGE_VERTEX_BIT, "body.vert.spv", "main")
+            .add_shader(VK_SHADER_STAGE_FRAGMENT_BIT, "body.frag.spv", "main")
+            .with_primitive_topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+            .with_rasterization_samples(device_->max_msaa_samples)
+            .add_vertex_input(binding_description(), attribute_descriptions())
+            .with_depth_test(depth_buffer_->format)
+            .build());
+
+    frame_data_ =
+        cppext::cycled_buffer<frame_resources>{renderer->image_count(),
+            renderer->image_count()};
+    for (auto& data : frame_data_.as_span())
+    {
+        // Written directly by update each frame, without staging
+        auto const instance_buffer_size{max_instance_count * sizeof(instance)};
+        data.instance_buffer = vkrndr::create_buffer(device_,
+            instance_buffer_size,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        data.instance_map =
+            vkrndr::map_memory(device_, data.instance_buffer.allocation);
+
+        auto const uniform_buffer_size{sizeof(camera_uniform)};
+        data.vertex_uniform = create_buffer(device_,
+            uniform_buffer_size,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        data.uniform_map =
+            vkrndr::map_memory(device_, data.vertex_uniform.allocation);
+
+        create_descriptor_sets(device_,
+            descriptor_set_layout_,
+            renderer->descriptor_pool(),
+            std::span{&data.descriptor_set, 1});
+
+        bind_descriptor_set(device_,
+            data.descriptor_set,
+            VkDescriptorBufferInfo{.buffer = data.vertex_uniform.buffer,
+                .offset = 0,
+                .range = uniform_buffer_size});
+    }
+}
+
+soil::body_renderer::~body_renderer()
+{
+    for (auto& data : frame_data_.as_span())
+    {
+        vkFreeDescriptorSets(device_->logical,
+            renderer_->descriptor_pool(),
+            1,
+            &data.descriptor_set);
+
+        unmap_memory(device_, &data.uniform_map);
+        destroy(device_, &data.vertex_uniform);
+
+        unmap_memory(device_, &data.instance_map);
+        destroy(device_, &data.instance_buffer);
+    }
+
+    destroy(device_, pipeline_.get());
+    pipeline_ = nullptr;
+
+    vkDestroyDescriptorSetLayout(device_->logical,
+        descriptor_set_layout_,
+        nullptr);
+
+    destroy(device_, &index_buffer_);
+    destroy(device_, &vertex_buffer_);
+}
+
+void soil::body_renderer::add_box(btRigidBody const* const body,
+    glm::vec3 const& half_extents)
+{
+    bodies_.insert_or_assign(body,
+        body_shape{.half_extents = half_extents, .sphere = false});
+}
+
+void soil::body_renderer::add_sphere(btRigidBody const* const body,
+    float const radius)
+{
+    bodies_.insert_or_assign(body,
+        body_shape{.half_extents = glm::vec3{radius}, .sphere = true});
+}
+
+void soil::body_renderer::remove_body(btRigidBody const* const body)
+{
+    bodies_.erase(body);
+}
+
+size_t soil::body_renderer::body_count() const { return bodies_.size(); }
+
+size_t soil::body_renderer::capacity() const { return max_instance_count; }
+
+void soil::body_renderer::update(vkrndr::camera const& camera,
+    std::span<body_transform const> const transforms)
+{
+    *frame_data_->uniform_map.as<camera_uniform>() = {
+        .view = camera.view_matrix(),
+        .projection = camera.projection_matrix()};
+
+    auto* const instances{frame_data_->instance_map.as<instance>()};
+    uint32_t instance_count{};
+    for (body_transform const& transform : transforms)
+    {
+        if (instance_count == max_instance_count)
+        {
+            break;
+        }
+
+        auto const it{bodies_.find(transform.body)};
+        if (it == bodies_.cend())
+        {
+            continue;
+        }
+
+        glm::quat const& rotation{transform.rotation};
+        instances[instance_count] = {
+            .rotation = {rotation.x, rotation.y, rotation.z, rotation.w},
+            .position = transform.position,
+            .sphere = it->second.sphere ? 1.0f : 0.0f,
+            .half_extents = it->second.half_extents};
+        ++instance_count;
+    }
+    frame_data_->instance_count = instance_count;
+}
+
+void soil::body_renderer::draw(VkImageView target_image,
+    VkCommandBuffer command_buffer,
+    VkRect2D const render_area)
+{
+    if (frame_data_->instance_count > 0)
+    {
+        vkrndr::render_pass render_pass;
+
+        render_pass.with_color_attachment(VK_ATTACHMENT_LOAD_OP_LOAD,
+            VK_ATTACHMENT_STORE_OP_STORE,
+            target_image,
+            std::nullopt,
+            color_image_->view);
+        render_pass.with_depth_attachment(VK_ATTACHMENT_LOAD_OP_LOAD,
+            VK_ATTACHMENT_STORE_OP_STORE,
+            depth_buffer_->view);
+
+        {
+            // cppcheck-suppress unreadVariable
+            auto const guard{render_pass.begin(command_buffer, render_area)};
+
+            std::array const vertex_buffers{vertex_buffer_.buffer,
+                frame_data_->instance_buffer.buffer};
+            std::array<VkDeviceSize, 2> const offsets{0, 0};
+            vkCmdBindVertexBuffers(command_buffer,
+                0,
+                vkrndr::count_cast(vertex_buffers.size()),
+                vertex_buffers.data(),
+                offsets.data());
+            vkCmdBindIndexBuffer(command_buffer,
+                index_buffer_.buffer,
+                0,
+                VK_INDEX_TYPE_UINT32);
+
+            vkrndr::bind_pipeline(command_buffer,
+                *pipeline_,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                0,
+                std::span<VkDescriptorSet const>{&frame_data_->descriptor_set,
+                    1});
+
+            vkCmdDrawIndexed(command_buffer,
+                index_count_,
+                frame_data_->instance_count,
+                0,
+                0,
+                0);
+        }
+    }
+
+    frame_data_.cycle([](auto const&, auto& next) { next.instance_count = 0; });
+}
@@ -0,0 +1,118 @@
+#ifndef SOIL_BODY_RENDERER_INCLUDED
+#define SOIL_BODY_RENDERER_INCLUDED
+
+#include <cppext_cycled_buffer.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_memory.hpp>
+
+#include <glm/vec3.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+
+class btRigidBody;
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    struct vulkan_image;
+    struct vulkan_pipeline;
+    class vulkan_renderer;
+    class camera;
+} // namespace vkrndr
+
+namespace soil
+{
+    struct body_transform;
+} // namespace soil
+
+namespace soil
+{
+    // Draws boxes and spheres of registered bodies with a single instanced
+    // draw call
+    class [[nodiscard]] body_renderer final
+    {
+    public:
+        body_renderer(vkrndr::vulkan_device* device,
+            vkrndr::vulkan_renderer* renderer,
+            vkrndr::vulkan_image* color_image,
+            vkrndr::vulkan_image* depth_buffer);
+
+        body_renderer(body_renderer const&) = delete;
+
+        body_renderer(body_renderer&&) noexcept = delete;
+
+    public:
+        ~body_renderer();
+
+    public:
+        void add_box(btRigidBody const* body, glm::vec3 const& half_extents);
+
+        void add_sphere(btRigidBody const* body, float radius);
+
+        void remove_body(btRigidBody const* body);
+
+        [[nodiscard]] size_t body_count() const;
+
+        // Bodies beyond capacity are not drawn
+        [[nodiscard]] size_t capacity() const;
+
+        // Writes instances of registered bodies among the transforms, bodies
+        // are only compared and never dereferenced
+        void update(vkrndr::camera const& camera,
+            std::span<body_transform const> transforms);
+
+        void draw(VkImageView target_image,
+            VkCommandBuffer command_buffer,
+            VkRect2D render_area);
+
+    public:
+        body_renderer& operator=(body_renderer const&) = delete;
+
+        body_renderer& operator=(body_renderer&&) noexcept = delete;
+
+    private:
+        struct [[nodiscard]] body_shape final
+        {
+            glm::vec3 half_extents;
+            bool sphere;
+        };
+
+        struct [[nodiscard]] frame_resources final
+        {
+            // Mapped for the lifetime of the renderer
+            vkrndr::vulkan_buffer instance_buffer;
+            vkrndr::mapped_memory instance_map{};
+            uint32_t instance_count{};
+
+            vkrndr::vulkan_buffer vertex_uniform;
+            vkrndr::mapped_memory uniform_map{};
+            VkDescriptorSet descriptor_set{VK_NULL_HANDLE};
+        };
+
+    private:
+        vkrndr::vulkan_device* device_;
+        vkrndr::vulkan_renderer* renderer_;
+        vkrndr::vulkan_image* color_image_;
+        vkrndr::vulkan_image* depth_buffer_;
+
+        std::unordered_map<btRigidBody const*, body_shape> bodies_;
+
+        vkrndr::vulkan_buffer vertex_buffer_;
+        vkrndr::vulkan_buffer index_buffer_;
+        uint32_t index_count_{};
+
+        VkDescriptorSetLayout descriptor_set_layout_{VK_NULL_HANDLE};
+        std::unique_ptr<vkrndr::vulkan_pipeline> pipeline_;
+
+        cppext::cycled_buffer<frame_resources> frame_data_;
+    };
+} // namespace soil
+
+#endif
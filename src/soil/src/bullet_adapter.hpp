@@ -1,10 +1,12 @@
 #ifndef BULLET_ADAPTER_INCLUDED
 #define BULLET_ADAPTER_INCLUDED
 
+#include <LinearMath/btQuaternion.h>
 #include <LinearMath/btVector3.h>
 
 #include <fmt/base.h>
 
+#include <glm/gtc/quaternion.hpp>
 #include <glm/vec3.hpp>
 
 namespace soil
@@ -18,6 +20,11 @@ namespace soil
     {
         return {vec.x(), vec.y(), vec.z()};
     }
+
+    [[nodiscard]] inline glm::quat from_bullet(btQuaternion const& quat)
+    {
+        return {quat.w(), quat.x(), quat.y(), quat.z()};
+    }
 } // namespace soil
 
 template<>
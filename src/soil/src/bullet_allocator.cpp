@@ -0,0 +1,172 @@
+#include <bullet_allocator.hpp>
+
+#include <LinearMath/btAlignedAllocator.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+namespace
+{
+    // Size of the allocation is stored in front of it, keeps the returned
+    // memory aligned like malloc
+    constexpr size_t header_size{16};
+
+    constexpr size_t size_class_step{32};
+    constexpr size_t size_class_count{16};
+    constexpr size_t max_pooled_size{size_class_step * size_class_count};
+    constexpr size_t block_size{64 * 1024};
+
+    struct [[nodiscard]] free_node final
+    {
+        free_node* next;
+    };
+
+    struct [[nodiscard]] size_class final
+    {
+        std::mutex mutex;
+        free_node* free{};
+    };
+
+    struct [[nodiscard]] allocator_state final
+    {
+        std::array<size_class, size_class_count> size_classes;
+
+        std::atomic<size_t> bytes;
+        std::atomic<size_t> peak_bytes;
+        std::atomic<size_t> allocations;
+        std::atomic<size_t> total_allocations;
+        std::atomic<size_t> pooled_bytes;
+    };
+
+    // Bullet may free memory during static destruction, state is never
+    // destroyed
+    [[nodiscard]] allocator_state& state()
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+        static auto* const rv{new allocator_state};
+        return *rv;
+    }
+
+    [[nodiscard]] void* pop(size_t const index)
+    {
+        size_class& pool{state().size_classes[index]};
+        std::lock_guard const lock{pool.mutex};
+
+        if (!pool.free)
+        {
+            // Blocks are carved into nodes of a single size class and kept
+            // for the lifetime of the process
+            void* const block{std::malloc(block_size)}; // NOLINT
+            if (!block)
+            {
+                return nullptr;
+            }
+            state().pooled_bytes.fetch_add(block_size,
+                std::memory_order_relaxed);
+
+            size_t const node_size{(index + 1) * size_class_step};
+            auto* const bytes{static_cast<std::byte*>(block)};
+            for (size_t offset{}; offset + node_size <= block_size;
+                offset += node_size)
+            {
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                auto* const node{::new (bytes + offset) free_node{pool.free}};
+                pool.free = node;
+            }
+        }
+
+        free_node* const rv{pool.free};
+        pool.free = rv->next;
+        return rv;
+    }
+
+    void push(size_t const index, void* const memory)
+    {
+        size_class& pool{state().size_classes[index]};
+        std::lock_guard const lock{pool.mutex};
+
+        pool.free = ::new (memory) free_node{pool.free};
+    }
+
+    void* allocate(size_t const size)
+    {
+        size_t const total{size + header_size};
+
+        void* const memory{total <= max_pooled_size
+                ? pop((total - 1) / size_class_step)
+                : std::malloc(total)}; // NOLINT
+        if (!memory)
+        {
+            return nullptr;
+        }
+        *static_cast<size_t*>(memory) = size;
+
+        allocator_state& s{state()};
+        size_t const bytes{
+            s.bytes.fetch_add(size, std::memory_order_relaxed) + size};
+        size_t peak{s.peak_bytes.load(std::memory_order_relaxed)};
+        while (bytes > peak &&
+            !s.peak_bytes.compare_exchange_weak(peak,
+                bytes,
+                std::memory_order_relaxed))
+        {
+        }
+        s.allocations.fetch_add(1, std::memory_order_relaxed);
+        s.total_allocations.fetch_add(1, std::memory_order_relaxed);
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        return static_cast<std::byte*>(memory) + header_size;
+    }
+
+    void deallocate(void* const pointer)
+    {
+        if (!pointer)
+        {
+            return;
+        }
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        void* const memory{static_cast<std::byte*>(pointer) - header_size};
+        size_t const size{*static_cast<size_t*>(memory)};
+
+        allocator_state& s{state()};
+        s.bytes.fetch_sub(size, std::memory_order_relaxed);
+        s.allocations.fetch_sub(1, std::memory_order_relaxed);
+
+        if (size_t const total{size + header_size}; total <= max_pooled_size)
+        {
+            push((total - 1) / size_class_step, memory);
+        }
+        else
+        {
+            std::free(memory); // NOLINT
+        }
+    }
+} // namespace
+
+void soil::install_bullet_allocator()
+{
+    static std::once_flag installed;
+    std::call_once(installed,
+        []()
+        {
+            // Created before Bullet's first allocation
+            [[maybe_unused]] allocator_state const& s{state()};
+            btAlignedAllocSetCustom(allocate, deallocate);
+        });
+}
+
+soil::allocation_stats soil::bullet_allocation_stats()
+{
+    allocator_state const& s{state()};
+    return {.bytes = s.bytes.load(std::memory_order_relaxed),
+        .peak_bytes = s.peak_bytes.load(std::memory_order_relaxed),
+        .allocations = s.allocations.load(std::memory_order_relaxed),
+        .total_allocations =
+            s.total_allocations.load(std::memory_order_relaxed),
+        .pooled_bytes = s.pooled_bytes.load(std::memory_order_relaxed)};
+}
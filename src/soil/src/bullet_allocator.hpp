@@ -0,0 +1,26 @@
+#ifndef SOIL_BULLET_ALLOCATOR_INCLUDED
+#define SOIL_BULLET_ALLOCATOR_INCLUDED
+
+#include <cstddef>
+
+namespace soil
+{
+    struct [[nodiscard]] allocation_stats final
+    {
+        size_t bytes{};
+        size_t peak_bytes{};
+        size_t allocations{};
+        size_t total_allocations{};
+        // Held by size class free lists, never returned to the system
+        size_t pooled_bytes{};
+    };
+
+    // Routes Bullet's allocations through a tracked allocator which serves
+    // small sizes from free lists. Has to be called before anything is
+    // allocated by Bullet, later calls do nothing.
+    void install_bullet_allocator();
+
+    [[nodiscard]] allocation_stats bullet_allocation_stats();
+} // namespace soil
+
+#endif
@@ -29,8 +29,10 @@
 
 #include <array>
 #include <cstddef>
+#include <mutex>
 #include <optional>
 #include <ranges>
+#include <vector>
 
 // IWYU pragma: no_include <filesystem>
 // IWYU pragma: no_include <span>
@@ -232,26 +234,9 @@ void soil::bullet_debug_renderer::drawLine(btVector3 const& from,
     btVector3 const& to,
     btVector3 const& color)
 {
-    if (cull_geometry_)
-    {
-        if (from.distance(camera_position_) > cull_distance_ &&
-            to.distance(camera_position_) > cull_distance_)
-        {
-            return;
-        }
-    }
-
-    if (frame_data_->vertex_count < max_vertex_count)
-    {
-        auto* const vertices{frame_data_->vertex_map.as<vertex>()};
-
-        vertices[frame_data_->vertex_count] =
-            vertex{.position = from_bullet(from), .color = from_bullet(color)};
-        vertices[frame_data_->vertex_count + 1] =
-            vertex{.position = from_bullet(to), .color = from_bullet(color)};
-
-        frame_data_->vertex_count += 2;
-    }
+    // Collected while the previous frame may still be recorded, copied to
+    // the vertex buffer on update
+    pending_lines_.push_back({.from = from, .to = to, .color = color});
 }
 
 void soil::bullet_debug_renderer::drawContactPoint(btVector3 const& PointOnB,
@@ -284,12 +269,45 @@ void soil::bullet_debug_renderer::setDebugMode(int debugMode)
 
 int soil::bullet_debug_renderer::getDebugMode() const { return debug_mode_; }
 
+void soil::bullet_debug_renderer::publish_lines()
+{
+    std::lock_guard const lock{lines_mutex_};
+    std::swap(lines_, pending_lines_);
+    pending_lines_.clear();
+}
+
 void soil::bullet_debug_renderer::update(vkrndr::camera const& camera,
     [[maybe_unused]] float const delta_time)
 {
     *frame_data_->uniform_map.as<camera_uniform>() = {
         .view = camera.view_matrix(),
         .projection = camera.projection_matrix()};
+
+    std::lock_guard const lock{lines_mutex_};
+
+    auto* const vertices{frame_data_->vertex_map.as<vertex>()};
+    uint32_t vertex_count{};
+    for (line const& drawn : lines_)
+    {
+        if (vertex_count == max_vertex_count)
+        {
+            break;
+        }
+
+        if (cull_geometry_ &&
+            drawn.from.distance(camera_position_) > cull_distance_ &&
+            drawn.to.distance(camera_position_) > cull_distance_)
+        {
+            continue;
+        }
+
+        vertices[vertex_count] = vertex{.position = from_bullet(drawn.from),
+            .color = from_bullet(drawn.color)};
+        vertices[vertex_count + 1] = vertex{.position = from_bullet(drawn.to),
+            .color = from_bullet(drawn.color)};
+        vertex_count += 2;
+    }
+    frame_data_->vertex_count = vertex_count;
 }
 
 void soil::bullet_debug_renderer::draw(VkImageView target_image,
@@ -16,6 +16,8 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace vkrndr
 {
@@ -46,6 +48,11 @@ namespace soil
     public:
         void set_camera_position(glm::vec3 const& position);
 
+        // Makes lines drawn since the last call available to update, may be
+        // called from the thread drawing the world
+        void publish_lines();
+
+        // Copies the last published lines for rendering
         void update(vkrndr::camera const& camera, float delta_time);
 
         void draw(VkImageView target_image,
@@ -80,6 +87,13 @@ namespace soil
         bullet_debug_renderer& operator=(bullet_debug_renderer&&) = delete;
 
     private:
+        struct [[nodiscard]] line final
+        {
+            btVector3 from;
+            btVector3 to;
+            btVector3 color;
+        };
+
         struct [[nodiscard]] frame_resources final
         {
             vkrndr::vulkan_buffer vertex_buffer;
@@ -94,6 +108,9 @@ namespace soil
     private: // Physics data
         int debug_mode_{
             btIDebugDraw::DBG_DrawWireframe | btIDebugDraw::DBG_DrawAabb};
+        std::vector<line> pending_lines_;
+        std::mutex lines_mutex_;
+        std::vector<line> lines_;
 
     private: // Render data
         vkrndr::vulkan_device* device_;
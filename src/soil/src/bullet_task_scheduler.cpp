@@ -0,0 +1,94 @@
+#include <bullet_task_scheduler.hpp>
+
+#include <cppext_numeric.hpp>
+#include <cppext_thread_pool.hpp>
+
+#include <LinearMath/btScalar.h>
+#include <LinearMath/btThreads.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+#if !BT_THREADSAFE
+#error "Multithreaded Bullet world requires Bullet built with BT_THREADSAFE"
+#endif
+
+soil::bullet_task_scheduler::bullet_task_scheduler(
+    cppext::thread_pool* const pool)
+    : btITaskScheduler{"soil"}
+    , pool_{pool}
+    // Pool workers, the thread stepping the world and the main thread
+    , thread_count_{std::min(cppext::narrow<int>(pool->thread_count()) + 2,
+          BT_MAX_THREAD_COUNT)}
+{
+}
+
+int soil::bullet_task_scheduler::getMaxNumThreads() const
+{
+    return BT_MAX_THREAD_COUNT;
+}
+
+int soil::bullet_task_scheduler::getNumThreads() const
+{
+    return thread_count_;
+}
+
+void soil::bullet_task_scheduler::setNumThreads(
+    [[maybe_unused]] int const numThreads)
+{
+    // Bullet indexes per thread data with the index of the calling thread,
+    // every thread which may call into it has to stay covered
+}
+
+void soil::bullet_task_scheduler::parallelFor(int const iBegin,
+    int const iEnd,
+    int const grainSize,
+    btIParallelForBody const& body)
+{
+    btPushThreadsAreRunning();
+    cppext::parallel_for(*pool_,
+        cppext::narrow<size_t>(iBegin),
+        cppext::narrow<size_t>(iEnd),
+        cppext::narrow<size_t>(std::max(grainSize, 1)),
+        [&body](size_t const first, size_t const last)
+        {
+            body.forLoop(cppext::narrow<int>(first),
+                cppext::narrow<int>(last));
+        });
+    btPopThreadsAreRunning();
+}
+
+btScalar soil::bullet_task_scheduler::parallelSum(int const iBegin,
+    int const iEnd,
+    int const grainSize,
+    btIParallelSumBody const& body)
+{
+    if (iBegin >= iEnd)
+    {
+        return btScalar{0};
+    }
+
+    auto const begin{cppext::narrow<size_t>(iBegin)};
+    auto const grain{cppext::narrow<size_t>(std::max(grainSize, 1))};
+
+    // One partial sum per subrange, summed in order for repeatable results
+    std::vector<btScalar> sums(
+        (cppext::narrow<size_t>(iEnd) - begin + grain - 1) / grain);
+
+    btPushThreadsAreRunning();
+    cppext::parallel_for(*pool_,
+        begin,
+        cppext::narrow<size_t>(iEnd),
+        grain,
+        [&body, &sums, begin, grain](size_t const first, size_t const last)
+        {
+            sums[(first - begin) / grain] =
+                body.sumLoop(cppext::narrow<int>(first),
+                    cppext::narrow<int>(last));
+        });
+    btPopThreadsAreRunning();
+
+    return std::accumulate(sums.begin(), sums.end(), btScalar{0});
+}
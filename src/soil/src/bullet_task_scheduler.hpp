@@ -0,0 +1,57 @@
+#ifndef SOIL_BULLET_TASK_SCHEDULER_INCLUDED
+#define SOIL_BULLET_TASK_SCHEDULER_INCLUDED
+
+#include <LinearMath/btScalar.h>
+#include <LinearMath/btThreads.h>
+
+namespace cppext
+{
+    class thread_pool;
+} // namespace cppext
+
+namespace soil
+{
+    // Runs parallel loops of the multithreaded Bullet world on a
+    // cppext::thread_pool
+    class [[nodiscard]] bullet_task_scheduler final : public btITaskScheduler
+    {
+    public:
+        explicit bullet_task_scheduler(cppext::thread_pool* pool);
+
+        bullet_task_scheduler(bullet_task_scheduler const&) = delete;
+
+        bullet_task_scheduler(bullet_task_scheduler&&) noexcept = delete;
+
+    public:
+        ~bullet_task_scheduler() override = default;
+
+    public: // btITaskScheduler overrides
+        [[nodiscard]] int getMaxNumThreads() const override;
+
+        [[nodiscard]] int getNumThreads() const override;
+
+        void setNumThreads(int numThreads) override;
+
+        void parallelFor(int iBegin,
+            int iEnd,
+            int grainSize,
+            btIParallelForBody const& body) override;
+
+        btScalar parallelSum(int iBegin,
+            int iEnd,
+            int grainSize,
+            btIParallelSumBody const& body) override;
+
+    public:
+        bullet_task_scheduler& operator=(bullet_task_scheduler const&) = delete;
+
+        bullet_task_scheduler& operator=(
+            bullet_task_scheduler&&) noexcept = delete;
+
+    private:
+        cppext::thread_pool* pool_;
+        int thread_count_;
+    };
+} // namespace soil
+
+#endif
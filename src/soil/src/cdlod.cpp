@@ -0,0 +1,225 @@
+#include <cdlod.hpp>
+
+#include <heightmap.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace
+{
+    // Vertices start morphing at this fraction of the range between levels
+    constexpr float morph_start_ratio{0.66f};
+
+    [[nodiscard]] uint32_t level_count(size_t const terrain_dimension,
+        size_t const leaf_size)
+    {
+        uint32_t rv{1};
+        while ((leaf_size << (rv - 1)) < terrain_dimension - 1)
+        {
+            ++rv;
+        }
+        return rv;
+    }
+} // namespace
+
+soil::cdlod_quadtree::cdlod_quadtree(size_t const terrain_dimension,
+    size_t const leaf_size)
+    : terrain_dimension_{terrain_dimension}
+    , leaf_size_{leaf_size}
+    , levels_{level_count(terrain_dimension, leaf_size)}
+    , lod_distance_{cppext::as_fp(leaf_size) * 2.0f}
+    , height_bounds_(levels_)
+{
+    assert(terrain_dimension_ > 1);
+    assert(leaf_size_ > 1 && leaf_size_ % 2 == 0);
+
+    for (uint32_t level{}; level != levels_; ++level)
+    {
+        auto const nodes{nodes_per_dimension(level)};
+        height_bounds_[level].resize(nodes * nodes);
+    }
+}
+
+uint32_t soil::cdlod_quadtree::levels() const { return levels_; }
+
+float soil::cdlod_quadtree::lod_distance() const { return lod_distance_; }
+
+void soil::cdlod_quadtree::set_lod_distance(float const distance)
+{
+    lod_distance_ = distance;
+}
+
+glm::vec2 soil::cdlod_quadtree::morph_range(uint32_t const level) const
+{
+    float const end{range(level)};
+    if (level + 1 == levels_)
+    {
+        // Coarsest level is never replaced by a parent
+        return glm::vec2{end};
+    }
+
+    float const previous{level == 0 ? 0.0f : range(level - 1)};
+    return {previous + (end - previous) * morph_start_ratio, end};
+}
+
+void soil::cdlod_quadtree::update(heightmap const& heightmap)
+{
+    assert(heightmap.dimension() == terrain_dimension_);
+
+    auto const last{terrain_dimension_ - 1};
+
+    auto const leaf_nodes{nodes_per_dimension(0)};
+    for (size_t node_y{}; node_y != leaf_nodes; ++node_y)
+    {
+        for (size_t node_x{}; node_x != leaf_nodes; ++node_x)
+        {
+            glm::vec2 bounds{std::numeric_limits<float>::max(),
+                std::numeric_limits<float>::lowest()};
+
+            auto const end_y{std::min(last, (node_y + 1) * leaf_size_)};
+            auto const end_x{std::min(last, (node_x + 1) * leaf_size_)};
+            for (size_t y{node_y * leaf_size_}; y <= end_y; ++y)
+            {
+                for (size_t x{node_x * leaf_size_}; x <= end_x; ++x)
+                {
+                    float const height{heightmap.value(x, y)};
+                    bounds.x = std::min(bounds.x, height);
+                    bounds.y = std::max(bounds.y, height);
+                }
+            }
+
+            height_bounds_[0][node_y * leaf_nodes + node_x] = bounds;
+        }
+    }
+
+    for (uint32_t level{1}; level != levels_; ++level)
+    {
+        auto const nodes{nodes_per_dimension(level)};
+        auto const child_nodes{nodes_per_dimension(level - 1)};
+        auto const& children{height_bounds_[level - 1]};
+
+        for (size_t node_y{}; node_y != nodes; ++node_y)
+        {
+            for (size_t node_x{}; node_x != nodes; ++node_x)
+            {
+                glm::vec2 bounds{std::numeric_limits<float>::max(),
+                    std::numeric_limits<float>::lowest()};
+
+                for (size_t y{node_y * 2};
+                    y != std::min(child_nodes, node_y * 2 + 2);
+                    ++y)
+                {
+                    for (size_t x{node_x * 2};
+                        x != std::min(child_nodes, node_x * 2 + 2);
+                        ++x)
+                    {
+                        auto const& child{children[y * child_nodes + x]};
+                        bounds.x = std::min(bounds.x, child.x);
+                        bounds.y = std::max(bounds.y, child.y);
+                    }
+                }
+
+                height_bounds_[level][node_y * nodes + node_x] = bounds;
+            }
+        }
+    }
+}
+
+void soil::cdlod_quadtree::select(glm::vec3 const& camera_position)
+{
+    selection_.clear();
+
+    auto const top_level{levels_ - 1};
+    auto const roots{cppext::narrow<uint32_t>(nodes_per_dimension(top_level))};
+    for (uint32_t y{}; y != roots; ++y)
+    {
+        for (uint32_t x{}; x != roots; ++x)
+        {
+            [[maybe_unused]] bool const selected{
+                select_node(camera_position, {x, y}, top_level)};
+            assert(selected);
+        }
+    }
+}
+
+std::span<soil::cdlod_node const> soil::cdlod_quadtree::selection() const
+{
+    return selection_;
+}
+
+bool soil::cdlod_quadtree::select_node(glm::vec3 const& camera_position,
+    glm::uvec2 const& node,
+    uint32_t const level)
+{
+    auto const nodes{nodes_per_dimension(level)};
+    if (node.x >= nodes || node.y >= nodes)
+    {
+        // Parent extends past the edge of the terrain
+        return true;
+    }
+
+    auto const size{cppext::narrow<uint32_t>(leaf_size_ << level)};
+    glm::uvec2 const origin{node.x * size, node.y * size};
+
+    auto const last{cppext::as_fp(terrain_dimension_ - 1)};
+    auto const& bounds{height_bounds_[level][node.y * nodes + node.x]};
+    glm::vec3 const min{cppext::as_fp(origin.x),
+        bounds.x,
+        cppext::as_fp(origin.y)};
+    glm::vec3 const max{std::min(last, cppext::as_fp(origin.x + size)),
+        bounds.y,
+        std::min(last, cppext::as_fp(origin.y + size))};
+
+    float const distance{glm::distance(camera_position,
+        glm::clamp(camera_position, min, max))};
+    if (distance > range(level))
+    {
+        return false;
+    }
+
+    if (level == 0 || distance > range(level - 1))
+    {
+        selection_.emplace_back(origin, level, all_quadrants);
+        return true;
+    }
+
+    uint32_t quadrants{};
+    for (uint32_t quadrant{}; quadrant != 4; ++quadrant)
+    {
+        glm::uvec2 const child{node.x * 2 + (quadrant & 1),
+            node.y * 2 + (quadrant >> 1)};
+        if (!select_node(camera_position, child, level - 1))
+        {
+            quadrants |= 1u << quadrant;
+        }
+    }
+
+    if (quadrants != 0)
+    {
+        selection_.emplace_back(origin, level, quadrants);
+    }
+
+    return true;
+}
+
+float soil::cdlod_quadtree::range(uint32_t const level) const
+{
+    if (level + 1 == levels_)
+    {
+        return std::numeric_limits<float>::max();
+    }
+
+    return lod_distance_ * cppext::as_fp(uint32_t{1} << level);
+}
+
+size_t soil::cdlod_quadtree::nodes_per_dimension(uint32_t const level) const
+{
+    auto const size{leaf_size_ << level};
+    return (terrain_dimension_ - 1 + size - 1) / size;
+}
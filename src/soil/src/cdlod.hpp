@@ -0,0 +1,93 @@
+#ifndef SOIL_CDLOD_INCLUDED
+#define SOIL_CDLOD_INCLUDED
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace soil
+{
+    class heightmap;
+} // namespace soil
+
+namespace soil
+{
+    struct [[nodiscard]] cdlod_node final
+    {
+        glm::uvec2 origin;
+        uint32_t level;
+        // Bitmask of node quadrants to draw, remaining quadrants are covered
+        // by child nodes
+        uint32_t quadrants;
+    };
+
+    // Quadtree for continuous distance dependent LOD. Every node is drawn
+    // with the same grid of leaf_size quads, vertex spacing doubles with each
+    // level. Positions are in heightmap space.
+    class [[nodiscard]] cdlod_quadtree final
+    {
+    public:
+        static constexpr uint32_t all_quadrants{0b1111};
+
+    public:
+        cdlod_quadtree(size_t terrain_dimension, size_t leaf_size);
+
+        cdlod_quadtree(cdlod_quadtree const&) = default;
+
+        cdlod_quadtree(cdlod_quadtree&&) noexcept = default;
+
+    public:
+        ~cdlod_quadtree() = default;
+
+    public:
+        [[nodiscard]] uint32_t levels() const;
+
+        // Range of the finest level, doubles with each level
+        [[nodiscard]] float lod_distance() const;
+
+        void set_lod_distance(float distance);
+
+        // Distances between which vertices of level morph into the next
+        // coarser level
+        [[nodiscard]] glm::vec2 morph_range(uint32_t level) const;
+
+        // Recalculates height bounds of nodes, heightmap dimension must not
+        // change
+        void update(heightmap const& heightmap);
+
+        void select(glm::vec3 const& camera_position);
+
+        [[nodiscard]] std::span<cdlod_node const> selection() const;
+
+    public:
+        cdlod_quadtree& operator=(cdlod_quadtree const&) = default;
+
+        cdlod_quadtree& operator=(cdlod_quadtree&&) noexcept = default;
+
+    private:
+        [[nodiscard]] bool select_node(glm::vec3 const& camera_position,
+            glm::uvec2 const& node,
+            uint32_t level);
+
+        [[nodiscard]] float range(uint32_t level) const;
+
+        [[nodiscard]] size_t nodes_per_dimension(uint32_t level) const;
+
+    private:
+        size_t terrain_dimension_;
+        size_t leaf_size_;
+        uint32_t levels_;
+        float lod_distance_;
+
+        // Minimum and maximum height of nodes for each level
+        std::vector<std::vector<glm::vec2>> height_bounds_;
+
+        std::vector<cdlod_node> selection_;
+    };
+} // namespace soil
+
+#endif
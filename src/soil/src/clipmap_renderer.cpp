@@ -0,0 +1,619 @@
+#include <clipmap_renderer.hpp>
+
+#include <noise.hpp>
+#include <perspective_camera.hpp>
+#include <terrain_renderer.hpp>
+
+#include <cppext_cycled_buffer.hpp>
+#include <cppext_numeric.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_descriptors.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_memory.hpp>
+#include <vulkan_pipeline.hpp>
+#include <vulkan_renderer.hpp>
+#include <vulkan_utility.hpp>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <ranges>
+#include <span>
+
+// IWYU pragma: no_include <filesystem>
+
+namespace
+{
+    // Grid dimensions must match clipmap.vert
+    constexpr int grid_cells{128};
+    constexpr int level_texels{grid_cells + 1};
+    constexpr int patch_cells{16};
+    constexpr int patches_per_level{grid_cells / patch_cells};
+    // Finer level covers half of the level in each dimension
+    constexpr int hole_patches{patches_per_level / 2};
+
+    constexpr size_t texels_per_level{size_t{level_texels} * level_texels};
+
+    struct [[nodiscard]] level_uniform final
+    {
+        glm::ivec2 origin;
+        glm::uvec2 wrapped_origin;
+    };
+
+    struct [[nodiscard]] frame_uniform final
+    {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec4 origin;
+        uint32_t level_count;
+        alignas(16) std::array<level_uniform,
+            soil::clipmap_renderer::max_levels> levels;
+    };
+
+    consteval auto binding_description()
+    {
+        constexpr std::array descriptions{
+            VkVertexInputBindingDescription{.binding = 0,
+                .stride = sizeof(soil::terrain_vertex),
+                .inputRate = VK_VERTEX_INPUT_RATE_VERTEX}};
+
+        return descriptions;
+    }
+
+    consteval auto attribute_descriptions()
+    {
+        constexpr std::array descriptions{
+            VkVertexInputAttributeDescription{.location = 0,
+                .binding = 0,
+                .format = VK_FORMAT_R32G32_UINT,
+                .offset = offsetof(soil::terrain_vertex, position)}};
+
+        return descriptions;
+    }
+
+    [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(
+        vkrndr::vulkan_device const* const device)
+    {
+        VkDescriptorSetLayoutBinding frame_uniform_binding{};
+        frame_uniform_binding.binding = 0;
+        frame_uniform_binding.descriptorType =
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        frame_uniform_binding.descriptorCount = 1;
+        frame_uniform_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        VkDescriptorSetLayoutBinding patches_binding{};
+        patches_binding.binding = 1;
+        patches_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        patches_binding.descriptorCount = 1;
+        patches_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        VkDescriptorSetLayoutBinding heights_binding{};
+        heights_binding.binding = 2;
+        heights_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        heights_binding.descriptorCount = 1;
+        heights_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        std::array const bindings{frame_uniform_binding,
+            patches_binding,
+            heights_binding};
+
+        VkDescriptorSetLayoutCreateInfo layout_info{};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.bindingCount = vkrndr::count_cast(bindings.size());
+        layout_info.pBindings = bindings.data();
+
+        VkDescriptorSetLayout rv; // NOLINT
+        vkrndr::check_result(vkCreateDescriptorSetLayout(device->logical,
+            &layout_info,
+            nullptr,
+            &rv));
+
+        return rv;
+    }
+
+    void bind_descriptor_set(vkrndr::vulkan_device const* const device,
+        VkDescriptorSet const& descriptor_set,
+        VkDescriptorBufferInfo const frame_uniform_info,
+        VkDescriptorBufferInfo const patches_info,
+        VkDescriptorBufferInfo const heights_info)
+    {
+        VkWriteDescriptorSet frame_uniform_write{};
+        frame_uniform_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        frame_uniform_write.dstSet = descriptor_set;
+        frame_uniform_write.dstBinding = 0;
+        frame_uniform_write.dstArrayElement = 0;
+        frame_uniform_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        frame_uniform_write.descriptorCount = 1;
+        frame_uniform_write.pBufferInfo = &frame_uniform_info;
+
+        VkWriteDescriptorSet patches_write{};
+        patches_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        patches_write.dstSet = descriptor_set;
+        patches_write.dstBinding = 1;
+        patches_write.dstArrayElement = 0;
+        patches_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        patches_write.descriptorCount = 1;
+        patches_write.pBufferInfo = &patches_info;
+
+        VkWriteDescriptorSet heights_write{};
+        heights_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        heights_write.dstSet = descriptor_set;
+        heights_write.dstBinding = 2;
+        heights_write.dstArrayElement = 0;
+        heights_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        heights_write.descriptorCount = 1;
+        heights_write.pBufferInfo = &heights_info;
+
+        std::array const descriptor_writes{frame_uniform_write,
+            patches_write,
+            heights_write};
+
+        vkUpdateDescriptorSets(device->logical,
+            vkrndr::count_cast(descriptor_writes.size()),
+            descriptor_writes.data(),
+            0,
+            nullptr);
+    }
+
+    void memory_barrier(VkCommandBuffer const command_buffer,
+        VkPipelineStageFlags2 const src_stage_mask,
+        VkAccessFlags2 const src_access_mask,
+        VkPipelineStageFlags2 const dst_stage_mask,
+        VkAccessFlags2 const dst_access_mask)
+    {
+        VkMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+        barrier.srcStageMask = src_stage_mask;
+        barrier.srcAccessMask = src_access_mask;
+        barrier.dstStageMask = dst_stage_mask;
+        barrier.dstAccessMask = dst_access_mask;
+
+        VkDependencyInfo dependency{};
+        dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency.memoryBarrierCount = 1;
+        dependency.pMemoryBarriers = &barrier;
+
+        vkCmdPipelineBarrier2(command_buffer, &dependency);
+    }
+
+    [[nodiscard]] int wrap(int const value)
+    {
+        return (value % level_texels + level_texels) % level_texels;
+    }
+
+    // Level origins are snapped to two patches so that the finer level
+    // always starts on a patch boundary of the coarser level
+    [[nodiscard]] glm::ivec2 level_origin(glm::vec3 const& camera_position,
+        uint32_t const level)
+    {
+        constexpr float snap{2.0f * patch_cells};
+
+        auto const spacing{cppext::as_fp(1 << level)};
+        auto const snapped = [&spacing](float const position)
+        {
+            return static_cast<int>(std::floor(
+                       (position / spacing - grid_cells / 2.0f) / snap)) *
+                2 * patch_cells;
+        };
+
+        return {snapped(camera_position.x), snapped(camera_position.z)};
+    }
+} // namespace
+
+soil::clipmap_renderer::clipmap_renderer(noise_settings const& settings,
+    uint32_t const levels,
+    vkrndr::vulkan_device* const device,
+    vkrndr::vulkan_renderer* const renderer,
+    vkrndr::vulkan_image* const depth_buffer)
+    : settings_{settings}
+    , levels_{levels}
+    , device_{device}
+    , renderer_{renderer}
+    , level_states_(levels)
+    , heights_buffer_{create_buffer(device,
+          texels_per_level * levels * sizeof(float),
+          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)}
+    , descriptor_set_layout_{create_descriptor_set_layout(device_)}
+{
+    assert(levels_ > 0 && levels_ <= max_levels);
+
+    fill_patch_buffers();
+
+    pipeline_ = std::make_unique<vkrndr::vulkan_pipeline>(
+        vkrndr::vulkan_pipeline_builder{device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(descriptor_set_layout_)
+                .build(),
+            renderer->image_format()}
+            .add_shader(VK_SHADER_STAGE_VERTEX_BIT, "clipmap.vert.spv", "main")
+            .add_shader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                "clipmap.frag.spv",
+                "main")
+            .with_primitive_topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+            .with_rasterization_samples(device_->max_msaa_samples)
+            .add_vertex_input(binding_description(), attribute_descriptions())
+            .with_depth_test(depth_buffer->format)
+            .with_culling(VK_CULL_MODE_BACK_BIT,
+                VK_FRONT_FACE_COUNTER_CLOCKWISE)
+            .build());
+
+    frame_data_ =
+        cppext::cycled_buffer<frame_resources>{renderer->image_count(),
+            renderer->image_count()};
+    for (auto& data : frame_data_.as_span())
+    {
+        data.frame_uniform = create_buffer(device_,
+            sizeof(frame_uniform),
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        data.frame_uniform_map =
+            vkrndr::map_memory(device, data.frame_uniform.allocation);
+
+        auto const patches_size{sizeof(glm::uvec4) * levels_ *
+            patches_per_level * patches_per_level};
+        data.patches = create_buffer(device_,
+            patches_size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        data.patches_map = vkrndr::map_memory(device, data.patches.allocation);
+
+        // Enough for regenerating every level after a teleport
+        data.staging = create_buffer(device_,
+            heights_buffer_.size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        data.staging_map = vkrndr::map_memory(device, data.staging.allocation);
+
+        create_descriptor_sets(device_,
+            descriptor_set_layout_,
+            renderer->descriptor_pool(),
+            std::span{&data.descriptor_set, 1});
+
+        bind_descriptor_set(device_,
+            data.descriptor_set,
+            VkDescriptorBufferInfo{.buffer = data.frame_uniform.buffer,
+                .offset = 0,
+                .range = sizeof(frame_uniform)},
+            VkDescriptorBufferInfo{.buffer = data.patches.buffer,
+                .offset = 0,
+                .range = patches_size},
+            VkDescriptorBufferInfo{.buffer = heights_buffer_.buffer,
+                .offset = 0,
+                .range = heights_buffer_.size});
+    }
+}
+
+soil::clipmap_renderer::~clipmap_renderer()
+{
+    for (auto& data : frame_data_.as_span())
+    {
+        vkFreeDescriptorSets(device_->logical,
+            renderer_->descriptor_pool(),
+            1,
+            &data.descriptor_set);
+
+        unmap_memory(device_, &data.staging_map);
+        destroy(device_, &data.staging);
+
+        unmap_memory(device_, &data.patches_map);
+        destroy(device_, &data.patches);
+
+        unmap_memory(device_, &data.frame_uniform_map);
+        destroy(device_, &data.frame_uniform);
+    }
+
+    destroy(device_, pipeline_.get());
+    pipeline_ = nullptr;
+
+    vkDestroyDescriptorSetLayout(device_->logical,
+        descriptor_set_layout_,
+        nullptr);
+
+    destroy(device_, &index_buffer_);
+    destroy(device_, &vertex_buffer_);
+
+    destroy(device_, &heights_buffer_);
+}
+
+size_t soil::clipmap_renderer::patch_count() const { return patch_count_; }
+
+size_t soil::clipmap_renderer::updated_samples() const
+{
+    return updated_samples_;
+}
+
+void soil::clipmap_renderer::update(perspective_camera const& camera,
+    glm::vec3 const& origin)
+{
+    glm::vec3 const camera_position{camera.position() - origin};
+
+    auto& uniform{*frame_data_->frame_uniform_map.as<frame_uniform>()};
+    uniform.view = camera.view_matrix();
+    uniform.projection = camera.projection_matrix();
+    uniform.origin = glm::vec4{origin, 0.0f};
+    uniform.level_count = levels_;
+
+    // Strips of an update which wasn't uploaded are generated again, they
+    // are computed against the origins of the last upload
+    frame_data_->copies.clear();
+    staging_offset_ = 0;
+    updated_samples_ = 0;
+
+    for (uint32_t level{}; level != levels_; ++level)
+    {
+        auto& state{level_states_[level]};
+        glm::ivec2 const new_origin{level_origin(camera_position, level)};
+
+        glm::ivec2 const delta{new_origin - state.origin};
+        if (!state.valid || std::abs(delta.x) >= level_texels ||
+            std::abs(delta.y) >= level_texels)
+        {
+            update_region(level,
+                new_origin,
+                glm::ivec2{level_texels, level_texels});
+        }
+        else
+        {
+            // Columns and rows which scrolled into the level window
+            if (delta.x > 0)
+            {
+                update_region(level,
+                    {new_origin.x + level_texels - delta.x, new_origin.y},
+                    {delta.x, level_texels});
+            }
+            else if (delta.x < 0)
+            {
+                update_region(level, new_origin, {-delta.x, level_texels});
+            }
+
+            if (delta.y > 0)
+            {
+                update_region(level,
+                    {new_origin.x, new_origin.y + level_texels - delta.y},
+                    {level_texels, delta.y});
+            }
+            else if (delta.y < 0)
+            {
+                update_region(level, new_origin, {level_texels, -delta.y});
+            }
+        }
+
+        state.pending_origin = new_origin;
+
+        uniform.levels[level] = {.origin = new_origin,
+            .wrapped_origin = glm::uvec2{
+                cppext::narrow<uint32_t>(wrap(new_origin.x)),
+                cppext::narrow<uint32_t>(wrap(new_origin.y))}};
+    }
+
+    // Finest level is drawn whole, coarser levels leave out the area covered
+    // by the finer level
+    auto* const patches{frame_data_->patches_map.as<glm::uvec4>()};
+    patch_count_ = 0;
+    for (uint32_t level{}; level != levels_; ++level)
+    {
+        glm::ivec2 hole{patches_per_level};
+        if (level > 0)
+        {
+            hole = (level_states_[level - 1].pending_origin / 2 -
+                       level_states_[level].pending_origin) /
+                patch_cells;
+            assert(hole.x >= 0 && hole.x + hole_patches <= patches_per_level);
+            assert(hole.y >= 0 && hole.y + hole_patches <= patches_per_level);
+        }
+
+        for (int y{}; y != patches_per_level; ++y)
+        {
+            for (int x{}; x != patches_per_level; ++x)
+            {
+                if (x >= hole.x && x < hole.x + hole_patches && y >= hole.y &&
+                    y < hole.y + hole_patches)
+                {
+                    continue;
+                }
+
+                patches[patch_count_++] =
+                    glm::uvec4{cppext::narrow<uint32_t>(x * patch_cells),
+                        cppext::narrow<uint32_t>(y * patch_cells),
+                        level,
+                        0};
+            }
+        }
+    }
+}
+
+void soil::clipmap_renderer::upload(VkCommandBuffer command_buffer)
+{
+    for (level_state& state : level_states_)
+    {
+        state.origin = state.pending_origin;
+        state.valid = true;
+    }
+
+    if (frame_data_->copies.empty())
+    {
+        return;
+    }
+
+    // Previous frames may still be reading heights
+    memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+        VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_NONE);
+
+    vkCmdCopyBuffer(command_buffer,
+        frame_data_->staging.buffer,
+        heights_buffer_.buffer,
+        vkrndr::count_cast(frame_data_->copies.size()),
+        frame_data_->copies.data());
+
+    memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+}
+
+void soil::clipmap_renderer::draw(VkCommandBuffer command_buffer)
+{
+    vkrndr::bind_pipeline(command_buffer,
+        *pipeline_,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        0,
+        std::span<VkDescriptorSet const>{&frame_data_->descriptor_set, 1});
+
+    VkDeviceSize const zero_offset{};
+    vkCmdBindVertexBuffers(command_buffer,
+        0,
+        1,
+        &vertex_buffer_.buffer,
+        &zero_offset);
+
+    vkCmdBindIndexBuffer(command_buffer,
+        index_buffer_.buffer,
+        0,
+        VK_INDEX_TYPE_UINT32);
+
+    vkCmdDrawIndexed(command_buffer,
+        index_count_,
+        cppext::narrow<uint32_t>(patch_count_),
+        0,
+        0,
+        0);
+
+    frame_data_.cycle();
+}
+
+void soil::clipmap_renderer::update_region(uint32_t const level,
+    glm::ivec2 const& first,
+    glm::ivec2 const& extent)
+{
+    auto const width{cppext::narrow<size_t>(extent.x)};
+    auto const height{cppext::narrow<size_t>(extent.y)};
+    assert(staging_offset_ + width * height <= texels_per_level * levels_);
+
+    // Level texels are spaced 1 << level samples apart
+    noise_settings level_settings{settings_};
+    level_settings.scale /= cppext::as_fp(1 << level);
+
+    std::span const samples{
+        frame_data_->staging_map.as<float>() + staging_offset_,
+        width * height};
+    generate_2d_noise(samples,
+        width,
+        height,
+        level_settings,
+        cppext::as_fp(first.x),
+        cppext::as_fp(first.y));
+
+    // Match the value range of heightmap images
+    std::ranges::transform(samples,
+        samples.begin(),
+        [](float const value)
+        { return value * cppext::as_fp(std::numeric_limits<uint8_t>::max()); });
+
+    auto const level_offset{texels_per_level * level};
+    auto const first_column{cppext::narrow<size_t>(wrap(first.x))};
+    for (size_t row{}; row != height; ++row)
+    {
+        auto const target_row{
+            cppext::narrow<size_t>(wrap(first.y + cppext::narrow<int>(row)))};
+        auto const source{staging_offset_ + row * width};
+        auto const target{level_offset + target_row * level_texels};
+
+        // Rows wrap around to the start of the level at most once
+        auto const head{std::min(width, level_texels - first_column)};
+        frame_data_->copies.push_back(
+            VkBufferCopy{.srcOffset = source * sizeof(float),
+                .dstOffset = (target + first_column) * sizeof(float),
+                .size = head * sizeof(float)});
+        if (head != width)
+        {
+            frame_data_->copies.push_back(
+                VkBufferCopy{.srcOffset = (source + head) * sizeof(float),
+                    .dstOffset = target * sizeof(float),
+                    .size = (width - head) * sizeof(float)});
+        }
+    }
+
+    staging_offset_ += width * height;
+    updated_samples_ += width * height;
+}
+
+void soil::clipmap_renderer::fill_patch_buffers()
+{
+    constexpr auto patch_vertices{patch_cells + 1};
+
+    std::vector<terrain_vertex> vertices;
+    vertices.reserve(size_t{patch_vertices} * patch_vertices);
+    for (uint32_t z{}; z != patch_vertices; ++z)
+    {
+        for (uint32_t x{}; x != patch_vertices; ++x)
+        {
+            vertices.push_back({.position = {x, z}});
+        }
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(size_t{patch_cells} * patch_cells * 6);
+    for (uint32_t z{}; z != patch_cells; ++z)
+    {
+        for (uint32_t x{}; x != patch_cells; ++x)
+        {
+            auto const base_vertex{z * patch_vertices + x};
+
+            indices.push_back(base_vertex);
+            indices.push_back(base_vertex + patch_vertices);
+            indices.push_back(base_vertex + 1);
+            indices.push_back(base_vertex + 1);
+            indices.push_back(base_vertex + patch_vertices);
+            indices.push_back(base_vertex + patch_vertices + 1);
+        }
+    }
+    index_count_ = cppext::narrow<uint32_t>(indices.size());
+
+    auto const upload = [this](std::span<std::byte const> const data,
+                            VkBufferUsageFlags const usage)
+    {
+        vkrndr::vulkan_buffer staging_buffer{vkrndr::create_buffer(device_,
+            data.size(),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)};
+
+        vkrndr::mapped_memory staging_map{
+            vkrndr::map_memory(device_, staging_buffer.allocation)};
+        std::ranges::copy(data, staging_map.as<std::byte>());
+        unmap_memory(device_, &staging_map);
+
+        vkrndr::vulkan_buffer rv{create_buffer(device_,
+            data.size(),
+            usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)};
+        renderer_->transfer_buffer(staging_buffer, rv);
+
+        destroy(device_, &staging_buffer);
+
+        return rv;
+    };
+
+    vertex_buffer_ = upload(std::as_bytes(std::span{vertices}),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    index_buffer_ = upload(std::as_bytes(std::span{indices}),
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+}
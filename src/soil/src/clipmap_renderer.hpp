@@ -0,0 +1,136 @@
+#ifndef SOIL_CLIPMAP_RENDERER_INCLUDED
+#define SOIL_CLIPMAP_RENDERER_INCLUDED
+
+#include <noise.hpp>
+
+#include <cppext_cycled_buffer.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_memory.hpp>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    struct vulkan_image;
+    struct vulkan_pipeline;
+    class vulkan_renderer;
+} // namespace vkrndr
+
+namespace soil
+{
+    class perspective_camera;
+} // namespace soil
+
+namespace soil
+{
+    // Geometry clipmap, nested rings of fixed size grids centered on the
+    // camera. Heights of each level are generated from noise into a
+    // toroidally addressed buffer, only strips exposed by camera movement
+    // are generated and uploaded.
+    class [[nodiscard]] clipmap_renderer final
+    {
+    public:
+        static constexpr uint32_t max_levels{8};
+
+    public:
+        clipmap_renderer(noise_settings const& settings,
+            uint32_t levels,
+            vkrndr::vulkan_device* device,
+            vkrndr::vulkan_renderer* renderer,
+            vkrndr::vulkan_image* depth_buffer);
+
+        clipmap_renderer(clipmap_renderer const&) = delete;
+
+        clipmap_renderer(clipmap_renderer&&) noexcept = delete;
+
+    public:
+        ~clipmap_renderer();
+
+    public:
+        [[nodiscard]] size_t patch_count() const;
+
+        // Samples generated by the last update
+        [[nodiscard]] size_t updated_samples() const;
+
+        // Origin is the world space position of noise sample (0, 0)
+        void update(perspective_camera const& camera, glm::vec3 const& origin);
+
+        // Records uploads of updated strips, must be called outside of a
+        // render pass
+        void upload(VkCommandBuffer command_buffer);
+
+        void draw(VkCommandBuffer command_buffer);
+
+    public:
+        clipmap_renderer& operator=(clipmap_renderer const&) = delete;
+
+        clipmap_renderer& operator=(clipmap_renderer&&) noexcept = delete;
+
+    private:
+        // Origin advances when the strips of an update are uploaded,
+        // updates between two uploads cover every texel scrolled in since
+        struct [[nodiscard]] level_state final
+        {
+            glm::ivec2 origin;
+            glm::ivec2 pending_origin;
+            bool valid{};
+        };
+
+        struct [[nodiscard]] frame_resources final
+        {
+            vkrndr::vulkan_buffer frame_uniform;
+            vkrndr::mapped_memory frame_uniform_map{};
+            vkrndr::vulkan_buffer patches;
+            vkrndr::mapped_memory patches_map{};
+            vkrndr::vulkan_buffer staging;
+            vkrndr::mapped_memory staging_map{};
+            std::vector<VkBufferCopy> copies;
+            VkDescriptorSet descriptor_set{VK_NULL_HANDLE};
+        };
+
+    private:
+        // Generates heights of texels [first, first + extent) of level into
+        // staging memory and records their copy to the toroidal position
+        void update_region(uint32_t level,
+            glm::ivec2 const& first,
+            glm::ivec2 const& extent);
+
+        void fill_patch_buffers();
+
+    private:
+        noise_settings settings_;
+        uint32_t levels_;
+
+        vkrndr::vulkan_device* device_;
+        vkrndr::vulkan_renderer* renderer_;
+
+        std::vector<level_state> level_states_;
+
+        vkrndr::vulkan_buffer heights_buffer_;
+
+        uint32_t index_count_{};
+        vkrndr::vulkan_buffer vertex_buffer_;
+        vkrndr::vulkan_buffer index_buffer_;
+
+        VkDescriptorSetLayout descriptor_set_layout_{VK_NULL_HANDLE};
+        std::unique_ptr<vkrndr::vulkan_pipeline> pipeline_;
+
+        cppext::cycled_buffer<frame_resources> frame_data_;
+
+        size_t patch_count_{};
+        size_t updated_samples_{};
+        size_t staging_offset_{};
+    };
+} // namespace soil
+
+#endif
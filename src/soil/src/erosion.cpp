@@ -0,0 +1,309 @@
+#include <erosion.hpp>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <ranges>
+
+namespace
+{
+    [[nodiscard]] size_t worker_count()
+    {
+        return std::max(size_t{1},
+            size_t{std::thread::hardware_concurrency()});
+    }
+} // namespace
+
+soil::cpu_erosion::cpu_erosion(size_t const dimension)
+    : dimension_{dimension}
+    , participants_{worker_count()}
+    , eroded_heights_(dimension * dimension)
+    , water_(dimension * dimension)
+    , flux_(dimension * dimension)
+    , velocity_(dimension * dimension)
+    , sediment_(dimension * dimension)
+    , suspended_sediment_(dimension * dimension)
+    , sync_{static_cast<std::ptrdiff_t>(participants_)}
+{
+    // Calling thread participates as the first worker
+    workers_.reserve(participants_ - 1);
+    for (size_t i{1}; i != participants_; ++i)
+    {
+        workers_.emplace_back([this, i](std::stop_token const& token)
+            { worker(token, i); });
+    }
+}
+
+soil::cpu_erosion::~cpu_erosion()
+{
+    for (auto& worker : workers_)
+    {
+        worker.request_stop();
+    }
+
+    // Release workers waiting for the next run so they observe the stop
+    sync_.arrive_and_wait();
+    workers_.clear();
+}
+
+void soil::cpu_erosion::reset()
+{
+    std::ranges::fill(water_, 0.0f);
+    std::ranges::fill(flux_, glm::vec4{0.0f});
+    std::ranges::fill(velocity_, glm::vec2{0.0f});
+    std::ranges::fill(sediment_, 0.0f);
+    std::ranges::fill(suspended_sediment_, 0.0f);
+}
+
+void soil::cpu_erosion::run(std::span<float> heights,
+    erosion_settings const& settings,
+    uint32_t const iterations)
+{
+    assert(heights.size() == dimension_ * dimension_);
+
+    heights_ = heights.data();
+    settings_ = settings;
+    iterations_ = iterations;
+
+    sync_.arrive_and_wait();
+    simulate(0);
+}
+
+void soil::cpu_erosion::worker(std::stop_token const& token,
+    size_t const index)
+{
+    while (true)
+    {
+        sync_.arrive_and_wait();
+        if (token.stop_requested())
+        {
+            return;
+        }
+
+        simulate(index);
+    }
+}
+
+void soil::cpu_erosion::simulate(size_t const index)
+{
+    size_t const rows{(dimension_ + participants_ - 1) / participants_};
+    size_t const begin{std::min(dimension_, index * rows)};
+    size_t const end{std::min(dimension_, begin + rows)};
+
+    for (uint32_t i{}; i != iterations_; ++i)
+    {
+        flux_pass(begin, end);
+        sync_.arrive_and_wait();
+
+        water_pass(begin, end);
+        sync_.arrive_and_wait();
+
+        transport_pass(begin, end);
+        sync_.arrive_and_wait();
+
+        thermal_pass(begin, end);
+        sync_.arrive_and_wait();
+    }
+}
+
+void soil::cpu_erosion::flux_pass(size_t const begin, size_t const end)
+{
+    float const rain{settings_.rain_rate * settings_.time_step};
+    auto const surface = [this, rain](size_t const index)
+    { return heights_[index] + water_[index] + rain; };
+
+    for (size_t y{begin}; y != end; ++y)
+    {
+        for (size_t x{}; x != dimension_; ++x)
+        {
+            size_t const index{y * dimension_ + x};
+            float const height{surface(index)};
+
+            // Outflow to left, right, top and bottom neighbours
+            glm::vec4 const difference{
+                x > 0 ? height - surface(index - 1) : 0.0f,
+                x < dimension_ - 1 ? height - surface(index + 1) : 0.0f,
+                y > 0 ? height - surface(index - dimension_) : 0.0f,
+                y < dimension_ - 1 ? height - surface(index + dimension_)
+                                   : 0.0f};
+
+            glm::vec4 outflow{glm::max(glm::vec4{0.0f},
+                flux_[index] +
+                    settings_.time_step * settings_.pipe_flow * difference)};
+            outflow *= glm::vec4{x > 0,
+                x < dimension_ - 1,
+                y > 0,
+                y < dimension_ - 1};
+
+            float const total{
+                (outflow.x + outflow.y + outflow.z + outflow.w) *
+                settings_.time_step};
+            if (total > 0.0f)
+            {
+                outflow *= std::min(1.0f, (water_[index] + rain) / total);
+            }
+
+            flux_[index] = outflow;
+        }
+    }
+}
+
+void soil::cpu_erosion::water_pass(size_t const begin, size_t const end)
+{
+    float const time_step{settings_.time_step};
+    auto const flux_at = [this](size_t const x, size_t const y)
+    {
+        return x < dimension_ && y < dimension_ ? flux_[y * dimension_ + x]
+                                                : glm::vec4{0.0f};
+    };
+    auto const height_at = [this](size_t const x, size_t const y)
+    {
+        return heights_[std::min(y, dimension_ - 1) * dimension_ +
+            std::min(x, dimension_ - 1)];
+    };
+
+    for (size_t y{begin}; y != end; ++y)
+    {
+        for (size_t x{}; x != dimension_; ++x)
+        {
+            size_t const index{y * dimension_ + x};
+
+            // Unsigned wrap around makes out of bounds neighbours miss
+            glm::vec4 const outflow{flux_[index]};
+            float const from_left{flux_at(x - 1, y).y};
+            float const from_right{flux_at(x + 1, y).x};
+            float const from_top{flux_at(x, y - 1).w};
+            float const from_bottom{flux_at(x, y + 1).z};
+
+            float const depth{
+                water_[index] + settings_.rain_rate * time_step};
+            float const new_depth{std::max(0.0f,
+                depth +
+                    time_step *
+                        (from_left + from_right + from_top + from_bottom -
+                            (outflow.x + outflow.y + outflow.z +
+                                outflow.w)))};
+            float const average_depth{
+                std::max(0.5f * (depth + new_depth), 1e-4f)};
+
+            glm::vec2 const flow{
+                0.5f *
+                glm::vec2{from_left - outflow.x + outflow.y - from_right,
+                    from_top - outflow.z + outflow.w - from_bottom} /
+                average_depth};
+
+            glm::vec2 const gradient{0.5f *
+                glm::vec2{height_at(x + 1, y) -
+                        height_at(x == 0 ? 0 : x - 1, y),
+                    height_at(x, y + 1) - height_at(x, y == 0 ? 0 : y - 1)}};
+            float const slope{glm::length(gradient)};
+            float const tilt{std::max(slope / std::sqrt(1.0f + slope * slope),
+                settings_.minimum_tilt)};
+
+            float const capacity{
+                settings_.sediment_capacity * tilt * glm::length(flow)};
+            float height{heights_[index]};
+            float suspended{sediment_[index]};
+            if (capacity > suspended)
+            {
+                float const amount{settings_.dissolve_rate * time_step *
+                    (capacity - suspended)};
+                height -= amount;
+                suspended += amount;
+            }
+            else
+            {
+                float const amount{settings_.deposition_rate * time_step *
+                    (suspended - capacity)};
+                height += amount;
+                suspended -= amount;
+            }
+
+            water_[index] = new_depth;
+            velocity_[index] = flow;
+            eroded_heights_[index] = height;
+            suspended_sediment_[index] = suspended;
+        }
+    }
+}
+
+void soil::cpu_erosion::transport_pass(size_t const begin, size_t const end)
+{
+    auto const last{static_cast<float>(dimension_ - 1)};
+    auto const suspended_at = [this](size_t const x, size_t const y)
+    { return suspended_sediment_[y * dimension_ + x]; };
+
+    for (size_t y{begin}; y != end; ++y)
+    {
+        for (size_t x{}; x != dimension_; ++x)
+        {
+            size_t const index{y * dimension_ + x};
+
+            // Semi-Lagrangian advection, sediment is fetched from where the
+            // flow came from
+            glm::vec2 const source{glm::clamp(
+                glm::vec2{static_cast<float>(x), static_cast<float>(y)} -
+                    velocity_[index] * settings_.time_step,
+                glm::vec2{0.0f},
+                glm::vec2{last})};
+            auto const base_x{std::min(static_cast<size_t>(source.x),
+                std::max(dimension_, size_t{2}) - 2)};
+            auto const base_y{std::min(static_cast<size_t>(source.y),
+                std::max(dimension_, size_t{2}) - 2)};
+            float const weight_x{source.x - static_cast<float>(base_x)};
+            float const weight_y{source.y - static_cast<float>(base_y)};
+
+            float const top{std::lerp(suspended_at(base_x, base_y),
+                suspended_at(base_x + 1, base_y),
+                weight_x)};
+            float const bottom{std::lerp(suspended_at(base_x, base_y + 1),
+                suspended_at(base_x + 1, base_y + 1),
+                weight_x)};
+
+            sediment_[index] = std::lerp(top, bottom, weight_y);
+            water_[index] *= std::max(0.0f,
+                1.0f - settings_.evaporation_rate * settings_.time_step);
+        }
+    }
+}
+
+void soil::cpu_erosion::thermal_pass(size_t const begin, size_t const end)
+{
+    auto const exchange = [this](size_t const x,
+                              size_t const y,
+                              float const height)
+    {
+        if (x >= dimension_ || y >= dimension_)
+        {
+            return 0.0f;
+        }
+
+        float const difference{eroded_heights_[y * dimension_ + x] - height};
+        return std::copysign(
+            std::max(std::fabs(difference) - settings_.talus, 0.0f),
+            difference);
+    };
+
+    for (size_t y{begin}; y != end; ++y)
+    {
+        for (size_t x{}; x != dimension_; ++x)
+        {
+            size_t const index{y * dimension_ + x};
+            float const height{eroded_heights_[index]};
+
+            // Material above the talus slope is exchanged symmetrically
+            // between neighbours
+            float const delta{exchange(x - 1, y, height) +
+                exchange(x + 1, y, height) + exchange(x, y - 1, height) +
+                exchange(x, y + 1, height)};
+
+            heights_[index] = height +
+                0.25f * settings_.thermal_rate * settings_.time_step * delta;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef SOIL_EROSION_INCLUDED
+#define SOIL_EROSION_INCLUDED
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace soil
+{
+    // Parameters of the virtual pipe hydraulic erosion model combined with
+    // thermal weathering of slopes steeper than talus
+    struct [[nodiscard]] erosion_settings final
+    {
+        float time_step{0.05f};
+        float rain_rate{0.01f};
+        float pipe_flow{20.0f};
+        float sediment_capacity{0.5f};
+        float dissolve_rate{0.5f};
+        float deposition_rate{1.0f};
+        float evaporation_rate{0.5f};
+        float talus{1.5f};
+        float thermal_rate{2.0f};
+        float minimum_tilt{0.05f};
+    };
+
+    // Multithreaded CPU implementation of the erosion compute passes
+    class [[nodiscard]] cpu_erosion final
+    {
+    public:
+        explicit cpu_erosion(size_t dimension);
+
+        cpu_erosion(cpu_erosion const&) = delete;
+
+        cpu_erosion(cpu_erosion&&) noexcept = delete;
+
+    public:
+        ~cpu_erosion();
+
+    public:
+        void reset();
+
+        void run(std::span<float> heights,
+            erosion_settings const& settings,
+            uint32_t iterations);
+
+    public:
+        cpu_erosion& operator=(cpu_erosion const&) = delete;
+
+        cpu_erosion& operator=(cpu_erosion&&) noexcept = delete;
+
+    private:
+        void worker(std::stop_token const& token, size_t index);
+
+        void simulate(size_t index);
+
+        void flux_pass(size_t begin, size_t end);
+
+        void water_pass(size_t begin, size_t end);
+
+        void transport_pass(size_t begin, size_t end);
+
+        void thermal_pass(size_t begin, size_t end);
+
+    private:
+        size_t dimension_;
+        size_t participants_;
+
+        std::vector<float> eroded_heights_;
+        std::vector<float> water_;
+        std::vector<glm::vec4> flux_;
+        std::vector<glm::vec2> velocity_;
+        std::vector<float> sediment_;
+        std::vector<float> suspended_sediment_;
+
+        float* heights_{};
+        erosion_settings settings_;
+        uint32_t iterations_{};
+
+        std::barrier<> sync_;
+        std::vector<std::jthread> workers_;
+    };
+} // namespace soil
+
+#endif
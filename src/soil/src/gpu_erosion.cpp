@@ -0,0 +1,361 @@
+#include <gpu_erosion.hpp>
+
+#include <erosion.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_descriptors.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_memory.hpp>
+#include <vulkan_pipeline.hpp>
+#include <vulkan_renderer.hpp>
+#include <vulkan_utility.hpp>
+
+#include <vma_impl.hpp>
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <cstddef>
+#include <ranges>
+
+namespace
+{
+    struct [[nodiscard]] push_constants final
+    {
+        uint32_t dimension;
+        float time_step;
+        float rain_rate;
+        float pipe_flow;
+        float sediment_capacity;
+        float dissolve_rate;
+        float deposition_rate;
+        float evaporation_rate;
+        float talus;
+        float thermal_rate;
+        float minimum_tilt;
+    };
+
+    constexpr uint32_t binding_count{8};
+
+    constexpr uint32_t workgroup_size{16};
+
+    [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(
+        vkrndr::vulkan_device const* const device)
+    {
+        std::array<VkDescriptorSetLayoutBinding, binding_count> bindings{};
+        for (auto const& [index, binding] : std::views::enumerate(bindings))
+        {
+            binding.binding = static_cast<uint32_t>(index);
+            binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            binding.descriptorCount = 1;
+            binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layout_info{};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.bindingCount = vkrndr::count_cast(bindings.size());
+        layout_info.pBindings = bindings.data();
+
+        VkDescriptorSetLayout rv; // NOLINT
+        vkrndr::check_result(vkCreateDescriptorSetLayout(device->logical,
+            &layout_info,
+            nullptr,
+            &rv));
+
+        return rv;
+    }
+
+    void bind_descriptor_set(vkrndr::vulkan_device const* const device,
+        VkDescriptorSet const& descriptor_set,
+        std::span<vkrndr::vulkan_buffer const* const> const buffers)
+    {
+        std::array<VkDescriptorBufferInfo, binding_count> buffer_infos{};
+        std::array<VkWriteDescriptorSet, binding_count> descriptor_writes{};
+        for (auto const& [index, buffer] : std::views::enumerate(buffers))
+        {
+            auto const i{static_cast<size_t>(index)};
+
+            buffer_infos[i] = VkDescriptorBufferInfo{.buffer = buffer->buffer,
+                .offset = 0,
+                .range = buffer->size};
+
+            VkWriteDescriptorSet& write{descriptor_writes[i]};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = descriptor_set;
+            write.dstBinding = static_cast<uint32_t>(index);
+            write.dstArrayElement = 0;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            write.descriptorCount = 1;
+            write.pBufferInfo = &buffer_infos[i];
+        }
+
+        vkUpdateDescriptorSets(device->logical,
+            vkrndr::count_cast(buffers.size()),
+            descriptor_writes.data(),
+            0,
+            nullptr);
+    }
+
+    void memory_barrier(VkCommandBuffer const command_buffer,
+        VkPipelineStageFlags2 const src_stage_mask,
+        VkAccessFlags2 const src_access_mask,
+        VkPipelineStageFlags2 const dst_stage_mask,
+        VkAccessFlags2 const dst_access_mask)
+    {
+        VkMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+        barrier.srcStageMask = src_stage_mask;
+        barrier.srcAccessMask = src_access_mask;
+        barrier.dstStageMask = dst_stage_mask;
+        barrier.dstAccessMask = dst_access_mask;
+
+        VkDependencyInfo dependency{};
+        dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency.memoryBarrierCount = 1;
+        dependency.pMemoryBarriers = &barrier;
+
+        vkCmdPipelineBarrier2(command_buffer, &dependency);
+    }
+
+    void compute_barrier(VkCommandBuffer const command_buffer)
+    {
+        memory_barrier(command_buffer,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+    }
+
+    [[nodiscard]] vkrndr::vulkan_buffer create_storage_buffer(
+        vkrndr::vulkan_device const* const device,
+        VkDeviceSize const size)
+    {
+        return vkrndr::create_buffer(device,
+            size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+} // namespace
+
+soil::gpu_erosion::gpu_erosion(vkrndr::vulkan_device* const device,
+    vkrndr::vulkan_renderer* const renderer,
+    vkrndr::vulkan_buffer const& heights,
+    vkrndr::vulkan_buffer const& normals,
+    uint32_t const dimension)
+    : device_{device}
+    , renderer_{renderer}
+    , heights_{&heights}
+    , dimension_{dimension}
+    , eroded_heights_{create_storage_buffer(device, heights.size)}
+    , water_{create_storage_buffer(device, heights.size)}
+    , flux_{create_storage_buffer(device,
+          VkDeviceSize{dimension} * dimension * sizeof(glm::vec4))}
+    , velocity_{create_storage_buffer(device,
+          VkDeviceSize{dimension} * dimension * sizeof(glm::vec2))}
+    , sediment_{create_storage_buffer(device, heights.size)}
+    , suspended_sediment_{create_storage_buffer(device, heights.size)}
+    , readback_buffer_{vkrndr::create_buffer(device,
+          heights.size,
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+              VK_MEMORY_PROPERTY_HOST_CACHED_BIT)}
+    , readback_map_{vkrndr::map_memory(device, readback_buffer_.allocation)}
+    , descriptor_set_layout_{create_descriptor_set_layout(device)}
+{
+    vkrndr::create_descriptor_sets(device_,
+        descriptor_set_layout_,
+        renderer_->descriptor_pool(),
+        std::span{&descriptor_set_, 1});
+
+    // Binding order matches the erosion compute shaders
+    std::array<vkrndr::vulkan_buffer const*, binding_count> const buffers{
+        heights_,
+        &eroded_heights_,
+        &water_,
+        &flux_,
+        &velocity_,
+        &sediment_,
+        &suspended_sediment_,
+        &normals};
+    bind_descriptor_set(device_, descriptor_set_, buffers);
+
+    auto const layout{vkrndr::vulkan_pipeline_layout_builder{device_}
+            .add_descriptor_set_layout(descriptor_set_layout_)
+            .add_push_constants({.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .offset = 0,
+                .size = sizeof(push_constants)})
+            .build()};
+
+    auto const create_pipeline = [this, &layout](char const* const shader)
+    {
+        return vkrndr::vulkan_compute_pipeline_builder{device_, layout}
+            .with_shader(shader, "main")
+            .build();
+    };
+    flux_pipeline_ = create_pipeline("erosion_flux.comp.spv");
+    water_pipeline_ = create_pipeline("erosion_water.comp.spv");
+    transport_pipeline_ = create_pipeline("erosion_transport.comp.spv");
+    thermal_pipeline_ = create_pipeline("erosion_thermal.comp.spv");
+    normals_pipeline_ = create_pipeline("terrain_normals.comp.spv");
+}
+
+soil::gpu_erosion::~gpu_erosion()
+{
+    destroy(device_, &normals_pipeline_);
+    destroy(device_, &thermal_pipeline_);
+    destroy(device_, &transport_pipeline_);
+    destroy(device_, &water_pipeline_);
+    destroy(device_, &flux_pipeline_);
+
+    vkFreeDescriptorSets(device_->logical,
+        renderer_->descriptor_pool(),
+        1,
+        &descriptor_set_);
+
+    vkDestroyDescriptorSetLayout(device_->logical,
+        descriptor_set_layout_,
+        nullptr);
+
+    unmap_memory(device_, &readback_map_);
+    destroy(device_, &readback_buffer_);
+
+    destroy(device_, &suspended_sediment_);
+    destroy(device_, &sediment_);
+    destroy(device_, &velocity_);
+    destroy(device_, &flux_);
+    destroy(device_, &water_);
+    destroy(device_, &eroded_heights_);
+}
+
+void soil::gpu_erosion::reset()
+{
+    clear_ = true;
+    readback_frame_.reset();
+}
+
+void soil::gpu_erosion::dispatch(VkCommandBuffer command_buffer,
+    erosion_settings const& settings,
+    uint32_t const iterations)
+{
+    if (clear_)
+    {
+        clear_buffers(command_buffer);
+        clear_ = false;
+    }
+
+    // Previous frames may still be reading heights and normals
+    memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_NONE);
+
+    push_constants const constants{.dimension = dimension_,
+        .time_step = settings.time_step,
+        .rain_rate = settings.rain_rate,
+        .pipe_flow = settings.pipe_flow,
+        .sediment_capacity = settings.sediment_capacity,
+        .dissolve_rate = settings.dissolve_rate,
+        .deposition_rate = settings.deposition_rate,
+        .evaporation_rate = settings.evaporation_rate,
+        .talus = settings.talus,
+        .thermal_rate = settings.thermal_rate,
+        .minimum_tilt = settings.minimum_tilt};
+
+    vkrndr::bind_pipeline(command_buffer,
+        flux_pipeline_,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        0,
+        std::span<VkDescriptorSet const>{&descriptor_set_, 1});
+    vkCmdPushConstants(command_buffer,
+        *flux_pipeline_.pipeline_layout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(push_constants),
+        &constants);
+
+    uint32_t const groups{(dimension_ + workgroup_size - 1) / workgroup_size};
+    auto const run = [&](vkrndr::vulkan_pipeline const& pipeline)
+    {
+        vkrndr::bind_pipeline(command_buffer,
+            pipeline,
+            VK_PIPELINE_BIND_POINT_COMPUTE);
+        vkCmdDispatch(command_buffer, groups, groups, 1);
+        compute_barrier(command_buffer);
+    };
+
+    for (uint32_t i{}; i != iterations; ++i)
+    {
+        run(flux_pipeline_);
+        run(water_pipeline_);
+        run(transport_pipeline_);
+        run(thermal_pipeline_);
+    }
+    run(normals_pipeline_);
+
+    bool const copy_heights{!readback_frame_};
+
+    memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_TRANSFER_READ_BIT);
+
+    if (copy_heights)
+    {
+        VkBufferCopy const region{.srcOffset = 0,
+            .dstOffset = 0,
+            .size = heights_->size};
+        vkCmdCopyBuffer(command_buffer,
+            heights_->buffer,
+            readback_buffer_.buffer,
+            1,
+            &region);
+
+        memory_barrier(command_buffer,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_HOST_BIT,
+            VK_ACCESS_2_HOST_READ_BIT);
+
+        readback_frame_ = renderer_->frame_number();
+    }
+}
+
+std::optional<std::span<float const>> soil::gpu_erosion::readback()
+{
+    if (!readback_frame_ || !renderer_->frame_finished(*readback_frame_))
+    {
+        return std::nullopt;
+    }
+    readback_frame_.reset();
+
+    vmaInvalidateAllocation(device_->allocator,
+        readback_buffer_.allocation,
+        0,
+        VK_WHOLE_SIZE);
+
+    return std::span{readback_map_.as<float const>(),
+        size_t{dimension_} * dimension_};
+}
+
+void soil::gpu_erosion::clear_buffers(VkCommandBuffer command_buffer)
+{
+    for (auto const* const buffer :
+        {&water_, &flux_, &velocity_, &sediment_, &suspended_sediment_})
+    {
+        vkCmdFillBuffer(command_buffer, buffer->buffer, 0, VK_WHOLE_SIZE, 0);
+    }
+
+    memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+}
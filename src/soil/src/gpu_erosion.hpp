@@ -0,0 +1,97 @@
+#ifndef SOIL_GPU_EROSION_INCLUDED
+#define SOIL_GPU_EROSION_INCLUDED
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_memory.hpp>
+#include <vulkan_pipeline.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    class vulkan_renderer;
+} // namespace vkrndr
+
+namespace soil
+{
+    struct erosion_settings;
+} // namespace soil
+
+namespace soil
+{
+    // Runs erosion compute passes over a height buffer and recalculates
+    // vertex normals of the eroded terrain
+    class [[nodiscard]] gpu_erosion final
+    {
+    public:
+        gpu_erosion(vkrndr::vulkan_device* device,
+            vkrndr::vulkan_renderer* renderer,
+            vkrndr::vulkan_buffer const& heights,
+            vkrndr::vulkan_buffer const& normals,
+            uint32_t dimension);
+
+        gpu_erosion(gpu_erosion const&) = delete;
+
+        gpu_erosion(gpu_erosion&&) noexcept = delete;
+
+    public:
+        ~gpu_erosion();
+
+    public:
+        // Clears water and sediment, cancels pending readback
+        void reset();
+
+        // Records erosion iterations, must be called outside of a render pass
+        void dispatch(VkCommandBuffer command_buffer,
+            erosion_settings const& settings,
+            uint32_t iterations);
+
+        // Heights copied back by an earlier dispatch, available once the
+        // frame which recorded the copy is no longer in flight
+        [[nodiscard]] std::optional<std::span<float const>> readback();
+
+    public:
+        gpu_erosion& operator=(gpu_erosion const&) = delete;
+
+        gpu_erosion& operator=(gpu_erosion&&) noexcept = delete;
+
+    private:
+        void clear_buffers(VkCommandBuffer command_buffer);
+
+    private:
+        vkrndr::vulkan_device* device_;
+        vkrndr::vulkan_renderer* renderer_;
+        vkrndr::vulkan_buffer const* heights_;
+        uint32_t dimension_;
+
+        vkrndr::vulkan_buffer eroded_heights_;
+        vkrndr::vulkan_buffer water_;
+        vkrndr::vulkan_buffer flux_;
+        vkrndr::vulkan_buffer velocity_;
+        vkrndr::vulkan_buffer sediment_;
+        vkrndr::vulkan_buffer suspended_sediment_;
+
+        vkrndr::vulkan_buffer readback_buffer_;
+        vkrndr::mapped_memory readback_map_{};
+        // Frame which recorded the pending copy
+        std::optional<uint64_t> readback_frame_;
+
+        VkDescriptorSetLayout descriptor_set_layout_{VK_NULL_HANDLE};
+        VkDescriptorSet descriptor_set_{VK_NULL_HANDLE};
+
+        vkrndr::vulkan_pipeline flux_pipeline_;
+        vkrndr::vulkan_pipeline water_pipeline_;
+        vkrndr::vulkan_pipeline transport_pipeline_;
+        vkrndr::vulkan_pipeline thermal_pipeline_;
+        vkrndr::vulkan_pipeline normals_pipeline_;
+
+        bool clear_{true};
+    };
+} // namespace soil
+
+#endif
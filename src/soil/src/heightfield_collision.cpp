@@ -0,0 +1,1439 @@
+#include <heightfield_collision.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <BulletCollision/BroadphaseCollision/btBroadphaseProxy.h>
+#include <BulletCollision/BroadphaseCollision/btCollisionAlgorithm.h>
+#include <BulletCollision/BroadphaseCollision/btDispatcher.h>
+#include <BulletCollision/CollisionDispatch/btActivatingCollisionAlgorithm.h>
+#include <BulletCollision/CollisionDispatch/btCollisionConfiguration.h>
+#include <BulletCollision/CollisionDispatch/btCollisionCreateFunc.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcher.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObject.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h>
+#include <BulletCollision/CollisionDispatch/btManifoldResult.h>
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
+#include <BulletCollision/CollisionShapes/btCapsuleShape.h>
+#include <BulletCollision/CollisionShapes/btCollisionShape.h>
+#include <BulletCollision/CollisionShapes/btSphereShape.h>
+#include <BulletCollision/NarrowPhaseCollision/btPersistentManifold.h>
+#include <LinearMath/btMatrix3x3.h>
+#include <LinearMath/btScalar.h>
+#include <LinearMath/btTransform.h>
+#include <LinearMath/btVector3.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOIL_HEIGHTFIELD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    constexpr size_t lane_count{4};
+
+    using lane_array = std::array<float, lane_count>;
+
+#ifdef SOIL_HEIGHTFIELD_SSE2
+    struct [[nodiscard]] lanes final
+    {
+        __m128 v;
+    };
+
+    struct [[nodiscard]] lane_mask final
+    {
+        __m128 v;
+    };
+
+    [[nodiscard]] lanes broadcast(float const value)
+    {
+        return {_mm_set1_ps(value)};
+    }
+
+    [[nodiscard]] lanes load(lane_array const& values)
+    {
+        return {_mm_loadu_ps(values.data())};
+    }
+
+    void store(lanes const a, lane_array& values)
+    {
+        _mm_storeu_ps(values.data(), a.v);
+    }
+
+    [[nodiscard]] lanes operator+(lanes const a, lanes const b)
+    {
+        return {_mm_add_ps(a.v, b.v)};
+    }
+
+    [[nodiscard]] lanes operator-(lanes const a, lanes const b)
+    {
+        return {_mm_sub_ps(a.v, b.v)};
+    }
+
+    [[nodiscard]] lanes operator*(lanes const a, lanes const b)
+    {
+        return {_mm_mul_ps(a.v, b.v)};
+    }
+
+    [[nodiscard]] lanes operator/(lanes const a, lanes const b)
+    {
+        return {_mm_div_ps(a.v, b.v)};
+    }
+
+    [[nodiscard]] lanes min(lanes const a, lanes const b)
+    {
+        return {_mm_min_ps(a.v, b.v)};
+    }
+
+    [[nodiscard]] lanes max(lanes const a, lanes const b)
+    {
+        return {_mm_max_ps(a.v, b.v)};
+    }
+
+    [[nodiscard]] lanes sqrt(lanes const a) { return {_mm_sqrt_ps(a.v)}; }
+
+    [[nodiscard]] lane_mask operator<(lanes const a, lanes const b)
+    {
+        return {_mm_cmplt_ps(a.v, b.v)};
+    }
+
+    [[nodiscard]] lane_mask operator<=(lanes const a, lanes const b)
+    {
+        return {_mm_cmple_ps(a.v, b.v)};
+    }
+
+    [[nodiscard]] lane_mask operator&(lane_mask const a, lane_mask const b)
+    {
+        return {_mm_and_ps(a.v, b.v)};
+    }
+
+    [[nodiscard]] lanes select(lane_mask const mask,
+        lanes const a,
+        lanes const b)
+    {
+        return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+    }
+
+    [[nodiscard]] bool any(lane_mask const mask)
+    {
+        return _mm_movemask_ps(mask.v) != 0;
+    }
+#else
+    struct [[nodiscard]] lanes final
+    {
+        lane_array v;
+    };
+
+    struct [[nodiscard]] lane_mask final
+    {
+        std::array<bool, lane_count> v;
+    };
+
+    template<typename Function>
+    [[nodiscard]] lanes transform(Function&& function)
+    {
+        lanes rv; // NOLINT
+        for (size_t i{}; i != lane_count; ++i)
+        {
+            rv.v[i] = function(i);
+        }
+        return rv;
+    }
+
+    template<typename Function>
+    [[nodiscard]] lane_mask compare(Function&& function)
+    {
+        lane_mask rv; // NOLINT
+        for (size_t i{}; i != lane_count; ++i)
+        {
+            rv.v[i] = function(i);
+        }
+        return rv;
+    }
+
+    [[nodiscard]] lanes broadcast(float const value)
+    {
+        return transform([value](size_t) { return value; });
+    }
+
+    [[nodiscard]] lanes load(lane_array const& values) { return {values}; }
+
+    void store(lanes const a, lane_array& values) { values = a.v; }
+
+    [[nodiscard]] lanes operator+(lanes const a, lanes const b)
+    {
+        return transform([&](size_t i) { return a.v[i] + b.v[i]; });
+    }
+
+    [[nodiscard]] lanes operator-(lanes const a, lanes const b)
+    {
+        return transform([&](size_t i) { return a.v[i] - b.v[i]; });
+    }
+
+    [[nodiscard]] lanes operator*(lanes const a, lanes const b)
+    {
+        return transform([&](size_t i) { return a.v[i] * b.v[i]; });
+    }
+
+    [[nodiscard]] lanes operator/(lanes const a, lanes const b)
+    {
+        return transform([&](size_t i) { return a.v[i] / b.v[i]; });
+    }
+
+    [[nodiscard]] lanes min(lanes const a, lanes const b)
+    {
+        return transform([&](size_t i) { return std::min(a.v[i], b.v[i]); });
+    }
+
+    [[nodiscard]] lanes max(lanes const a, lanes const b)
+    {
+        return transform([&](size_t i) { return std::max(a.v[i], b.v[i]); });
+    }
+
+    [[nodiscard]] lanes sqrt(lanes const a)
+    {
+        return transform([&](size_t i) { return std::sqrt(a.v[i]); });
+    }
+
+    [[nodiscard]] lane_mask operator<(lanes const a, lanes const b)
+    {
+        return compare([&](size_t i) { return a.v[i] < b.v[i]; });
+    }
+
+    [[nodiscard]] lane_mask operator<=(lanes const a, lanes const b)
+    {
+        return compare([&](size_t i) { return a.v[i] <= b.v[i]; });
+    }
+
+    [[nodiscard]] lane_mask operator&(lane_mask const a, lane_mask const b)
+    {
+        return compare([&](size_t i) { return a.v[i] && b.v[i]; });
+    }
+
+    [[nodiscard]] lanes select(lane_mask const mask,
+        lanes const a,
+        lanes const b)
+    {
+        return transform([&](size_t i) { return mask.v[i] ? a.v[i] : b.v[i]; });
+    }
+
+    [[nodiscard]] bool any(lane_mask const mask)
+    {
+        return std::ranges::any_of(mask.v, [](bool const b) { return b; });
+    }
+#endif
+
+    [[nodiscard]] lanes clamp01(lanes const a)
+    {
+        return min(max(a, broadcast(0.0f)), broadcast(1.0f));
+    }
+
+    struct [[nodiscard]] lanes3 final
+    {
+        lanes x;
+        lanes y;
+        lanes z;
+    };
+
+    [[nodiscard]] lanes3 broadcast(btVector3 const& value)
+    {
+        return {broadcast(value.x()),
+            broadcast(value.y()),
+            broadcast(value.z())};
+    }
+
+    [[nodiscard]] lanes3 operator+(lanes3 const& a, lanes3 const& b)
+    {
+        return {a.x + b.x, a.y + b.y, a.z + b.z};
+    }
+
+    [[nodiscard]] lanes3 operator-(lanes3 const& a, lanes3 const& b)
+    {
+        return {a.x - b.x, a.y - b.y, a.z - b.z};
+    }
+
+    [[nodiscard]] lanes3 operator*(lanes3 const& a, lanes const b)
+    {
+        return {a.x * b, a.y * b, a.z * b};
+    }
+
+    [[nodiscard]] lanes dot(lanes3 const& a, lanes3 const& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    [[nodiscard]] lanes3 cross(lanes3 const& a, lanes3 const& b)
+    {
+        return {a.y * b.z - a.z * b.y,
+            a.z * b.x - a.x * b.z,
+            a.x * b.y - a.y * b.x};
+    }
+
+    [[nodiscard]] lanes3 select(lane_mask const mask,
+        lanes3 const& a,
+        lanes3 const& b)
+    {
+        return {select(mask, a.x, b.x),
+            select(mask, a.y, b.y),
+            select(mask, a.z, b.z)};
+    }
+
+    struct [[nodiscard]] lane_array3 final
+    {
+        lane_array x;
+        lane_array y;
+        lane_array z;
+
+        [[nodiscard]] btVector3 operator[](size_t const i) const
+        {
+            return {x[i], y[i], z[i]};
+        }
+    };
+
+    [[nodiscard]] lanes3 load(lane_array3 const& values)
+    {
+        return {load(values.x), load(values.y), load(values.z)};
+    }
+
+    void store(lanes3 const& a, lane_array3& values)
+    {
+        store(a.x, values.x);
+        store(a.y, values.y);
+        store(a.z, values.z);
+    }
+
+    // Below this distances are treated as touching and directions come from
+    // the triangle
+    constexpr float touching_distance{1e-6f};
+
+    struct [[nodiscard]] triangle_lanes final
+    {
+        lanes3 a;
+        lanes3 b;
+        lanes3 c;
+    };
+
+    struct [[nodiscard]] closest_lanes final
+    {
+        // Point on the triangle
+        lanes3 point;
+        // Unit direction from the point towards the query
+        lanes3 normal;
+        // Signed above or below the triangle, positive near its edges
+        lanes distance;
+    };
+
+    [[nodiscard]] lanes3 closest_on_segment(lanes3 const& a,
+        lanes3 const& ab,
+        lanes3 const& p)
+    {
+        return a + ab * clamp01(dot(p - a, ab) / dot(ab, ab));
+    }
+
+    // Triangles are wound so that their normal points up
+    [[nodiscard]] closest_lanes closest_to_point(triangle_lanes const& t,
+        lanes3 const& p)
+    {
+        lanes const zero{broadcast(0.0f)};
+
+        lanes3 const ab{t.b - t.a};
+        lanes3 const bc{t.c - t.b};
+        lanes3 const ca{t.a - t.c};
+        lanes3 const face{cross(ab, t.c - t.a)};
+        lanes3 const normal{face * (broadcast(1.0f) / sqrt(dot(face, face)))};
+
+        lanes3 const ap{p - t.a};
+        lane_mask const inside{(zero <= dot(cross(ab, ap), normal)) &
+            (zero <= dot(cross(bc, p - t.b), normal)) &
+            (zero <= dot(cross(ca, p - t.c), normal))};
+        lanes const plane_distance{dot(ap, normal)};
+
+        lanes3 const on_ab{closest_on_segment(t.a, ab, p)};
+        lanes3 const on_bc{closest_on_segment(t.b, bc, p)};
+        lanes3 const on_ca{closest_on_segment(t.c, ca, p)};
+        lanes const to_ab{dot(p - on_ab, p - on_ab)};
+        lanes const to_bc{dot(p - on_bc, p - on_bc)};
+        lanes const to_ca{dot(p - on_ca, p - on_ca)};
+
+        lane_mask const ab_closest{(to_ab <= to_bc) & (to_ab <= to_ca)};
+        lane_mask const bc_closest{to_bc <= to_ca};
+        lanes3 const edge_point{
+            select(ab_closest, on_ab, select(bc_closest, on_bc, on_ca))};
+        lanes const edge_distance{
+            sqrt(select(ab_closest, to_ab, min(to_bc, to_ca)))};
+        lanes3 const edge_normal{select(broadcast(touching_distance) <
+                edge_distance,
+            (p - edge_point) *
+                (broadcast(1.0f) /
+                    max(edge_distance, broadcast(touching_distance))),
+            normal)};
+
+        return {select(inside, p - normal * plane_distance, edge_point),
+            select(inside, normal, edge_normal),
+            select(inside, plane_distance, edge_distance)};
+    }
+
+    // Part of segment p + t * dp above or below the triangle, closest to its
+    // face. Distance is the largest float when there is none.
+    [[nodiscard]] closest_lanes closest_to_segment(triangle_lanes const& t,
+        lanes3 const& p,
+        lanes3 const& dp)
+    {
+        lanes const zero{broadcast(0.0f)};
+
+        lanes3 const face{cross(t.b - t.a, t.c - t.a)};
+        lanes3 const normal{face * (broadcast(1.0f) / sqrt(dot(face, face)))};
+
+        // Clip against planes through the edges, perpendicular to the face
+        lanes first{zero};
+        lanes last{broadcast(1.0f)};
+        for (auto const& [start, end] :
+            {std::pair{t.a, t.b}, std::pair{t.b, t.c}, std::pair{t.c, t.a}})
+        {
+            lanes3 const inward{cross(normal, end - start)};
+            lanes const from{dot(p - start, inward)};
+            lanes const to{dot(p + dp - start, inward)};
+            lanes const crossing{from / (from - to)};
+
+            first = select((from < zero) & (zero <= to),
+                max(first, crossing),
+                first);
+            last = select((to < zero) & (zero <= from),
+                min(last, crossing),
+                last);
+            // Both outside, leaves an empty range
+            first = select((from < zero) & (to < zero), broadcast(2.0f), first);
+        }
+
+        lanes3 const near{p + dp * first};
+        lanes3 const far{p + dp * last};
+        lanes const near_distance{dot(near - t.a, normal)};
+        lanes const far_distance{dot(far - t.a, normal)};
+        lane_mask const far_deeper{far_distance < near_distance};
+        lanes3 const deepest{select(far_deeper, far, near)};
+        lanes const distance{select(far_deeper, far_distance, near_distance)};
+
+        return {deepest - normal * distance,
+            normal,
+            select(first <= last,
+                distance,
+                broadcast(std::numeric_limits<float>::max()))};
+    }
+
+    // Closest points of segments p + s * dp and q + t * dq
+    [[nodiscard]] std::pair<lanes3, lanes3> closest_between_segments(
+        lanes3 const& p,
+        lanes3 const& dp,
+        lanes3 const& q,
+        lanes3 const& dq)
+    {
+        lanes const zero{broadcast(0.0f)};
+        lanes const one{broadcast(1.0f)};
+        lanes const epsilon{broadcast(touching_distance)};
+
+        lanes3 const r{p - q};
+        lanes const a{dot(dp, dp)};
+        lanes const b{dot(dp, dq)};
+        lanes const c{dot(dp, r)};
+        lanes const e{dot(dq, dq)};
+        lanes const f{dot(dq, r)};
+        lanes const denominator{a * e - b * b};
+
+        // Parallel segments use any point of the first one
+        lanes s{select(epsilon < denominator,
+            clamp01((b * f - c * e) / max(denominator, epsilon)),
+            zero)};
+        lanes const t{(b * s + f) / e};
+        s = select(t < zero,
+            clamp01(zero - c / a),
+            select(one < t, clamp01((b - c) / a), s));
+
+        return {p + dp * s, q + dq * clamp01(t)};
+    }
+
+    // Heights of a heightfield in its local space
+    struct [[nodiscard]] grid final
+    {
+        float const* heights;
+        int dimension;
+        float height_offset;
+
+        [[nodiscard]] float half_extent() const
+        {
+            return cppext::as_fp(dimension - 1) / 2.0f;
+        }
+
+        [[nodiscard]] float height(int const x, int const z) const
+        {
+            return heights[static_cast<size_t>(z) *
+                       static_cast<size_t>(dimension) +
+                       static_cast<size_t>(x)] -
+                height_offset;
+        }
+
+        [[nodiscard]] btVector3 vertex(int const x, int const z) const
+        {
+            return {cppext::as_fp(x) - half_extent(),
+                height(x, z),
+                cppext::as_fp(z) - half_extent()};
+        }
+    };
+
+    // Inclusive range of grid cells or vertices
+    struct [[nodiscard]] grid_range final
+    {
+        int min_x;
+        int min_z;
+        int max_x;
+        int max_z;
+
+        [[nodiscard]] bool empty() const
+        {
+            return min_x > max_x || min_z > max_z;
+        }
+    };
+
+    [[nodiscard]] grid_range overlapped_cells(grid const& g,
+        btVector3 const& min,
+        btVector3 const& max)
+    {
+        float const half{g.half_extent()};
+        int const last{g.dimension - 2};
+        return {std::max(static_cast<int>(std::floor(min.x() + half)), 0),
+            std::max(static_cast<int>(std::floor(min.z() + half)), 0),
+            std::min(static_cast<int>(std::floor(max.x() + half)), last),
+            std::min(static_cast<int>(std::floor(max.z() + half)), last)};
+    }
+
+    [[nodiscard]] grid_range overlapped_vertices(grid const& g,
+        btVector3 const& min,
+        btVector3 const& max)
+    {
+        float const half{g.half_extent()};
+        int const last{g.dimension - 1};
+        return {std::max(static_cast<int>(std::ceil(min.x() + half)), 0),
+            std::max(static_cast<int>(std::ceil(min.z() + half)), 0),
+            std::min(static_cast<int>(std::floor(max.x() + half)), last),
+            std::min(static_cast<int>(std::floor(max.z() + half)), last)};
+    }
+
+    struct [[nodiscard]] triangle_batch final
+    {
+        std::array<lane_array3, 3> vertices;
+        size_t count{};
+
+        void push(btVector3 const& a, btVector3 const& b, btVector3 const& c)
+        {
+            assert(count != lane_count);
+
+            set(count, a, b, c);
+            ++count;
+        }
+
+        // Unused lanes repeat the first triangle to stay finite
+        [[nodiscard]] triangle_lanes gather()
+        {
+            for (size_t i{count}; i != lane_count; ++i)
+            {
+                set(i, vertices[0][0], vertices[1][0], vertices[2][0]);
+            }
+            return {load(vertices[0]), load(vertices[1]), load(vertices[2])};
+        }
+
+    private:
+        void set(size_t const lane,
+            btVector3 const& a,
+            btVector3 const& b,
+            btVector3 const& c)
+        {
+            set(vertices[0], lane, a);
+            set(vertices[1], lane, b);
+            set(vertices[2], lane, c);
+        }
+
+        static void set(lane_array3& vertex,
+            size_t const lane,
+            btVector3 const& value)
+        {
+            vertex.x[lane] = value.x();
+            vertex.y[lane] = value.y();
+            vertex.z[lane] = value.z();
+        }
+    };
+
+    // Calls function with batches of triangles of the cells in range which
+    // aren't completely below min_height. Each cell is split along the
+    // diagonal from (x + 1, z) to (x, z + 1), same as in
+    // btHeightfieldTerrainShape.
+    template<typename Function>
+    void for_each_triangle_batch(grid const& g,
+        grid_range const& range,
+        float const min_height,
+        Function&& function)
+    {
+        triangle_batch batch;
+        for (int z{range.min_z}; z <= range.max_z; ++z)
+        {
+            for (int x{range.min_x}; x <= range.max_x; ++x)
+            {
+                btVector3 const v00{g.vertex(x, z)};
+                btVector3 const v10{g.vertex(x + 1, z)};
+                btVector3 const v01{g.vertex(x, z + 1)};
+                btVector3 const v11{g.vertex(x + 1, z + 1)};
+
+                if (std::max({v00.y(), v10.y(), v01.y(), v11.y()}) <
+                    min_height)
+                {
+                    continue;
+                }
+
+                batch.push(v00, v01, v10);
+                batch.push(v10, v01, v11);
+                if (batch.count == lane_count)
+                {
+                    function(batch.gather(), batch.count);
+                    batch.count = 0;
+                }
+            }
+        }
+
+        if (batch.count != 0)
+        {
+            function(batch.gather(), batch.count);
+        }
+    }
+
+    // Sink is called with the point on the heightfield, unit normal towards
+    // the convex and signed distance, all in heightfield space
+    template<typename Sink>
+    void emit(closest_lanes const& closest,
+        lanes const radius,
+        size_t const count,
+        float const threshold,
+        Sink& sink)
+    {
+        lanes const distance{closest.distance - radius};
+        if (!any(distance < broadcast(threshold)))
+        {
+            return;
+        }
+
+        lane_array3 points; // NOLINT
+        lane_array3 normals; // NOLINT
+        lane_array distances; // NOLINT
+        store(closest.point, points);
+        store(closest.normal, normals);
+        store(distance, distances);
+        for (size_t i{}; i != count; ++i)
+        {
+            if (distances[i] < threshold)
+            {
+                sink(points[i], normals[i], distances[i]);
+            }
+        }
+    }
+
+    template<typename Sink>
+    void collide_sphere(grid const& g,
+        btVector3 const& center,
+        float const radius,
+        float const threshold,
+        Sink& sink)
+    {
+        float const reach{radius + threshold};
+        btVector3 const extent{reach, reach, reach};
+        grid_range const range{
+            overlapped_cells(g, center - extent, center + extent)};
+        if (range.empty())
+        {
+            return;
+        }
+
+        lanes3 const p{broadcast(center)};
+        lanes const r{broadcast(radius)};
+        for_each_triangle_batch(g,
+            range,
+            center.y() - reach,
+            [&](triangle_lanes const& triangles, size_t const count)
+            {
+                emit(closest_to_point(triangles, p),
+                    r,
+                    count,
+                    threshold,
+                    sink);
+            });
+    }
+
+    template<typename Sink>
+    void collide_capsule(grid const& g,
+        btVector3 const& from,
+        btVector3 const& to,
+        float const radius,
+        float const threshold,
+        Sink& sink)
+    {
+        float const reach{radius + threshold};
+        btVector3 lower{from};
+        lower.setMin(to);
+        btVector3 upper{from};
+        upper.setMax(to);
+        grid_range const range{overlapped_cells(g,
+            lower - btVector3{reach, reach, reach},
+            upper + btVector3{reach, reach, reach})};
+        if (range.empty())
+        {
+            return;
+        }
+
+        lanes3 const p0{broadcast(from)};
+        lanes3 const p1{broadcast(to)};
+        lanes3 const axis{p1 - p0};
+        lanes const r{broadcast(radius)};
+        lanes const epsilon{broadcast(touching_distance)};
+
+        for_each_triangle_batch(g,
+            range,
+            lower.y() - reach,
+            [&](triangle_lanes const& t, size_t const count)
+            {
+                // Axis over the face, then the axis against each edge
+                closest_lanes best{closest_to_segment(t, p0, axis)};
+                for (auto const& [start, edge] :
+                    {std::pair{t.a, t.b - t.a},
+                        std::pair{t.b, t.c - t.b},
+                        std::pair{t.c, t.a - t.c}})
+                {
+                    auto const [on_axis, on_edge]{
+                        closest_between_segments(p0, axis, start, edge)};
+                    lanes3 const offset{on_axis - on_edge};
+                    lanes const distance{sqrt(dot(offset, offset))};
+
+                    lane_mask const closer{distance < best.distance};
+                    lanes3 const normal{select(epsilon < distance,
+                        offset * (broadcast(1.0f) / max(distance, epsilon)),
+                        best.normal)};
+                    best = {select(closer, on_edge, best.point),
+                        select(closer, normal, best.normal),
+                        select(closer, distance, best.distance)};
+                }
+
+                emit(best, r, count, threshold, sink);
+            });
+    }
+
+    // Corners of the box against the triangle below or above them
+    template<typename Sink>
+    void collide_box_corners(grid const& g,
+        btTransform const& box,
+        btVector3 const& half_extents,
+        float const threshold,
+        Sink& sink)
+    {
+        float const half{g.half_extent()};
+        int const last{g.dimension - 2};
+
+        for (size_t first{}; first != 8; first += lane_count)
+        {
+            lane_array3 corners; // NOLINT
+            lane_array fx; // NOLINT
+            lane_array fz; // NOLINT
+            std::array<lane_array, 4> heights; // NOLINT
+            std::array<bool, lane_count> valid; // NOLINT
+
+            for (size_t i{}; i != lane_count; ++i)
+            {
+                size_t const corner{first + i};
+                btVector3 const sign{(corner & 1) ? 1.0f : -1.0f,
+                    (corner & 2) ? 1.0f : -1.0f,
+                    (corner & 4) ? 1.0f : -1.0f};
+                btVector3 const position{box(half_extents * sign)};
+                corners.x[i] = position.x();
+                corners.y[i] = position.y();
+                corners.z[i] = position.z();
+
+                float const gx{position.x() + half};
+                float const gz{position.z() + half};
+                auto const x{static_cast<int>(std::floor(gx))};
+                auto const z{static_cast<int>(std::floor(gz))};
+                valid[i] = x >= 0 && z >= 0 && x <= last && z <= last;
+                if (!valid[i])
+                {
+                    fx[i] = fz[i] = 0.0f;
+                    heights[0][i] = heights[1][i] = heights[2][i] =
+                        heights[3][i] = 0.0f;
+                    continue;
+                }
+
+                fx[i] = gx - cppext::as_fp(x);
+                fz[i] = gz - cppext::as_fp(z);
+                heights[0][i] = g.height(x, z);
+                heights[1][i] = g.height(x + 1, z);
+                heights[2][i] = g.height(x, z + 1);
+                heights[3][i] = g.height(x + 1, z + 1);
+            }
+
+            lanes const one{broadcast(1.0f)};
+            lanes const x{load(fx)};
+            lanes const z{load(fz)};
+            lanes const h00{load(heights[0])};
+            lanes const h10{load(heights[1])};
+            lanes const h01{load(heights[2])};
+            lanes const h11{load(heights[3])};
+
+            // Height and slope of the triangle containing the corner
+            lane_mask const first_triangle{x + z <= one};
+            lanes const slope_x{select(first_triangle, h10 - h00, h11 - h01)};
+            lanes const slope_z{select(first_triangle, h01 - h00, h11 - h10)};
+            lanes const height{select(first_triangle,
+                h00 + x * slope_x + z * slope_z,
+                h11 - (one - x) * slope_x - (one - z) * slope_z)};
+
+            lanes const zero{broadcast(0.0f)};
+            lanes3 const face{zero - slope_x, one, zero - slope_z};
+            lanes const inverse_length{one / sqrt(dot(face, face))};
+            lanes3 const normal{face * inverse_length};
+
+            lanes3 const corner{load(corners)};
+            lanes const distance{(corner.y - height) * inverse_length};
+
+            lane_array3 points; // NOLINT
+            lane_array3 normals; // NOLINT
+            lane_array distances; // NOLINT
+            store(corner - normal * distance, points);
+            store(normal, normals);
+            store(distance, distances);
+            for (size_t i{}; i != lane_count; ++i)
+            {
+                if (valid[i] && distances[i] < threshold)
+                {
+                    sink(points[i], normals[i], distances[i]);
+                }
+            }
+        }
+    }
+
+    // Heightfield vertices inside the box, pushed out through the nearest
+    // face of the box
+    template<typename Sink>
+    void collide_box_vertices(grid const& g,
+        btTransform const& box,
+        btVector3 const& half_extents,
+        btVector3 const& aabb_min,
+        btVector3 const& aabb_max,
+        Sink& sink)
+    {
+        grid_range const range{overlapped_vertices(g, aabb_min, aabb_max)};
+        if (range.empty())
+        {
+            return;
+        }
+
+        btMatrix3x3 const& basis{box.getBasis()};
+        lanes3 const center{broadcast(box.getOrigin())};
+        std::array<lanes3, 3> const axes{broadcast(basis.getColumn(0)),
+            broadcast(basis.getColumn(1)),
+            broadcast(basis.getColumn(2))};
+        lanes3 const extents{broadcast(half_extents)};
+
+        lanes const zero{broadcast(0.0f)};
+        for (int z{range.min_z}; z <= range.max_z; ++z)
+        {
+            for (int first{range.min_x}; first <= range.max_x;
+                first += static_cast<int>(lane_count))
+            {
+                auto const count{static_cast<size_t>(
+                    std::min(range.max_x - first + 1,
+                        static_cast<int>(lane_count)))};
+
+                lane_array3 vertices; // NOLINT
+                for (size_t i{}; i != lane_count; ++i)
+                {
+                    btVector3 const vertex{g.vertex(
+                        first + static_cast<int>(std::min(i, count - 1)),
+                        z)};
+                    vertices.x[i] = vertex.x();
+                    vertices.y[i] = vertex.y();
+                    vertices.z[i] = vertex.z();
+                }
+
+                lanes3 const vertex{load(vertices)};
+                lanes3 const offset{vertex - center};
+                lanes3 const local{dot(offset, axes[0]),
+                    dot(offset, axes[1]),
+                    dot(offset, axes[2])};
+                // Depth of the vertex below each face
+                lanes3 const depth{extents.x - max(local.x, zero - local.x),
+                    extents.y - max(local.y, zero - local.y),
+                    extents.z - max(local.z, zero - local.z)};
+
+                lane_mask const inside{
+                    (zero < depth.x) & (zero < depth.y) & (zero < depth.z)};
+                if (!any(inside))
+                {
+                    continue;
+                }
+
+                lane_mask const x_nearest{
+                    (depth.x <= depth.y) & (depth.x <= depth.z)};
+                lane_mask const y_nearest{depth.y <= depth.z};
+                lanes const nearest_depth{select(x_nearest,
+                    depth.x,
+                    select(y_nearest, depth.y, depth.z))};
+                lanes const nearest_local{select(x_nearest,
+                    local.x,
+                    select(y_nearest, local.y, local.z))};
+                lanes3 const nearest_axis{select(x_nearest,
+                    axes[0],
+                    select(y_nearest, axes[1], axes[2]))};
+
+                // Box moves away from the vertex through the nearest face
+                lanes const direction{select(nearest_local < zero,
+                    broadcast(1.0f),
+                    broadcast(-1.0f))};
+
+                lane_array3 normals; // NOLINT
+                lane_array distances; // NOLINT
+                lane_array inside_lanes; // NOLINT
+                store(nearest_axis * direction, normals);
+                store(zero - nearest_depth, distances);
+                store(select(inside, broadcast(1.0f), zero), inside_lanes);
+                for (size_t i{}; i != count; ++i)
+                {
+                    if (inside_lanes[i] != 0.0f)
+                    {
+                        sink(vertices[i], normals[i], distances[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Edges of the box against ridges of the grid, a box lying across a
+    // ridge between two vertices has neither a corner below the surface nor
+    // a vertex inside of it. A pair of edges touches along the direction
+    // perpendicular to both when it is within the normal cones of the faces
+    // next to each edge.
+    template<typename Sink>
+    void collide_box_edges(grid const& g,
+        btTransform const& box,
+        btVector3 const& half_extents,
+        btVector3 const& aabb_min,
+        btVector3 const& aabb_max,
+        float const threshold,
+        Sink& sink)
+    {
+        btVector3 const reach{threshold, threshold, threshold};
+        grid_range const range{
+            overlapped_cells(g, aabb_min - reach, aabb_max + reach)};
+        if (range.empty())
+        {
+            return;
+        }
+
+        // Four edges parallel to each axis of the box, with outward normals
+        // of the two faces next to them
+        struct [[nodiscard]] box_edges final
+        {
+            lanes3 start;
+            lanes3 direction;
+            lanes3 face0;
+            lanes3 face1;
+        };
+
+        btMatrix3x3 const& basis{box.getBasis()};
+        std::array<box_edges, 3> edges; // NOLINT
+        for (int axis{}; axis != 3; ++axis)
+        {
+            int const u{(axis + 1) % 3};
+            int const v{(axis + 2) % 3};
+
+            lane_array3 starts; // NOLINT
+            lane_array3 faces0; // NOLINT
+            lane_array3 faces1; // NOLINT
+            for (size_t i{}; i != lane_count; ++i)
+            {
+                btVector3 sign{0, 0, 0};
+                sign[axis] = -1.0f;
+                sign[u] = (i & 1) ? 1.0f : -1.0f;
+                sign[v] = (i & 2) ? 1.0f : -1.0f;
+                btVector3 const start{box(half_extents * sign)};
+                btVector3 const face0{basis.getColumn(u) * sign[u]};
+                btVector3 const face1{basis.getColumn(v) * sign[v]};
+                starts.x[i] = start.x();
+                starts.y[i] = start.y();
+                starts.z[i] = start.z();
+                faces0.x[i] = face0.x();
+                faces0.y[i] = face0.y();
+                faces0.z[i] = face0.z();
+                faces1.x[i] = face1.x();
+                faces1.y[i] = face1.y();
+                faces1.z[i] = face1.z();
+            }
+
+            edges[static_cast<size_t>(axis)] = {load(starts),
+                broadcast(basis.getColumn(axis) * (2.0f * half_extents[axis])),
+                load(faces0),
+                load(faces1)};
+        }
+
+        lanes const zero{broadcast(0.0f)};
+        lanes const one{broadcast(1.0f)};
+        lanes const epsilon{broadcast(touching_distance)};
+        lanes const limit{broadcast(threshold)};
+
+        // Edge from a to b shared by the triangles with the opposite
+        // vertices
+        auto const collide_edge = [&](btVector3 const& a,
+                                      btVector3 const& b,
+                                      btVector3 const& opposite0,
+                                      btVector3 const& opposite1)
+        {
+            if (std::max(a.y(), b.y()) + threshold < aabb_min.y())
+            {
+                return;
+            }
+
+            btVector3 const edge{b - a};
+            btVector3 normal0{edge.cross(opposite0 - a).normalized()};
+            btVector3 normal1{edge.cross(opposite1 - a).normalized()};
+            normal0 *= normal0.y() < 0.0f ? -1.0f : 1.0f;
+            normal1 *= normal1.y() < 0.0f ? -1.0f : 1.0f;
+
+            // Only ridges, corners of the box cover valleys and flat edges
+            if (normal0.dot(opposite1 - a) > -touching_distance)
+            {
+                return;
+            }
+
+            lanes3 const q{broadcast(a)};
+            lanes3 const dq{broadcast(edge)};
+            lanes3 const n0{broadcast(normal0)};
+            lanes3 const n1{broadcast(normal1)};
+            lanes3 const outward{n0 + n1};
+            lanes const winding{broadcast(normal0.cross(normal1).dot(edge))};
+
+            for (box_edges const& e : edges)
+            {
+                lanes3 const perpendicular{cross(e.direction, dq)};
+                lanes const length{sqrt(dot(perpendicular, perpendicular))};
+                lanes3 axis{perpendicular * (one / max(length, epsilon))};
+                axis = axis *
+                    select(dot(axis, outward) < zero, broadcast(-1.0f), one);
+
+                // Axis between the face normals of the ridge, the box faces
+                // next to its edge look down the axis
+                lane_mask const ridge_cone{
+                    (zero <= dot(cross(n0, axis), dq) * winding) &
+                    (zero <= dot(cross(axis, n1), dq) * winding)};
+                lane_mask const box_cone{(dot(axis, e.face0) <= zero) &
+                    (dot(axis, e.face1) <= zero)};
+
+                // Closest points of the lines have to be inside of both
+                // edges, otherwise a corner or a vertex is closer
+                lanes3 const r{e.start - q};
+                lanes const b{dot(e.direction, dq)};
+                lanes const c{dot(e.direction, r)};
+                lanes const f{dot(dq, r)};
+                lanes const denominator{max(length * length, epsilon)};
+                lanes const s{
+                    (b * f - c * dot(dq, dq)) / denominator};
+                lanes const t{
+                    (dot(e.direction, e.direction) * f - b * c) /
+                    denominator};
+                lane_mask const inside{(zero < s) & (s < one) & (zero < t) &
+                    (t < one)};
+
+                lanes const distance{dot(r, axis)};
+                lane_mask const touching{(epsilon < length) & ridge_cone &
+                    box_cone & inside & (distance < limit)};
+                if (!any(touching))
+                {
+                    continue;
+                }
+
+                lane_array3 points; // NOLINT
+                lane_array3 normals; // NOLINT
+                lane_array distances; // NOLINT
+                lane_array touching_lanes; // NOLINT
+                store(q + dq * t, points);
+                store(axis, normals);
+                store(distance, distances);
+                store(select(touching, one, zero), touching_lanes);
+                for (size_t i{}; i != lane_count; ++i)
+                {
+                    if (touching_lanes[i] != 0.0f)
+                    {
+                        sink(points[i], normals[i], distances[i]);
+                    }
+                }
+            }
+        };
+
+        // Edges along x and z between cells on the grid border have a single
+        // triangle and are skipped
+        int const last{g.dimension - 1};
+        for (int z{range.min_z}; z <= range.max_z + 1; ++z)
+        {
+            for (int x{range.min_x}; x <= range.max_x + 1; ++x)
+            {
+                if (x <= range.max_x && z > 0 && z < last)
+                {
+                    collide_edge(g.vertex(x, z),
+                        g.vertex(x + 1, z),
+                        g.vertex(x, z + 1),
+                        g.vertex(x + 1, z - 1));
+                }
+                if (z <= range.max_z && x > 0 && x < last)
+                {
+                    collide_edge(g.vertex(x, z),
+                        g.vertex(x, z + 1),
+                        g.vertex(x + 1, z),
+                        g.vertex(x - 1, z + 1));
+                }
+                if (x <= range.max_x && z <= range.max_z)
+                {
+                    collide_edge(g.vertex(x + 1, z),
+                        g.vertex(x, z + 1),
+                        g.vertex(x, z),
+                        g.vertex(x + 1, z + 1));
+                }
+            }
+        }
+    }
+
+    class [[nodiscard]] heightfield_algorithm final
+        : public btActivatingCollisionAlgorithm
+    {
+    public:
+        heightfield_algorithm(btCollisionAlgorithmConstructionInfo const& ci,
+            btCollisionObjectWrapper const* body0,
+            btCollisionObjectWrapper const* body1,
+            bool swapped);
+
+        heightfield_algorithm(heightfield_algorithm const&) = delete;
+
+        heightfield_algorithm(heightfield_algorithm&&) noexcept = delete;
+
+    public:
+        ~heightfield_algorithm() override;
+
+    public:
+        void processCollision(btCollisionObjectWrapper const* body0Wrap,
+            btCollisionObjectWrapper const* body1Wrap,
+            btDispatcherInfo const& dispatchInfo,
+            btManifoldResult* resultOut) override;
+
+        btScalar calculateTimeOfImpact(btCollisionObject* body0,
+            btCollisionObject* body1,
+            btDispatcherInfo const& dispatchInfo,
+            btManifoldResult* resultOut) override;
+
+        void getAllContactManifolds(btManifoldArray& manifoldArray) override;
+
+    public:
+        heightfield_algorithm& operator=(heightfield_algorithm const&) = delete;
+
+        heightfield_algorithm& operator=(
+            heightfield_algorithm&&) noexcept = delete;
+
+    private:
+        btPersistentManifold* manifold_;
+        bool owns_manifold_{};
+        bool swapped_;
+    };
+
+    heightfield_algorithm::heightfield_algorithm(
+        btCollisionAlgorithmConstructionInfo const& ci,
+        btCollisionObjectWrapper const* const body0,
+        btCollisionObjectWrapper const* const body1,
+        bool const swapped)
+        : btActivatingCollisionAlgorithm{ci, body0, body1}
+        , manifold_{ci.m_manifold}
+        , swapped_{swapped}
+    {
+        if (!manifold_)
+        {
+            // Contacts are kept with the convex as the first body
+            manifold_ = m_dispatcher->getNewManifold(
+                (swapped_ ? body1 : body0)->getCollisionObject(),
+                (swapped_ ? body0 : body1)->getCollisionObject());
+            owns_manifold_ = true;
+        }
+    }
+
+    heightfield_algorithm::~heightfield_algorithm()
+    {
+        if (owns_manifold_ && manifold_)
+        {
+            m_dispatcher->releaseManifold(manifold_);
+        }
+    }
+
+    void heightfield_algorithm::processCollision(
+        btCollisionObjectWrapper const* const body0Wrap,
+        btCollisionObjectWrapper const* const body1Wrap,
+        [[maybe_unused]] btDispatcherInfo const& dispatchInfo,
+        btManifoldResult* const resultOut)
+    {
+        btCollisionObjectWrapper const* const convex{
+            swapped_ ? body1Wrap : body0Wrap};
+        btCollisionObjectWrapper const* const terrain{
+            swapped_ ? body0Wrap : body1Wrap};
+
+        auto const& shape{static_cast<soil::heightfield_shape const&>(
+            *terrain->getCollisionShape())};
+        grid const g{shape.heights(),
+            cppext::narrow<int>(shape.dimension()),
+            shape.height_offset()};
+
+        btTransform const& terrain_transform{terrain->getWorldTransform()};
+        btTransform const local{
+            terrain_transform.inverseTimes(convex->getWorldTransform())};
+        float const threshold{manifold_->getContactBreakingThreshold() +
+            resultOut->m_closestPointDistanceThreshold};
+
+        resultOut->setPersistentManifold(manifold_);
+
+        // Normal passed to the result points towards its first body
+        auto sink = [&](btVector3 const& point,
+                        btVector3 const& normal,
+                        float const distance)
+        {
+            btVector3 const world_point{terrain_transform(point)};
+            btVector3 const world_normal{terrain_transform.getBasis() * normal};
+            if (swapped_)
+            {
+                resultOut->addContactPoint(-world_normal,
+                    world_point + world_normal * distance,
+                    distance);
+            }
+            else
+            {
+                resultOut->addContactPoint(world_normal, world_point, distance);
+            }
+        };
+
+        btCollisionShape const* const convex_shape{
+            convex->getCollisionShape()};
+        switch (convex_shape->getShapeType())
+        {
+        case SPHERE_SHAPE_PROXYTYPE:
+        {
+            auto const* const sphere{
+                static_cast<btSphereShape const*>(convex_shape)};
+            collide_sphere(g,
+                local.getOrigin(),
+                sphere->getRadius(),
+                threshold,
+                sink);
+            break;
+        }
+        case CAPSULE_SHAPE_PROXYTYPE:
+        {
+            auto const* const capsule{
+                static_cast<btCapsuleShape const*>(convex_shape)};
+            btVector3 axis{0, 0, 0};
+            axis[capsule->getUpAxis()] = capsule->getHalfHeight();
+            collide_capsule(g,
+                local(-axis),
+                local(axis),
+                capsule->getRadius(),
+                threshold,
+                sink);
+            break;
+        }
+        case BOX_SHAPE_PROXYTYPE:
+        {
+            auto const* const box{static_cast<btBoxShape const*>(convex_shape)};
+            btVector3 const half_extents{box->getHalfExtentsWithMargin()};
+            btVector3 aabb_min;
+            btVector3 aabb_max;
+            box->getAabb(local, aabb_min, aabb_max);
+
+            collide_box_corners(g, local, half_extents, threshold, sink);
+            collide_box_vertices(g,
+                local,
+                half_extents,
+                aabb_min,
+                aabb_max,
+                sink);
+
+            collide_box_edges(g,
+                local,
+                half_extents,
+                aabb_min,
+                aabb_max,
+                threshold,
+                sink);
+            break;
+        }
+        default:
+            assert(false);
+            break;
+        }
+
+        if (owns_manifold_)
+        {
+            resultOut->refreshContactPoints();
+        }
+    }
+
+    btScalar heightfield_algorithm::calculateTimeOfImpact(
+        [[maybe_unused]] btCollisionObject* const body0,
+        [[maybe_unused]] btCollisionObject* const body1,
+        [[maybe_unused]] btDispatcherInfo const& dispatchInfo,
+        [[maybe_unused]] btManifoldResult* const resultOut)
+    {
+        return btScalar{1};
+    }
+
+    void heightfield_algorithm::getAllContactManifolds(
+        btManifoldArray& manifoldArray)
+    {
+        if (manifold_ && owns_manifold_)
+        {
+            manifoldArray.push_back(manifold_);
+        }
+    }
+
+    class [[nodiscard]] create_function final
+        : public btCollisionAlgorithmCreateFunc
+    {
+    public:
+        create_function(btCollisionAlgorithmCreateFunc* const fallback,
+            bool const swapped)
+            : fallback_{fallback}
+        {
+            m_swapped = swapped;
+        }
+
+    public:
+        btCollisionAlgorithm* CreateCollisionAlgorithm(
+            btCollisionAlgorithmConstructionInfo& ci,
+            btCollisionObjectWrapper const* const body0Wrap,
+            btCollisionObjectWrapper const* const body1Wrap) override
+        {
+            // Only shapes created as heightfield_shape are read directly
+            auto const* const shape{
+                dynamic_cast<soil::heightfield_shape const*>(
+                    (m_swapped ? body0Wrap : body1Wrap)->getCollisionShape())};
+            // Time of impact isn't calculated, bodies with continuous
+            // collision detection enabled when the pair is created keep
+            // Bullet's algorithm
+            btCollisionObject const* const convex{
+                (m_swapped ? body1Wrap : body0Wrap)->getCollisionObject()};
+            if (!shape || shape->getLocalScaling() != btVector3{1, 1, 1} ||
+                convex->getCcdSquareMotionThreshold() > 0)
+            {
+                return fallback_->CreateCollisionAlgorithm(ci,
+                    body0Wrap,
+                    body1Wrap);
+            }
+
+            void* const memory{ci.m_dispatcher1->allocateCollisionAlgorithm(
+                sizeof(heightfield_algorithm))};
+            return new (memory)
+                heightfield_algorithm{ci, body0Wrap, body1Wrap, m_swapped};
+        }
+
+    private:
+        btCollisionAlgorithmCreateFunc* fallback_;
+    };
+} // namespace
+
+soil::heightfield_shape::heightfield_shape(size_t const dimension,
+    float const* const heights,
+    float const min_height,
+    float const max_height)
+    : btHeightfieldTerrainShape{cppext::narrow<int>(dimension),
+          cppext::narrow<int>(dimension),
+          heights,
+          min_height,
+          max_height,
+          1,
+          false}
+    , dimension_{dimension}
+    , heights_{heights}
+    , height_offset_{(min_height + max_height) / 2.0f}
+{
+}
+
+size_t soil::heightfield_shape::dimension() const { return dimension_; }
+
+float const* soil::heightfield_shape::heights() const { return heights_; }
+
+float soil::heightfield_shape::height_offset() const { return height_offset_; }
+
+soil::heightfield_collision::heightfield_collision(
+    btCollisionDispatcher* const dispatcher,
+    btCollisionConfiguration* const configuration)
+    : dispatcher_{dispatcher}
+{
+    for (int const convex :
+        {SPHERE_SHAPE_PROXYTYPE, CAPSULE_SHAPE_PROXYTYPE, BOX_SHAPE_PROXYTYPE})
+    {
+        for (bool const swapped : {false, true})
+        {
+            int const proxy_type0{swapped ? TERRAIN_SHAPE_PROXYTYPE : convex};
+            int const proxy_type1{swapped ? convex : TERRAIN_SHAPE_PROXYTYPE};
+
+            btCollisionAlgorithmCreateFunc* const fallback{
+                configuration->getCollisionAlgorithmCreateFunc(proxy_type0,
+                    proxy_type1)};
+            registrations_.push_back({proxy_type0,
+                proxy_type1,
+                false,
+                fallback,
+                std::make_unique<create_function>(fallback, swapped)});
+
+            btCollisionAlgorithmCreateFunc* const closest_points_fallback{
+                configuration->getClosestPointsAlgorithmCreateFunc(proxy_type0,
+                    proxy_type1)};
+            registrations_.push_back({proxy_type0,
+                proxy_type1,
+                true,
+                closest_points_fallback,
+                std::make_unique<create_function>(closest_points_fallback,
+                    swapped)});
+        }
+    }
+
+    set_enabled(true);
+}
+
+soil::heightfield_collision::~heightfield_collision() { set_enabled(false); }
+
+void soil::heightfield_collision::set_enabled(bool const enabled)
+{
+    for (registration const& r : registrations_)
+    {
+        btCollisionAlgorithmCreateFunc* const function{
+            enabled ? r.function.get() : r.fallback};
+        if (r.closest_points)
+        {
+            dispatcher_->registerClosestPointsCreateFunc(r.proxy_type0,
+                r.proxy_type1,
+                function);
+        }
+        else
+        {
+            dispatcher_->registerCollisionCreateFunc(r.proxy_type0,
+                r.proxy_type1,
+                function);
+        }
+    }
+
+    enabled_ = enabled;
+}
+
+bool soil::heightfield_collision::enabled() const { return enabled_; }
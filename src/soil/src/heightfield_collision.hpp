@@ -0,0 +1,99 @@
+#ifndef SOIL_HEIGHTFIELD_COLLISION_INCLUDED
+#define SOIL_HEIGHTFIELD_COLLISION_INCLUDED
+
+#include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class btCollisionConfiguration;
+class btCollisionDispatcher;
+struct btCollisionAlgorithmCreateFunc;
+
+namespace soil
+{
+    // Square heightfield of float heights read in place, centered on the
+    // origin like btHeightfieldTerrainShape
+    class [[nodiscard]] heightfield_shape final
+        : public btHeightfieldTerrainShape
+    {
+    public:
+        heightfield_shape(size_t dimension,
+            float const* heights,
+            float min_height,
+            float max_height);
+
+        heightfield_shape(heightfield_shape const&) = delete;
+
+        heightfield_shape(heightfield_shape&&) noexcept = delete;
+
+    public:
+        ~heightfield_shape() override = default;
+
+    public:
+        [[nodiscard]] size_t dimension() const;
+
+        [[nodiscard]] float const* heights() const;
+
+        // Subtracted from heights in local space
+        [[nodiscard]] float height_offset() const;
+
+    public:
+        heightfield_shape& operator=(heightfield_shape const&) = delete;
+
+        heightfield_shape& operator=(heightfield_shape&&) noexcept = delete;
+
+    private:
+        size_t dimension_;
+        float const* heights_;
+        float height_offset_;
+    };
+
+    // Collides spheres, capsules and boxes directly with the grid cells of
+    // a heightfield_shape, several triangles at a time, instead of through
+    // a callback for each triangle. Other pairs keep the algorithms of the
+    // configuration.
+    class [[nodiscard]] heightfield_collision final
+    {
+    public:
+        heightfield_collision(btCollisionDispatcher* dispatcher,
+            btCollisionConfiguration* configuration);
+
+        heightfield_collision(heightfield_collision const&) = delete;
+
+        heightfield_collision(heightfield_collision&&) noexcept = delete;
+
+    public:
+        ~heightfield_collision();
+
+    public:
+        // Affects algorithms created afterwards, existing pairs keep theirs
+        void set_enabled(bool enabled);
+
+        [[nodiscard]] bool enabled() const;
+
+    public:
+        heightfield_collision& operator=(heightfield_collision const&) = delete;
+
+        heightfield_collision& operator=(
+            heightfield_collision&&) noexcept = delete;
+
+    private:
+        struct [[nodiscard]] registration final
+        {
+            int proxy_type0;
+            int proxy_type1;
+            bool closest_points;
+            btCollisionAlgorithmCreateFunc* fallback;
+            std::unique_ptr<btCollisionAlgorithmCreateFunc> function;
+        };
+
+    private:
+        btCollisionDispatcher* dispatcher_;
+        std::vector<registration> registrations_;
+        bool enabled_{};
+    };
+} // namespace soil
+
+#endif
@@ -1,11 +1,14 @@
 #include <heightmap.hpp>
 
 #include <cppext_numeric.hpp>
+#include <cppext_thread_pool.hpp>
 
 #include <stb_image.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <span>
 
 soil::heightmap::heightmap(std::filesystem::path const& path)
 {
@@ -22,19 +25,35 @@ soil::heightmap::heightmap(std::filesystem::path const& path)
     assert(pixels);
 
     dimension_ = cppext::narrow<size_t>(width);
-    data_.reserve(dimension_ * dimension_);
-
-    // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
-    for (auto point :
-        std::span{reinterpret_cast<uint8_t*>(pixels), dimension_ * dimension_})
-    {
-        data_.push_back(cppext::as_fp(point));
-    }
-    // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+    data_.resize(dimension_ * dimension_);
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    std::span const points{reinterpret_cast<uint8_t*>(pixels), data_.size()};
+
+    cppext::thread_pool& pool{cppext::default_thread_pool()};
+    cppext::parallel_for(pool,
+        0,
+        dimension_,
+        std::max(size_t{1}, dimension_ / (pool.thread_count() * 4)),
+        [this, points](size_t const first, size_t const last)
+        {
+            for (size_t i{first * dimension_}; i != last * dimension_; ++i)
+            {
+                data_[i] = cppext::as_fp(points[i]);
+            }
+        });
 
     stbi_image_free(pixels);
 }
 
+soil::heightmap::heightmap(size_t const dimension)
+    : dimension_{dimension}
+    , data_(dimension * dimension)
+{
+}
+
 size_t soil::heightmap::dimension() const { return dimension_; }
 
 std::span<float const> soil::heightmap::data() const { return data_; }
+
+std::span<float> soil::heightmap::data() { return data_; }
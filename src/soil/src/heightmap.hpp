@@ -13,6 +13,8 @@ namespace soil
     public:
         explicit heightmap(std::filesystem::path const& path);
 
+        explicit heightmap(size_t dimension);
+
         heightmap(heightmap const&) = default;
 
         heightmap(heightmap&&) noexcept = default;
@@ -26,6 +28,9 @@ namespace soil
         // cppcheck-suppress returnByReference
         [[nodiscard]] std::span<float const> data() const;
 
+        // cppcheck-suppress returnByReference
+        [[nodiscard]] std::span<float> data();
+
         [[nodiscard]] float value(size_t x, size_t y) const
         {
             return data_[y * dimension_ + x];
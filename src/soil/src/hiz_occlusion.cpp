@@ -0,0 +1,666 @@
+#include <hiz_occlusion.hpp>
+
+#include <cppext_cycled_buffer.hpp>
+#include <cppext_numeric.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_descriptors.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_memory.hpp>
+#include <vulkan_pipeline.hpp>
+#include <vulkan_renderer.hpp>
+#include <vulkan_utility.hpp>
+
+#include <glm/mat4x4.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <ranges>
+#include <vector>
+
+namespace
+{
+    struct [[nodiscard]] cull_push_constants final
+    {
+        glm::mat4 view_projection;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levels;
+        uint32_t draw_count;
+    };
+
+    constexpr uint32_t reduce_workgroup_size{8};
+
+    constexpr uint32_t cull_workgroup_size{64};
+
+    [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(
+        vkrndr::vulkan_device const* const device,
+        std::span<VkDescriptorType const> const types)
+    {
+        std::vector<VkDescriptorSetLayoutBinding> bindings(types.size());
+        for (auto const& [index, binding] : std::views::enumerate(bindings))
+        {
+            binding.binding = static_cast<uint32_t>(index);
+            binding.descriptorType = types[static_cast<size_t>(index)];
+            binding.descriptorCount = 1;
+            binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layout_info{};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.bindingCount = vkrndr::count_cast(bindings.size());
+        layout_info.pBindings = bindings.data();
+
+        VkDescriptorSetLayout rv; // NOLINT
+        vkrndr::check_result(vkCreateDescriptorSetLayout(device->logical,
+            &layout_info,
+            nullptr,
+            &rv));
+
+        return rv;
+    }
+
+    [[nodiscard]] VkWriteDescriptorSet image_write(
+        VkDescriptorSet const descriptor_set,
+        uint32_t const binding,
+        VkDescriptorType const type,
+        VkDescriptorImageInfo const* const info)
+    {
+        VkWriteDescriptorSet rv{};
+        rv.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        rv.dstSet = descriptor_set;
+        rv.dstBinding = binding;
+        rv.dstArrayElement = 0;
+        rv.descriptorType = type;
+        rv.descriptorCount = 1;
+        rv.pImageInfo = info;
+        return rv;
+    }
+
+    [[nodiscard]] VkWriteDescriptorSet buffer_write(
+        VkDescriptorSet const descriptor_set,
+        uint32_t const binding,
+        VkDescriptorBufferInfo const* const info)
+    {
+        VkWriteDescriptorSet rv{};
+        rv.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        rv.dstSet = descriptor_set;
+        rv.dstBinding = binding;
+        rv.dstArrayElement = 0;
+        rv.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        rv.descriptorCount = 1;
+        rv.pBufferInfo = info;
+        return rv;
+    }
+
+    [[nodiscard]] VkSampler create_sampler(
+        vkrndr::vulkan_device const* const device)
+    {
+        VkSamplerCreateInfo sampler_info{};
+        sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        sampler_info.magFilter = VK_FILTER_NEAREST;
+        sampler_info.minFilter = VK_FILTER_NEAREST;
+        sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler_info.anisotropyEnable = VK_FALSE;
+        sampler_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        sampler_info.unnormalizedCoordinates = VK_FALSE;
+        sampler_info.compareEnable = VK_FALSE;
+        sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
+        sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        sampler_info.minLod = 0.0f;
+        sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+
+        VkSampler rv; // NOLINT
+        vkrndr::check_result(
+            vkCreateSampler(device->logical, &sampler_info, nullptr, &rv));
+
+        return rv;
+    }
+
+    [[nodiscard]] VkImageView create_level_view(
+        vkrndr::vulkan_device const* const device,
+        vkrndr::vulkan_image const& image,
+        uint32_t const level)
+    {
+        VkImageViewCreateInfo view_info{};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = image.image;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = image.format;
+        view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        view_info.subresourceRange.baseMipLevel = level;
+        view_info.subresourceRange.levelCount = 1;
+        view_info.subresourceRange.baseArrayLayer = 0;
+        view_info.subresourceRange.layerCount = 1;
+
+        VkImageView rv; // NOLINT
+        vkrndr::check_result(
+            vkCreateImageView(device->logical, &view_info, nullptr, &rv));
+        return rv;
+    }
+
+    void memory_barrier(VkCommandBuffer const command_buffer,
+        VkPipelineStageFlags2 const src_stage_mask,
+        VkAccessFlags2 const src_access_mask,
+        VkPipelineStageFlags2 const dst_stage_mask,
+        VkAccessFlags2 const dst_access_mask)
+    {
+        VkMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+        barrier.srcStageMask = src_stage_mask;
+        barrier.srcAccessMask = src_access_mask;
+        barrier.dstStageMask = dst_stage_mask;
+        barrier.dstAccessMask = dst_access_mask;
+
+        VkDependencyInfo dependency{};
+        dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency.memoryBarrierCount = 1;
+        dependency.pMemoryBarriers = &barrier;
+
+        vkCmdPipelineBarrier2(command_buffer, &dependency);
+    }
+
+    void image_barrier(VkCommandBuffer const command_buffer,
+        VkImage const image,
+        VkImageAspectFlags const aspect,
+        uint32_t const levels,
+        VkImageLayout const old_layout,
+        VkPipelineStageFlags2 const src_stage_mask,
+        VkAccessFlags2 const src_access_mask,
+        VkImageLayout const new_layout,
+        VkPipelineStageFlags2 const dst_stage_mask,
+        VkAccessFlags2 const dst_access_mask)
+    {
+        VkImageMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        barrier.oldLayout = old_layout;
+        barrier.srcStageMask = src_stage_mask;
+        barrier.srcAccessMask = src_access_mask;
+        barrier.newLayout = new_layout;
+        barrier.dstStageMask = dst_stage_mask;
+        barrier.dstAccessMask = dst_access_mask;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = {.aspectMask = aspect,
+            .baseMipLevel = 0,
+            .levelCount = levels,
+            .baseArrayLayer = 0,
+            .layerCount = 1};
+
+        VkDependencyInfo dependency{};
+        dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency.imageMemoryBarrierCount = 1;
+        dependency.pImageMemoryBarriers = &barrier;
+
+        vkCmdPipelineBarrier2(command_buffer, &dependency);
+    }
+
+    constexpr VkPipelineStageFlags2 depth_stages{
+        VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+        VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT};
+
+    constexpr VkAccessFlags2 depth_access{
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT};
+
+    [[nodiscard]] VkExtent2D level_extent(VkExtent2D const& extent,
+        uint32_t const level)
+    {
+        return {std::max(extent.width >> level, 1u),
+            std::max(extent.height >> level, 1u)};
+    }
+
+    [[nodiscard]] uint32_t group_count(uint32_t const size)
+    {
+        return (size + reduce_workgroup_size - 1) / reduce_workgroup_size;
+    }
+} // namespace
+
+soil::hiz_occlusion::hiz_occlusion(vkrndr::vulkan_device* const device,
+    vkrndr::vulkan_renderer* const renderer,
+    vkrndr::vulkan_image* const depth_buffer,
+    uint32_t const max_draws)
+    : device_{device}
+    , renderer_{renderer}
+    , depth_buffer_{depth_buffer}
+    , max_draws_{max_draws}
+    , sampler_{create_sampler(device)}
+{
+    constexpr std::array init_types{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE};
+    init_descriptor_set_layout_ =
+        create_descriptor_set_layout(device_, init_types);
+
+    constexpr std::array reduce_types{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE};
+    reduce_descriptor_set_layout_ =
+        create_descriptor_set_layout(device_, reduce_types);
+
+    constexpr std::array cull_types{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER};
+    cull_descriptor_set_layout_ =
+        create_descriptor_set_layout(device_, cull_types);
+
+    // Multisampled depth is read with a different sampler type
+    init_pipeline_ =
+        vkrndr::vulkan_compute_pipeline_builder{device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(init_descriptor_set_layout_)
+                .build()}
+            .with_shader(device_->max_msaa_samples == VK_SAMPLE_COUNT_1_BIT
+                    ? "hiz_init.comp.spv"
+                    : "hiz_init_ms.comp.spv",
+                "main")
+            .build();
+
+    reduce_pipeline_ =
+        vkrndr::vulkan_compute_pipeline_builder{device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(reduce_descriptor_set_layout_)
+                .build()}
+            .with_shader("hiz_reduce.comp.spv", "main")
+            .build();
+
+    cull_pipeline_ =
+        vkrndr::vulkan_compute_pipeline_builder{device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(cull_descriptor_set_layout_)
+                .add_push_constants({.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                    .offset = 0,
+                    .size = sizeof(cull_push_constants)})
+                .build()}
+            .with_shader("hiz_cull.comp.spv", "main")
+            .build();
+
+    frame_data_ =
+        cppext::cycled_buffer<frame_resources>{renderer->image_count(),
+            renderer->image_count()};
+    for (auto& data : frame_data_.as_span())
+    {
+        data.bounds = create_buffer(device_,
+            max_draws_ * sizeof(occlusion_bounds),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        data.bounds_map = vkrndr::map_memory(device_, data.bounds.allocation);
+
+        data.draws = create_buffer(device_,
+            max_draws_ * sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        data.draws_map = vkrndr::map_memory(device_, data.draws.allocation);
+
+        data.statistics = create_buffer(device_,
+            sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        data.statistics_map =
+            vkrndr::map_memory(device_, data.statistics.allocation);
+        *data.statistics_map.as<uint32_t>() = 0;
+
+        vkrndr::create_descriptor_sets(device_,
+            cull_descriptor_set_layout_,
+            renderer_->descriptor_pool(),
+            std::span{&data.descriptor_set, 1});
+
+        VkDescriptorBufferInfo const bounds_info{.buffer = data.bounds.buffer,
+            .offset = 0,
+            .range = data.bounds.size};
+        VkDescriptorBufferInfo const draws_info{.buffer = data.draws.buffer,
+            .offset = 0,
+            .range = data.draws.size};
+        VkDescriptorBufferInfo const statistics_info{
+            .buffer = data.statistics.buffer,
+            .offset = 0,
+            .range = data.statistics.size};
+
+        std::array const writes{
+            buffer_write(data.descriptor_set, 1, &bounds_info),
+            buffer_write(data.descriptor_set, 2, &draws_info),
+            buffer_write(data.descriptor_set, 3, &statistics_info)};
+        vkUpdateDescriptorSets(device_->logical,
+            vkrndr::count_cast(writes.size()),
+            writes.data(),
+            0,
+            nullptr);
+    }
+}
+
+soil::hiz_occlusion::~hiz_occlusion()
+{
+    for (auto& data : frame_data_.as_span())
+    {
+        vkFreeDescriptorSets(device_->logical,
+            renderer_->descriptor_pool(),
+            1,
+            &data.descriptor_set);
+
+        unmap_memory(device_, &data.statistics_map);
+        destroy(device_, &data.statistics);
+
+        unmap_memory(device_, &data.draws_map);
+        destroy(device_, &data.draws);
+
+        unmap_memory(device_, &data.bounds_map);
+        destroy(device_, &data.bounds);
+    }
+
+    destroy_pyramid();
+
+    destroy(device_, &cull_pipeline_);
+    destroy(device_, &reduce_pipeline_);
+    destroy(device_, &init_pipeline_);
+
+    vkDestroyDescriptorSetLayout(device_->logical,
+        cull_descriptor_set_layout_,
+        nullptr);
+    vkDestroyDescriptorSetLayout(device_->logical,
+        reduce_descriptor_set_layout_,
+        nullptr);
+    vkDestroyDescriptorSetLayout(device_->logical,
+        init_descriptor_set_layout_,
+        nullptr);
+
+    vkDestroySampler(device_->logical, sampler_, nullptr);
+}
+
+void soil::hiz_occlusion::build(VkCommandBuffer command_buffer)
+{
+    // Handles of a recreated depth buffer may be reused
+    if (pyramid_source_ != depth_buffer_->image ||
+        pyramid_.extent.width != depth_buffer_->extent.width ||
+        pyramid_.extent.height != depth_buffer_->extent.height)
+    {
+        create_pyramid();
+
+        // Depth buffer contents are undefined until it is rendered to, the
+        // pyramid is built starting with the next frame
+        image_barrier(command_buffer,
+            depth_buffer_->image,
+            VK_IMAGE_ASPECT_DEPTH_BIT,
+            1,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+            VK_ACCESS_2_NONE,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            depth_stages,
+            depth_access);
+        image_barrier(command_buffer,
+            pyramid_.image,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            pyramid_.mip_levels,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+            VK_ACCESS_2_NONE,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+        return;
+    }
+
+    image_barrier(command_buffer,
+        depth_buffer_->image,
+        VK_IMAGE_ASPECT_DEPTH_BIT,
+        1,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        depth_stages,
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+
+    // Culling of the previous frame may still be reading the pyramid
+    memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_NONE);
+
+    vkrndr::bind_pipeline(command_buffer,
+        init_pipeline_,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        0,
+        std::span<VkDescriptorSet const>{&init_descriptor_set_, 1});
+    vkCmdDispatch(command_buffer,
+        group_count(pyramid_.extent.width),
+        group_count(pyramid_.extent.height),
+        1);
+
+    for (uint32_t level{1}; level != pyramid_.mip_levels; ++level)
+    {
+        memory_barrier(command_buffer,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+
+        auto const extent{level_extent(pyramid_.extent, level)};
+        vkrndr::bind_pipeline(command_buffer,
+            reduce_pipeline_,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            0,
+            std::span<VkDescriptorSet const>{
+                &reduce_descriptor_sets_[level - 1],
+                1});
+        vkCmdDispatch(command_buffer,
+            group_count(extent.width),
+            group_count(extent.height),
+            1);
+    }
+
+    memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+
+    image_barrier(command_buffer,
+        depth_buffer_->image,
+        VK_IMAGE_ASPECT_DEPTH_BIT,
+        1,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_NONE,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        depth_stages,
+        depth_access);
+
+    pyramid_valid_ = true;
+}
+
+VkBuffer soil::hiz_occlusion::cull(VkCommandBuffer command_buffer,
+    glm::mat4 const& view_projection,
+    std::span<occlusion_bounds const> const bounds,
+    std::span<VkDrawIndexedIndirectCommand const> const draws)
+{
+    assert(bounds.size() == draws.size());
+    assert(draws.size() <= max_draws_);
+
+    // Frame which last used these resources is no longer in flight
+    auto* const statistics{frame_data_->statistics_map.as<uint32_t>()};
+    rejected_ = *statistics;
+    *statistics = 0;
+
+    std::ranges::copy(bounds, frame_data_->bounds_map.as<occlusion_bounds>());
+    std::ranges::copy(draws,
+        frame_data_->draws_map.as<VkDrawIndexedIndirectCommand>());
+
+    if (pyramid_valid_ && !draws.empty())
+    {
+        cull_push_constants const constants{.view_projection = view_projection,
+            .width = pyramid_.extent.width,
+            .height = pyramid_.extent.height,
+            .levels = pyramid_.mip_levels,
+            .draw_count = cppext::narrow<uint32_t>(draws.size())};
+
+        vkrndr::bind_pipeline(command_buffer,
+            cull_pipeline_,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            0,
+            std::span<VkDescriptorSet const>{&frame_data_->descriptor_set, 1});
+        vkCmdPushConstants(command_buffer,
+            *cull_pipeline_.pipeline_layout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(cull_push_constants),
+            &constants);
+        vkCmdDispatch(command_buffer,
+            (constants.draw_count + cull_workgroup_size - 1) /
+                cull_workgroup_size,
+            1,
+            1);
+
+        memory_barrier(command_buffer,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+            VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+    }
+
+    VkBuffer const rv{frame_data_->draws.buffer};
+    frame_data_.cycle();
+    return rv;
+}
+
+void soil::hiz_occlusion::create_pyramid()
+{
+    // Pyramid and its descriptors may still be in use by frames in flight
+    vkDeviceWaitIdle(device_->logical);
+
+    destroy_pyramid();
+
+    auto const& extent{depth_buffer_->extent};
+    uint32_t const levels{
+        cppext::narrow<uint32_t>(std::bit_width(
+            std::max(extent.width, extent.height)))};
+
+    pyramid_ = vkrndr::create_image_and_view(device_,
+        extent,
+        levels,
+        VK_SAMPLE_COUNT_1_BIT,
+        VK_FORMAT_R32_SFLOAT,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT);
+
+    level_views_.resize(levels);
+    for (uint32_t level{}; level != levels; ++level)
+    {
+        level_views_[level] = create_level_view(device_, pyramid_, level);
+    }
+
+    vkrndr::create_descriptor_sets(device_,
+        init_descriptor_set_layout_,
+        renderer_->descriptor_pool(),
+        std::span{&init_descriptor_set_, 1});
+
+    VkDescriptorImageInfo const depth_info{.sampler = sampler_,
+        .imageView = depth_buffer_->view,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkDescriptorImageInfo const base_info{.sampler = VK_NULL_HANDLE,
+        .imageView = level_views_[0],
+        .imageLayout = VK_IMAGE_LAYOUT_GENERAL};
+    std::array const init_writes{image_write(init_descriptor_set_,
+                                     0,
+                                     VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                                     &depth_info),
+        image_write(init_descriptor_set_,
+            1,
+            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            &base_info)};
+    vkUpdateDescriptorSets(device_->logical,
+        vkrndr::count_cast(init_writes.size()),
+        init_writes.data(),
+        0,
+        nullptr);
+
+    reduce_descriptor_sets_.resize(levels - 1);
+    for (uint32_t level{1}; level != levels; ++level)
+    {
+        auto& descriptor_set{reduce_descriptor_sets_[level - 1]};
+        vkrndr::create_descriptor_sets(device_,
+            reduce_descriptor_set_layout_,
+            renderer_->descriptor_pool(),
+            std::span{&descriptor_set, 1});
+
+        VkDescriptorImageInfo const source_info{.sampler = VK_NULL_HANDLE,
+            .imageView = level_views_[level - 1],
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL};
+        VkDescriptorImageInfo const target_info{.sampler = VK_NULL_HANDLE,
+            .imageView = level_views_[level],
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL};
+        std::array const writes{image_write(descriptor_set,
+                                    0,
+                                    VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                                    &source_info),
+            image_write(descriptor_set,
+                1,
+                VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                &target_info)};
+        vkUpdateDescriptorSets(device_->logical,
+            vkrndr::count_cast(writes.size()),
+            writes.data(),
+            0,
+            nullptr);
+    }
+
+    VkDescriptorImageInfo const pyramid_info{.sampler = sampler_,
+        .imageView = pyramid_.view,
+        .imageLayout = VK_IMAGE_LAYOUT_GENERAL};
+    for (auto const& data : frame_data_.as_span())
+    {
+        auto const write{image_write(data.descriptor_set,
+            0,
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            &pyramid_info)};
+        vkUpdateDescriptorSets(device_->logical, 1, &write, 0, nullptr);
+    }
+
+    pyramid_source_ = depth_buffer_->image;
+    pyramid_valid_ = false;
+}
+
+void soil::hiz_occlusion::destroy_pyramid()
+{
+    if (pyramid_source_ == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    if (!reduce_descriptor_sets_.empty())
+    {
+        vkFreeDescriptorSets(device_->logical,
+            renderer_->descriptor_pool(),
+            vkrndr::count_cast(reduce_descriptor_sets_.size()),
+            reduce_descriptor_sets_.data());
+        reduce_descriptor_sets_.clear();
+    }
+
+    vkFreeDescriptorSets(device_->logical,
+        renderer_->descriptor_pool(),
+        1,
+        &init_descriptor_set_);
+
+    for (VkImageView const view : level_views_)
+    {
+        vkDestroyImageView(device_->logical, view, nullptr);
+    }
+    level_views_.clear();
+
+    destroy(device_, &pyramid_);
+
+    pyramid_source_ = VK_NULL_HANDLE;
+    pyramid_valid_ = false;
+}
@@ -0,0 +1,121 @@
+#ifndef SOIL_HIZ_OCCLUSION_INCLUDED
+#define SOIL_HIZ_OCCLUSION_INCLUDED
+
+#include <cppext_cycled_buffer.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_memory.hpp>
+#include <vulkan_pipeline.hpp>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    class vulkan_renderer;
+} // namespace vkrndr
+
+namespace soil
+{
+    // World space axis aligned bounding box, padded for std430 layout
+    struct [[nodiscard]] occlusion_bounds final
+    {
+        glm::vec4 min;
+        glm::vec4 max;
+    };
+
+    // Hierarchical depth buffer built from the depth buffer of the previous
+    // frame. Indirect draws are culled against it on the GPU before the depth
+    // buffer is cleared for the current frame.
+    class [[nodiscard]] hiz_occlusion final
+    {
+    public:
+        hiz_occlusion(vkrndr::vulkan_device* device,
+            vkrndr::vulkan_renderer* renderer,
+            vkrndr::vulkan_image* depth_buffer,
+            uint32_t max_draws);
+
+        hiz_occlusion(hiz_occlusion const&) = delete;
+
+        hiz_occlusion(hiz_occlusion&&) noexcept = delete;
+
+    public:
+        ~hiz_occlusion();
+
+    public:
+        // Draws rejected by the most recently completed culling pass
+        [[nodiscard]] uint32_t rejected() const { return rejected_; }
+
+        // Reduces contents of the depth buffer into the pyramid, must be
+        // called outside of a render pass before the depth buffer is cleared
+        void build(VkCommandBuffer command_buffer);
+
+        // Records culling of draws whose bounds are hidden behind the depth
+        // pyramid, their instance count is set to zero. Returns the buffer
+        // holding the culled draws at the same positions.
+        [[nodiscard]] VkBuffer cull(VkCommandBuffer command_buffer,
+            glm::mat4 const& view_projection,
+            std::span<occlusion_bounds const> bounds,
+            std::span<VkDrawIndexedIndirectCommand const> draws);
+
+    public:
+        hiz_occlusion& operator=(hiz_occlusion const&) = delete;
+
+        hiz_occlusion& operator=(hiz_occlusion&&) noexcept = delete;
+
+    private:
+        struct [[nodiscard]] frame_resources final
+        {
+            vkrndr::vulkan_buffer bounds;
+            vkrndr::mapped_memory bounds_map{};
+            vkrndr::vulkan_buffer draws;
+            vkrndr::mapped_memory draws_map{};
+            vkrndr::vulkan_buffer statistics;
+            vkrndr::mapped_memory statistics_map{};
+            VkDescriptorSet descriptor_set{VK_NULL_HANDLE};
+        };
+
+    private:
+        // Recreates the pyramid when the depth buffer was recreated
+        void create_pyramid();
+
+        void destroy_pyramid();
+
+    private:
+        vkrndr::vulkan_device* device_;
+        vkrndr::vulkan_renderer* renderer_;
+        vkrndr::vulkan_image* depth_buffer_;
+        uint32_t max_draws_;
+
+        VkImage pyramid_source_{VK_NULL_HANDLE};
+        bool pyramid_valid_{};
+        vkrndr::vulkan_image pyramid_;
+        std::vector<VkImageView> level_views_;
+
+        VkSampler sampler_{VK_NULL_HANDLE};
+
+        VkDescriptorSetLayout init_descriptor_set_layout_{VK_NULL_HANDLE};
+        VkDescriptorSet init_descriptor_set_{VK_NULL_HANDLE};
+        VkDescriptorSetLayout reduce_descriptor_set_layout_{VK_NULL_HANDLE};
+        std::vector<VkDescriptorSet> reduce_descriptor_sets_;
+        VkDescriptorSetLayout cull_descriptor_set_layout_{VK_NULL_HANDLE};
+
+        vkrndr::vulkan_pipeline init_pipeline_;
+        vkrndr::vulkan_pipeline reduce_pipeline_;
+        vkrndr::vulkan_pipeline cull_pipeline_;
+
+        cppext::cycled_buffer<frame_resources> frame_data_;
+
+        uint32_t rejected_{};
+    };
+} // namespace soil
+
+#endif
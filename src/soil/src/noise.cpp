@@ -1,30 +1,447 @@
 #include <noise.hpp>
 
 #include <cppext_numeric.hpp>
+#include <cppext_thread_pool.hpp>
 
-#include <PerlinNoise.hpp>
-
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
 
-void soil::generate_2d_noise(std::span<std::byte> output,
-    size_t const dimension)
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOIL_NOISE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
 {
-    constexpr siv::PerlinNoise::seed_type seed{123456u};
-    constexpr float div_factor{50.0f};
+    constexpr size_t lane_count{4};
+
+    // Regions smaller than this are generated on the calling thread
+    constexpr size_t parallel_threshold{256 * 256};
+
+    using permutation_table = std::array<int32_t, 512>;
+
+    [[nodiscard]] permutation_table make_permutation_table(
+        uint32_t const seed)
+    {
+        std::array<int32_t, 256> values; // NOLINT
+        std::iota(values.begin(), values.end(), 0);
+
+        // Fisher-Yates with raw engine output, std::shuffle isn't portable
+        std::mt19937 engine{seed};
+        for (size_t i{values.size() - 1}; i != 0; --i)
+        {
+            size_t const j{engine() % (i + 1)};
+            std::swap(values[i], values[j]);
+        }
+
+        permutation_table rv; // NOLINT
+        std::ranges::copy(values, rv.begin());
+        std::ranges::copy(values, rv.begin() + 256);
+        return rv;
+    }
+
+#ifdef SOIL_NOISE_SSE2
+    struct [[nodiscard]] lanes final
+    {
+        __m128 v;
+    };
+
+    [[nodiscard]] lanes broadcast(float const value)
+    {
+        return {_mm_set1_ps(value)};
+    }
+
+    [[nodiscard]] lanes sequence(float const start)
+    {
+        return {_mm_add_ps(_mm_set1_ps(start),
+            _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f))};
+    }
+
+    [[nodiscard]] lanes operator+(lanes const a, lanes const b)
+    {
+        return {_mm_add_ps(a.v, b.v)};
+    }
+
+    [[nodiscard]] lanes operator-(lanes const a, lanes const b)
+    {
+        return {_mm_sub_ps(a.v, b.v)};
+    }
+
+    [[nodiscard]] lanes operator*(lanes const a, lanes const b)
+    {
+        return {_mm_mul_ps(a.v, b.v)};
+    }
+
+    [[nodiscard]] lanes abs(lanes const a)
+    {
+        return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)};
+    }
+
+    [[nodiscard]] lanes clamp01(lanes const a)
+    {
+        return {_mm_min_ps(_mm_max_ps(a.v, _mm_setzero_ps()), _mm_set1_ps(1))};
+    }
 
-    assert(output.size() >= dimension * dimension);
+    [[nodiscard]] lanes floor(lanes const a, std::array<int32_t, 4>& integral)
+    {
+        __m128i const truncated{_mm_cvttps_epi32(a.v)};
+        __m128 const as_float{_mm_cvtepi32_ps(truncated)};
+        // Truncation rounds negative values up, step those back by one
+        __m128 const adjust{
+            _mm_and_ps(_mm_cmpgt_ps(as_float, a.v), _mm_set1_ps(1.0f))};
+        __m128 const rv{_mm_sub_ps(as_float, adjust)};
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(integral.data()),
+            _mm_cvttps_epi32(rv));
+        return {rv};
+    }
 
-    siv::BasicPerlinNoise<float> const perlin{seed};
+    // Diagonal gradient selected by the lowest two bits of the hash,
+    // applied by flipping sign bits instead of branching
+    [[nodiscard]] lanes gradient(std::array<int32_t, 4> const& hashes,
+        lanes const x,
+        lanes const y)
+    {
+        __m128i const h{
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(hashes.data()))};
+        __m128 const sign_x{_mm_castsi128_ps(
+            _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31))};
+        __m128 const sign_y{_mm_castsi128_ps(
+            _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30))};
+        return {_mm_add_ps(_mm_xor_ps(x.v, sign_x), _mm_xor_ps(y.v, sign_y))};
+    }
 
-    for (size_t j{}; j != dimension; ++j)
+    void store(lanes const a, float* const output, size_t const count)
     {
-        for (size_t i{}; i != dimension; ++i)
+        if (count == lane_count)
+        {
+            _mm_storeu_ps(output, a.v);
+        }
+        else
         {
-            output[j * dimension + i] = static_cast<std::byte>(
-                roundf(perlin.noise2D_01(cppext::as_fp(i) / div_factor,
-                           cppext::as_fp(j) / div_factor) *
-                    255.0f));
+            alignas(16) std::array<float, lane_count> values; // NOLINT
+            _mm_store_ps(values.data(), a.v);
+            std::copy_n(values.data(), count, output);
         }
     }
+#else
+    struct [[nodiscard]] lanes final
+    {
+        std::array<float, lane_count> v;
+    };
+
+    template<typename Function>
+    [[nodiscard]] lanes transform(Function&& function)
+    {
+        lanes rv; // NOLINT
+        for (size_t i{}; i != lane_count; ++i)
+        {
+            rv.v[i] = function(i);
+        }
+        return rv;
+    }
+
+    [[nodiscard]] lanes broadcast(float const value)
+    {
+        return transform([value](size_t) { return value; });
+    }
+
+    [[nodiscard]] lanes sequence(float const start)
+    {
+        return transform([start](size_t i)
+            { return start + cppext::as_fp(i); });
+    }
+
+    [[nodiscard]] lanes operator+(lanes const a, lanes const b)
+    {
+        return transform([&](size_t i) { return a.v[i] + b.v[i]; });
+    }
+
+    [[nodiscard]] lanes operator-(lanes const a, lanes const b)
+    {
+        return transform([&](size_t i) { return a.v[i] - b.v[i]; });
+    }
+
+    [[nodiscard]] lanes operator*(lanes const a, lanes const b)
+    {
+        return transform([&](size_t i) { return a.v[i] * b.v[i]; });
+    }
+
+    [[nodiscard]] lanes abs(lanes const a)
+    {
+        return transform([&](size_t i) { return std::fabs(a.v[i]); });
+    }
+
+    [[nodiscard]] lanes clamp01(lanes const a)
+    {
+        return transform([&](size_t i)
+            { return std::clamp(a.v[i], 0.0f, 1.0f); });
+    }
+
+    [[nodiscard]] lanes floor(lanes const a, std::array<int32_t, 4>& integral)
+    {
+        return transform(
+            [&](size_t i)
+            {
+                float const rv{std::floor(a.v[i])};
+                integral[i] = static_cast<int32_t>(rv);
+                return rv;
+            });
+    }
+
+    [[nodiscard]] lanes gradient(std::array<int32_t, 4> const& hashes,
+        lanes const x,
+        lanes const y)
+    {
+        return transform(
+            [&](size_t i)
+            {
+                return ((hashes[i] & 1) ? -x.v[i] : x.v[i]) +
+                    ((hashes[i] & 2) ? -y.v[i] : y.v[i]);
+            });
+    }
+
+    void store(lanes const a, float* const output, size_t const count)
+    {
+        std::copy_n(a.v.data(), count, output);
+    }
+#endif
+
+    [[nodiscard]] lanes fade(lanes const t)
+    {
+        // 6t^5 - 15t^4 + 10t^3
+        return t * t * t *
+            (t * (t * broadcast(6.0f) - broadcast(15.0f)) + broadcast(10.0f));
+    }
+
+    [[nodiscard]] lanes lerp(lanes const t, lanes const a, lanes const b)
+    {
+        return a + t * (b - a);
+    }
+
+    // Gradient noise in [-1, 1], four samples at a time
+    [[nodiscard]] lanes gradient_noise(permutation_table const& permutation,
+        lanes const x,
+        lanes const y)
+    {
+        std::array<int32_t, 4> xi; // NOLINT
+        std::array<int32_t, 4> yi; // NOLINT
+        lanes const fx{x - floor(x, xi)};
+        lanes const fy{y - floor(y, yi)};
+
+        std::array<int32_t, 4> h00; // NOLINT
+        std::array<int32_t, 4> h10; // NOLINT
+        std::array<int32_t, 4> h01; // NOLINT
+        std::array<int32_t, 4> h11; // NOLINT
+        for (size_t i{}; i != lane_count; ++i)
+        {
+            auto const px{static_cast<size_t>(xi[i] & 255)};
+            auto const py{static_cast<size_t>(yi[i] & 255)};
+
+            auto const a{static_cast<size_t>(permutation[px]) + py};
+            auto const b{static_cast<size_t>(permutation[px + 1]) + py};
+
+            h00[i] = permutation[a];
+            h10[i] = permutation[b];
+            h01[i] = permutation[a + 1];
+            h11[i] = permutation[b + 1];
+        }
+
+        lanes const one{broadcast(1.0f)};
+        lanes const g00{gradient(h00, fx, fy)};
+        lanes const g10{gradient(h10, fx - one, fy)};
+        lanes const g01{gradient(h01, fx, fy - one)};
+        lanes const g11{gradient(h11, fx - one, fy - one)};
+
+        lanes const u{fade(fx)};
+        return lerp(fade(fy), lerp(u, g00, g10), lerp(u, g01, g11));
+    }
+
+    class [[nodiscard]] noise_generator final
+    {
+    public:
+        explicit noise_generator(soil::noise_settings const& settings)
+            : settings_{settings}
+            , permutation_{make_permutation_table(settings.seed)}
+            , frequency_{1.0f / settings.scale}
+        {
+            assert(settings.scale > 0.0f);
+            assert(settings.octaves > 0);
+        }
+
+    public:
+        void generate_row(float* const output,
+            size_t const width,
+            float const origin_x,
+            float const y) const
+        {
+            lanes const row{broadcast(y)};
+            for (size_t i{}; i < width; i += lane_count)
+            {
+                lanes const column{sequence(origin_x + cppext::as_fp(i))};
+                store(sample(column, row),
+                    output + i,
+                    std::min(lane_count, width - i));
+            }
+        }
+
+    private:
+        [[nodiscard]] lanes sample(lanes x, lanes y) const
+        {
+            if (settings_.warp_strength > 0.0f)
+            {
+                lanes const warp_frequency{
+                    broadcast(frequency_ / settings_.warp_scale)};
+                lanes const displacement{
+                    broadcast(settings_.warp_strength * settings_.scale)};
+
+                lanes const wx{x * warp_frequency};
+                lanes const wy{y * warp_frequency};
+                lanes const dx{gradient_noise(permutation_,
+                    wx + broadcast(5.2f),
+                    wy + broadcast(1.3f))};
+                lanes const dy{gradient_noise(permutation_,
+                    wx + broadcast(1.7f),
+                    wy + broadcast(9.2f))};
+
+                x = x + dx * displacement;
+                y = y + dy * displacement;
+            }
+
+            lanes const half{broadcast(0.5f)};
+            lanes const one{broadcast(1.0f)};
+
+            lanes value{broadcast(0.0f)};
+            float amplitude{1.0f};
+            float normalization{};
+            float frequency{frequency_};
+            for (uint32_t octave{}; octave != settings_.octaves; ++octave)
+            {
+                // Offset octaves so that lattice points don't line up
+                auto const offset{cppext::as_fp(octave) * 17.31f};
+                lanes noise{gradient_noise(permutation_,
+                    x * broadcast(frequency) + broadcast(offset),
+                    y * broadcast(frequency) + broadcast(offset))};
+
+                if (settings_.type == soil::noise_type::ridged)
+                {
+                    noise = one - abs(noise);
+                    noise = noise * noise;
+                }
+                else
+                {
+                    noise = noise * half + half;
+                }
+
+                value = value + noise * broadcast(amplitude);
+                normalization += amplitude;
+                amplitude *= settings_.gain;
+                frequency *= settings_.lacunarity;
+            }
+
+            return clamp01(value * broadcast(1.0f / normalization));
+        }
+
+    private:
+        soil::noise_settings settings_;
+        permutation_table permutation_;
+        float frequency_;
+    };
+
+    template<typename RowSink>
+    void generate_rows(noise_generator const& generator,
+        size_t const width,
+        size_t const height,
+        float const origin_x,
+        float const origin_y,
+        RowSink const& sink)
+    {
+        auto const generate = [&](size_t const begin, size_t const end)
+        {
+            std::vector<float> row(width);
+            for (size_t j{begin}; j != end; ++j)
+            {
+                generator.generate_row(row.data(),
+                    width,
+                    origin_x,
+                    origin_y + cppext::as_fp(j));
+                sink(j, row);
+            }
+        };
+
+        cppext::thread_pool& pool{cppext::default_thread_pool()};
+        if (pool.thread_count() == 1 || width * height < parallel_threshold)
+        {
+            generate(0, height);
+            return;
+        }
+
+        // Few row groups per thread even out differences in progress
+        size_t const groups{pool.thread_count() * 4};
+        cppext::parallel_for(pool,
+            0,
+            height,
+            (height + groups - 1) / groups,
+            generate);
+    }
+} // namespace
+
+void soil::generate_2d_noise(std::span<float> output,
+    size_t const width,
+    size_t const height,
+    noise_settings const& settings,
+    float const origin_x,
+    float const origin_y)
+{
+    assert(output.size() >= width * height);
+
+    noise_generator const generator{settings};
+    generate_rows(generator,
+        width,
+        height,
+        origin_x,
+        origin_y,
+        [&output, width](size_t const j, std::vector<float> const& row)
+        {
+            std::ranges::copy(row,
+                output.begin() + cppext::narrow<std::ptrdiff_t>(j * width));
+        });
+}
+
+void soil::generate_2d_noise(std::span<std::byte> output,
+    size_t const width,
+    size_t const height,
+    noise_settings const& settings,
+    float const origin_x,
+    float const origin_y)
+{
+    assert(output.size() >= width * height);
+
+    noise_generator const generator{settings};
+    generate_rows(generator,
+        width,
+        height,
+        origin_x,
+        origin_y,
+        [&output, width](size_t const j, std::vector<float> const& row)
+        {
+            std::ranges::transform(row,
+                output.begin() + cppext::narrow<std::ptrdiff_t>(j * width),
+                [](float const value)
+                { return static_cast<std::byte>(roundf(value * 255.0f)); });
+        });
+}
+
+void soil::generate_2d_noise(std::span<std::byte> output,
+    size_t const dimension)
+{
+    generate_2d_noise(output, dimension, dimension, noise_settings{});
 }
@@ -2,10 +2,47 @@
 #define SOIL_NOISE_INCLUDED
 
 #include <cstddef>
+#include <cstdint>
 #include <span>
 
 namespace soil
 {
+    enum class noise_type : uint8_t
+    {
+        fbm,
+        ridged
+    };
+
+    struct [[nodiscard]] noise_settings final
+    {
+        uint32_t seed{123456u};
+        // Size of the base octave features in samples
+        float scale{50.0f};
+        uint32_t octaves{1};
+        float lacunarity{2.0f};
+        float gain{0.5f};
+        noise_type type{noise_type::fbm};
+        // Domain warping is disabled when strength is zero
+        float warp_strength{0.0f};
+        float warp_scale{4.0f};
+    };
+
+    // Fills a width * height region starting at (origin_x, origin_y) with
+    // values in [0, 1]. Rows are distributed across hardware threads.
+    void generate_2d_noise(std::span<float> output,
+        size_t width,
+        size_t height,
+        noise_settings const& settings,
+        float origin_x = 0.0f,
+        float origin_y = 0.0f);
+
+    void generate_2d_noise(std::span<std::byte> output,
+        size_t width,
+        size_t height,
+        noise_settings const& settings,
+        float origin_x = 0.0f,
+        float origin_y = 0.0f);
+
     void generate_2d_noise(std::span<std::byte> output, size_t dimension);
 } // namespace soil
 
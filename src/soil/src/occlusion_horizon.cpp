@@ -0,0 +1,230 @@
+#include <occlusion_horizon.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <optional>
+
+namespace
+{
+    struct [[nodiscard]] azimuth_bounds final
+    {
+        // Azimuth range in units of bins, unwrapped
+        float first{std::numeric_limits<float>::max()};
+        float last{std::numeric_limits<float>::lowest()};
+        float min_distance{};
+        float max_distance{};
+    };
+
+    // Rectangles containing or touching the camera in the XZ plane surround
+    // it, they are neither occluded nor occluders
+    constexpr float min_distance{1e-3f};
+
+    [[nodiscard]] std::optional<azimuth_bounds> project(
+        glm::vec2 const& camera,
+        glm::vec2 const& min,
+        glm::vec2 const& max,
+        size_t const bins)
+    {
+        glm::vec2 const nearest{glm::clamp(camera, min, max)};
+
+        azimuth_bounds rv;
+        rv.min_distance = glm::distance(camera, nearest);
+        if (rv.min_distance < min_distance)
+        {
+            return std::nullopt;
+        }
+
+        // Whole rectangle lies beyond its nearest point, corners are within
+        // a quarter turn of the direction towards it. Corner angles are
+        // unwrapped around it so that rectangles sharing a corner get the
+        // same angle for it.
+        glm::vec2 const to_nearest{nearest - camera};
+        float const reference{std::atan2(to_nearest.y, to_nearest.x)};
+
+        std::array const corners{min,
+            glm::vec2{max.x, min.y},
+            glm::vec2{min.x, max.y},
+            max};
+        for (glm::vec2 const& corner : corners)
+        {
+            glm::vec2 const to_corner{corner - camera};
+            rv.max_distance =
+                std::max(rv.max_distance, glm::length(to_corner));
+
+            float angle{std::atan2(to_corner.y, to_corner.x)};
+            if (angle - reference > std::numbers::pi_v<float>)
+            {
+                angle -= 2.0f * std::numbers::pi_v<float>;
+            }
+            else if (angle - reference < -std::numbers::pi_v<float>)
+            {
+                angle += 2.0f * std::numbers::pi_v<float>;
+            }
+
+            rv.first = std::min(rv.first, angle);
+            rv.last = std::max(rv.last, angle);
+        }
+
+        float const scale{
+            cppext::as_fp(bins) / (2.0f * std::numbers::pi_v<float>)};
+        rv.first *= scale;
+        rv.last *= scale;
+        return rv;
+    }
+
+    [[nodiscard]] size_t wrap_bin(int64_t const bin, size_t const bins)
+    {
+        auto const count{static_cast<int64_t>(bins)};
+        return static_cast<size_t>((bin % count + count) % count);
+    }
+
+    constexpr float lowest_slope{std::numeric_limits<float>::lowest()};
+} // namespace
+
+soil::occlusion_horizon::occlusion_horizon(uint32_t const bins)
+    : bins_(bins)
+{
+    assert(bins > 0);
+    reset(camera_position_);
+}
+
+void soil::occlusion_horizon::reset(glm::vec3 const& camera_position)
+{
+    camera_position_ = camera_position;
+    std::ranges::fill(bins_,
+        bin{.slope = lowest_slope,
+            .left_end = 0.0f,
+            .left_slope = lowest_slope,
+            .right_start = 1.0f,
+            .right_slope = lowest_slope});
+}
+
+bool soil::occlusion_horizon::occluded(glm::vec3 const& min,
+    glm::vec3 const& max) const
+{
+    auto const bounds{project({camera_position_.x, camera_position_.z},
+        {min.x, min.z},
+        {max.x, max.z},
+        bins_.size())};
+    if (!bounds)
+    {
+        return false;
+    }
+
+    // Steepest line of sight to the box, its top is seen from the nearest
+    // point when above the camera and from the farthest one when below
+    float const top{max.y - camera_position_.y};
+    float const slope{
+        top / (top > 0.0f ? bounds->min_distance : bounds->max_distance)};
+
+    // Every bin the box touches has to be above it
+    auto const first{static_cast<int64_t>(std::floor(bounds->first))};
+    auto const last{static_cast<int64_t>(std::floor(bounds->last))};
+    for (int64_t index{first}; index <= last; ++index)
+    {
+        if (bins_[wrap_bin(index, bins_.size())].slope < slope)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void soil::occlusion_horizon::add_occluder(glm::vec2 const& min,
+    glm::vec2 const& max,
+    float const height)
+{
+    auto const bounds{project({camera_position_.x, camera_position_.z},
+        min,
+        max,
+        bins_.size())};
+    if (!bounds)
+    {
+        return;
+    }
+
+    // Every direction strictly inside of the azimuth range crosses the
+    // rectangle, lines of sight passing below its top are blocked. Slope to
+    // the top is at least the one at the farthest corner when above the
+    // camera and at the nearest point when below.
+    float const top{height - camera_position_.y};
+    float const slope{
+        top / (top > 0.0f ? bounds->max_distance : bounds->min_distance)};
+
+    float const first_bin{std::floor(bounds->first)};
+    float const last_bin{std::floor(bounds->last)};
+    if (first_bin == last_bin)
+    {
+        return;
+    }
+
+    // Bins at the ends of the range are covered only partially unless the
+    // range starts exactly at a bin edge
+    auto first{static_cast<int64_t>(first_bin)};
+    auto const last{static_cast<int64_t>(last_bin)};
+    if (bounds->first != first_bin)
+    {
+        cover_right(bins_[wrap_bin(first, bins_.size())],
+            bounds->first - first_bin,
+            slope);
+        ++first;
+    }
+    for (int64_t index{first}; index < last; ++index)
+    {
+        float& bin_slope{bins_[wrap_bin(index, bins_.size())].slope};
+        bin_slope = std::max(bin_slope, slope);
+    }
+    if (bounds->last != last_bin)
+    {
+        cover_left(bins_[wrap_bin(last, bins_.size())],
+            bounds->last - last_bin,
+            slope);
+    }
+}
+
+void soil::occlusion_horizon::cover_left(bin& target,
+    float const end,
+    float const slope)
+{
+    if (end > target.left_end ||
+        (end == target.left_end && slope > target.left_slope))
+    {
+        target.left_end = end;
+        target.left_slope = slope;
+    }
+
+    if (target.left_end >= target.right_start)
+    {
+        target.slope = std::max(target.slope,
+            std::min(target.left_slope, target.right_slope));
+    }
+}
+
+void soil::occlusion_horizon::cover_right(bin& target,
+    float const start,
+    float const slope)
+{
+    if (start < target.right_start ||
+        (start == target.right_start && slope > target.right_slope))
+    {
+        target.right_start = start;
+        target.right_slope = slope;
+    }
+
+    if (target.left_end >= target.right_start)
+    {
+        target.slope = std::max(target.slope,
+            std::min(target.left_slope, target.right_slope));
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef SOIL_OCCLUSION_HORIZON_INCLUDED
+#define SOIL_OCCLUSION_HORIZON_INCLUDED
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace soil
+{
+    // Conservative horizon of terrain added so far as seen from the camera
+    // position. Directions around the camera are split into azimuth bins,
+    // each holding the elevation slope below which everything farther away
+    // is hidden. Bins are in world space, so the horizon doesn't depend on
+    // the camera orientation. Chunks have to be tested and added in front to
+    // back order of their distance in the XZ plane.
+    class [[nodiscard]] occlusion_horizon final
+    {
+    public:
+        explicit occlusion_horizon(uint32_t bins);
+
+        occlusion_horizon(occlusion_horizon const&) = default;
+
+        occlusion_horizon(occlusion_horizon&&) noexcept = default;
+
+    public:
+        ~occlusion_horizon() = default;
+
+    public:
+        // Clears the horizon for a new traversal from the camera position
+        void reset(glm::vec3 const& camera_position);
+
+        // True if the box falls entirely below the horizon
+        [[nodiscard]] bool occluded(glm::vec3 const& min,
+            glm::vec3 const& max) const;
+
+        // Raises the horizon with the solid part of a chunk, everything under
+        // its minimum height over the rectangle min, max in the XZ plane
+        void add_occluder(glm::vec2 const& min,
+            glm::vec2 const& max,
+            float height);
+
+    public:
+        occlusion_horizon& operator=(occlusion_horizon const&) = default;
+
+        occlusion_horizon& operator=(occlusion_horizon&&) noexcept = default;
+
+    private:
+        // Slopes are height differences over horizontal distance from the
+        // camera. Parts of a bin hidden by an occluder ending inside of it
+        // are tracked from both of its edges, when they meet the whole bin
+        // is hidden by the lower of the two.
+        struct [[nodiscard]] bin final
+        {
+            float slope;
+            float left_end;
+            float left_slope;
+            float right_start;
+            float right_slope;
+        };
+
+        static void cover_left(bin& target, float end, float slope);
+
+        static void cover_right(bin& target, float start, float slope);
+
+    private:
+        glm::vec3 camera_position_{};
+        std::vector<bin> bins_;
+    };
+} // namespace soil
+
+#endif
@@ -1,9 +1,20 @@
 #include <physics_engine.hpp>
 
 #include <bullet_adapter.hpp>
+#include <bullet_allocator.hpp>
 #include <bullet_debug_renderer.hpp>
+#include <heightfield_collision.hpp>
+#ifdef SOIL_BULLET_MULTITHREADED
+#include <bullet_task_scheduler.hpp>
+#endif
 
+#include <cppext_object_pool.hpp>
+#include <cppext_thread_pool.hpp>
+#include <cppext_triple_buffer.hpp>
+
+#include <BulletCollision/BroadphaseCollision/btBroadphaseProxy.h>
 #include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <BulletCollision/BroadphaseCollision/btOverlappingPairCache.h>
 #include <BulletCollision/CollisionDispatch/btCollisionDispatcher.h>
 #include <BulletCollision/CollisionDispatch/btCollisionObject.h>
 #include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
@@ -12,15 +23,54 @@
 #include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
 #include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
 #include <BulletDynamics/Dynamics/btRigidBody.h>
-#include <LinearMath/btAlignedObjectArray.h>
 #include <LinearMath/btDefaultMotionState.h>
 #include <LinearMath/btMotionState.h>
+#include <LinearMath/btTransform.h>
 #include <LinearMath/btVector3.h>
 
+#ifdef SOIL_BULLET_MULTITHREADED
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <LinearMath/btThreads.h>
+#endif
+
+#include <imgui.h>
+
+#include <glm/common.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/vec3.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <condition_variable>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <tuple>
 #include <utility>
+#include <vector>
+
+namespace
+{
+    using steady_clock = std::chrono::steady_clock;
+
+    // Transforms before and after a single step, bodies are interpolated
+    // within one snapshot as earlier steps may never be read
+    struct [[nodiscard]] snapshot final
+    {
+        steady_clock::time_point previous_time;
+        steady_clock::time_point time;
+        std::vector<soil::body_transform> previous;
+        std::vector<soil::body_transform> bodies;
+    };
+} // namespace
 
 class [[nodiscard]] soil::physics_engine::impl final
 {
@@ -35,9 +85,21 @@ public:
     ~impl();
 
 public:
+    void start_thread(float step_interval);
+
+    void stop_thread();
+
+    [[nodiscard]] bool threaded() const;
+
+    void synchronize(std::move_only_function<void()> function);
+
     void fixed_update(float delta_time);
 
-    void update(glm::vec3 const& camera_position);
+    void update(glm::vec3 const& camera_position, float interpolation_alpha);
+
+    [[nodiscard]] std::span<body_transform const> body_transforms() const;
+
+    void draw_imgui();
 
     [[nodiscard]] bullet_debug_renderer* debug_renderer();
 
@@ -54,80 +116,305 @@ public:
 
     btRigidBody* add_rigid_body(std::unique_ptr<btCollisionShape> shape,
         float mass,
-        btTransform const& transform);
+        btTransform const& transform,
+        int user_index);
+
+    void remove_rigid_body(btRigidBody* body);
+
+    // Body has to be removed from the world, its shape is deleted with it
+    void destroy_body(btRigidBody* body);
 
     [[nodiscard]] std::pair<btRigidBody const*, btVector3>
-    raycast(btVector3 const& from, btVector3 const& to) const;
+    raycast(btVector3 const& from, btVector3 const& to);
+
+    void raycast(std::span<ray const> rays, std::span<ray_hit> hits);
+
+    void on_raycast(std::function<void(std::span<ray const>)> listener);
+
+    void notify_raycast(std::span<ray const> rays) const;
 
 public:
     impl& operator=(impl const&) = delete;
 
     impl& operator=(impl&&) noexcept = delete;
 
+private:
+    // Runs command on the simulation thread if it is running
+    void submit(std::move_only_function<void()> command);
+
+    void simulate(std::stop_token const& stop_token, float step_interval);
+
+    void run_commands(std::vector<std::move_only_function<void()>>& commands);
+
+    void step(float delta_time, int max_sub_steps);
+
+    void publish_snapshot();
+
+    void debug_draw();
+
 private:
     btDefaultCollisionConfiguration collision_configuration_;
+#ifdef SOIL_BULLET_MULTITHREADED
+    bullet_task_scheduler task_scheduler_;
+    btCollisionDispatcherMt dispatcher_;
+    btDbvtBroadphase overlapping_pair_cache_;
+    btConstraintSolverPoolMt solver_pool_;
+    btSequentialImpulseConstraintSolverMt solver_;
+    btDiscreteDynamicsWorldMt world_;
+#else
     btCollisionDispatcher dispatcher_;
     btDbvtBroadphase overlapping_pair_cache_;
     btSequentialImpulseConstraintSolver solver_;
     btDiscreteDynamicsWorld world_;
+#endif
+    heightfield_collision heightfield_collision_;
 
-    btAlignedObjectArray<btCollisionShape*> collision_shapes_;
+    // Bodies are created by the caller of add_rigid_body and destroyed on
+    // the simulation thread
+    std::mutex pool_mutex_;
+    cppext::object_pool<btDefaultMotionState> motion_states_;
+    cppext::object_pool<btRigidBody> bodies_;
 
     std::unique_ptr<bullet_debug_renderer> debug_renderer_;
+
+    std::function<void(std::span<ray const>)> raycast_listener_;
+
+    // Simulation thread
+    std::mutex command_mutex_;
+    std::condition_variable_any command_condition_;
+    std::vector<std::move_only_function<void()>> commands_;
+    std::atomic_bool debug_draw_requested_{};
+    std::jthread thread_;
+
+    // Transforms after the latest step, accessed only by the stepping thread
+    steady_clock::time_point last_step_time_;
+    std::vector<body_transform> last_step_;
+
+    // Written after each step, read by update
+    cppext::triple_buffer<snapshot> snapshots_;
+    snapshot current_;
+    std::vector<body_transform> interpolated_;
+
+    // Statistics of the last step
+    std::atomic<float> step_time_{};
+    std::atomic<int> dynamic_bodies_{};
+
+    // Mirrors heightfield_collision_ for the debug window
+    bool heightfield_narrowphase_{true};
 };
 
+#ifdef SOIL_BULLET_MULTITHREADED
+soil::physics_engine::impl::impl()
+    : task_scheduler_{&cppext::default_thread_pool()}
+    , dispatcher_{&collision_configuration_}
+    , solver_pool_{task_scheduler_.getNumThreads()}
+    , world_{&dispatcher_,
+          &overlapping_pair_cache_,
+          &solver_pool_,
+          &solver_,
+          &collision_configuration_}
+    , heightfield_collision_{&dispatcher_, &collision_configuration_}
+{
+    // Has to be called from the main thread
+    btSetTaskScheduler(&task_scheduler_);
+}
+#else
 soil::physics_engine::impl::impl()
     : dispatcher_{&collision_configuration_}
     , world_{&dispatcher_,
           &overlapping_pair_cache_,
           &solver_,
           &collision_configuration_}
+    , heightfield_collision_{&dispatcher_, &collision_configuration_}
 {
 }
+#endif
 
 soil::physics_engine::impl::~impl()
 {
-    // NOLINTBEGIN(cppcoreguidelines-owning-memory)
+    stop_thread();
+
     // remove the rigidbodies from the dynamics world and delete them
     for (int i{world_.getNumCollisionObjects() - 1}; i >= 0; --i)
     {
         btCollisionObject* obj{world_.getCollisionObjectArray()[i]};
+        world_.removeCollisionObject(obj);
 
-        if (btRigidBody* const body{btRigidBody::upcast(obj)};
-            body && body->getMotionState())
+        if (btRigidBody* const body{btRigidBody::upcast(obj)})
         {
-            delete body->getMotionState();
+            destroy_body(body);
         }
+        else
+        {
+            delete obj; // NOLINT(cppcoreguidelines-owning-memory)
+        }
+    }
 
-        world_.removeCollisionObject(obj);
-        delete obj;
+#ifdef SOIL_BULLET_MULTITHREADED
+    btSetTaskScheduler(btGetSequentialTaskScheduler());
+#endif
+}
+
+void soil::physics_engine::impl::start_thread(float const step_interval)
+{
+    thread_ = std::jthread{
+        [this, step_interval](std::stop_token const& stop_token)
+        { simulate(stop_token, step_interval); }};
+}
+
+void soil::physics_engine::impl::stop_thread()
+{
+    if (thread_.joinable())
+    {
+        thread_.request_stop();
+        thread_.join();
     }
+}
+
+bool soil::physics_engine::impl::threaded() const
+{
+    return thread_.joinable();
+}
 
-    // delete collision shapes
-    for (int j{}; j < collision_shapes_.size(); ++j)
+void soil::physics_engine::impl::synchronize(
+    std::move_only_function<void()> function)
+{
+    if (!threaded() || std::this_thread::get_id() == thread_.get_id())
     {
-        delete std::exchange(collision_shapes_[j], nullptr);
+        function();
+        return;
     }
-    collision_shapes_.clear();
-    // NOLINTEND(cppcoreguidelines-owning-memory)
+
+    std::packaged_task<void()> task{std::move(function)};
+    std::future<void> result{task.get_future()};
+    submit(std::move(task));
+    result.get();
 }
 
 void soil::physics_engine::impl::fixed_update(float const delta_time)
 {
-    world_.stepSimulation(delta_time, 10);
+    if (threaded())
+    {
+        return;
+    }
+
+    // Called with fixed intervals, stepped without internal substeps
+    step(delta_time, 0);
+    publish_snapshot();
 }
 
 void soil::physics_engine::impl::set_gravity(glm::vec3 const& gravity)
 {
-    world_.setGravity(to_bullet(gravity));
+    submit([this, gravity]() { world_.setGravity(to_bullet(gravity)); });
 }
 
-void soil::physics_engine::impl::update(glm::vec3 const& camera_position)
+void soil::physics_engine::impl::update(glm::vec3 const& camera_position,
+    float const interpolation_alpha)
 {
+    if (snapshots_.update())
+    {
+        current_ = snapshots_.read_buffer();
+    }
+
+    // Rendered one step behind, within the latest step. Simulation thread
+    // isn't synchronized with the frame, alpha is estimated from the time
+    // elapsed since the latest step.
+    float alpha{interpolation_alpha};
+    if (threaded())
+    {
+        using seconds = std::chrono::duration<float>;
+        alpha = current_.time > current_.previous_time
+            ? std::min(seconds{steady_clock::now() - current_.time} /
+                      seconds{current_.time - current_.previous_time},
+                  1.0f)
+            : 1.0f;
+    }
+
+    interpolated_.resize(current_.bodies.size());
+    for (size_t i{}; i != current_.bodies.size(); ++i)
+    {
+        body_transform const& from{current_.previous[i]};
+        body_transform const& to{current_.bodies[i]};
+        interpolated_[i] = {.body = to.body,
+            .position = glm::mix(from.position, to.position, alpha),
+            .rotation = glm::slerp(from.rotation, to.rotation, alpha)};
+    }
+
     if (debug_renderer_)
     {
         debug_renderer_->set_camera_position(camera_position);
-        world_.debugDrawWorld();
+        if (threaded())
+        {
+            // World is read by the simulation thread after its next step
+            debug_draw_requested_ = true;
+        }
+        else
+        {
+            debug_draw();
+        }
+    }
+}
+
+std::span<soil::body_transform const>
+soil::physics_engine::impl::body_transforms() const
+{
+    return interpolated_;
+}
+
+void soil::physics_engine::impl::draw_imgui()
+{
+    ImGui::Begin("Bullet Physics");
+#ifdef SOIL_BULLET_MULTITHREADED
+    ImGui::Text("Multithreaded world, %d threads",
+        task_scheduler_.getNumThreads());
+#endif
+    ImGui::Text("Step time: %.3f ms", static_cast<double>(step_time_.load()));
+    ImGui::Text("Dynamic bodies: %d", dynamic_bodies_.load());
+
+    allocation_stats const bullet{bullet_allocation_stats()};
+    ImGui::Text("Bullet memory: %zu KiB, peak %zu KiB",
+        bullet.bytes / 1024,
+        bullet.peak_bytes / 1024);
+    ImGui::Text("Bullet allocations: %zu live, %zu total",
+        bullet.allocations,
+        bullet.total_allocations);
+    ImGui::Text("Bullet free lists: %zu KiB", bullet.pooled_bytes / 1024);
+
+    auto const [bodies, body_capacity, motion_state_capacity] = [this]()
+    {
+        std::lock_guard const lock{pool_mutex_};
+        return std::tuple{bodies_.size(),
+            bodies_.capacity(),
+            motion_states_.capacity()};
+    }();
+    ImGui::Text("Body pool: %zu / %zu, %zu KiB",
+        bodies,
+        body_capacity,
+        (body_capacity * sizeof(btRigidBody) +
+            motion_state_capacity * sizeof(btDefaultMotionState)) /
+            1024);
+
+    if (ImGui::Checkbox("Heightfield narrowphase", &heightfield_narrowphase_))
+    {
+        submit(
+            [this, enabled = heightfield_narrowphase_]()
+            {
+                heightfield_collision_.set_enabled(enabled);
+
+                // Existing pairs recreate their algorithms on the next step
+                btOverlappingPairCache* const cache{world_.getPairCache()};
+                btBroadphasePairArray& pairs{cache->getOverlappingPairArray()};
+                for (int i{}; i < pairs.size(); ++i)
+                {
+                    cache->cleanOverlappingPair(pairs[i], &dispatcher_);
+                }
+            });
+    }
+    ImGui::End();
+
+    if (debug_renderer_)
+    {
+        debug_renderer_->draw_imgui();
     }
 }
 
@@ -142,78 +429,304 @@ void soil::physics_engine::impl::attach_renderer(
     vkrndr::vulkan_image* const color_image,
     vkrndr::vulkan_image* const depth_buffer)
 {
-    debug_renderer_ = std::make_unique<bullet_debug_renderer>(device,
+    auto debug_renderer{std::make_unique<bullet_debug_renderer>(device,
         renderer,
         color_image,
-        depth_buffer);
-    world_.setDebugDrawer(debug_renderer_.get());
+        depth_buffer)};
+    synchronize(
+        [this, &debug_renderer]()
+        {
+            debug_renderer_ = std::move(debug_renderer);
+            world_.setDebugDrawer(debug_renderer_.get());
+        });
 }
 
 void soil::physics_engine::impl::detach_renderer(
     [[maybe_unused]] vkrndr::vulkan_device* const device,
     [[maybe_unused]] vkrndr::vulkan_renderer* const renderer)
 {
-    world_.setDebugDrawer(nullptr);
-    debug_renderer_ = nullptr;
+    synchronize(
+        [this]()
+        {
+            world_.setDebugDrawer(nullptr);
+            debug_renderer_ = nullptr;
+        });
 }
 
 btRigidBody* soil::physics_engine::impl::add_rigid_body(
     std::unique_ptr<btCollisionShape> shape,
     float const mass,
-    btTransform const& transform)
+    btTransform const& transform,
+    int const user_index)
 {
     btVector3 local_inertia{0, 0, 0};
     if (shape && mass != 0.0f)
     {
         shape->calculateLocalInertia(mass, local_inertia);
     }
-    collision_shapes_.push_back(shape.release());
 
-    // NOLINTBEGIN(cppcoreguidelines-owning-memory)
-    btDefaultMotionState* const motion_state{
-        new btDefaultMotionState{transform}};
-    btRigidBody::btRigidBodyConstructionInfo const rigid_body_info{mass,
-        motion_state,
-        collision_shapes_[collision_shapes_.size() - 1],
-        local_inertia};
-    btRigidBody* const body{new btRigidBody{rigid_body_info}};
-    // NOLINTEND(cppcoreguidelines-owning-memory)
+    btRigidBody* body; // NOLINT
+    {
+        std::lock_guard const lock{pool_mutex_};
+
+        btDefaultMotionState* const motion_state{
+            motion_states_.create(transform)};
+        btRigidBody::btRigidBodyConstructionInfo const rigid_body_info{mass,
+            motion_state,
+            shape.release(),
+            local_inertia};
+        body = bodies_.create(rigid_body_info);
+    }
+    body->setUserIndex(user_index);
 
     // add the body to the dynamics world
-    world_.addRigidBody(body);
+    submit([this, body]() { world_.addRigidBody(body); });
 
     return body;
 }
 
+void soil::physics_engine::impl::remove_rigid_body(btRigidBody* const body)
+{
+    submit(
+        [this, body]()
+        {
+            world_.removeRigidBody(body);
+            destroy_body(body);
+        });
+}
+
+void soil::physics_engine::impl::destroy_body(btRigidBody* const body)
+{
+    btCollisionShape* const shape{body->getCollisionShape()};
+    // All motion states are created by add_rigid_body
+    auto* const motion_state{
+        static_cast<btDefaultMotionState*>(body->getMotionState())};
+
+    {
+        std::lock_guard const lock{pool_mutex_};
+        bodies_.destroy(body);
+        motion_states_.destroy(motion_state);
+    }
+
+    delete shape; // NOLINT(cppcoreguidelines-owning-memory)
+}
+
 std::pair<btRigidBody const*, btVector3> soil::physics_engine::impl::raycast(
     btVector3 const& from,
-    btVector3 const& to) const
+    btVector3 const& to)
+{
+    std::pair<btRigidBody const*, btVector3> rv{nullptr, {}};
+
+    synchronize(
+        [this, &from, &to, &rv]()
+        {
+            btCollisionWorld::ClosestRayResultCallback callback{from, to};
+            world_.rayTest(from, to, callback);
+            if (callback.hasHit())
+            {
+                rv = std::make_pair(
+                    btRigidBody::upcast(callback.m_collisionObject),
+                    callback.m_hitPointWorld);
+            }
+        });
+
+    return rv;
+}
+
+void soil::physics_engine::impl::raycast(std::span<ray const> const rays,
+    std::span<ray_hit> const hits)
+{
+    // World isn't modified while rays are cast
+    synchronize(
+        [this, rays, hits]()
+        {
+            cast_rays(overlapping_pair_cache_,
+                rays,
+                hits,
+                cppext::default_thread_pool());
+        });
+}
+
+void soil::physics_engine::impl::on_raycast(
+    std::function<void(std::span<ray const>)> listener)
+{
+    raycast_listener_ = std::move(listener);
+}
+
+void soil::physics_engine::impl::notify_raycast(
+    std::span<ray const> const rays) const
+{
+    if (raycast_listener_)
+    {
+        raycast_listener_(rays);
+    }
+}
+
+void soil::physics_engine::impl::submit(
+    std::move_only_function<void()> command)
+{
+    if (!threaded() || std::this_thread::get_id() == thread_.get_id())
+    {
+        command();
+        return;
+    }
+
+    {
+        std::lock_guard const lock{command_mutex_};
+        commands_.push_back(std::move(command));
+    }
+    command_condition_.notify_one();
+}
+
+void soil::physics_engine::impl::simulate(std::stop_token const& stop_token,
+    float const step_interval)
+{
+    auto const interval{std::chrono::duration_cast<steady_clock::duration>(
+        std::chrono::duration<float>{step_interval})};
+    // Steps missed beyond this are dropped instead of caught up on
+    constexpr int max_behind{10};
+
+    std::vector<std::move_only_function<void()>> commands;
+    steady_clock::time_point next_step{steady_clock::now() + interval};
+    while (!stop_token.stop_requested())
+    {
+        {
+            std::unique_lock lock{command_mutex_};
+            command_condition_.wait_until(lock,
+                stop_token,
+                next_step,
+                [this]() { return !commands_.empty(); });
+            std::swap(commands, commands_);
+        }
+        run_commands(commands);
+
+        steady_clock::time_point const now{steady_clock::now()};
+        if (now < next_step)
+        {
+            continue;
+        }
+
+        step(step_interval, 0);
+        publish_snapshot();
+
+        if (debug_renderer_ && debug_draw_requested_.exchange(false))
+        {
+            debug_draw();
+        }
+
+        next_step += interval;
+        if (now - next_step > max_behind * interval)
+        {
+            next_step = now + interval;
+        }
+    }
+
+    // Bodies queued before stopping are still owned by the world
+    std::lock_guard const lock{command_mutex_};
+    run_commands(commands_);
+}
+
+void soil::physics_engine::impl::run_commands(
+    std::vector<std::move_only_function<void()>>& commands)
 {
-    btCollisionWorld::ClosestRayResultCallback callback{from, to};
-    world_.rayTest(from, to, callback);
-    if (callback.hasHit())
+    for (auto& command : commands)
     {
-        return std::make_pair(btRigidBody::upcast(callback.m_collisionObject),
-            callback.m_hitPointWorld);
+        command();
     }
+    commands.clear();
+}
 
-    return {nullptr, {}};
+void soil::physics_engine::impl::step(float const delta_time,
+    int const max_sub_steps)
+{
+    auto const start{steady_clock::now()};
+    world_.stepSimulation(delta_time, max_sub_steps);
+    std::chrono::duration<float, std::milli> const elapsed{
+        steady_clock::now() - start};
+    step_time_ = elapsed.count();
 }
 
-soil::physics_engine::physics_engine() : impl_{std::make_unique<impl>()} { }
+void soil::physics_engine::impl::publish_snapshot()
+{
+    snapshot& next{snapshots_.write_buffer()};
+    next.previous_time = last_step_time_;
+    next.time = steady_clock::now();
+    next.previous.clear();
+    next.bodies.clear();
+
+    auto const& bodies{world_.getNonStaticRigidBodies()};
+    for (int i{}; i != bodies.size(); ++i)
+    {
+        btTransform const& transform{bodies[i]->getWorldTransform()};
+        body_transform const current{.body = bodies[i],
+            .position = from_bullet(transform.getOrigin()),
+            .rotation = from_bullet(transform.getRotation())};
+
+        // Bodies added since the previous step don't move within this one
+        auto const index{static_cast<size_t>(i)};
+        next.previous.push_back(
+            index < last_step_.size() && last_step_[index].body == bodies[i]
+                ? last_step_[index]
+                : current);
+        next.bodies.push_back(current);
+    }
+    dynamic_bodies_ = bodies.size();
+
+    last_step_time_ = next.time;
+    last_step_ = next.bodies;
+
+    snapshots_.publish();
+}
+
+void soil::physics_engine::impl::debug_draw()
+{
+    world_.debugDrawWorld();
+    debug_renderer_->publish_lines();
+}
+
+soil::physics_engine::physics_engine()
+{
+    // Before the world makes its first allocation
+    install_bullet_allocator();
+    impl_ = std::make_unique<impl>();
+}
 
 soil::physics_engine::~physics_engine() = default;
 
+void soil::physics_engine::start_thread(float const step_interval)
+{
+    impl_->start_thread(step_interval);
+}
+
+void soil::physics_engine::stop_thread() { impl_->stop_thread(); }
+
+bool soil::physics_engine::threaded() const { return impl_->threaded(); }
+
+void soil::physics_engine::synchronize(
+    std::move_only_function<void()> function)
+{
+    impl_->synchronize(std::move(function));
+}
+
 void soil::physics_engine::fixed_update(float const delta_time)
 {
     impl_->fixed_update(delta_time);
 }
 
-void soil::physics_engine::update(glm::vec3 const& camera_position)
+void soil::physics_engine::update(glm::vec3 const& camera_position,
+    float const interpolation_alpha)
+{
+    impl_->update(camera_position, interpolation_alpha);
+}
+
+std::span<soil::body_transform const>
+soil::physics_engine::body_transforms() const
 {
-    impl_->update(camera_position);
+    return impl_->body_transforms();
 }
 
+void soil::physics_engine::draw_imgui() { impl_->draw_imgui(); }
+
 soil::bullet_debug_renderer* soil::physics_engine::debug_renderer()
 {
     return impl_->debug_renderer();
@@ -241,14 +754,39 @@ void soil::physics_engine::set_gravity(glm::vec3 const& gravity)
 btRigidBody* soil::physics_engine::add_rigid_body(
     std::unique_ptr<btCollisionShape> shape,
     float const mass,
-    btTransform const& transform)
+    btTransform const& transform,
+    int const user_index)
+{
+    return impl_->add_rigid_body(std::move(shape),
+        mass,
+        transform,
+        user_index);
+}
+
+void soil::physics_engine::remove_rigid_body(btRigidBody* const body)
 {
-    return impl_->add_rigid_body(std::move(shape), mass, transform);
+    impl_->remove_rigid_body(body);
 }
 
 std::pair<btRigidBody const*, glm::vec3>
 soil::physics_engine::raycast(glm::vec3 const& from, glm::vec3 const& to) const
 {
+    ray const r{.from = from, .to = to};
+    impl_->notify_raycast({&r, 1});
+
     auto rv{impl_->raycast(to_bullet(from), to_bullet(to))};
     return {rv.first, from_bullet(rv.second)};
 }
+
+void soil::physics_engine::raycast(std::span<ray const> const rays,
+    std::span<ray_hit> const hits) const
+{
+    impl_->notify_raycast(rays);
+    impl_->raycast(rays, hits);
+}
+
+void soil::physics_engine::on_raycast(
+    std::function<void(std::span<ray const>)> listener)
+{
+    impl_->on_raycast(std::move(listener));
+}
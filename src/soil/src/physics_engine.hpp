@@ -1,9 +1,15 @@
 #ifndef SOIL_PHYSICS_ENGINE_INCLUDED
 #define SOIL_PHYSICS_ENGINE_INCLUDED
 
+#include <ray_batch.hpp>
+
+#include <glm/gtc/quaternion.hpp>
 #include <glm/vec3.hpp>
 
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <span>
 #include <utility>
 
 class btCollisionShape;
@@ -24,6 +30,13 @@ namespace soil
 
 namespace soil
 {
+    struct [[nodiscard]] body_transform final
+    {
+        btRigidBody const* body;
+        glm::vec3 position;
+        glm::quat rotation;
+    };
+
     class [[nodiscard]] physics_engine final
     {
     public:
@@ -37,9 +50,28 @@ namespace soil
         ~physics_engine();
 
     public:
+        // Steps the world every step_interval seconds on a dedicated thread,
+        // fixed_update does nothing while it is running
+        void start_thread(float step_interval);
+
+        void stop_thread();
+
+        [[nodiscard]] bool threaded() const;
+
+        // Runs function between simulation steps and waits for it to finish
+        void synchronize(std::move_only_function<void()> function);
+
         void fixed_update(float delta_time);
 
-        void update(glm::vec3 const& camera_position);
+        // Reads the latest published step and interpolates body transforms,
+        // alpha is the elapsed fraction of the next step when not threaded
+        void update(glm::vec3 const& camera_position,
+            float interpolation_alpha);
+
+        // Dynamic bodies interpolated between the last two steps
+        [[nodiscard]] std::span<body_transform const> body_transforms() const;
+
+        void draw_imgui();
 
         [[nodiscard]] bullet_debug_renderer* debug_renderer();
 
@@ -54,13 +86,26 @@ namespace soil
     public:
         void set_gravity(glm::vec3 const& gravity);
 
+        // When threaded the body is added to the world before the next step,
+        // user_index is set before the simulation can see the body
         btRigidBody* add_rigid_body(std::unique_ptr<btCollisionShape> shape,
             float mass,
-            btTransform const& transform);
+            btTransform const& transform,
+            int user_index = -1);
+
+        void remove_rigid_body(btRigidBody* body);
 
         [[nodiscard]] std::pair<btRigidBody const*, glm::vec3>
         raycast(glm::vec3 const& from, glm::vec3 const& to) const;
 
+        // Casts rays in parallel, hits[i] is the closest hit of rays[i] or
+        // without a body if there is none
+        void raycast(std::span<ray const> rays, std::span<ray_hit> hits) const;
+
+        // Called with the rays before they are cast, allows bodies along
+        // them to be added on demand
+        void on_raycast(std::function<void(std::span<ray const>)> listener);
+
     public:
         physics_engine& operator=(physics_engine const&) = delete;
 
@@ -0,0 +1,326 @@
+#include <procedural_heightmap.hpp>
+
+#include <heightmap.hpp>
+#include <noise.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <glm/vec2.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+soil::procedural_heightmap::procedural_heightmap(
+    noise_settings const& settings,
+    size_t const tile_dimension,
+    size_t const cache_capacity)
+    : settings_{settings}
+    , tile_dimension_{tile_dimension}
+    , cache_capacity_{cache_capacity}
+{
+    assert(tile_dimension_ > 1);
+    assert(cache_capacity_ > 0);
+
+    auto const worker_count{
+        std::max(1u, std::thread::hardware_concurrency() / 2)};
+    workers_.reserve(worker_count);
+    for (unsigned i{}; i != worker_count; ++i)
+    {
+        workers_.emplace_back([this](std::stop_token const& token)
+            { worker(token); });
+    }
+}
+
+soil::procedural_heightmap::~procedural_heightmap()
+{
+    for (auto& worker : workers_)
+    {
+        worker.request_stop();
+    }
+    workers_.clear();
+}
+
+soil::noise_settings const& soil::procedural_heightmap::settings() const
+{
+    return settings_;
+}
+
+size_t soil::procedural_heightmap::tile_dimension() const
+{
+    return tile_dimension_;
+}
+
+size_t soil::procedural_heightmap::cached_tiles() const
+{
+    std::scoped_lock const lock{mutex_};
+    return lru_.size();
+}
+
+size_t soil::procedural_heightmap::pending_tiles() const
+{
+    std::scoped_lock const lock{mutex_};
+    return pending_.size();
+}
+
+void soil::procedural_heightmap::request(glm::ivec2 const& tile)
+{
+    std::scoped_lock const lock{mutex_};
+    request_locked(tile);
+}
+
+void soil::procedural_heightmap::wait_idle()
+{
+    std::unique_lock lock{mutex_};
+    work_done_.wait(lock, [this]() { return pending_.empty(); });
+}
+
+bool soil::procedural_heightmap::fill(heightmap& target,
+    glm::ivec2 const& first_tile,
+    size_t const tiles_per_dimension)
+{
+    auto const step{tile_dimension_ - 1};
+    assert(target.dimension() == tiles_per_dimension * step + 1);
+
+    std::vector<tile_data> tiles;
+    tiles.reserve(tiles_per_dimension * tiles_per_dimension);
+    {
+        std::scoped_lock const lock{mutex_};
+
+        bool complete{true};
+        for (size_t y{}; y != tiles_per_dimension; ++y)
+        {
+            for (size_t x{}; x != tiles_per_dimension; ++x)
+            {
+                glm::ivec2 const tile{
+                    first_tile.x + cppext::narrow<int>(x),
+                    first_tile.y + cppext::narrow<int>(y)};
+
+                if (auto const it{cache_.find(tile)}; it != cache_.cend())
+                {
+                    lru_.splice(lru_.begin(), lru_, it->second);
+                    tiles.push_back(it->second->second);
+                }
+                else
+                {
+                    request_locked(tile);
+                    complete = false;
+                }
+            }
+        }
+
+        if (!complete)
+        {
+            return false;
+        }
+    }
+
+    auto const data{target.data()};
+    for (size_t y{}; y != tiles_per_dimension; ++y)
+    {
+        for (size_t x{}; x != tiles_per_dimension; ++x)
+        {
+            auto const& tile{*tiles[y * tiles_per_dimension + x]};
+            for (size_t row{}; row != tile_dimension_; ++row)
+            {
+                std::ranges::copy_n(tile.data() + row * tile_dimension_,
+                    cppext::narrow<std::ptrdiff_t>(tile_dimension_),
+                    data.data() + (y * step + row) * target.dimension() +
+                        x * step);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool soil::procedural_heightmap::shift(heightmap& target,
+    glm::ivec2 const& previous_first_tile,
+    glm::ivec2 const& first_tile,
+    size_t const tiles_per_dimension)
+{
+    auto const step{tile_dimension_ - 1};
+    assert(target.dimension() == tiles_per_dimension * step + 1);
+
+    auto const window{cppext::narrow<int>(tiles_per_dimension)};
+    glm::ivec2 const tile_shift{first_tile - previous_first_tile};
+    auto const in_previous_window = [&](glm::ivec2 const& local)
+    {
+        glm::ivec2 const previous{local + tile_shift};
+        return previous.x >= 0 && previous.x < window && previous.y >= 0 &&
+            previous.y < window;
+    };
+
+    std::vector<std::pair<glm::ivec2, tile_data>> tiles;
+    {
+        std::scoped_lock const lock{mutex_};
+
+        bool complete{true};
+        for (int y{}; y != window; ++y)
+        {
+            for (int x{}; x != window; ++x)
+            {
+                glm::ivec2 const local{x, y};
+                if (in_previous_window(local))
+                {
+                    continue;
+                }
+
+                glm::ivec2 const tile{first_tile + local};
+                if (auto const it{cache_.find(tile)}; it != cache_.cend())
+                {
+                    lru_.splice(lru_.begin(), lru_, it->second);
+                    tiles.emplace_back(local, it->second->second);
+                }
+                else
+                {
+                    request_locked(tile);
+                    complete = false;
+                }
+            }
+        }
+
+        if (!complete)
+        {
+            return false;
+        }
+    }
+
+    auto const dimension{cppext::narrow<int>(target.dimension())};
+    glm::ivec2 const sample_shift{tile_shift * cppext::narrow<int>(step)};
+    auto const retained = [dimension](int const sample, int const shift)
+    {
+        int const source{sample + shift};
+        return source >= 0 && source < dimension;
+    };
+
+    auto const data{target.data()};
+    auto const at = [&data, dimension](int const x, int const y)
+    { return data.data() + cppext::narrow<size_t>(y * dimension + x); };
+
+    // Rows are moved in the order which reads each row before it is
+    // overwritten
+    int const moved_width{dimension - std::abs(sample_shift.x)};
+    if (moved_width > 0)
+    {
+        for (int i{}; i != dimension; ++i)
+        {
+            int const y{sample_shift.y > 0 ? i : dimension - 1 - i};
+            if (retained(y, sample_shift.y))
+            {
+                std::memmove(at(std::max(0, -sample_shift.x), y),
+                    at(std::max(0, sample_shift.x), y + sample_shift.y),
+                    cppext::narrow<size_t>(moved_width) * sizeof(float));
+            }
+        }
+    }
+
+    // Edge samples shared with kept tiles keep their values
+    auto const tile_dimension{cppext::narrow<int>(tile_dimension_)};
+    for (auto const& [local, tile] : tiles)
+    {
+        glm::ivec2 const origin{local * cppext::narrow<int>(step)};
+        for (int row{}; row != tile_dimension; ++row)
+        {
+            int const y{origin.y + row};
+            for (int column{}; column != tile_dimension; ++column)
+            {
+                int const x{origin.x + column};
+                if (!retained(x, sample_shift.x) ||
+                    !retained(y, sample_shift.y))
+                {
+                    *at(x, y) = (*tile)[cppext::narrow<size_t>(
+                        row * tile_dimension + column)];
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t soil::procedural_heightmap::tile_hash::operator()(
+    glm::ivec2 const& tile) const noexcept
+{
+    auto const packed{
+        (static_cast<uint64_t>(static_cast<uint32_t>(tile.x)) << 32) |
+        static_cast<uint32_t>(tile.y)};
+    return std::hash<uint64_t>{}(packed);
+}
+
+void soil::procedural_heightmap::request_locked(glm::ivec2 const& tile)
+{
+    if (cache_.contains(tile) || !pending_.insert(tile).second)
+    {
+        return;
+    }
+
+    queue_.push_back(tile);
+    work_available_.notify_one();
+}
+
+soil::procedural_heightmap::tile_data soil::procedural_heightmap::generate(
+    glm::ivec2 const& tile) const
+{
+    auto const step{cppext::as_fp(tile_dimension_ - 1)};
+
+    std::vector<float> heights(tile_dimension_ * tile_dimension_);
+    generate_2d_noise(heights,
+        tile_dimension_,
+        tile_dimension_,
+        settings_,
+        cppext::as_fp(tile.x) * step,
+        cppext::as_fp(tile.y) * step);
+
+    // Match the value range of heightmap images
+    std::ranges::transform(heights,
+        heights.begin(),
+        [](float const value)
+        { return value * cppext::as_fp(std::numeric_limits<uint8_t>::max()); });
+
+    return std::make_shared<std::vector<float> const>(std::move(heights));
+}
+
+void soil::procedural_heightmap::worker(std::stop_token const& token)
+{
+    while (!token.stop_requested())
+    {
+        glm::ivec2 tile; // NOLINT
+        {
+            std::unique_lock lock{mutex_};
+            if (!work_available_.wait(lock,
+                    token,
+                    [this]() { return !queue_.empty(); }))
+            {
+                return;
+            }
+
+            tile = queue_.front();
+            queue_.pop_front();
+        }
+
+        auto data{generate(tile)};
+
+        {
+            std::scoped_lock const lock{mutex_};
+
+            lru_.emplace_front(tile, std::move(data));
+            cache_.emplace(tile, lru_.begin());
+            while (lru_.size() > cache_capacity_)
+            {
+                cache_.erase(lru_.back().first);
+                lru_.pop_back();
+            }
+
+            pending_.erase(tile);
+        }
+        work_done_.notify_all();
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef SOIL_PROCEDURAL_HEIGHTMAP_INCLUDED
+#define SOIL_PROCEDURAL_HEIGHTMAP_INCLUDED
+
+#include <noise.hpp>
+
+#include <glm/vec2.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace soil
+{
+    class heightmap;
+} // namespace soil
+
+namespace soil
+{
+    // Generates square tiles of heights from noise on worker threads.
+    // Neighbouring tiles share their edge samples, tile (x, y) starts at
+    // sample (x * (tile_dimension - 1), y * (tile_dimension - 1)).
+    class [[nodiscard]] procedural_heightmap final
+    {
+    public:
+        procedural_heightmap(noise_settings const& settings,
+            size_t tile_dimension,
+            size_t cache_capacity);
+
+        procedural_heightmap(procedural_heightmap const&) = delete;
+
+        procedural_heightmap(procedural_heightmap&&) noexcept = delete;
+
+    public:
+        ~procedural_heightmap();
+
+    public:
+        [[nodiscard]] noise_settings const& settings() const;
+
+        [[nodiscard]] size_t tile_dimension() const;
+
+        [[nodiscard]] size_t cached_tiles() const;
+
+        [[nodiscard]] size_t pending_tiles() const;
+
+        void request(glm::ivec2 const& tile);
+
+        // Blocks until all requested tiles are generated
+        void wait_idle();
+
+        // Copies tiles_per_dimension * tiles_per_dimension tiles starting at
+        // first_tile into target. Missing tiles are requested and target is
+        // left unchanged.
+        [[nodiscard]] bool fill(heightmap& target,
+            glm::ivec2 const& first_tile,
+            size_t tiles_per_dimension);
+
+        // Moves the window in target from previous_first_tile to first_tile.
+        // Samples present in both windows are kept, only samples of tiles
+        // which weren't in the previous window are copied. Missing tiles are
+        // requested and target is left unchanged.
+        [[nodiscard]] bool shift(heightmap& target,
+            glm::ivec2 const& previous_first_tile,
+            glm::ivec2 const& first_tile,
+            size_t tiles_per_dimension);
+
+    public:
+        procedural_heightmap& operator=(procedural_heightmap const&) = delete;
+
+        procedural_heightmap& operator=(
+            procedural_heightmap&&) noexcept = delete;
+
+    private:
+        using tile_data = std::shared_ptr<std::vector<float> const>;
+
+        struct [[nodiscard]] tile_hash final
+        {
+            [[nodiscard]] size_t operator()(
+                glm::ivec2 const& tile) const noexcept;
+        };
+
+    private:
+        void request_locked(glm::ivec2 const& tile);
+
+        [[nodiscard]] tile_data generate(glm::ivec2 const& tile) const;
+
+        void worker(std::stop_token const& token);
+
+    private:
+        noise_settings settings_;
+        size_t tile_dimension_;
+        size_t cache_capacity_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable_any work_available_;
+        std::condition_variable_any work_done_;
+
+        std::deque<glm::ivec2> queue_;
+        std::unordered_set<glm::ivec2, tile_hash> pending_;
+
+        // Most recently used tiles are at the front
+        std::list<std::pair<glm::ivec2, tile_data>> lru_;
+        std::unordered_map<glm::ivec2,
+            decltype(lru_)::iterator,
+            tile_hash>
+            cache_;
+
+        std::vector<std::jthread> workers_;
+    };
+} // namespace soil
+
+#endif
@@ -0,0 +1,149 @@
+#include <ray_batch.hpp>
+
+#include <bullet_adapter.hpp>
+
+#include <cppext_thread_pool.hpp>
+
+#include <BulletCollision/BroadphaseCollision/btBroadphaseProxy.h>
+#include <BulletCollision/BroadphaseCollision/btDbvt.h>
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObject.h>
+#include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+#include <BulletDynamics/Dynamics/btRigidBody.h>
+#include <LinearMath/btAlignedObjectArray.h>
+#include <LinearMath/btQuaternion.h>
+#include <LinearMath/btScalar.h>
+#include <LinearMath/btTransform.h>
+#include <LinearMath/btVector3.h>
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+
+namespace
+{
+    // Rays handled by a single task
+    constexpr size_t raycast_grain{256};
+
+    // Same as the ray test of btDbvtBroadphase, which shares its traversal
+    // stack between all callers unless Bullet is built as thread safe
+    class [[nodiscard]] closest_ray_tester final : public btDbvt::ICollide
+    {
+    public:
+        closest_ray_tester(btVector3 const& from, btVector3 const& to);
+
+    public:
+        void test(btDbvtBroadphase const& broadphase,
+            btAlignedObjectArray<btDbvtNode const*>& stack);
+
+        [[nodiscard]] soil::ray_hit hit() const;
+
+    public: // btDbvt::ICollide overrides
+        void Process(btDbvtNode const* leaf) override;
+
+    private:
+        btCollisionWorld::ClosestRayResultCallback callback_;
+        btTransform from_;
+        btTransform to_;
+    };
+
+    closest_ray_tester::closest_ray_tester(btVector3 const& from,
+        btVector3 const& to)
+        : callback_{from, to}
+        , from_{btQuaternion::getIdentity(), from}
+        , to_{btQuaternion::getIdentity(), to}
+    {
+    }
+
+    void closest_ray_tester::test(btDbvtBroadphase const& broadphase,
+        btAlignedObjectArray<btDbvtNode const*>& stack)
+    {
+        btVector3 const& from{from_.getOrigin()};
+        btVector3 const& to{to_.getOrigin()};
+
+        btVector3 const direction{(to - from).normalized()};
+        btVector3 inverse_direction; // NOLINT
+        std::array<unsigned, 3> signs; // NOLINT
+        for (int i{}; i != 3; ++i)
+        {
+            inverse_direction[i] = direction[i] == btScalar{0}
+                ? btScalar{BT_LARGE_FLOAT}
+                : btScalar{1} / direction[i];
+            signs[static_cast<size_t>(i)] = inverse_direction[i] < 0;
+        }
+        btScalar const lambda_max{direction.dot(to - from)};
+
+        btVector3 const zero{0, 0, 0};
+        for (btDbvt const& set : broadphase.m_sets)
+        {
+            set.rayTestInternal(set.m_root,
+                from,
+                to,
+                inverse_direction,
+                signs.data(),
+                lambda_max,
+                zero,
+                zero,
+                stack,
+                *this);
+        }
+    }
+
+    soil::ray_hit closest_ray_tester::hit() const
+    {
+        if (!callback_.hasHit())
+        {
+            return {};
+        }
+
+        return {.body = btRigidBody::upcast(callback_.m_collisionObject),
+            .position = soil::from_bullet(callback_.m_hitPointWorld),
+            .normal = soil::from_bullet(callback_.m_hitNormalWorld)};
+    }
+
+    void closest_ray_tester::Process(btDbvtNode const* const leaf)
+    {
+        if (callback_.m_closestHitFraction == btScalar{0})
+        {
+            return;
+        }
+
+        auto const* const proxy{static_cast<btDbvtProxy const*>(leaf->data)};
+        auto* const object{
+            static_cast<btCollisionObject*>(proxy->m_clientObject)};
+        if (callback_.needsCollision(object->getBroadphaseHandle()))
+        {
+            btCollisionWorld::rayTestSingle(from_,
+                to_,
+                object,
+                object->getCollisionShape(),
+                object->getWorldTransform(),
+                callback_);
+        }
+    }
+} // namespace
+
+void soil::cast_rays(btDbvtBroadphase const& broadphase,
+    std::span<ray const> const rays,
+    std::span<ray_hit> const hits,
+    cppext::thread_pool& pool)
+{
+    assert(rays.size() == hits.size());
+
+    // Each task uses its own traversal stack
+    cppext::parallel_for(pool,
+        0,
+        rays.size(),
+        raycast_grain,
+        [&broadphase, rays, hits](size_t const first, size_t const last)
+        {
+            btAlignedObjectArray<btDbvtNode const*> stack;
+            for (size_t i{first}; i != last; ++i)
+            {
+                closest_ray_tester tester{to_bullet(rays[i].from),
+                    to_bullet(rays[i].to)};
+                tester.test(broadphase, stack);
+                hits[i] = tester.hit();
+            }
+        });
+}
@@ -0,0 +1,40 @@
+#ifndef SOIL_RAY_BATCH_INCLUDED
+#define SOIL_RAY_BATCH_INCLUDED
+
+#include <glm/vec3.hpp>
+
+#include <span>
+
+class btDbvtBroadphase;
+class btRigidBody;
+
+namespace cppext
+{
+    class thread_pool;
+} // namespace cppext
+
+namespace soil
+{
+    struct [[nodiscard]] ray final
+    {
+        glm::vec3 from;
+        glm::vec3 to;
+    };
+
+    struct [[nodiscard]] ray_hit final
+    {
+        btRigidBody const* body{nullptr};
+        glm::vec3 position;
+        glm::vec3 normal;
+    };
+
+    // Casts rays in parallel against the objects of the broadphase, hits[i]
+    // is the closest hit of rays[i] or empty. Objects mustn't be modified
+    // until it returns.
+    void cast_rays(btDbvtBroadphase const& broadphase,
+        std::span<ray const> rays,
+        std::span<ray_hit> hits,
+        cppext::thread_pool& pool);
+} // namespace soil
+
+#endif
@@ -1,6 +1,15 @@
 #include <application.hpp>
 
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <system_error>
 
 namespace
 {
@@ -11,9 +20,51 @@ namespace
 #endif
 } // namespace
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
+int main(int argc, char** argv)
 {
-    soil::application app{enable_validation_layers};
+    std::span const arguments{argv, static_cast<size_t>(argc)};
+    bool const procedural{std::ranges::any_of(arguments,
+        [](char const* argument)
+        { return std::string_view{argument} == "--procedural"; })};
+    bool const render_thread{std::ranges::any_of(arguments,
+        [](char const* argument)
+        { return std::string_view{argument} == "--render-thread"; })};
+    bool const physics_thread{std::ranges::any_of(arguments,
+        [](char const* argument)
+        { return std::string_view{argument} == "--physics-thread"; })};
+
+    // --spawn=<count> drops bodies on the terrain after startup
+    uint32_t spawn_count{};
+    for (std::string_view argument : arguments)
+    {
+        constexpr std::string_view spawn_option{"--spawn="};
+        if (argument.starts_with(spawn_option))
+        {
+            argument.remove_prefix(spawn_option.size());
+            auto const [end, error] = std::from_chars(argument.data(),
+                argument.data() + argument.size(),
+                spawn_count);
+            // Count is edited as an int in the spawner window
+            constexpr auto max_count{
+                static_cast<uint32_t>(std::numeric_limits<int>::max())};
+            if (error != std::errc{} ||
+                end != argument.data() + argument.size() ||
+                spawn_count > max_count)
+            {
+                spdlog::error("Invalid body count '{}' for --spawn, expected "
+                              "a number up to {}",
+                    argument,
+                    max_count);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    soil::application app{enable_validation_layers,
+        procedural,
+        render_thread,
+        physics_thread,
+        spawn_count};
     app.run();
     return EXIT_SUCCESS;
 }
@@ -1,44 +1,123 @@
 #include <terrain.hpp>
 
+#include <cdlod.hpp>
+#include <clipmap_renderer.hpp>
+#include <erosion.hpp>
+#include <gpu_erosion.hpp>
+#include <heightfield_collision.hpp>
 #include <heightmap.hpp>
+#include <hiz_occlusion.hpp>
+#include <occlusion_horizon.hpp>
+#include <perspective_camera.hpp>
 #include <physics_engine.hpp>
+#include <procedural_heightmap.hpp>
+#include <terrain_lod.hpp>
 #include <terrain_renderer.hpp>
 
 #include <cppext_numeric.hpp>
 
+#include <vulkan_device.hpp>
+
+#include <BulletCollision/CollisionDispatch/btCollisionObject.h>
+#include <BulletCollision/CollisionDispatch/btInternalEdgeUtility.h>
+#include <BulletCollision/CollisionDispatch/btManifoldResult.h>
 #include <BulletCollision/CollisionShapes/btCollisionShape.h> // IWYU pragma: keep
 #include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
+#include <BulletCollision/CollisionShapes/btTriangleInfoMap.h>
+#include <BulletCollision/NarrowPhaseCollision/btManifoldPoint.h>
 #include <BulletDynamics/Dynamics/btRigidBody.h>
 #include <LinearMath/btTransform.h>
 #include <LinearMath/btVector3.h>
 
 #include <imgui.h>
 
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
 #include <cstring>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <ranges>
+#include <span>
 #include <utility>
 #include <vector>
 
 namespace
 {
+    constexpr uint32_t clipmap_levels{6};
+
+    // Draws recorded into a single secondary command buffer
+    constexpr size_t draws_per_group{32};
+
     struct [[nodiscard]] chunk_component final
     {
         uint32_t chunk_index;
         glm::vec3 chunk_offset;
     };
 
+    struct [[nodiscard]] lod_component final
+    {
+        std::vector<float> errors;
+        float min_height{};
+        float max_height{};
+        uint32_t lod{};
+        // Edges bordering a chunk with the next coarser LOD
+        uint32_t stitched_edges{};
+        bool visible{true};
+    };
+
     struct [[nodiscard]] physics_component final
     {
         std::vector<float> heights;
         btRigidBody* rigid_body{nullptr};
+        uint64_t last_used{};
     };
 
+    // Colliders are created for chunks within this distance of dynamic
+    // bodies and removed after this many updates without activity
+    constexpr float collider_activation_margin{16.0f};
+    constexpr uint64_t collider_idle_updates{120};
+
+    // Height range of heightfield colliders centered on their origin
+    constexpr float collider_min_height{-127.5f};
+    constexpr float collider_max_height{127.5f};
+
+    // Uses edge info of the terrain collider to remove contacts with
+    // internal edges between its triangles
+    bool adjust_internal_edge_contact(btManifoldPoint& cp,
+        btCollisionObjectWrapper const* const object0,
+        int const part0,
+        int const index0,
+        btCollisionObjectWrapper const* const object1,
+        int const part1,
+        int const index1)
+    {
+        // Adjusts only if the first object is a triangle of a shape with
+        // edge info
+        btAdjustInternalEdgeContacts(cp, object0, object1, part0, index0);
+        btAdjustInternalEdgeContacts(cp, object1, object0, part1, index1);
+        return true;
+    }
+
+    [[nodiscard]] uint32_t chunk_count(uint32_t const terrain_dimension,
+        uint32_t const chunk_dimension)
+    {
+        auto const chunks_per_dimension{
+            (terrain_dimension - 1) / (chunk_dimension - 1) + 1};
+        return chunks_per_dimension * chunks_per_dimension;
+    }
+
     [[nodiscard]] std::pair<size_t, size_t> global_position(size_t const x,
         size_t const y,
         size_t const chunk,
@@ -52,83 +131,138 @@ namespace
             chunk_y * (chunk_dimension - 1) + y};
     }
 
-    void generate_chunks(entt::registry& registry,
-        soil::physics_engine& physics_engine,
+    void fill_chunk_heights(std::span<float> heights,
         soil::heightmap const& heightmap,
-        size_t terrain_dimension,
-        size_t const chunk_dimension)
+        size_t const chunk,
+        size_t const chunk_dimension,
+        size_t const chunks_per_dimension)
+    {
+        for (size_t j{}; j != chunk_dimension; ++j)
+        {
+            for (size_t i{}; i != chunk_dimension; ++i)
+            {
+                auto const& [x, y] = global_position(i,
+                    j,
+                    chunk,
+                    chunk_dimension,
+                    chunks_per_dimension);
+                heights[j * chunk_dimension + i] = heightmap.value(x, y);
+            }
+        }
+    }
+
+    // Chunk at (chunk_x, chunk_y) of the window, its collider is created
+    // on demand
+    [[nodiscard]] entt::entity create_chunk(entt::registry& registry,
+        size_t const chunk_x,
+        size_t const chunk_y,
+        size_t const chunk_dimension,
+        size_t const chunks_per_dimension,
+        glm::ivec2 const& window_origin)
     {
-        auto const chunks_per_dimension{
-            (terrain_dimension - 1) / (chunk_dimension - 1) + 1};
         auto const center_distance{cppext::as_fp(chunk_dimension - 1)};
         auto const center_offset{center_distance / 2.0f};
 
-        auto generate_chunk =
-            [&](size_t const chunk_x, size_t const chunk_y) mutable
-        {
-            auto const id{registry.create()};
+        auto const id{registry.create()};
 
-            auto const offset_x{cppext::as_fp(chunk_x) * center_distance};
-            auto const offset_y{cppext::as_fp(chunk_y) * center_distance};
-            auto const& chunk{registry.emplace<chunk_component>(id,
-                cppext::narrow<uint32_t>(
-                    chunk_y * chunks_per_dimension + chunk_x),
-                glm::vec3{-center_offset + offset_x,
-                    -127.5f,
-                    -center_offset + offset_y})};
+        auto const offset_x{
+            cppext::as_fp(window_origin.x + cppext::narrow<int>(chunk_x)) *
+            center_distance};
+        auto const offset_y{
+            cppext::as_fp(window_origin.y + cppext::narrow<int>(chunk_y)) *
+            center_distance};
+        registry.emplace<chunk_component>(id,
+            cppext::narrow<uint32_t>(chunk_y * chunks_per_dimension + chunk_x),
+            glm::vec3{-center_offset + offset_x,
+                -127.5f,
+                -center_offset + offset_y});
+        registry.emplace<lod_component>(id);
 
-            // Skip adding physics to chunks which are not on diagonal
-            if (chunk_x != chunk_y)
-            {
-                return;
-            }
+        return id;
+    }
 
-            std::vector<float> heights;
-            heights.reserve(chunk_dimension * chunk_dimension);
-            for (size_t j{}; j != chunk_dimension; ++j)
-            {
-                for (size_t i{}; i != chunk_dimension; ++i)
-                {
-                    auto const& [x, y] = global_position(i,
-                        j,
-                        chunk.chunk_index,
-                        chunk_dimension,
-                        chunks_per_dimension);
-                    heights.push_back(heightmap.value(x, y));
-                }
-            }
+    // Returns chunk entities indexed by chunk index
+    [[nodiscard]] std::vector<entt::entity> generate_chunks(
+        entt::registry& registry,
+        size_t terrain_dimension,
+        size_t const chunk_dimension,
+        glm::ivec2 const& window_origin)
+    {
+        auto const chunks_per_dimension{
+            (terrain_dimension - 1) / (chunk_dimension - 1) + 1};
 
-            auto& component{registry.emplace<physics_component>(id,
-                std::move(heights),
-                nullptr)};
-
-            auto heightfield_shape{std::make_unique<btHeightfieldTerrainShape>(
-                cppext::narrow<int>(chunk_dimension),
-                cppext::narrow<int>(chunk_dimension),
-                component.heights.data(),
-                0.0f,
-                cppext::as_fp(std::numeric_limits<uint8_t>::max()),
-                1,
-                false)};
-
-            btTransform transform;
-            transform.setIdentity();
-            transform.setOrigin({offset_x, 0.0f, offset_y});
-            component.rigid_body =
-                physics_engine.add_rigid_body(std::move(heightfield_shape),
-                    0.0f,
-                    transform);
-            component.rigid_body->setUserIndex(
-                cppext::narrow<int>(chunk.chunk_index));
-        };
+        std::vector<entt::entity> rv(
+            chunks_per_dimension * chunks_per_dimension,
+            entt::null);
 
         for (auto y : std::views::iota(size_t{0}, chunks_per_dimension - 1))
         {
             for (auto x : std::views::iota(size_t{0}, chunks_per_dimension - 1))
             {
-                generate_chunk(x, y);
+                rv[y * chunks_per_dimension + x] = create_chunk(registry,
+                    x,
+                    y,
+                    chunk_dimension,
+                    chunks_per_dimension,
+                    window_origin);
             }
         }
+
+        return rv;
+    }
+
+    void calculate_chunk_errors(soil::heightmap const& heightmap,
+        chunk_component const& chunk,
+        lod_component& lod,
+        std::span<float> heights,
+        size_t const chunk_dimension,
+        size_t const chunks_per_dimension,
+        uint32_t const lod_levels)
+    {
+        fill_chunk_heights(heights,
+            heightmap,
+            chunk.chunk_index,
+            chunk_dimension,
+            chunks_per_dimension);
+
+        auto const& [min, max] = std::ranges::minmax(heights);
+        lod.min_height = min;
+        lod.max_height = max;
+        lod.errors = soil::chunk_lod_errors(heights,
+            cppext::narrow<uint32_t>(chunk_dimension),
+            lod_levels);
+    }
+
+    [[nodiscard]] soil::heightmap initial_window(
+        soil::procedural_heightmap& source,
+        uint32_t const window_chunks,
+        glm::ivec2 const& window_origin)
+    {
+        soil::heightmap rv{window_chunks * (source.tile_dimension() - 1) + 1};
+        while (!source.fill(rv, window_origin, window_chunks))
+        {
+            source.wait_idle();
+        }
+        return rv;
+    }
+
+    // Chunk grid cell containing position, chunk with offset zero is
+    // centered on the origin
+    [[nodiscard]] glm::ivec2 chunk_cell(glm::vec3 const& position,
+        float const chunk_size)
+    {
+        auto const center_offset{chunk_size / 2.0f};
+        return {static_cast<int>(
+                    std::floor((position.x + center_offset) / chunk_size)),
+            static_cast<int>(
+                std::floor((position.z + center_offset) / chunk_size))};
+    }
+
+    [[nodiscard]] float distance_to_box(glm::vec3 const& point,
+        glm::vec3 const& min,
+        glm::vec3 const& max)
+    {
+        return glm::distance(point, glm::clamp(point, min, max));
     }
 } // namespace
 
@@ -140,43 +274,222 @@ soil::terrain::terrain(heightmap const& heightmap,
     vkrndr::vulkan_image* depth_buffer)
     : physics_engine_{physics_engine}
     , device_{device}
-    , terrain_dimension_{cppext::narrow<uint32_t>(heightmap.dimension())}
-    , renderer_{heightmap,
+    , vulkan_renderer_{renderer}
+    , heightmap_{heightmap}
+    , terrain_dimension_{cppext::narrow<uint32_t>(heightmap_.dimension())}
+    , renderer_{heightmap_,
           device,
           renderer,
           color_image,
           depth_buffer,
           terrain_dimension_,
           chunk_dimension_}
+    , quadtree_{terrain_dimension_, chunk_dimension_ - 1}
+    , occlusion_{device,
+          renderer,
+          depth_buffer,
+          chunk_count(terrain_dimension_, chunk_dimension_)}
+{
+    chunk_entities_ = generate_chunks(chunk_registry_,
+        terrain_dimension_,
+        chunk_dimension_,
+        window_origin_);
+    upload_chunk_models();
+    calculate_lod_errors();
+
+    physics_engine_->on_raycast([this](std::span<ray const> const rays)
+        { request_colliders(rays); });
+}
 
+soil::terrain::terrain(procedural_heightmap* const source,
+    uint32_t const window_chunks,
+    physics_engine* const physics_engine,
+    vkrndr::vulkan_device* device,
+    vkrndr::vulkan_renderer* renderer,
+    vkrndr::vulkan_image* color_image,
+    vkrndr::vulkan_image* depth_buffer)
+    : physics_engine_{physics_engine}
+    , device_{device}
+    , vulkan_renderer_{renderer}
+    , source_{source}
+    , window_chunks_{window_chunks}
+    , window_origin_{-cppext::narrow<int>(window_chunks / 2),
+          -cppext::narrow<int>(window_chunks / 2)}
+    , heightmap_{initial_window(*source_, window_chunks_, window_origin_)}
+    , terrain_dimension_{cppext::narrow<uint32_t>(heightmap_.dimension())}
+    , chunk_dimension_{cppext::narrow<uint32_t>(source_->tile_dimension())}
+    , renderer_{heightmap_,
+          device,
+          renderer,
+          color_image,
+          depth_buffer,
+          terrain_dimension_,
+          chunk_dimension_}
+    , quadtree_{terrain_dimension_, chunk_dimension_ - 1}
+    , clipmap_{std::make_unique<clipmap_renderer>(source_->settings(),
+          clipmap_levels,
+          device,
+          renderer,
+          depth_buffer)}
+    , occlusion_{device,
+          renderer,
+          depth_buffer,
+          chunk_count(terrain_dimension_, chunk_dimension_)}
 {
-    generate_chunks(chunk_registry_,
-        *physics_engine_,
-        heightmap,
+    chunk_entities_ = generate_chunks(chunk_registry_,
         terrain_dimension_,
-        chunk_dimension_);
+        chunk_dimension_,
+        window_origin_);
+    upload_chunk_models();
+    calculate_lod_errors();
+
+    physics_engine_->on_raycast([this](std::span<ray const> const rays)
+        { request_colliders(rays); });
+}
+
+soil::terrain::~terrain()
+{
+    physics_engine_->on_raycast(nullptr);
+
+    clear_chunks();
+
+    gpu_erosion_.reset();
 }
 
 void soil::terrain::update(soil::perspective_camera const& camera,
     [[maybe_unused]] float delta_time)
 {
+    if (source_)
+    {
+        update_window(camera.position());
+    }
+
+    update_erosion();
+
+    if (single_collider_ != (terrain_collider_ != nullptr))
+    {
+        remove_colliders();
+        if (single_collider_)
+        {
+            create_terrain_collider();
+        }
+    }
+
+    if (clipmap_enabled_)
+    {
+        auto const center_offset{cppext::as_fp(chunk_dimension_ - 1) / 2.0f};
+        clipmap_->update(camera,
+            glm::vec3{-center_offset, -127.5f, -center_offset});
+    }
+    else if (!tessellation_)
+    {
+        if (!cdlod_)
+        {
+            cull_below_horizon(camera);
+        }
+        select_lods(camera);
+
+        if (!cdlod_)
+        {
+            auto const cell{chunk_cell(camera.position(),
+                cppext::as_fp(chunk_dimension_ - 1))};
+            if (cell != camera_cell_)
+            {
+                camera_cell_ = cell;
+                draw_list_dirty_ = true;
+            }
+
+            if (draw_list_dirty_)
+            {
+                rebuild_draw_list(camera.position());
+            }
+        }
+    }
+
+    view_projection_ = camera.view_projection_matrix();
+
     renderer_.update(camera);
+
+    ++physics_updates_;
+    activate_requested_colliders();
+    activate_body_colliders();
+    deactivate_idle_colliders();
 }
 
 void soil::terrain::draw(VkImageView target_image,
     VkCommandBuffer command_buffer,
     VkRect2D render_area)
 {
+    renderer_.upload(command_buffer);
+
+    if (erosion_enabled_ && gpu_erosion_)
+    {
+        gpu_erosion_->dispatch(command_buffer,
+            erosion_settings_,
+            cppext::narrow<uint32_t>(erosion_iterations_));
+    }
+
+    if (clipmap_enabled_)
+    {
+        clipmap_->upload(command_buffer);
+    }
+
+    // Pyramid is built from the depth of the previous frame, before the
+    // render pass clears it
+    bool const chunked{!clipmap_enabled_ && !tessellation_ && !cdlod_};
+    bool const occlusion_culling{occlusion_culling_ && chunked};
+    VkBuffer culled_draws{VK_NULL_HANDLE};
+    if (occlusion_culling)
+    {
+        occlusion_.build(command_buffer);
+        culled_draws = occlusion_.cull(command_buffer,
+            view_projection_,
+            occlusion_bounds_,
+            occlusion_draws_);
+    }
+
+    if (chunked && (prerecorded_ || parallel_recording_))
+    {
+        record_draw_list(target_image,
+            command_buffer,
+            render_area,
+            culled_draws);
+        return;
+    }
+
     auto const guard{
         renderer_.begin_render_pass(target_image, command_buffer, render_area)};
 
-    for (auto entity : chunk_registry_.view<chunk_component>())
+    if (clipmap_enabled_)
+    {
+        clipmap_->draw(command_buffer);
+    }
+    else if (tessellation_)
+    {
+        renderer_.begin_tessellation(command_buffer,
+            tessellation_edge_pixels_,
+            cppext::as_fp(render_area.extent.height));
+        for (auto const& [entity, chunk_comp] :
+            chunk_registry_.view<chunk_component>().each())
+        {
+            renderer_.draw_tessellated(command_buffer, chunk_comp.chunk_index);
+        }
+    }
+    else if (cdlod_)
+    {
+        renderer_.begin_cdlod(command_buffer);
+        for (auto const& node : quadtree_.selection())
+        {
+            renderer_.draw(command_buffer,
+                node,
+                quadtree_.morph_range(node.level),
+                cdlod_camera_position_,
+                heightmap_origin());
+        }
+    }
+    else
     {
-        auto const& chunk_comp{chunk_registry_.get<chunk_component>(entity)};
-        renderer_.draw(command_buffer,
-            static_cast<uint32_t>(lod_),
-            chunk_comp.chunk_index,
-            glm::translate(glm::mat4{1.0f}, chunk_comp.chunk_offset));
+        draw_range(command_buffer, 0, draw_list_.size(), culled_draws);
     }
 
     renderer_.end_render_pass();
@@ -187,8 +500,1042 @@ void soil::terrain::draw_imgui()
     ImGui::ShowMetricsWindow();
 
     ImGui::Begin("Terrain");
-    ImGui::SliderInt("LOD", &lod_, 0, renderer_.lod_levels());
+    if (clipmap_)
+    {
+        ImGui::Checkbox("Clipmap", &clipmap_enabled_);
+    }
+
+    if (clipmap_enabled_)
+    {
+        ImGui::Text("Patches: %zu", clipmap_->patch_count());
+        ImGui::Text("Updated samples: %zu", clipmap_->updated_samples());
+    }
+    else
+    {
+        if (renderer_.tessellation_supported())
+        {
+            ImGui::Checkbox("Tessellation", &tessellation_);
+        }
+
+        if (tessellation_)
+        {
+            ImGui::SliderFloat("Edge pixels",
+                &tessellation_edge_pixels_,
+                2.0f,
+                32.0f);
+        }
+        else
+        {
+            ImGui::Checkbox("CDLOD", &cdlod_);
+            if (cdlod_)
+            {
+                float distance{quadtree_.lod_distance()};
+                auto const leaf_size{cppext::as_fp(chunk_dimension_ - 1)};
+                if (ImGui::SliderFloat("LOD distance",
+                        &distance,
+                        leaf_size * 1.5f,
+                        leaf_size * 8.0f))
+                {
+                    quadtree_.set_lod_distance(distance);
+                }
+                ImGui::Text("Nodes: %zu", quadtree_.selection().size());
+            }
+            else
+            {
+                ImGui::Checkbox("Screen space error", &screen_space_lod_);
+                if (screen_space_lod_)
+                {
+                    ImGui::SliderFloat("Pixel error",
+                        &pixel_error_,
+                        0.5f,
+                        16.0f);
+                }
+                else
+                {
+                    ImGui::SliderInt("LOD", &lod_, 0, renderer_.lod_levels());
+                }
+
+                bool vertex_pulling{renderer_.vertex_pulling()};
+                if (ImGui::Checkbox("Vertex pulling", &vertex_pulling))
+                {
+                    renderer_.set_vertex_pulling(vertex_pulling);
+                }
+
+                ImGui::Checkbox("Horizon culling", &horizon_culling_);
+                if (horizon_culling_)
+                {
+                    ImGui::Text("Below horizon: %zu", horizon_culled_);
+                    ImGui::Text("Horizon culling: %" PRId64 "us",
+                        horizon_culling_time_);
+                }
+
+                ImGui::Checkbox("Occlusion culling", &occlusion_culling_);
+                if (occlusion_culling_)
+                {
+                    ImGui::Text("Occluded chunks: %u", occlusion_.rejected());
+                }
+
+                ImGui::Checkbox("Prerecorded commands", &prerecorded_);
+                ImGui::Checkbox("Parallel recording", &parallel_recording_);
+                if (parallel_recording_ && !prerecorded_)
+                {
+                    ImGui::Text("Recording threads: %u",
+                        vulkan_renderer_->recording_threads());
+                }
+            }
+        }
+    }
+
+    if (!clipmap_enabled_ && !tessellation_)
+    {
+        ImGui::Text("Triangles: %zu", drawn_triangles_);
+        ImGui::Text("LOD selection: %" PRId64 "us", lod_selection_time_);
+        if (!cdlod_)
+        {
+            ImGui::Text("Draw list rebuilds: %zu", draw_list_rebuilds_);
+        }
+    }
+
+    ImGui::Checkbox("Single collider", &single_collider_);
+
+    if (source_)
+    {
+        ImGui::Text("Window origin: %d, %d",
+            window_origin_.x,
+            window_origin_.y);
+        ImGui::Text("Cached tiles: %zu", source_->cached_tiles());
+        ImGui::Text("Pending tiles: %zu", source_->pending_tiles());
+    }
+    ImGui::End();
+
+    ImGui::Begin("Erosion");
+    ImGui::Checkbox("Enabled", &erosion_enabled_);
+    ImGui::Checkbox("CPU fallback", &erosion_on_cpu_);
+    ImGui::SliderInt("Iterations per frame", &erosion_iterations_, 1, 100);
+    ImGui::SliderFloat("Rain", &erosion_settings_.rain_rate, 0.0f, 0.1f);
+    ImGui::SliderFloat("Sediment capacity",
+        &erosion_settings_.sediment_capacity,
+        0.0f,
+        2.0f);
+    ImGui::SliderFloat("Dissolve",
+        &erosion_settings_.dissolve_rate,
+        0.0f,
+        2.0f);
+    ImGui::SliderFloat("Deposition",
+        &erosion_settings_.deposition_rate,
+        0.0f,
+        2.0f);
+    ImGui::SliderFloat("Evaporation",
+        &erosion_settings_.evaporation_rate,
+        0.0f,
+        2.0f);
+    ImGui::SliderFloat("Talus", &erosion_settings_.talus, 0.1f, 10.0f);
+    ImGui::SliderFloat("Thermal", &erosion_settings_.thermal_rate, 0.0f, 10.0f);
+    ImGui::Text("Refreshed colliders: %zu", refreshed_chunks_);
+    ImGui::Text("Active colliders: %zu", active_colliders_);
+    ImGui::Text("Collider heights: %zu KiB",
+        active_colliders_ * chunk_dimension_ * chunk_dimension_ *
+            sizeof(float) / 1024);
     ImGui::End();
 
     renderer_.draw_imgui();
 }
+
+void soil::terrain::update_window(glm::vec3 const& camera_position)
+{
+    auto const half_window{cppext::narrow<int>(window_chunks_ / 2)};
+    glm::ivec2 const desired_origin{
+        chunk_cell(camera_position, cppext::as_fp(chunk_dimension_ - 1)) -
+        glm::ivec2{half_window}};
+    if (desired_origin == window_origin_)
+    {
+        return;
+    }
+
+    // Prefetch one ring of chunks around the new window
+    auto const window{cppext::narrow<int>(window_chunks_)};
+    for (int y{-1}; y <= window; ++y)
+    {
+        for (int x{-1}; x <= window; ++x)
+        {
+            source_->request(desired_origin + glm::ivec2{x, y});
+        }
+    }
+
+    bool shifted{};
+    write_heights(
+        [&, this]()
+        {
+            shifted = source_->shift(heightmap_,
+                window_origin_,
+                desired_origin,
+                window_chunks_);
+        });
+    if (!shifted)
+    {
+        return;
+    }
+
+    glm::ivec2 const shift{desired_origin - window_origin_};
+    window_origin_ = desired_origin;
+    renderer_.shift_heightmap(heightmap_,
+        shift * cppext::narrow<int>(chunk_dimension_ - 1));
+
+    // Water and sediment don't belong to the new window
+    if (gpu_erosion_)
+    {
+        gpu_erosion_->reset();
+    }
+    if (cpu_erosion_)
+    {
+        cpu_erosion_->reset();
+    }
+
+    // Single collider covers the previous window, it is created again on
+    // next update
+    if (terrain_collider_)
+    {
+        remove_colliders();
+    }
+
+    move_chunks(shift);
+    upload_chunk_models();
+    quadtree_.update(heightmap_);
+}
+
+void soil::terrain::move_chunks(glm::ivec2 const& shift)
+{
+    auto const chunks_per_dimension{
+        (terrain_dimension_ - 1) / (chunk_dimension_ - 1) + 1};
+    auto const window{cppext::narrow<int>(window_chunks_)};
+    auto const stride{cppext::narrow<int>(chunks_per_dimension)};
+
+    std::vector<entt::entity> moved(chunk_entities_.size(), entt::null);
+    std::vector<entt::entity> removed;
+    for (int y{}; y != window; ++y)
+    {
+        for (int x{}; x != window; ++x)
+        {
+            entt::entity const entity{
+                chunk_entities_[cppext::narrow<size_t>(y * stride + x)]};
+
+            glm::ivec2 const local{glm::ivec2{x, y} - shift};
+            if (local.x < 0 || local.y < 0 || local.x >= window ||
+                local.y >= window)
+            {
+                removed.push_back(entity);
+                continue;
+            }
+
+            auto const chunk_index{
+                cppext::narrow<uint32_t>(local.y * stride + local.x)};
+            chunk_registry_.get<chunk_component>(entity).chunk_index =
+                chunk_index;
+            moved[chunk_index] = entity;
+        }
+    }
+
+    if (active_colliders_ != 0)
+    {
+        // Heights of removed colliders are destroyed with their chunks,
+        // kept colliders are labeled with their new chunk index
+        physics_engine_->synchronize(
+            [this, &removed]()
+            {
+                for (entt::entity const entity : removed)
+                {
+                    if (auto const* const physics{
+                            chunk_registry_.try_get<physics_component>(
+                                entity)})
+                    {
+                        physics_engine_->remove_rigid_body(
+                            physics->rigid_body);
+                        --active_colliders_;
+                    }
+                }
+
+                for (auto&& [entity, chunk, physics] :
+                    chunk_registry_
+                        .view<chunk_component, physics_component>()
+                        .each())
+                {
+                    physics.rigid_body->setUserIndex(
+                        cppext::narrow<int>(chunk.chunk_index));
+                }
+            });
+    }
+    chunk_registry_.destroy(removed.begin(), removed.end());
+
+    std::vector<float> heights(size_t{chunk_dimension_} * chunk_dimension_);
+    for (size_t y{}; y != window_chunks_; ++y)
+    {
+        for (size_t x{}; x != window_chunks_; ++x)
+        {
+            entt::entity& entity{moved[y * chunks_per_dimension + x]};
+            if (entity != entt::null)
+            {
+                continue;
+            }
+
+            entity = create_chunk(chunk_registry_,
+                x,
+                y,
+                chunk_dimension_,
+                chunks_per_dimension,
+                window_origin_);
+            calculate_chunk_errors(heightmap_,
+                chunk_registry_.get<chunk_component>(entity),
+                chunk_registry_.get<lod_component>(entity),
+                heights,
+                chunk_dimension_,
+                chunks_per_dimension,
+                cppext::narrow<uint32_t>(renderer_.lod_levels()));
+        }
+    }
+    chunk_entities_ = std::move(moved);
+
+    // Chunk indices changed
+    draw_list_dirty_ = true;
+}
+
+void soil::terrain::upload_chunk_models()
+{
+    auto const chunks_per_dimension{
+        (terrain_dimension_ - 1) / (chunk_dimension_ - 1) + 1};
+
+    std::vector<glm::mat4> models(
+        size_t{chunks_per_dimension} * chunks_per_dimension,
+        glm::mat4{1.0f});
+    for (auto const& [entity, chunk] :
+        chunk_registry_.view<chunk_component>().each())
+    {
+        models[chunk.chunk_index] =
+            glm::translate(glm::mat4{1.0f}, chunk.chunk_offset);
+    }
+
+    renderer_.update_chunks(models);
+}
+
+void soil::terrain::calculate_lod_errors()
+{
+    quadtree_.update(heightmap_);
+
+    auto const chunks_per_dimension{
+        (terrain_dimension_ - 1) / (chunk_dimension_ - 1) + 1};
+
+    std::vector<float> heights(size_t{chunk_dimension_} * chunk_dimension_);
+    for (auto&& [entity, chunk, lod] :
+        chunk_registry_.view<chunk_component, lod_component>().each())
+    {
+        calculate_chunk_errors(heightmap_,
+            chunk,
+            lod,
+            heights,
+            chunk_dimension_,
+            chunks_per_dimension,
+            cppext::narrow<uint32_t>(renderer_.lod_levels()));
+    }
+
+    // Bounds of chunks changed
+    draw_list_dirty_ = true;
+}
+
+void soil::terrain::cull_below_horizon(
+    soil::perspective_camera const& camera)
+{
+    auto view{chunk_registry_.view<chunk_component, lod_component>()};
+    if (!horizon_culling_)
+    {
+        horizon_culled_ = 0;
+        for (auto&& [entity, chunk, lod] : view.each())
+        {
+            draw_list_dirty_ |= !lod.visible;
+            lod.visible = true;
+        }
+        return;
+    }
+
+    auto const culling_start{std::chrono::steady_clock::now()};
+
+    auto const chunk_size{cppext::as_fp(chunk_dimension_ - 1)};
+
+    // Horizon is built in the XZ plane, chunks are ordered by their
+    // horizontal distance
+    glm::vec3 const camera_position{camera.position().x,
+        0.0f,
+        camera.position().z};
+
+    front_to_back_.clear();
+    for (auto&& [entity, chunk, lod] : view.each())
+    {
+        glm::vec3 const min{chunk.chunk_offset.x, 0.0f, chunk.chunk_offset.z};
+        glm::vec3 const max{chunk.chunk_offset.x + chunk_size,
+            0.0f,
+            chunk.chunk_offset.z + chunk_size};
+        front_to_back_.emplace_back(distance_to_box(camera_position, min, max),
+            entity);
+    }
+    std::ranges::sort(front_to_back_);
+
+    horizon_.reset(camera.position());
+    horizon_culled_ = 0;
+    for (auto const& [distance, entity] : front_to_back_)
+    {
+        auto const& chunk{view.get<chunk_component>(entity)};
+        auto& lod{view.get<lod_component>(entity)};
+
+        glm::vec3 const& offset{chunk.chunk_offset};
+        bool const visible{!horizon_.occluded(
+            {offset.x, offset.y + lod.min_height, offset.z},
+            {offset.x + chunk_size,
+                offset.y + lod.max_height,
+                offset.z + chunk_size})};
+        draw_list_dirty_ |= visible != lod.visible;
+        lod.visible = visible;
+        if (!lod.visible)
+        {
+            ++horizon_culled_;
+            continue;
+        }
+
+        horizon_.add_occluder({offset.x, offset.z},
+            {offset.x + chunk_size, offset.z + chunk_size},
+            offset.y + lod.min_height);
+    }
+
+    horizon_culling_time_ =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - culling_start)
+            .count();
+}
+
+void soil::terrain::select_lods(soil::perspective_camera const& camera)
+{
+    auto const selection_start{std::chrono::steady_clock::now()};
+    auto const record_selection_time = [this, &selection_start]()
+    {
+        lod_selection_time_ =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - selection_start)
+                .count();
+    };
+
+    auto const quads{size_t{chunk_dimension_ - 1}};
+
+    if (cdlod_)
+    {
+        cdlod_camera_position_ = camera.position() - heightmap_origin();
+        quadtree_.select(cdlod_camera_position_);
+        record_selection_time();
+
+        drawn_triangles_ = 0;
+        for (auto const& node : quadtree_.selection())
+        {
+            drawn_triangles_ += 2 * quads * quads *
+                cppext::narrow<size_t>(std::popcount(node.quadrants)) / 4;
+        }
+        return;
+    }
+
+    auto const scale{projection_scale(camera.fov(), camera.extent().y)};
+    auto const chunk_size{cppext::as_fp(chunk_dimension_ - 1)};
+    auto const chunks_per_dimension{
+        (terrain_dimension_ - 1) / (chunk_dimension_ - 1) + 1};
+    size_t const grid{chunks_per_dimension - 1};
+
+    // LODs of the chunk grid, cracks between chunks are closed by
+    // stitching to a neighbour at most one LOD coarser
+    auto const grid_index = [&](chunk_component const& chunk)
+    {
+        return chunk.chunk_index / chunks_per_dimension * grid +
+            chunk.chunk_index % chunks_per_dimension;
+    };
+    std::vector<uint32_t> lods(grid * grid);
+    for (auto&& [entity, chunk, lod] :
+        chunk_registry_.view<chunk_component, lod_component>().each())
+    {
+        uint32_t& selected{lods[grid_index(chunk)]};
+        if (screen_space_lod_)
+        {
+            glm::vec3 const min{chunk.chunk_offset.x,
+                chunk.chunk_offset.y + lod.min_height,
+                chunk.chunk_offset.z};
+            glm::vec3 const max{chunk.chunk_offset.x + chunk_size,
+                chunk.chunk_offset.y + lod.max_height,
+                chunk.chunk_offset.z + chunk_size};
+
+            selected = select_lod(lod.errors,
+                distance_to_box(camera.position(), min, max),
+                scale,
+                pixel_error_);
+        }
+        else
+        {
+            selected = cppext::narrow<uint32_t>(lod_);
+        }
+    }
+    limit_lod_difference(lods, grid);
+
+    drawn_triangles_ = 0;
+    for (auto&& [entity, chunk, lod] :
+        chunk_registry_.view<chunk_component, lod_component>().each())
+    {
+        auto const previous_lod{lod.lod};
+        auto const previous_edges{lod.stitched_edges};
+
+        size_t const index{grid_index(chunk)};
+        lod.lod = lods[index];
+        lod.stitched_edges = stitched_edges(lods,
+            grid,
+            index % grid,
+            index / grid);
+        draw_list_dirty_ |=
+            lod.lod != previous_lod || lod.stitched_edges != previous_edges;
+
+        if (lod.visible)
+        {
+            auto const side{quads >> lod.lod};
+            drawn_triangles_ += 2 * side * side;
+        }
+    }
+    record_selection_time();
+}
+
+void soil::terrain::rebuild_draw_list(glm::vec3 const& camera_position)
+{
+    auto const chunk_size{cppext::as_fp(chunk_dimension_ - 1)};
+
+    draw_list_.clear();
+    for (auto&& [entity, chunk, lod] :
+        chunk_registry_.view<chunk_component, lod_component>().each())
+    {
+        if (!lod.visible)
+        {
+            continue;
+        }
+
+        glm::vec3 const& offset{chunk.chunk_offset};
+        glm::vec3 const min{offset.x, offset.y + lod.min_height, offset.z};
+        glm::vec3 const max{offset.x + chunk_size,
+            offset.y + lod.max_height,
+            offset.z + chunk_size};
+
+        draw_list_.push_back(
+            {.distance = distance_to_box(camera_position, min, max),
+                .chunk_index = chunk.chunk_index,
+                .lod = lod.lod,
+                .stitched_edges = lod.stitched_edges,
+                .bounds = {.min = glm::vec4{min, 1.0f},
+                    .max = glm::vec4{max, 1.0f}}});
+    }
+
+    // Front to back order lets early depth testing reject hidden fragments
+    std::ranges::sort(draw_list_, {}, &chunk_draw::distance);
+
+    occlusion_bounds_.clear();
+    occlusion_draws_.clear();
+    for (chunk_draw const& draw : draw_list_)
+    {
+        occlusion_bounds_.push_back(draw.bounds);
+        occlusion_draws_.push_back(
+            {.indexCount = renderer_.index_count(draw.lod),
+                .instanceCount = 1,
+                .firstIndex = 0,
+                .vertexOffset = 0,
+                .firstInstance = 0});
+    }
+
+    draw_list_dirty_ = false;
+    ++draw_list_rebuilds_;
+
+    // Recorded draws reference LODs and order of the previous list
+    renderer_.invalidate_recorded();
+}
+
+void soil::terrain::record_draw_list(VkImageView target_image,
+    VkCommandBuffer command_buffer,
+    VkRect2D const render_area,
+    VkBuffer const culled_draws)
+{
+    {
+        auto const guard{renderer_.begin_secondary_render_pass(target_image,
+            command_buffer,
+            render_area)};
+
+        if (prerecorded_)
+        {
+            renderer_.execute_recorded(command_buffer,
+                render_area,
+                culled_draws,
+                [this, culled_draws](VkCommandBuffer const secondary)
+                {
+                    draw_range(secondary,
+                        0,
+                        draw_list_.size(),
+                        culled_draws);
+                });
+        }
+        else
+        {
+            auto const group_count{cppext::narrow<uint32_t>(
+                (draw_list_.size() + draws_per_group - 1) / draws_per_group)};
+
+            vulkan_renderer_->record_secondary(command_buffer,
+                renderer_.rendering_inheritance(),
+                group_count,
+                [this, render_area, culled_draws](
+                    VkCommandBuffer const secondary,
+                    uint32_t const group)
+                {
+                    renderer_.begin_secondary(secondary, render_area);
+
+                    size_t const first{group * draws_per_group};
+                    draw_range(secondary,
+                        first,
+                        std::min(first + draws_per_group, draw_list_.size()),
+                        culled_draws);
+                });
+        }
+    }
+
+    renderer_.end_render_pass();
+}
+
+void soil::terrain::draw_range(VkCommandBuffer command_buffer,
+    size_t const first,
+    size_t const last,
+    VkBuffer const culled_draws)
+{
+    for (size_t i{first}; i != last; ++i)
+    {
+        chunk_draw const& draw{draw_list_[i]};
+        if (culled_draws == VK_NULL_HANDLE)
+        {
+            renderer_.draw(command_buffer,
+                draw.lod,
+                draw.stitched_edges,
+                draw.chunk_index);
+        }
+        else
+        {
+            // Culled draws are in the order of the draw list
+            renderer_.draw(command_buffer,
+                draw.lod,
+                draw.stitched_edges,
+                draw.chunk_index,
+                culled_draws,
+                i * sizeof(VkDrawIndexedIndirectCommand));
+        }
+    }
+}
+
+glm::vec3 soil::terrain::heightmap_origin() const
+{
+    auto const center_distance{cppext::as_fp(chunk_dimension_ - 1)};
+    auto const center_offset{center_distance / 2.0f};
+
+    return {cppext::as_fp(window_origin_.x) * center_distance - center_offset,
+        -127.5f,
+        cppext::as_fp(window_origin_.y) * center_distance - center_offset};
+}
+
+void soil::terrain::activate_colliders(glm::vec3 const& min,
+    glm::vec3 const& max)
+{
+    if (max.y < collider_min_height || min.y > collider_max_height)
+    {
+        return;
+    }
+
+    auto const chunk_size{cppext::as_fp(chunk_dimension_ - 1)};
+    glm::ivec2 const first{chunk_cell(min, chunk_size)};
+    glm::ivec2 const last{chunk_cell(max, chunk_size)};
+    for (int y{first.y}; y <= last.y; ++y)
+    {
+        for (int x{first.x}; x <= last.x; ++x)
+        {
+            activate_collider({x, y});
+        }
+    }
+}
+
+void soil::terrain::activate_colliders(std::span<ray const> const rays)
+{
+    auto const chunk_size{cppext::as_fp(chunk_dimension_ - 1)};
+
+    for (ray const& r : rays)
+    {
+        // Clip to the height range of colliders
+        glm::vec3 const direction{r.to - r.from};
+        float clip_begin{0.0f};
+        float clip_end{1.0f};
+        if (direction.y != 0.0f)
+        {
+            auto const [lower, upper] =
+                std::minmax((collider_min_height - r.from.y) / direction.y,
+                    (collider_max_height - r.from.y) / direction.y);
+            clip_begin = std::max(clip_begin, lower);
+            clip_end = std::min(clip_end, upper);
+        }
+        else if (r.from.y < collider_min_height ||
+            r.from.y > collider_max_height)
+        {
+            continue;
+        }
+
+        if (clip_begin > clip_end)
+        {
+            continue;
+        }
+
+        glm::vec3 const from{r.from + direction * clip_begin};
+        glm::vec3 const to{r.from + direction * clip_end};
+
+        // Walk the chunk cells crossed by the ray in the horizontal plane
+        glm::ivec2 cell{chunk_cell(from, chunk_size)};
+        glm::ivec2 const last{chunk_cell(to, chunk_size)};
+        glm::vec2 const start{from.x + chunk_size / 2.0f,
+            from.z + chunk_size / 2.0f};
+        glm::vec2 const delta{to.x - from.x, to.z - from.z};
+
+        glm::ivec2 step; // NOLINT
+        glm::vec2 next_boundary; // NOLINT
+        glm::vec2 boundary_distance; // NOLINT
+        for (glm::length_t i{}; i != 2; ++i)
+        {
+            step[i] = delta[i] < 0.0f ? -1 : 1;
+            if (delta[i] == 0.0f)
+            {
+                next_boundary[i] = std::numeric_limits<float>::max();
+                boundary_distance[i] = std::numeric_limits<float>::max();
+            }
+            else
+            {
+                float const boundary{
+                    cppext::as_fp(cell[i] + (step[i] > 0 ? 1 : 0)) *
+                    chunk_size};
+                next_boundary[i] = (boundary - start[i]) / delta[i];
+                boundary_distance[i] = chunk_size / std::fabs(delta[i]);
+            }
+        }
+
+        activate_collider(cell);
+        while (cell != last &&
+            std::min(next_boundary.x, next_boundary.y) <= 1.0f)
+        {
+            glm::length_t const axis{next_boundary.x < next_boundary.y ? 0 : 1};
+            cell[axis] += step[axis];
+            next_boundary[axis] += boundary_distance[axis];
+            activate_collider(cell);
+        }
+    }
+}
+
+void soil::terrain::request_colliders(std::span<ray const> const rays)
+{
+    std::lock_guard const lock{requested_rays_mutex_};
+    requested_rays_.insert(requested_rays_.end(), rays.begin(), rays.end());
+}
+
+void soil::terrain::activate_requested_colliders()
+{
+    std::vector<ray> rays;
+    {
+        std::lock_guard const lock{requested_rays_mutex_};
+        std::swap(rays, requested_rays_);
+    }
+    activate_colliders(rays);
+}
+
+void soil::terrain::activate_collider(glm::ivec2 const& cell)
+{
+    if (terrain_collider_)
+    {
+        return;
+    }
+
+    auto const chunks_per_dimension{
+        (terrain_dimension_ - 1) / (chunk_dimension_ - 1) + 1};
+
+    glm::ivec2 const local{cell - window_origin_};
+    if (local.x < 0 || local.y < 0 ||
+        local.x >= cppext::narrow<int>(chunks_per_dimension) ||
+        local.y >= cppext::narrow<int>(chunks_per_dimension))
+    {
+        return;
+    }
+
+    entt::entity const entity{chunk_entities_[cppext::narrow<size_t>(
+        local.y * cppext::narrow<int>(chunks_per_dimension) + local.x)]};
+    if (entity == entt::null)
+    {
+        return;
+    }
+
+    if (auto* const physics{
+            chunk_registry_.try_get<physics_component>(entity)})
+    {
+        physics->last_used = physics_updates_;
+        return;
+    }
+
+    auto const& chunk{chunk_registry_.get<chunk_component>(entity)};
+    auto& physics{chunk_registry_.emplace<physics_component>(entity,
+        std::vector<float>(size_t{chunk_dimension_} * chunk_dimension_),
+        nullptr,
+        physics_updates_)};
+
+    fill_chunk_heights(physics.heights,
+        heightmap_,
+        chunk.chunk_index,
+        chunk_dimension_,
+        chunks_per_dimension);
+
+    // Shape references the heights, their storage doesn't move with the
+    // component
+    auto shape{std::make_unique<heightfield_shape>(chunk_dimension_,
+        physics.heights.data(),
+        0.0f,
+        cppext::as_fp(std::numeric_limits<uint8_t>::max()))};
+
+    auto const center_offset{cppext::as_fp(chunk_dimension_ - 1) / 2.0f};
+    btTransform transform;
+    transform.setIdentity();
+    transform.setOrigin({chunk.chunk_offset.x + center_offset,
+        0.0f,
+        chunk.chunk_offset.z + center_offset});
+
+    physics.rigid_body = physics_engine_->add_rigid_body(std::move(shape),
+        0.0f,
+        transform,
+        cppext::narrow<int>(chunk.chunk_index));
+
+    ++active_colliders_;
+}
+
+void soil::terrain::deactivate_idle_colliders()
+{
+    std::vector<entt::entity> idle;
+    for (auto&& [entity, physics] :
+        chunk_registry_.view<physics_component>().each())
+    {
+        if (physics_updates_ - physics.last_used > collider_idle_updates)
+        {
+            idle.push_back(entity);
+        }
+    }
+
+    if (idle.empty())
+    {
+        return;
+    }
+
+    physics_engine_->synchronize(
+        [this, &idle]()
+        {
+            for (entt::entity const entity : idle)
+            {
+                physics_engine_->remove_rigid_body(
+                    chunk_registry_.get<physics_component>(entity).rigid_body);
+            }
+        });
+
+    chunk_registry_.remove<physics_component>(idle.begin(), idle.end());
+    active_colliders_ -= idle.size();
+}
+
+void soil::terrain::activate_body_colliders()
+{
+    glm::vec3 const margin{collider_activation_margin};
+    for (body_transform const& body : physics_engine_->body_transforms())
+    {
+        activate_colliders(body.position - margin, body.position + margin);
+    }
+}
+
+void soil::terrain::create_terrain_collider()
+{
+    // Shape reads the heightmap without copying it
+    auto shape{std::make_unique<heightfield_shape>(terrain_dimension_,
+        heightmap_.data().data(),
+        0.0f,
+        cppext::as_fp(std::numeric_limits<uint8_t>::max()))};
+    // Skips blocks of cells below or above the ray
+    shape->buildAccelerator();
+
+    triangle_info_ = std::make_unique<btTriangleInfoMap>();
+    shape->setTriangleInfoMap(triangle_info_.get());
+    btGenerateInternalEdgeInfo(shape.get(), triangle_info_.get());
+    terrain_shape_ = shape.get();
+
+    auto const center_offset{cppext::as_fp(terrain_dimension_ - 1) / 2.0f};
+    glm::vec3 const origin{heightmap_origin()};
+    btTransform transform;
+    transform.setIdentity();
+    transform.setOrigin(
+        {origin.x + center_offset, 0.0f, origin.z + center_offset});
+
+    physics_engine_->synchronize(
+        [&, this]()
+        {
+            gContactAddedCallback = adjust_internal_edge_contact;
+
+            terrain_collider_ =
+                physics_engine_->add_rigid_body(std::move(shape),
+                    0.0f,
+                    transform);
+            terrain_collider_->setCollisionFlags(
+                terrain_collider_->getCollisionFlags() |
+                btCollisionObject::CF_CUSTOM_MATERIAL_CALLBACK);
+        });
+}
+
+void soil::terrain::remove_colliders()
+{
+    // Heightfield shapes reference the heights of the chunk components or
+    // the heightmap
+    physics_engine_->synchronize(
+        [this]()
+        {
+            for (auto entity : chunk_registry_.view<physics_component>())
+            {
+                physics_engine_->remove_rigid_body(
+                    chunk_registry_.get<physics_component>(entity).rigid_body);
+            }
+
+            if (terrain_collider_)
+            {
+                physics_engine_->remove_rigid_body(
+                    std::exchange(terrain_collider_, nullptr));
+            }
+        });
+    chunk_registry_.clear<physics_component>();
+    active_colliders_ = 0;
+
+    terrain_shape_ = nullptr;
+    triangle_info_.reset();
+}
+
+void soil::terrain::write_heights(std::move_only_function<void()> function)
+{
+    if (terrain_collider_)
+    {
+        physics_engine_->synchronize(std::move(function));
+    }
+    else
+    {
+        function();
+    }
+}
+
+void soil::terrain::clear_chunks()
+{
+    remove_colliders();
+    chunk_registry_.clear();
+    chunk_entities_.clear();
+}
+
+void soil::terrain::update_erosion()
+{
+    if (gpu_erosion_)
+    {
+        if (auto const heights{gpu_erosion_->readback()})
+        {
+            write_heights([this, &heights]()
+                { std::ranges::copy(*heights, heightmap_.data().begin()); });
+            refresh_physics();
+            calculate_lod_errors();
+        }
+    }
+
+    if (!erosion_enabled_)
+    {
+        return;
+    }
+
+    if (erosion_on_cpu_)
+    {
+        if (!cpu_erosion_)
+        {
+            cpu_erosion_ = std::make_unique<cpu_erosion>(terrain_dimension_);
+        }
+
+        if (gpu_erosion_)
+        {
+            // Continues from the last heights read back from the GPU
+            vkDeviceWaitIdle(device_->logical);
+            gpu_erosion_.reset();
+        }
+
+        write_heights(
+            [this]()
+            {
+                cpu_erosion_->run(heightmap_.data(),
+                    erosion_settings_,
+                    cppext::narrow<uint32_t>(erosion_iterations_));
+            });
+        renderer_.update_heightmap(heightmap_);
+        refresh_physics();
+        calculate_lod_errors();
+    }
+    else if (!gpu_erosion_)
+    {
+        gpu_erosion_ = std::make_unique<gpu_erosion>(device_,
+            vulkan_renderer_,
+            renderer_.heightmap_buffer(),
+            renderer_.normal_buffer(),
+            terrain_dimension_);
+    }
+}
+
+void soil::terrain::refresh_physics()
+{
+    constexpr float tolerance{0.01f};
+
+    auto const chunks_per_dimension{
+        (terrain_dimension_ - 1) / (chunk_dimension_ - 1) + 1};
+
+    std::vector<float> heights(size_t{chunk_dimension_} * chunk_dimension_);
+
+    if (terrain_shape_)
+    {
+        // Edge info is too expensive to regenerate after each erosion step,
+        // contacts aren't adjusted until the collider is created again
+        physics_engine_->synchronize(
+            [this]()
+            {
+                terrain_shape_->buildAccelerator();
+                triangle_info_->clear();
+            });
+        return;
+    }
+
+    refreshed_chunks_ = 0;
+    // Heights are read by the simulation when it is running on its thread
+    physics_engine_->synchronize(
+        [&, this]()
+        {
+            for (auto&& [entity, chunk, physics] :
+                chunk_registry_.view<chunk_component, physics_component>()
+                    .each())
+            {
+                fill_chunk_heights(heights,
+                    heightmap_,
+                    chunk.chunk_index,
+                    chunk_dimension_,
+                    chunks_per_dimension);
+
+                bool const dirty{!std::ranges::equal(heights,
+                    physics.heights,
+                    [](float const a, float const b)
+                    { return std::fabs(a - b) <= tolerance; })};
+                if (dirty)
+                {
+                    // Heightfield shape references this data, size must not
+                    // change
+                    std::ranges::copy(heights, physics.heights.begin());
+                    ++refreshed_chunks_;
+                }
+            }
+        });
+}
@@ -1,13 +1,33 @@
 #ifndef SOIL_TERRAIN_INCLUDED
 #define SOIL_TERRAIN_INCLUDED
 
+#include <cdlod.hpp>
+#include <erosion.hpp>
+#include <heightmap.hpp>
+#include <hiz_occlusion.hpp>
+#include <occlusion_horizon.hpp>
 #include <terrain_renderer.hpp>
 
 #include <entt/entt.hpp>
 
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
 #include <vulkan/vulkan_core.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+class btHeightfieldTerrainShape;
+class btRigidBody;
+struct btTriangleInfoMap;
 
 namespace vkrndr
 {
@@ -18,9 +38,12 @@ namespace vkrndr
 
 namespace soil
 {
-    class heightmap;
+    class clipmap_renderer;
+    class gpu_erosion;
     class physics_engine;
     class perspective_camera;
+    class procedural_heightmap;
+    struct ray;
 } // namespace soil
 
 namespace soil
@@ -35,12 +58,22 @@ namespace soil
             vkrndr::vulkan_image* color_image,
             vkrndr::vulkan_image* depth_buffer);
 
+        // Keeps a window of window_chunks * window_chunks chunks generated
+        // by source centered on the camera
+        terrain(procedural_heightmap* source,
+            uint32_t window_chunks,
+            physics_engine* physics_engine,
+            vkrndr::vulkan_device* device,
+            vkrndr::vulkan_renderer* renderer,
+            vkrndr::vulkan_image* color_image,
+            vkrndr::vulkan_image* depth_buffer);
+
         terrain(terrain const&) = delete;
 
         terrain(terrain&&) noexcept = delete;
 
     public:
-        ~terrain() = default;
+        ~terrain();
 
     public:
         void update(soil::perspective_camera const& camera, float delta_time);
@@ -56,18 +89,159 @@ namespace soil
 
         terrain& operator=(terrain&&) noexcept = delete;
 
+    private:
+        struct [[nodiscard]] chunk_draw final
+        {
+            float distance{};
+            uint32_t chunk_index{};
+            uint32_t lod{};
+            uint32_t stitched_edges{};
+            occlusion_bounds bounds;
+        };
+
+    private:
+        void update_window(glm::vec3 const& camera_position);
+
+        // Keeps chunks which stay in the window after it moved by shift
+        // chunks, chunks which left it are replaced with new ones
+        void move_chunks(glm::ivec2 const& shift);
+
+        // Model matrices only change when chunks are regenerated
+        void upload_chunk_models();
+
+        // Recalculates geometric error of each LOD and quadtree height
+        // bounds from current heights
+        void calculate_lod_errors();
+
+        // Hides chunks below the horizon of nearer chunks
+        void cull_below_horizon(soil::perspective_camera const& camera);
+
+        void select_lods(soil::perspective_camera const& camera);
+
+        // Visible chunks sorted front to back with their selected LOD
+        void rebuild_draw_list(glm::vec3 const& camera_position);
+
+        // Records the draw list into secondary command buffers, either once
+        // until it changes or in groups on multiple threads. Draws are read
+        // from culled_draws if it is set.
+        void record_draw_list(VkImageView target_image,
+            VkCommandBuffer command_buffer,
+            VkRect2D render_area,
+            VkBuffer culled_draws);
+
+        void draw_range(VkCommandBuffer command_buffer,
+            size_t first,
+            size_t last,
+            VkBuffer culled_draws);
+
+        // World space position of the first heightmap sample
+        [[nodiscard]] glm::vec3 heightmap_origin() const;
+
+        // Creates colliders of chunks overlapping the box, existing ones
+        // are kept alive
+        void activate_colliders(glm::vec3 const& min, glm::vec3 const& max);
+
+        // Creates colliders of chunks crossed by the rays
+        void activate_colliders(std::span<ray const> rays);
+
+        // Queues rays cast by the physics engine, the chunk registry is
+        // read by the render thread until the next update
+        void request_colliders(std::span<ray const> rays);
+
+        void activate_requested_colliders();
+
+        void activate_collider(glm::ivec2 const& cell);
+
+        // Creates colliders of chunks near dynamic bodies
+        void activate_body_colliders();
+
+        // Removes colliders not activated recently
+        void deactivate_idle_colliders();
+
+        // Single collider reading heights of the whole window in place,
+        // used instead of chunk colliders
+        void create_terrain_collider();
+
+        void remove_colliders();
+
+        // Runs function with heights which may be read by the simulation
+        void write_heights(std::move_only_function<void()> function);
+
+        void clear_chunks();
+
+        void update_erosion();
+
+        // Copies heights of chunks changed by erosion to their colliders
+        void refresh_physics();
+
     private:
         physics_engine* physics_engine_;
         vkrndr::vulkan_device* device_;
+        vkrndr::vulkan_renderer* vulkan_renderer_;
 
         entt::registry chunk_registry_;
+        // Indexed by chunk index
+        std::vector<entt::entity> chunk_entities_;
+
+        procedural_heightmap* source_{};
+        uint32_t window_chunks_{};
+        glm::ivec2 window_origin_{};
+        heightmap heightmap_;
 
         uint32_t terrain_dimension_;
         uint32_t chunk_dimension_{65};
 
         terrain_renderer renderer_;
+        cdlod_quadtree quadtree_;
+        std::unique_ptr<clipmap_renderer> clipmap_;
+        hiz_occlusion occlusion_;
 
         int lod_{};
+        bool screen_space_lod_{true};
+        float pixel_error_{2.0f};
+        bool cdlod_{};
+        bool clipmap_enabled_{};
+        bool tessellation_{};
+        float tessellation_edge_pixels_{8.0f};
+        glm::vec3 cdlod_camera_position_{};
+        size_t drawn_triangles_{};
+        int64_t lod_selection_time_{};
+
+        bool horizon_culling_{};
+        occlusion_horizon horizon_{256};
+        std::vector<std::pair<float, entt::entity>> front_to_back_;
+        size_t horizon_culled_{};
+        int64_t horizon_culling_time_{};
+
+        std::vector<chunk_draw> draw_list_;
+        bool draw_list_dirty_{true};
+        glm::ivec2 camera_cell_{};
+        size_t draw_list_rebuilds_{};
+        bool parallel_recording_{};
+        bool prerecorded_{};
+
+        bool occlusion_culling_{};
+        glm::mat4 view_projection_{1.0f};
+        std::vector<occlusion_bounds> occlusion_bounds_;
+        std::vector<VkDrawIndexedIndirectCommand> occlusion_draws_;
+
+        bool erosion_enabled_{};
+        bool erosion_on_cpu_{};
+        int erosion_iterations_{10};
+        erosion_settings erosion_settings_;
+        std::unique_ptr<gpu_erosion> gpu_erosion_;
+        std::unique_ptr<cpu_erosion> cpu_erosion_;
+        size_t refreshed_chunks_{};
+
+        uint64_t physics_updates_{};
+        size_t active_colliders_{};
+        std::mutex requested_rays_mutex_;
+        std::vector<ray> requested_rays_;
+
+        bool single_collider_{};
+        std::unique_ptr<btTriangleInfoMap> triangle_info_;
+        btHeightfieldTerrainShape* terrain_shape_{};
+        btRigidBody* terrain_collider_{};
     };
 } // namespace soil
 
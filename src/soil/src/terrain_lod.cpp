@@ -0,0 +1,204 @@
+#include <terrain_lod.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+
+std::vector<float> soil::chunk_lod_errors(std::span<float const> heights,
+    size_t const chunk_dimension,
+    uint32_t const lod_levels)
+{
+    assert(heights.size() == chunk_dimension * chunk_dimension);
+
+    auto const height_at = [&](size_t const x, size_t const z)
+    { return heights[z * chunk_dimension + x]; };
+
+    std::vector<float> rv(lod_levels + 1);
+    for (uint32_t lod{1}; lod <= lod_levels; ++lod)
+    {
+        size_t const step{size_t{1} << lod};
+        auto const step_fp{cppext::as_fp(step)};
+
+        float error{rv[lod - 1]};
+        for (size_t z{}; z + step < chunk_dimension; z += step)
+        {
+            for (size_t x{}; x + step < chunk_dimension; x += step)
+            {
+                float const h0{height_at(x, z)};
+                float const h1{height_at(x, z + step)};
+                float const h2{height_at(x + step, z)};
+                float const h3{height_at(x + step, z + step)};
+
+                // Quads are split along the diagonal from (x + step, z) to
+                // (x, z + step)
+                for (size_t j{}; j <= step; ++j)
+                {
+                    for (size_t i{}; i <= step; ++i)
+                    {
+                        float const u{cppext::as_fp(i) / step_fp};
+                        float const v{cppext::as_fp(j) / step_fp};
+
+                        float const interpolated{u + v <= 1.0f
+                                ? h0 + u * (h2 - h0) + v * (h1 - h0)
+                                : h3 + (1.0f - u) * (h1 - h3) +
+                                    (1.0f - v) * (h2 - h3)};
+
+                        error = std::max(error,
+                            std::fabs(height_at(x + i, z + j) - interpolated));
+                    }
+                }
+            }
+        }
+        rv[lod] = error;
+    }
+
+    return rv;
+}
+
+float soil::projection_scale(float const fov_degrees,
+    uint32_t const viewport_height)
+{
+    float const half_fov{fov_degrees * std::numbers::pi_v<float> / 360.0f};
+    return cppext::as_fp(viewport_height) / (2.0f * std::tan(half_fov));
+}
+
+uint32_t soil::select_lod(std::span<float const> errors,
+    float const distance,
+    float const projection_scale,
+    float const threshold)
+{
+    float const pixels_per_unit{projection_scale / std::max(distance, 1.0f)};
+
+    uint32_t rv{};
+    for (uint32_t lod{1}; lod != errors.size(); ++lod)
+    {
+        if (errors[lod] * pixels_per_unit > threshold)
+        {
+            break;
+        }
+        rv = lod;
+    }
+    return rv;
+}
+
+std::vector<uint32_t> soil::chunk_lod_indices(uint32_t const chunk_dimension,
+    uint32_t const lod,
+    uint32_t const stitched_edges)
+{
+    uint32_t const step{1u << lod};
+    uint32_t const last{chunk_dimension - 1};
+    assert(last % step == 0);
+
+    // Position along a stitched edge is moved to the preceding even
+    // multiple of the step
+    auto const snap = [step](uint32_t const v) { return v - v % (2 * step); };
+
+    auto const index = [&](uint32_t x, uint32_t z)
+    {
+        if ((x == 0 && (stitched_edges & edge_min_x)) ||
+            (x == last && (stitched_edges & edge_max_x)))
+        {
+            z = snap(z);
+        }
+        if ((z == 0 && (stitched_edges & edge_min_z)) ||
+            (z == last && (stitched_edges & edge_max_z)))
+        {
+            x = snap(x);
+        }
+        return z * chunk_dimension + x;
+    };
+
+    std::vector<uint32_t> rv;
+    rv.reserve(size_t{last / step} * (last / step) * 6);
+    for (uint32_t z{}; z != last; z += step)
+    {
+        for (uint32_t x{}; x != last; x += step)
+        {
+            rv.insert(std::end(rv),
+                {index(x, z),
+                    index(x, z + step),
+                    index(x + step, z),
+                    index(x + step, z),
+                    index(x, z + step),
+                    index(x + step, z + step)});
+        }
+    }
+
+    return rv;
+}
+
+void soil::limit_lod_difference(std::span<uint32_t> lods,
+    size_t const dimension)
+{
+    assert(lods.size() == dimension * dimension);
+
+    bool changed{true};
+    while (changed)
+    {
+        changed = false;
+        for (size_t z{}; z != dimension; ++z)
+        {
+            for (size_t x{}; x != dimension; ++x)
+            {
+                uint32_t& lod{lods[z * dimension + x]};
+
+                uint32_t limit{lod};
+                auto const neighbour = [&](size_t const i)
+                { limit = std::min(limit, lods[i] + 1); };
+                if (x != 0)
+                {
+                    neighbour(z * dimension + x - 1);
+                }
+                if (x + 1 != dimension)
+                {
+                    neighbour(z * dimension + x + 1);
+                }
+                if (z != 0)
+                {
+                    neighbour((z - 1) * dimension + x);
+                }
+                if (z + 1 != dimension)
+                {
+                    neighbour((z + 1) * dimension + x);
+                }
+
+                if (limit != lod)
+                {
+                    lod = limit;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+uint32_t soil::stitched_edges(std::span<uint32_t const> lods,
+    size_t const dimension,
+    size_t const x,
+    size_t const z)
+{
+    uint32_t const lod{lods[z * dimension + x]};
+    auto const coarser = [&](size_t const i) { return lods[i] > lod; };
+
+    uint32_t rv{};
+    if (x != 0 && coarser(z * dimension + x - 1))
+    {
+        rv |= edge_min_x;
+    }
+    if (x + 1 != dimension && coarser(z * dimension + x + 1))
+    {
+        rv |= edge_max_x;
+    }
+    if (z != 0 && coarser((z - 1) * dimension + x))
+    {
+        rv |= edge_min_z;
+    }
+    if (z + 1 != dimension && coarser((z + 1) * dimension + x))
+    {
+        rv |= edge_max_z;
+    }
+    return rv;
+}
@@ -0,0 +1,57 @@
+#ifndef SOIL_TERRAIN_LOD_INCLUDED
+#define SOIL_TERRAIN_LOD_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace soil
+{
+    // Edges of a chunk bordering a chunk with a coarser LOD
+    inline constexpr uint32_t edge_min_x{1};
+    inline constexpr uint32_t edge_max_x{2};
+    inline constexpr uint32_t edge_min_z{4};
+    inline constexpr uint32_t edge_max_z{8};
+    inline constexpr uint32_t edge_combinations{16};
+
+    // Maximum vertical distance between the full resolution heights of a
+    // chunk and the triangles of each LOD, triangulated the same way as
+    // chunk index buffers. Errors never decrease with increasing LOD.
+    [[nodiscard]] std::vector<float> chunk_lod_errors(
+        std::span<float const> heights,
+        size_t chunk_dimension,
+        uint32_t lod_levels);
+
+    // Number of pixels a world space length at unit distance covers
+    [[nodiscard]] float projection_scale(float fov_degrees,
+        uint32_t viewport_height);
+
+    // Coarsest LOD whose error projected from distance is within threshold
+    // pixels
+    [[nodiscard]] uint32_t select_lod(std::span<float const> errors,
+        float distance,
+        float projection_scale,
+        float threshold);
+
+    // Indices of the chunk grid at a LOD. Vertices on stitched edges which
+    // the next coarser LOD doesn't have are moved to the preceding vertex
+    // it has, triangles which become degenerate are kept so all edge
+    // combinations of a LOD have the same index count.
+    [[nodiscard]] std::vector<uint32_t> chunk_lod_indices(
+        uint32_t chunk_dimension,
+        uint32_t lod,
+        uint32_t stitched_edges);
+
+    // Refines chunks of a grid until LODs of neighbouring chunks differ by
+    // at most one
+    void limit_lod_difference(std::span<uint32_t> lods, size_t dimension);
+
+    // Edges of the chunk at (x, z) of a grid bordering a coarser chunk
+    [[nodiscard]] uint32_t stitched_edges(std::span<uint32_t const> lods,
+        size_t dimension,
+        size_t x,
+        size_t z);
+} // namespace soil
+
+#endif
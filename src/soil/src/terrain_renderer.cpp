@@ -1,42 +1,86 @@
 #include <terrain_renderer.hpp>
 
+#include <cdlod.hpp>
 #include <heightmap.hpp>
 #include <noise.hpp>
 #include <perspective_camera.hpp>
+#include <terrain_lod.hpp>
+#include <vertex_cache.hpp>
 
 #include <cppext_cycled_buffer.hpp>
 #include <cppext_numeric.hpp>
 #include <cppext_pragma_warning.hpp>
+#include <cppext_thread_pool.hpp>
 
 #include <vkrndr_render_pass.hpp>
 #include <vulkan_buffer.hpp>
+#include <vulkan_commands.hpp>
 #include <vulkan_descriptors.hpp>
 #include <vulkan_device.hpp>
 #include <vulkan_image.hpp>
 #include <vulkan_memory.hpp>
 #include <vulkan_pipeline.hpp>
+#include <vulkan_queue.hpp>
 #include <vulkan_renderer.hpp>
 #include <vulkan_utility.hpp>
 
 #include <glm/geometric.hpp>
 #include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <ranges>
 #include <span>
+#include <utility>
+#include <variant>
+#include <vector>
 
 // IWYU pragma: no_include <filesystem>
 
 namespace
 {
+    void memory_barrier(VkCommandBuffer const command_buffer,
+        VkPipelineStageFlags2 const src_stage_mask,
+        VkAccessFlags2 const src_access_mask,
+        VkPipelineStageFlags2 const dst_stage_mask,
+        VkAccessFlags2 const dst_access_mask)
+    {
+        VkMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+        barrier.srcStageMask = src_stage_mask;
+        barrier.srcAccessMask = src_access_mask;
+        barrier.dstStageMask = dst_stage_mask;
+        barrier.dstAccessMask = dst_access_mask;
+
+        VkDependencyInfo dependency{};
+        dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency.memoryBarrierCount = 1;
+        dependency.pMemoryBarriers = &barrier;
+
+        vkCmdPipelineBarrier2(command_buffer, &dependency);
+    }
+
+    // Stages reading or writing heights, normals and chunks
+    constexpr VkPipelineStageFlags2 terrain_buffer_stages{
+        VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT |
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT};
+
     struct [[nodiscard]] camera_uniform final
     {
         glm::mat4 view;
@@ -57,6 +101,43 @@ namespace
         uint32_t chunks_per_dimension;
     };
 
+    // Starts with the layout of push_constants shared with fragment shader
+    struct [[nodiscard]] tessellation_push_constants final
+    {
+        uint32_t lod;
+        uint32_t chunk;
+        uint32_t chunk_dimension;
+        uint32_t terrain_dimension;
+        uint32_t chunks_per_dimension;
+        float edge_pixels;
+        float viewport_height;
+    };
+
+    // Patches are subdivided at most to full heightmap resolution, must match
+    // maxTessellation in terrain.tesc
+    constexpr uint32_t patch_size{8};
+
+    constexpr VkShaderStageFlags tessellation_stages{
+        VK_SHADER_STAGE_VERTEX_BIT |
+        VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT |
+        VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT |
+        VK_SHADER_STAGE_FRAGMENT_BIT};
+
+    // Starts with the layout of push_constants shared with fragment shader
+    struct [[nodiscard]] cdlod_push_constants final
+    {
+        uint32_t lod;
+        uint32_t chunk;
+        uint32_t chunk_dimension;
+        uint32_t terrain_dimension;
+        uint32_t chunks_per_dimension;
+        uint32_t node_scale;
+        glm::uvec2 node_origin;
+        glm::vec2 morph_range;
+        alignas(16) glm::vec3 camera_position;
+        alignas(16) glm::vec3 origin;
+    };
+
     consteval auto binding_description()
     {
         constexpr std::array descriptions{
@@ -113,33 +194,39 @@ namespace
     [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(
         vkrndr::vulkan_device const* const device)
     {
+        VkShaderStageFlags const geometry_stages{device->tessellation_shader
+                ? VK_SHADER_STAGE_VERTEX_BIT |
+                    VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT |
+                    VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT
+                : VK_SHADER_STAGE_VERTEX_BIT};
+
         VkDescriptorSetLayoutBinding camera_uniform_binding{};
         camera_uniform_binding.binding = 0;
         camera_uniform_binding.descriptorType =
             VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         camera_uniform_binding.descriptorCount = 1;
-        camera_uniform_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        camera_uniform_binding.stageFlags = geometry_stages;
 
         VkDescriptorSetLayoutBinding chunk_uniform_binding{};
         chunk_uniform_binding.binding = 1;
         chunk_uniform_binding.descriptorType =
             VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         chunk_uniform_binding.descriptorCount = 1;
-        chunk_uniform_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        chunk_uniform_binding.stageFlags = geometry_stages;
 
         VkDescriptorSetLayoutBinding heightmap_storage_binding{};
         heightmap_storage_binding.binding = 2;
         heightmap_storage_binding.descriptorType =
             VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         heightmap_storage_binding.descriptorCount = 1;
-        heightmap_storage_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        heightmap_storage_binding.stageFlags = geometry_stages;
 
         VkDescriptorSetLayoutBinding normals_storage_binding{};
         normals_storage_binding.binding = 3;
         normals_storage_binding.descriptorType =
             VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         normals_storage_binding.descriptorCount = 1;
-        normals_storage_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        normals_storage_binding.stageFlags = geometry_stages;
 
         VkDescriptorSetLayoutBinding textures_binding{};
         textures_binding.binding = 4;
@@ -272,10 +359,18 @@ soil::terrain_renderer::terrain_renderer(heightmap const& heightmap,
           1}
     , heightmap_buffer_{create_buffer(device,
           heightmap.dimension() * heightmap.dimension() * sizeof(float),
-          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+              VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+              VK_BUFFER_USAGE_TRANSFER_DST_BIT,
           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)}
     , normal_buffer_{create_buffer(device,
           heightmap.dimension() * heightmap.dimension() * sizeof(glm::vec4),
+          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+              VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+              VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)}
+    , chunk_buffer_{create_buffer(device,
+          sizeof(chunk_uniform) * chunks_per_dimension_ * chunks_per_dimension_,
           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)}
     , texture_mix_image_{create_texture_mix_image()}
@@ -286,6 +381,9 @@ soil::terrain_renderer::terrain_renderer(heightmap const& heightmap,
           vertex_count_ * sizeof(terrain_vertex),
           VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)}
+    , index_type_{vertex_count_ <= std::numeric_limits<uint16_t>::max() + 1u
+              ? VK_INDEX_TYPE_UINT16
+              : VK_INDEX_TYPE_UINT32}
     , descriptor_set_layout_{create_descriptor_set_layout(device_)}
 {
     fill_heightmap(heightmap);
@@ -298,6 +396,7 @@ soil::terrain_renderer::terrain_renderer(heightmap const& heightmap,
     {
         fill_index_buffer(chunk_dimension, i);
     }
+    fill_quadrant_index_buffer(chunk_dimension);
 
     pipeline_ = std::make_unique<vkrndr::vulkan_pipeline>(
         vkrndr::vulkan_pipeline_builder{device_,
@@ -321,6 +420,92 @@ soil::terrain_renderer::terrain_renderer(heightmap const& heightmap,
                 VK_FRONT_FACE_COUNTER_CLOCKWISE)
             .build());
 
+    pulling_pipeline_ = std::make_unique<vkrndr::vulkan_pipeline>(
+        vkrndr::vulkan_pipeline_builder{device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(descriptor_set_layout_)
+                .add_push_constants({.stageFlags = VK_SHADER_STAGE_VERTEX_BIT |
+                        VK_SHADER_STAGE_FRAGMENT_BIT,
+                    .offset = 0,
+                    .size = sizeof(push_constants)})
+                .build(),
+            renderer->image_format()}
+            .add_shader(VK_SHADER_STAGE_VERTEX_BIT,
+                "terrain_pulled.vert.spv",
+                "main")
+            .add_shader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                "terrain.frag.spv",
+                "main")
+            .with_primitive_topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+            .with_rasterization_samples(device_->max_msaa_samples)
+            .with_depth_test(depth_buffer_->format)
+            .with_culling(VK_CULL_MODE_BACK_BIT,
+                VK_FRONT_FACE_COUNTER_CLOCKWISE)
+            .build());
+
+    cdlod_pipeline_ = std::make_unique<vkrndr::vulkan_pipeline>(
+        vkrndr::vulkan_pipeline_builder{device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(descriptor_set_layout_)
+                .add_push_constants({.stageFlags = VK_SHADER_STAGE_VERTEX_BIT |
+                        VK_SHADER_STAGE_FRAGMENT_BIT,
+                    .offset = 0,
+                    .size = sizeof(cdlod_push_constants)})
+                .build(),
+            renderer->image_format()}
+            .add_shader(VK_SHADER_STAGE_VERTEX_BIT,
+                "terrain_cdlod.vert.spv",
+                "main")
+            .add_shader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                "terrain.frag.spv",
+                "main")
+            .with_primitive_topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+            .with_rasterization_samples(device_->max_msaa_samples)
+            .add_vertex_input(binding_description(), attribute_descriptions())
+            .with_depth_test(depth_buffer_->format)
+            .with_culling(VK_CULL_MODE_BACK_BIT,
+                VK_FRONT_FACE_COUNTER_CLOCKWISE)
+            .build());
+
+    if (device_->tessellation_shader)
+    {
+        fill_patch_index_buffer(chunk_dimension, patch_size);
+
+        tessellation_pipeline_ = std::make_unique<vkrndr::vulkan_pipeline>(
+            vkrndr::vulkan_pipeline_builder{device_,
+                vkrndr::vulkan_pipeline_layout_builder{device_}
+                    .add_descriptor_set_layout(descriptor_set_layout_)
+                    .add_push_constants({.stageFlags = tessellation_stages,
+                        .offset = 0,
+                        .size = sizeof(tessellation_push_constants)})
+                    .build(),
+                renderer->image_format()}
+                .add_shader(VK_SHADER_STAGE_VERTEX_BIT,
+                    "terrain_tess.vert.spv",
+                    "main")
+                .add_shader(VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
+                    "terrain.tesc.spv",
+                    "main")
+                .add_shader(VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+                    "terrain.tese.spv",
+                    "main")
+                .add_shader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                    "terrain.frag.spv",
+                    "main")
+                .with_primitive_topology(VK_PRIMITIVE_TOPOLOGY_PATCH_LIST)
+                .with_tessellation(4)
+                .with_rasterization_samples(device_->max_msaa_samples)
+                .add_vertex_input(binding_description(),
+                    attribute_descriptions())
+                .with_depth_test(depth_buffer_->format)
+                .with_culling(VK_CULL_MODE_BACK_BIT,
+                    VK_FRONT_FACE_COUNTER_CLOCKWISE)
+                .build());
+    }
+
+    recorded_command_pool_ =
+        create_command_pool(device_, device_->present_queue->family);
+
     frame_data_ =
         cppext::cycled_buffer<frame_resources>{renderer->image_count(),
             renderer->image_count()};
@@ -336,21 +521,17 @@ soil::terrain_renderer::terrain_renderer(heightmap const& heightmap,
         data.camera_uniform_map =
             vkrndr::map_memory(device, data.camera_uniform.allocation);
 
-        auto const chunk_uniform_buffer_size{sizeof(chunk_uniform) *
-            chunks_per_dimension_ * chunks_per_dimension_};
-        data.chunk_uniform = create_buffer(device_,
-            chunk_uniform_buffer_size,
-            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        data.chunk_uniform_map =
-            vkrndr::map_memory(device, data.chunk_uniform.allocation);
-
         create_descriptor_sets(device_,
             descriptor_set_layout_,
             renderer->descriptor_pool(),
             std::span{&data.descriptor_set, 1});
 
+        vkrndr::create_command_buffers(device_,
+            recorded_command_pool_,
+            1,
+            VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            std::span{&data.recorded_commands, 1});
+
         DISABLE_WARNING_PUSH
         DISABLE_WARNING_MISSING_FIELD_INITIALIZERS
         std::array const texture_info{
@@ -365,9 +546,9 @@ soil::terrain_renderer::terrain_renderer(heightmap const& heightmap,
             VkDescriptorBufferInfo{.buffer = data.camera_uniform.buffer,
                 .offset = 0,
                 .range = camera_uniform_buffer_size},
-            VkDescriptorBufferInfo{.buffer = data.chunk_uniform.buffer,
+            VkDescriptorBufferInfo{.buffer = chunk_buffer_.buffer,
                 .offset = 0,
-                .range = chunk_uniform_buffer_size},
+                .range = chunk_buffer_.size},
             VkDescriptorBufferInfo{.buffer = heightmap_buffer_.buffer,
                 .offset = 0,
                 .range = heightmap_buffer_.size},
@@ -388,13 +569,38 @@ soil::terrain_renderer::~terrain_renderer()
             1,
             &data.descriptor_set);
 
-        unmap_memory(device_, &data.chunk_uniform_map);
-        destroy(device_, &data.chunk_uniform);
-
         unmap_memory(device_, &data.camera_uniform_map);
         destroy(device_, &data.camera_uniform);
+
+        for (auto& staging : data.retired_staging)
+        {
+            destroy(device_, &staging);
+        }
+    }
+
+    for (auto& transfer : pending_transfers_)
+    {
+        if (auto* const copy{std::get_if<staged_copy>(&transfer)})
+        {
+            destroy(device_, &copy->staging);
+        }
+    }
+
+    vkDestroyCommandPool(device_->logical, recorded_command_pool_, nullptr);
+
+    if (tessellation_pipeline_)
+    {
+        destroy(device_, tessellation_pipeline_.get());
+        tessellation_pipeline_ = nullptr;
+        destroy(device_, &patch_index_buffer_);
     }
 
+    destroy(device_, cdlod_pipeline_.get());
+    cdlod_pipeline_ = nullptr;
+
+    destroy(device_, pulling_pipeline_.get());
+    pulling_pipeline_ = nullptr;
+
     destroy(device_, pipeline_.get());
     pipeline_ = nullptr;
 
@@ -406,6 +612,7 @@ soil::terrain_renderer::~terrain_renderer()
     {
         destroy(device_, &index_buffer.index_buffer);
     }
+    destroy(device_, &quadrant_index_buffer_);
 
     destroy(device_, &vertex_buffer_);
 
@@ -413,10 +620,28 @@ soil::terrain_renderer::~terrain_renderer()
 
     destroy(device_, &texture_mix_image_);
 
+    destroy(device_, &move_buffer_);
+    destroy(device_, &chunk_buffer_);
     destroy(device_, &normal_buffer_);
     destroy(device_, &heightmap_buffer_);
 }
 
+uint32_t soil::terrain_renderer::index_count(uint32_t const lod) const
+{
+    auto const it{
+        std::ranges::find(index_buffers_, lod, &lod_index_buffer::lod)};
+    return it != std::cend(index_buffers_) ? it->index_count : 0;
+}
+
+void soil::terrain_renderer::set_vertex_pulling(bool const enabled)
+{
+    if (vertex_pulling_ != enabled)
+    {
+        invalidate_recorded();
+    }
+    vertex_pulling_ = enabled;
+}
+
 void soil::terrain_renderer::update(soil::perspective_camera const& camera)
 {
     auto& cam_uniform{*frame_data_->camera_uniform_map.as<camera_uniform>()};
@@ -424,72 +649,396 @@ void soil::terrain_renderer::update(soil::perspective_camera const& camera)
     cam_uniform.projection = camera.projection_matrix();
 }
 
+void soil::terrain_renderer::update_heightmap(heightmap const& heightmap)
+{
+    assert(heightmap.dimension() == terrain_dimension_);
+
+    std::array const whole{sample_region{.x = 0,
+        .y = 0,
+        .width = terrain_dimension_,
+        .height = terrain_dimension_}};
+    stage_heights(heightmap, whole);
+    stage_normals(heightmap, whole);
+}
+
+void soil::terrain_renderer::shift_heightmap(heightmap const& heightmap,
+    glm::ivec2 const& shift)
+{
+    assert(heightmap.dimension() == terrain_dimension_);
+
+    size_t const dimension{terrain_dimension_};
+    if (std::cmp_greater_equal(std::abs(shift.x), dimension) ||
+        std::cmp_greater_equal(std::abs(shift.y), dimension))
+    {
+        update_heightmap(heightmap);
+        return;
+    }
+
+    // Samples not covered by the moved ones, extended by margin samples
+    // towards them. Rows of the whole heightmap are taken first, columns
+    // don't overlap them.
+    auto const uncovered = [dimension, &shift](size_t const margin)
+    {
+        auto const range = [dimension, margin](int const offset)
+        {
+            if (offset == 0)
+            {
+                return std::pair<size_t, size_t>{};
+            }
+
+            size_t const count{std::min(dimension,
+                cppext::narrow<size_t>(std::abs(offset)) + margin)};
+            return offset > 0 ? std::pair{dimension - count, dimension}
+                              : std::pair{size_t{0}, count};
+        };
+
+        std::vector<sample_region> rv;
+
+        auto const [row_first, row_last] = range(shift.y);
+        if (row_first != row_last)
+        {
+            rv.push_back({.x = 0,
+                .y = row_first,
+                .width = dimension,
+                .height = row_last - row_first});
+        }
+
+        auto const [column_first, column_last] = range(shift.x);
+        size_t const first{row_first == 0 ? row_last : 0};
+        size_t const last{row_first == 0 ? dimension : row_first};
+        if (column_first != column_last && first != last)
+        {
+            rv.push_back({.x = column_first,
+                .y = first,
+                .width = column_last - column_first,
+                .height = last - first});
+        }
+
+        return rv;
+    };
+
+    if (move_buffer_.buffer == VK_NULL_HANDLE)
+    {
+        move_buffer_ = create_buffer(device_,
+            heightmap_buffer_.size + normal_buffer_.size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    // Moving the buffers as a single array leaves wrong values only in the
+    // samples which are not covered, they are overwritten by the uploads
+    pending_transfers_.emplace_back(heightmap_move{
+        .offset = int64_t{shift.y} * terrain_dimension_ + shift.x});
+
+    stage_heights(heightmap, uncovered(0));
+    // Normals of samples next to uncovered ones depend on their heights
+    stage_normals(heightmap, uncovered(1));
+}
+
+void soil::terrain_renderer::upload(VkCommandBuffer command_buffer)
+{
+    frame_resources& frame{*frame_data_};
+
+    // Previous execution of this frame has completed
+    for (auto& staging : frame.retired_staging)
+    {
+        destroy(device_, &staging);
+    }
+    frame.retired_staging.clear();
+
+    if (pending_transfers_.empty())
+    {
+        return;
+    }
+
+    // Previous frames may still be reading the buffers, erosion writes
+    // heights and normals
+    memory_barrier(command_buffer,
+        terrain_buffer_stages,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    for (auto& transfer : pending_transfers_)
+    {
+        if (auto const* const move{std::get_if<heightmap_move>(&transfer)})
+        {
+            record_move(command_buffer, move->offset);
+        }
+        else
+        {
+            auto& copy{std::get<staged_copy>(transfer)};
+            vkCmdCopyBuffer(command_buffer,
+                copy.staging.buffer,
+                copy.target,
+                vkrndr::count_cast(copy.regions.size()),
+                copy.regions.data());
+            frame.retired_staging.push_back(copy.staging);
+        }
+
+        // Following transfers may write the same memory
+        memory_barrier(command_buffer,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT);
+    }
+    pending_transfers_.clear();
+
+    memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        terrain_buffer_stages,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+            VK_ACCESS_2_TRANSFER_READ_BIT);
+}
+
+void soil::terrain_renderer::update_chunks(std::span<glm::mat4 const> models)
+{
+    assert(models.size_bytes() <= chunk_buffer_.size);
+
+    staged_copy copy{.staging = vkrndr::create_buffer(device_,
+                         models.size() * sizeof(chunk_uniform),
+                         VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+        .target = chunk_buffer_.buffer,
+        .regions = {}};
+    copy.regions.push_back(
+        {.srcOffset = 0, .dstOffset = 0, .size = copy.staging.size});
+
+    vkrndr::mapped_memory staging_map{
+        vkrndr::map_memory(device_, copy.staging.allocation)};
+
+    auto* const chunks{staging_map.as<chunk_uniform>()};
+    for (size_t i{}; i != models.size(); ++i)
+    {
+        chunks[i].model = models[i];
+    }
+    unmap_memory(device_, &staging_map);
+
+    pending_transfers_.emplace_back(std::move(copy));
+}
+
 vkrndr::render_pass_guard soil::terrain_renderer::begin_render_pass(
     VkImageView target_image,
     VkCommandBuffer command_buffer,
     VkRect2D const render_area)
 {
-    vkrndr::render_pass render_pass;
+    auto guard{begin(target_image, command_buffer, render_area, 0)};
 
-    render_pass.with_color_attachment(VK_ATTACHMENT_LOAD_OP_CLEAR,
-        VK_ATTACHMENT_STORE_OP_STORE,
-        target_image,
-        VkClearValue{{{0.0f, 0.0f, 0.0f, 1.f}}},
-        color_image_->view);
-    render_pass.with_depth_attachment(VK_ATTACHMENT_LOAD_OP_CLEAR,
-        VK_ATTACHMENT_STORE_OP_STORE,
-        depth_buffer_->view,
-        VkClearValue{.depthStencil = {1.0f, 0}});
+    bind_chunk_pipeline(command_buffer);
+
+    return guard;
+}
+
+vkrndr::rendering_inheritance
+soil::terrain_renderer::rendering_inheritance() const
+{
+    return {.color_format = renderer_->image_format(),
+        .depth_format = depth_buffer_->format,
+        .samples = device_->max_msaa_samples};
+}
 
-    auto guard{render_pass.begin(command_buffer, render_area)};
+vkrndr::render_pass_guard soil::terrain_renderer::begin_secondary_render_pass(
+    VkImageView target_image,
+    VkCommandBuffer command_buffer,
+    VkRect2D const render_area)
+{
+    return begin(target_image,
+        command_buffer,
+        render_area,
+        VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT);
+}
+
+void soil::terrain_renderer::begin_secondary(VkCommandBuffer command_buffer,
+    VkRect2D const render_area)
+{
+    VkViewport const viewport{.x = cppext::as_fp(render_area.offset.x),
+        .y = cppext::as_fp(render_area.offset.y),
+        .width = cppext::as_fp(render_area.extent.width),
+        .height = cppext::as_fp(render_area.extent.height),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f};
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &render_area);
+
+    bind_chunk_pipeline(command_buffer);
+}
+
+void soil::terrain_renderer::execute_recorded(VkCommandBuffer command_buffer,
+    VkRect2D const render_area,
+    VkBuffer const indirect_buffer,
+    std::function<void(VkCommandBuffer)> const& record)
+{
+    frame_resources& frame{*frame_data_};
+
+    bool const same_area{frame.recorded_area.offset.x == render_area.offset.x &&
+        frame.recorded_area.offset.y == render_area.offset.y &&
+        frame.recorded_area.extent.width == render_area.extent.width &&
+        frame.recorded_area.extent.height == render_area.extent.height};
+    if (frame.recorded_generation != recorded_generation_ || !same_area ||
+        frame.recorded_indirect_buffer != indirect_buffer)
+    {
+        // There are at least as many frame resources as frames in flight,
+        // previous execution of this buffer has completed
+        vkrndr::check_result(
+            vkResetCommandBuffer(frame.recorded_commands, 0));
+
+        vkrndr::begin_secondary_command_buffer(frame.recorded_commands,
+            rendering_inheritance(),
+            0);
+        begin_secondary(frame.recorded_commands, render_area);
+        record(frame.recorded_commands);
+        vkrndr::check_result(vkEndCommandBuffer(frame.recorded_commands));
+
+        frame.recorded_generation = recorded_generation_;
+        frame.recorded_area = render_area;
+        frame.recorded_indirect_buffer = indirect_buffer;
+    }
+
+    vkCmdExecuteCommands(command_buffer, 1, &frame.recorded_commands);
+}
+
+void soil::terrain_renderer::invalidate_recorded() { ++recorded_generation_; }
+
+void soil::terrain_renderer::draw(VkCommandBuffer command_buffer,
+    uint32_t const lod,
+    uint32_t const stitched_edges,
+    uint32_t const chunk_index)
+{
+    if (auto const* const buffer{
+            bind_chunk(command_buffer, lod, stitched_edges, chunk_index)})
+    {
+        vkCmdDrawIndexed(command_buffer, buffer->index_count, 1, 0, 0, 0);
+    }
+}
+
+void soil::terrain_renderer::draw(VkCommandBuffer command_buffer,
+    uint32_t const lod,
+    uint32_t const stitched_edges,
+    uint32_t const chunk_index,
+    VkBuffer const indirect_buffer,
+    VkDeviceSize const offset)
+{
+    if (bind_chunk(command_buffer, lod, stitched_edges, chunk_index))
+    {
+        vkCmdDrawIndexedIndirect(command_buffer,
+            indirect_buffer,
+            offset,
+            1,
+            sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+
+void soil::terrain_renderer::begin_tessellation(
+    VkCommandBuffer command_buffer,
+    float const edge_pixels,
+    float const viewport_height)
+{
+    assert(tessellation_pipeline_);
+
+    edge_pixels_ = edge_pixels;
+    viewport_height_ = viewport_height;
 
     vkrndr::bind_pipeline(command_buffer,
-        *pipeline_,
+        *tessellation_pipeline_,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
         0,
         std::span<VkDescriptorSet const>{&frame_data_->descriptor_set, 1});
 
-    VkDeviceSize const zero_offset{};
-    vkCmdBindVertexBuffers(command_buffer,
+    bind_vertex_buffer(command_buffer);
+
+    vkCmdBindIndexBuffer(command_buffer,
+        patch_index_buffer_.buffer,
         0,
-        1,
-        &vertex_buffer_.buffer,
-        &zero_offset);
+        index_type_);
+}
 
-    return guard;
+void soil::terrain_renderer::draw_tessellated(VkCommandBuffer command_buffer,
+    uint32_t const chunk_index)
+{
+    tessellation_push_constants const constants{.lod = 0,
+        .chunk = chunk_index,
+        .chunk_dimension = chunk_dimension_,
+        .terrain_dimension = terrain_dimension_,
+        .chunks_per_dimension = chunks_per_dimension_,
+        .edge_pixels = edge_pixels_,
+        .viewport_height = viewport_height_};
+
+    vkCmdPushConstants(command_buffer,
+        *tessellation_pipeline_->pipeline_layout,
+        tessellation_stages,
+        0,
+        sizeof(tessellation_push_constants),
+        &constants);
+
+    vkCmdDrawIndexed(command_buffer, patch_index_count_, 1, 0, 0, 0);
+}
+
+void soil::terrain_renderer::begin_cdlod(VkCommandBuffer command_buffer)
+{
+    vkrndr::bind_pipeline(command_buffer,
+        *cdlod_pipeline_,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        0,
+        std::span<VkDescriptorSet const>{&frame_data_->descriptor_set, 1});
+
+    bind_vertex_buffer(command_buffer);
+
+    vkCmdBindIndexBuffer(command_buffer,
+        quadrant_index_buffer_.buffer,
+        0,
+        index_type_);
 }
 
 void soil::terrain_renderer::draw(VkCommandBuffer command_buffer,
-    uint32_t const lod,
-    uint32_t const chunk_index,
-    glm::mat4 const& model)
+    cdlod_node const& node,
+    glm::vec2 const& morph_range,
+    glm::vec3 const& camera_position,
+    glm::vec3 const& origin)
 {
-    if (auto it{std::ranges::find(index_buffers_, lod, &lod_index_buffer::lod)};
-        it != std::cend(index_buffers_))
-    {
-        push_constants const constants{.lod = lod,
-            .chunk = chunk_index,
-            .chunk_dimension = chunk_dimension_,
-            .terrain_dimension = terrain_dimension_,
-            .chunks_per_dimension = chunks_per_dimension_};
+    cdlod_push_constants const constants{.lod = node.level,
+        .chunk = 0,
+        .chunk_dimension = chunk_dimension_,
+        .terrain_dimension = terrain_dimension_,
+        .chunks_per_dimension = chunks_per_dimension_,
+        .node_scale = 1u << node.level,
+        .node_origin = node.origin,
+        .morph_range = morph_range,
+        .camera_position = camera_position,
+        .origin = origin};
+
+    vkCmdPushConstants(command_buffer,
+        *cdlod_pipeline_->pipeline_layout,
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        0,
+        sizeof(cdlod_push_constants),
+        &constants);
 
-        auto* const ch_uniform{
-            frame_data_->chunk_uniform_map.as<chunk_uniform>()};
-        ch_uniform[chunk_index].model = model;
+    // Adjacent quadrants are merged into a single draw
+    auto const quadrant_indices{quadrant_index_count_ / 4};
+    for (uint32_t quadrant{}; quadrant != 4;)
+    {
+        if ((node.quadrants & (1u << quadrant)) == 0)
+        {
+            ++quadrant;
+            continue;
+        }
 
-        vkCmdPushConstants(command_buffer,
-            *pipeline_->pipeline_layout,
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-            0,
-            sizeof(push_constants),
-            &constants);
+        uint32_t const first{quadrant};
+        while (quadrant != 4 && (node.quadrants & (1u << quadrant)) != 0)
+        {
+            ++quadrant;
+        }
 
-        vkCmdBindIndexBuffer(command_buffer,
-            it->index_buffer.buffer,
+        vkCmdDrawIndexed(command_buffer,
+            (quadrant - first) * quadrant_indices,
+            1,
+            first * quadrant_indices,
             0,
-            VK_INDEX_TYPE_UINT32);
-
-        vkCmdDrawIndexed(command_buffer, it->index_count, 1, 0, 0, 0);
+            0);
     }
 }
 
@@ -529,57 +1078,264 @@ void soil::terrain_renderer::fill_normals(heightmap const& heightmap)
     vkrndr::mapped_memory staging_map{
         vkrndr::map_memory(device_, staging_buffer.allocation)};
 
-    auto const face_normal = [](glm::vec3 const& point1,
-                                 glm::vec3 const& point2,
-                                 glm::vec3 const& point3)
+    calculate_normals(heightmap,
+        {.x = 0,
+            .y = 0,
+            .width = terrain_dimension_,
+            .height = terrain_dimension_},
+        staging_map.as<glm::vec4>());
+
+    unmap_memory(device_, &staging_map);
+
+    renderer_->transfer_buffer(staging_buffer, normal_buffer_);
+
+    destroy(device_, &staging_buffer);
+}
+
+void soil::terrain_renderer::stage_heights(heightmap const& heightmap,
+    std::span<sample_region const> const regions)
+{
+    size_t const dimension{terrain_dimension_};
+
+    size_t samples{};
+    for (sample_region const& region : regions)
     {
-        glm::vec3 const edge1{point2 - point1};
-        glm::vec3 const edge2{point3 - point1};
+        samples += region.width * region.height;
+    }
+    if (samples == 0)
+    {
+        return;
+    }
 
-        // https://stackoverflow.com/a/57812028
-        return glm::normalize(glm::cross(edge1, edge2));
-    };
+    staged_copy copy{.staging = vkrndr::create_buffer(device_,
+                         samples * sizeof(float),
+                         VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+        .target = heightmap_buffer_.buffer,
+        .regions = {}};
 
-    memset(staging_map.as<void>(), 0, normal_buffer_.size);
+    vkrndr::mapped_memory staging_map{
+        vkrndr::map_memory(device_, copy.staging.allocation)};
+    auto* const staged{staging_map.as<float>()};
 
-    auto* const normals{staging_map.as<glm::vec4>()};
-    for (uint32_t z{}; z != terrain_dimension_ - 1; ++z)
+    auto const heights{heightmap.data()};
+    size_t offset{};
+    for (sample_region const& region : regions)
     {
-        for (uint32_t x{}; x != terrain_dimension_ - 1; ++x)
+        for (size_t row{region.y}; row != region.y + region.height; ++row)
         {
-            auto const base_vertex{
-                cppext::narrow<uint32_t>(z * terrain_dimension_ + x)};
-
-            auto const fn1 = face_normal({x, heightmap.value(x, z), z},
-                {x, heightmap.value(x, z + 1), z + 1},
-                {x + 1, heightmap.value(x + 1, z), z});
-            normals[base_vertex] += glm::vec4{fn1, 0.0f};
-            normals[cppext::narrow<uint32_t>(
-                base_vertex + terrain_dimension_)] += glm::vec4{fn1, 0.0f};
-            normals[base_vertex + 1] += glm::vec4{fn1, 0.0f};
-
-            auto const fn2 = face_normal({x + 1, heightmap.value(x + 1, z), z},
-                {x, heightmap.value(x, z + 1), z + 1},
-                {x + 1, heightmap.value(x + 1, z + 1), z + 1});
-
-            normals[base_vertex + 1] += glm::vec4{fn2, 0.0f};
-            normals[cppext::narrow<uint32_t>(
-                base_vertex + terrain_dimension_)] += glm::vec4{fn2, 0.0f};
-            normals[cppext::narrow<uint32_t>(
-                base_vertex + terrain_dimension_ + 1)] += glm::vec4{fn2, 0.0f};
+            size_t const first{row * dimension + region.x};
+            std::ranges::copy_n(heights.begin() + std::ptrdiff_t(first),
+                std::ptrdiff_t(region.width),
+                staged + offset);
+            copy.regions.push_back({.srcOffset = offset * sizeof(float),
+                .dstOffset = first * sizeof(float),
+                .size = region.width * sizeof(float)});
+            offset += region.width;
         }
     }
+    unmap_memory(device_, &staging_map);
+
+    pending_transfers_.emplace_back(std::move(copy));
+}
 
-    for (size_t i{}; i != normal_buffer_.size / sizeof(glm::vec4); ++i)
+void soil::terrain_renderer::stage_normals(heightmap const& heightmap,
+    std::span<sample_region const> const regions)
+{
+    size_t const dimension{terrain_dimension_};
+
+    size_t samples{};
+    for (sample_region const& region : regions)
+    {
+        samples += region.width * region.height;
+    }
+    if (samples == 0)
     {
-        normals[i] = glm::normalize(normals[i]);
+        return;
     }
 
+    staged_copy copy{.staging = vkrndr::create_buffer(device_,
+                         samples * sizeof(glm::vec4),
+                         VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+        .target = normal_buffer_.buffer,
+        .regions = {}};
+
+    vkrndr::mapped_memory staging_map{
+        vkrndr::map_memory(device_, copy.staging.allocation)};
+    auto* const staged{staging_map.as<glm::vec4>()};
+
+    size_t offset{};
+    for (sample_region const& region : regions)
+    {
+        calculate_normals(heightmap, region, staged + offset);
+        for (size_t row{region.y}; row != region.y + region.height; ++row)
+        {
+            copy.regions.push_back({.srcOffset = offset * sizeof(glm::vec4),
+                .dstOffset = (row * dimension + region.x) * sizeof(glm::vec4),
+                .size = region.width * sizeof(glm::vec4)});
+            offset += region.width;
+        }
+    }
     unmap_memory(device_, &staging_map);
 
-    renderer_->transfer_buffer(staging_buffer, normal_buffer_);
+    pending_transfers_.emplace_back(std::move(copy));
+}
 
-    destroy(device_, &staging_buffer);
+void soil::terrain_renderer::record_move(VkCommandBuffer command_buffer,
+    int64_t const offset)
+{
+    auto const samples{
+        VkDeviceSize{terrain_dimension_} * terrain_dimension_ -
+        cppext::narrow<VkDeviceSize>(std::abs(offset))};
+    auto const source{
+        cppext::narrow<VkDeviceSize>(std::max(offset, int64_t{0}))};
+    auto const target{
+        cppext::narrow<VkDeviceSize>(std::max(-offset, int64_t{0}))};
+
+    // Regions of a copy within the same buffer can't overlap, samples are
+    // copied out and back to their new place
+    std::array const out{
+        VkBufferCopy{.srcOffset = source * sizeof(float),
+            .dstOffset = target * sizeof(float),
+            .size = samples * sizeof(float)},
+        VkBufferCopy{.srcOffset = source * sizeof(glm::vec4),
+            .dstOffset = heightmap_buffer_.size + target * sizeof(glm::vec4),
+            .size = samples * sizeof(glm::vec4)}};
+    vkCmdCopyBuffer(command_buffer,
+        heightmap_buffer_.buffer,
+        move_buffer_.buffer,
+        1,
+        &out[0]);
+    vkCmdCopyBuffer(command_buffer,
+        normal_buffer_.buffer,
+        move_buffer_.buffer,
+        1,
+        &out[1]);
+
+    memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    std::array const back{
+        VkBufferCopy{.srcOffset = out[0].dstOffset,
+            .dstOffset = out[0].dstOffset,
+            .size = out[0].size},
+        VkBufferCopy{.srcOffset = out[1].dstOffset,
+            .dstOffset = target * sizeof(glm::vec4),
+            .size = out[1].size}};
+    vkCmdCopyBuffer(command_buffer,
+        move_buffer_.buffer,
+        heightmap_buffer_.buffer,
+        1,
+        &back[0]);
+    vkCmdCopyBuffer(command_buffer,
+        move_buffer_.buffer,
+        normal_buffer_.buffer,
+        1,
+        &back[1]);
+}
+
+void soil::terrain_renderer::calculate_normals(heightmap const& heightmap,
+    sample_region const& region,
+    glm::vec4* const output) const
+{
+    auto const face_normal = [](glm::vec3 const& point1,
+                                 glm::vec3 const& point2,
+                                 glm::vec3 const& point3)
+    {
+        glm::vec3 const edge1{point2 - point1};
+        glm::vec3 const edge2{point3 - point1};
+
+        // https://stackoverflow.com/a/57812028
+        return glm::normalize(glm::cross(edge1, edge2));
+    };
+
+    cppext::thread_pool& pool{cppext::default_thread_pool()};
+    size_t const dimension{terrain_dimension_};
+    size_t const cells{dimension - 1};
+
+    // Cells sharing a vertex with the region
+    size_t const first_x{region.x > 0 ? region.x - 1 : 0};
+    size_t const first_z{region.y > 0 ? region.y - 1 : 0};
+    size_t const last_x{std::min(region.x + region.width, cells)};
+    size_t const last_z{std::min(region.y + region.height, cells)};
+    size_t const width{last_x - first_x};
+
+    size_t const grain{
+        std::max(size_t{1}, region.height / (pool.thread_count() * 4))};
+
+    // Two triangles per cell, first one is adjacent to the cell origin and
+    // its neighbours along both axes, second one to the opposite corner
+    std::vector<std::array<glm::vec3, 2>> faces(width * (last_z - first_z));
+    auto const face = [&faces, first_x, first_z, width](size_t const x,
+                          size_t const z) -> std::array<glm::vec3, 2>&
+    { return faces[(z - first_z) * width + x - first_x]; };
+
+    cppext::parallel_for(pool,
+        first_z,
+        last_z,
+        grain,
+        [&](size_t const first, size_t const last)
+        {
+            for (size_t z{first}; z != last; ++z)
+            {
+                for (size_t x{first_x}; x != last_x; ++x)
+                {
+                    auto const fx{cppext::as_fp(x)};
+                    auto const fz{cppext::as_fp(z)};
+                    face(x, z) = {
+                        face_normal({fx, heightmap.value(x, z), fz},
+                            {fx, heightmap.value(x, z + 1), fz + 1},
+                            {fx + 1, heightmap.value(x + 1, z), fz}),
+                        face_normal({fx + 1, heightmap.value(x + 1, z), fz},
+                            {fx, heightmap.value(x, z + 1), fz + 1},
+                            {fx + 1, heightmap.value(x + 1, z + 1), fz + 1})};
+                }
+            }
+        });
+
+    // Every vertex gathers normals of up to six triangles sharing it, rows
+    // are written independently
+    cppext::parallel_for(pool,
+        region.y,
+        region.y + region.height,
+        grain,
+        [&](size_t const first, size_t const last)
+        {
+            for (size_t z{first}; z != last; ++z)
+            {
+                for (size_t x{region.x}; x != region.x + region.width; ++x)
+                {
+                    glm::vec3 sum{0.0f};
+                    if (x < cells && z < cells)
+                    {
+                        sum += face(x, z)[0];
+                    }
+                    if (x < cells && z > 0)
+                    {
+                        auto const& cell{face(x, z - 1)};
+                        sum += cell[0] + cell[1];
+                    }
+                    if (x > 0 && z < cells)
+                    {
+                        auto const& cell{face(x - 1, z)};
+                        sum += cell[0] + cell[1];
+                    }
+                    if (x > 0 && z > 0)
+                    {
+                        sum += face(x - 1, z - 1)[1];
+                    }
+
+                    output[(z - region.y) * region.width + x - region.x] =
+                        glm::vec4{glm::normalize(sum), 0.0f};
+                }
+            }
+        });
 }
 
 vkrndr::vulkan_image soil::terrain_renderer::create_texture_mix_image()
@@ -630,16 +1386,15 @@ void soil::terrain_renderer::fill_vertex_buffer()
     destroy(device_, &staging_buffer);
 }
 
-void soil::terrain_renderer::fill_index_buffer(uint32_t const dimension,
-    uint32_t const lod)
+vkrndr::vulkan_buffer soil::terrain_renderer::create_index_buffer(
+    std::span<uint32_t const> indices)
 {
-    auto const lod_step{cppext::narrow<uint32_t>(1 << lod)};
-
-    uint32_t const whole_index_count{(dimension - 1) * (dimension - 1) * 6};
-    uint32_t const lod_index_count{whole_index_count / (lod_step * lod_step)};
+    size_t const index_size{index_type_ == VK_INDEX_TYPE_UINT16
+            ? sizeof(uint16_t)
+            : sizeof(uint32_t)};
 
     vkrndr::vulkan_buffer staging_buffer{vkrndr::create_buffer(device_,
-        lod_index_count * sizeof(uint32_t),
+        indices.size() * index_size,
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)};
@@ -647,36 +1402,229 @@ void soil::terrain_renderer::fill_index_buffer(uint32_t const dimension,
     vkrndr::mapped_memory staging_map{
         vkrndr::map_memory(device_, staging_buffer.allocation)};
 
-    auto* indices{staging_map.as<uint32_t>()};
-    for (uint32_t z{}; z != dimension - 1; z += lod_step)
+    if (index_type_ == VK_INDEX_TYPE_UINT16)
     {
-        for (uint32_t x{}; x != dimension - 1; x += lod_step)
-        {
-            auto const base_vertex{cppext::narrow<uint32_t>(z * dimension + x)};
-
-            indices[0] = base_vertex;
-            indices[1] =
-                cppext::narrow<uint32_t>(base_vertex + dimension * lod_step);
-            indices[2] = base_vertex + lod_step;
-            indices[3] = base_vertex + lod_step;
-            indices[4] =
-                cppext::narrow<uint32_t>(base_vertex + dimension * lod_step);
-            indices[5] = cppext::narrow<uint32_t>(
-                base_vertex + dimension * lod_step + lod_step);
-
-            indices += 6;
-        }
+        std::ranges::transform(indices,
+            staging_map.as<uint16_t>(),
+            [](uint32_t const index)
+            { return cppext::narrow<uint16_t>(index); });
+    }
+    else
+    {
+        std::ranges::copy(indices, staging_map.as<uint32_t>());
     }
 
-    vkrndr::vulkan_buffer const lod_buffer{create_buffer(device_,
-        lod_index_count * sizeof(uint32_t),
+    vkrndr::vulkan_buffer rv{create_buffer(device_,
+        indices.size() * index_size,
         VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)};
 
-    renderer_->transfer_buffer(staging_buffer, lod_buffer);
-
-    index_buffers_.emplace_back(lod, lod_index_count, lod_buffer);
+    renderer_->transfer_buffer(staging_buffer, rv);
 
     unmap_memory(device_, &staging_map);
     destroy(device_, &staging_buffer);
+
+    return rv;
+}
+
+vkrndr::render_pass_guard soil::terrain_renderer::begin(
+    VkImageView target_image,
+    VkCommandBuffer command_buffer,
+    VkRect2D const render_area,
+    VkRenderingFlags const flags)
+{
+    vkrndr::render_pass render_pass;
+
+    render_pass.with_color_attachment(VK_ATTACHMENT_LOAD_OP_CLEAR,
+        VK_ATTACHMENT_STORE_OP_STORE,
+        target_image,
+        VkClearValue{{{0.0f, 0.0f, 0.0f, 1.f}}},
+        color_image_->view);
+    render_pass.with_depth_attachment(VK_ATTACHMENT_LOAD_OP_CLEAR,
+        VK_ATTACHMENT_STORE_OP_STORE,
+        depth_buffer_->view,
+        VkClearValue{.depthStencil = {1.0f, 0}});
+
+    return render_pass.begin(command_buffer, render_area, flags);
+}
+
+void soil::terrain_renderer::bind_chunk_pipeline(
+    VkCommandBuffer command_buffer)
+{
+    vkrndr::bind_pipeline(command_buffer,
+        vertex_pulling_ ? *pulling_pipeline_ : *pipeline_,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        0,
+        std::span<VkDescriptorSet const>{&frame_data_->descriptor_set, 1});
+
+    if (!vertex_pulling_)
+    {
+        bind_vertex_buffer(command_buffer);
+    }
+}
+
+void soil::terrain_renderer::bind_vertex_buffer(VkCommandBuffer command_buffer)
+{
+    VkDeviceSize const zero_offset{};
+    vkCmdBindVertexBuffers(command_buffer,
+        0,
+        1,
+        &vertex_buffer_.buffer,
+        &zero_offset);
+}
+
+soil::terrain_renderer::lod_index_buffer const*
+soil::terrain_renderer::bind_chunk(VkCommandBuffer command_buffer,
+    uint32_t const lod,
+    uint32_t const stitched_edges,
+    uint32_t const chunk_index)
+{
+    auto const it{
+        std::ranges::find(index_buffers_, lod, &lod_index_buffer::lod)};
+    if (it == std::cend(index_buffers_))
+    {
+        return nullptr;
+    }
+    assert(stitched_edges < edge_combinations);
+
+    push_constants const constants{.lod = lod,
+        .chunk = chunk_index,
+        .chunk_dimension = chunk_dimension_,
+        .terrain_dimension = terrain_dimension_,
+        .chunks_per_dimension = chunks_per_dimension_};
+
+    vkCmdPushConstants(command_buffer,
+        vertex_pulling_ ? *pulling_pipeline_->pipeline_layout
+                        : *pipeline_->pipeline_layout,
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        0,
+        sizeof(push_constants),
+        &constants);
+
+    size_t const index_size{index_type_ == VK_INDEX_TYPE_UINT16
+            ? sizeof(uint16_t)
+            : sizeof(uint32_t)};
+    vkCmdBindIndexBuffer(command_buffer,
+        it->index_buffer.buffer,
+        VkDeviceSize{stitched_edges} * it->index_count * index_size,
+        index_type_);
+
+    return &*it;
+}
+
+void soil::terrain_renderer::fill_index_buffer(uint32_t const dimension,
+    uint32_t const lod)
+{
+    auto const lod_step{cppext::narrow<uint32_t>(1 << lod)};
+
+    uint32_t const whole_index_count{(dimension - 1) * (dimension - 1) * 6};
+    uint32_t const lod_index_count{whole_index_count / (lod_step * lod_step)};
+
+    // Neighbouring chunks differ by at most one LOD, every combination of
+    // edges stitched to the next coarser LOD is stored
+    std::vector<uint32_t> indices;
+    indices.reserve(size_t{lod_index_count} * edge_combinations);
+    for (uint32_t edges{}; edges != edge_combinations; ++edges)
+    {
+        std::vector<uint32_t> combination{
+            chunk_lod_indices(dimension, lod, edges)};
+        assert(combination.size() == lod_index_count);
+
+        if (edges == 0)
+        {
+            auto const before{analyze_vertex_cache(combination, vertex_count_)};
+            optimize_vertex_cache(combination, vertex_count_);
+            auto const after{analyze_vertex_cache(combination, vertex_count_)};
+            spdlog::info("LOD {} vertex cache ACMR {:.3f} -> {:.3f}, "
+                         "ATVR {:.3f} -> {:.3f}",
+                lod,
+                before.acmr,
+                after.acmr,
+                before.atvr,
+                after.atvr);
+        }
+        else
+        {
+            optimize_vertex_cache(combination, vertex_count_);
+        }
+
+        indices.insert(std::end(indices),
+            std::cbegin(combination),
+            std::cend(combination));
+    }
+
+    index_buffers_.emplace_back(lod,
+        lod_index_count,
+        create_index_buffer(indices));
+}
+
+void soil::terrain_renderer::fill_quadrant_index_buffer(
+    uint32_t const dimension)
+{
+    assert((dimension - 1) % 2 == 0);
+
+    auto const half{(dimension - 1) / 2};
+    quadrant_index_count_ = (dimension - 1) * (dimension - 1) * 6;
+
+    std::vector<uint32_t> indices;
+    indices.reserve(quadrant_index_count_);
+    for (uint32_t quadrant{}; quadrant != 4; ++quadrant)
+    {
+        auto const start_x{(quadrant & 1) * half};
+        auto const start_z{(quadrant >> 1) * half};
+        for (uint32_t z{start_z}; z != start_z + half; ++z)
+        {
+            for (uint32_t x{start_x}; x != start_x + half; ++x)
+            {
+                auto const base_vertex{z * dimension + x};
+
+                indices.insert(std::end(indices),
+                    {base_vertex,
+                        base_vertex + dimension,
+                        base_vertex + 1,
+                        base_vertex + 1,
+                        base_vertex + dimension,
+                        base_vertex + dimension + 1});
+            }
+        }
+
+        // Quadrants are drawn as separate ranges, triangles are reordered
+        // only within a quadrant
+        auto const quadrant_indices{quadrant_index_count_ / 4};
+        optimize_vertex_cache(
+            std::span{indices}.subspan(quadrant * quadrant_indices,
+                quadrant_indices),
+            vertex_count_);
+    }
+
+    quadrant_index_buffer_ = create_index_buffer(indices);
+}
+
+void soil::terrain_renderer::fill_patch_index_buffer(uint32_t const dimension,
+    uint32_t const patch_size)
+{
+    assert((dimension - 1) % patch_size == 0);
+
+    auto const patches{(dimension - 1) / patch_size};
+    patch_index_count_ = patches * patches * 4;
+
+    // Control points ordered (0, 0), (1, 0), (1, 1), (0, 1) as expected by
+    // terrain.tesc
+    std::vector<uint32_t> indices;
+    indices.reserve(patch_index_count_);
+    for (uint32_t z{}; z != dimension - 1; z += patch_size)
+    {
+        for (uint32_t x{}; x != dimension - 1; x += patch_size)
+        {
+            auto const base_vertex{z * dimension + x};
+
+            indices.insert(std::end(indices),
+                {base_vertex,
+                    base_vertex + patch_size,
+                    base_vertex + dimension * patch_size + patch_size,
+                    base_vertex + dimension * patch_size});
+        }
+    }
+
+    patch_index_buffer_ = create_index_buffer(indices);
 }
@@ -6,16 +6,23 @@
 
 #include <vkrndr_render_pass.hpp>
 #include <vulkan_buffer.hpp>
+#include <vulkan_commands.hpp>
 #include <vulkan_image.hpp>
 #include <vulkan_memory.hpp>
 
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 
 #include <vulkan/vulkan_core.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <span>
+#include <variant>
 #include <vector>
 
 namespace vkrndr
@@ -27,6 +34,7 @@ namespace vkrndr
 
 namespace soil
 {
+    struct cdlod_node;
     class heightmap;
     class perspective_camera;
 } // namespace soil
@@ -62,16 +70,117 @@ namespace soil
             return cppext::narrow<int>(index_buffers_.back().lod);
         }
 
+        [[nodiscard]] uint32_t index_count(uint32_t lod) const;
+
+        [[nodiscard]] bool vertex_pulling() const { return vertex_pulling_; }
+
+        // Derives grid positions from the vertex index instead of fetching
+        // them from the vertex buffer, applies to subsequent render passes
+        void set_vertex_pulling(bool enabled);
+
+        [[nodiscard]] bool tessellation_supported() const
+        {
+            return tessellation_pipeline_ != nullptr;
+        }
+
+        [[nodiscard]] vkrndr::vulkan_buffer const& heightmap_buffer() const
+        {
+            return heightmap_buffer_;
+        }
+
+        [[nodiscard]] vkrndr::vulkan_buffer const& normal_buffer() const
+        {
+            return normal_buffer_;
+        }
+
         void update(soil::perspective_camera const& camera);
 
+        // Uploads model matrices of chunks indexed by chunk index to device
+        // local memory, they are used from the next frame until the next
+        // upload
+        void update_chunks(std::span<glm::mat4 const> models);
+
+        // Replaces heights and normals from the next frame, heightmap
+        // dimension must not change
+        void update_heightmap(heightmap const& heightmap);
+
+        // Moves heights and normals by shift samples from the next frame,
+        // sample (x, y) takes the value of (x + shift.x, y + shift.y).
+        // Heightmap has to be moved the same way, only the samples which
+        // weren't covered before the move are uploaded from it.
+        void shift_heightmap(heightmap const& heightmap,
+            glm::ivec2 const& shift);
+
+        // Records pending uploads, has to be called before anything reads
+        // terrain buffers in the frame
+        void upload(VkCommandBuffer command_buffer);
+
         vkrndr::render_pass_guard begin_render_pass(VkImageView target_image,
             VkCommandBuffer command_buffer,
             VkRect2D render_area);
 
+        // Attachment formats of the render pass for secondary command buffers
+        [[nodiscard]] vkrndr::rendering_inheritance
+        rendering_inheritance() const;
+
+        // Begins a render pass whose contents are recorded into secondary
+        // command buffers, each of them has to call begin_secondary first
+        vkrndr::render_pass_guard begin_secondary_render_pass(
+            VkImageView target_image,
+            VkCommandBuffer command_buffer,
+            VkRect2D render_area);
+
+        // State isn't inherited by secondary command buffers, sets viewport
+        // and binds the same resources as begin_render_pass
+        void begin_secondary(VkCommandBuffer command_buffer,
+            VkRect2D render_area);
+
+        // Executes draws recorded into a secondary command buffer of the
+        // current frame. Draws are recorded by record only when the frame
+        // has no recording, it was invalidated or the render area or indirect
+        // buffer differ from the ones it was recorded with. Render pass has
+        // to be begun with begin_secondary_render_pass.
+        void execute_recorded(VkCommandBuffer command_buffer,
+            VkRect2D render_area,
+            VkBuffer indirect_buffer,
+            std::function<void(VkCommandBuffer)> const& record);
+
+        // Recorded draws of all frames are recorded again on next execution
+        void invalidate_recorded();
+
         void draw(VkCommandBuffer command_buffer,
             uint32_t lod,
+            uint32_t stitched_edges,
+            uint32_t chunk_index);
+
+        // Reads draw parameters from indirect_buffer at offset, used for
+        // draws which are culled on the GPU
+        void draw(VkCommandBuffer command_buffer,
+            uint32_t lod,
+            uint32_t stitched_edges,
             uint32_t chunk_index,
-            glm::mat4 const& model);
+            VkBuffer indirect_buffer,
+            VkDeviceSize offset);
+
+        // Switches to drawing tessellated patches until the end of the render
+        // pass, edges are subdivided to segments of edge_pixels
+        void begin_tessellation(VkCommandBuffer command_buffer,
+            float edge_pixels,
+            float viewport_height);
+
+        void draw_tessellated(VkCommandBuffer command_buffer,
+            uint32_t chunk_index);
+
+        // Switches to drawing quadtree nodes until the end of the render pass
+        void begin_cdlod(VkCommandBuffer command_buffer);
+
+        // Camera position and origin of the heightmap in world space are
+        // relative to the heightmap
+        void draw(VkCommandBuffer command_buffer,
+            cdlod_node const& node,
+            glm::vec2 const& morph_range,
+            glm::vec3 const& camera_position,
+            glm::vec3 const& origin);
 
         void end_render_pass();
 
@@ -87,19 +196,62 @@ namespace soil
         {
             vkrndr::vulkan_buffer camera_uniform;
             vkrndr::mapped_memory camera_uniform_map{};
-            vkrndr::vulkan_buffer chunk_uniform;
-            vkrndr::mapped_memory chunk_uniform_map{};
             VkDescriptorSet descriptor_set{VK_NULL_HANDLE};
+
+            VkCommandBuffer recorded_commands{VK_NULL_HANDLE};
+            uint64_t recorded_generation{};
+            VkRect2D recorded_area{};
+            VkBuffer recorded_indirect_buffer{VK_NULL_HANDLE};
+
+            // Staging buffers of uploads recorded in this frame
+            std::vector<vkrndr::vulkan_buffer> retired_staging;
+        };
+
+        struct [[nodiscard]] staged_copy final
+        {
+            vkrndr::vulkan_buffer staging;
+            VkBuffer target{VK_NULL_HANDLE};
+            std::vector<VkBufferCopy> regions;
+        };
+
+        // Heights and normals are moved by offset samples
+        struct [[nodiscard]] heightmap_move final
+        {
+            int64_t offset{};
+        };
+
+        // Rectangle of heightmap samples
+        struct [[nodiscard]] sample_region final
+        {
+            size_t x{};
+            size_t y{};
+            size_t width{};
+            size_t height{};
         };
 
         struct [[nodiscard]] lod_index_buffer final
         {
             uint32_t lod{};
+            // Indices of one edge combination, combinations follow each
+            // other in the buffer
             uint32_t index_count{};
             vkrndr::vulkan_buffer index_buffer;
         };
 
     private:
+        void stage_heights(heightmap const& heightmap,
+            std::span<sample_region const> regions);
+
+        void stage_normals(heightmap const& heightmap,
+            std::span<sample_region const> regions);
+
+        void record_move(VkCommandBuffer command_buffer, int64_t offset);
+
+        // Writes normals of region row by row to output
+        void calculate_normals(heightmap const& heightmap,
+            sample_region const& region,
+            glm::vec4* output) const;
+
         void fill_heightmap(heightmap const& heightmap);
 
         void fill_normals(heightmap const& heightmap);
@@ -108,8 +260,35 @@ namespace soil
 
         void fill_vertex_buffer();
 
+        // Converts indices to index_type_ and uploads them to a device local
+        // index buffer
+        [[nodiscard]] vkrndr::vulkan_buffer create_index_buffer(
+            std::span<uint32_t const> indices);
+
+        [[nodiscard]] vkrndr::render_pass_guard begin(VkImageView target_image,
+            VkCommandBuffer command_buffer,
+            VkRect2D render_area,
+            VkRenderingFlags flags);
+
+        void bind_chunk_pipeline(VkCommandBuffer command_buffer);
+
+        void bind_vertex_buffer(VkCommandBuffer command_buffer);
+
+        // Binds index buffer of the LOD stitched along the edges and chunk
+        // parameters, returns nullptr if there is no such LOD
+        lod_index_buffer const* bind_chunk(VkCommandBuffer command_buffer,
+            uint32_t lod,
+            uint32_t stitched_edges,
+            uint32_t chunk_index);
+
         void fill_index_buffer(uint32_t dimension, uint32_t lod);
 
+        // Full resolution grid indices ordered by node quadrant
+        void fill_quadrant_index_buffer(uint32_t dimension);
+
+        // Quad patches of patch_size cells for the tessellation pipeline
+        void fill_patch_index_buffer(uint32_t dimension, uint32_t patch_size);
+
     private:
         vkrndr::vulkan_device* device_;
         vkrndr::vulkan_renderer* renderer_;
@@ -122,6 +301,13 @@ namespace soil
 
         vkrndr::vulkan_buffer heightmap_buffer_;
         vkrndr::vulkan_buffer normal_buffer_;
+        vkrndr::vulkan_buffer chunk_buffer_;
+        // Heights and normals are moved through it, created on first move
+        vkrndr::vulkan_buffer move_buffer_;
+
+        // Recorded in order by the next upload
+        std::vector<std::variant<staged_copy, heightmap_move>>
+            pending_transfers_;
 
         vkrndr::vulkan_image texture_mix_image_;
         VkSampler texture_sampler_;
@@ -129,10 +315,26 @@ namespace soil
         uint32_t vertex_count_{};
         vkrndr::vulkan_buffer vertex_buffer_;
 
+        // 16 bit indices are used whenever the chunk grid fits
+        VkIndexType index_type_{VK_INDEX_TYPE_UINT32};
         std::vector<lod_index_buffer> index_buffers_;
+        uint32_t quadrant_index_count_{};
+        vkrndr::vulkan_buffer quadrant_index_buffer_;
+        uint32_t patch_index_count_{};
+        vkrndr::vulkan_buffer patch_index_buffer_;
 
         VkDescriptorSetLayout descriptor_set_layout_{VK_NULL_HANDLE};
         std::unique_ptr<vkrndr::vulkan_pipeline> pipeline_;
+        std::unique_ptr<vkrndr::vulkan_pipeline> pulling_pipeline_;
+        bool vertex_pulling_{};
+        std::unique_ptr<vkrndr::vulkan_pipeline> cdlod_pipeline_;
+        std::unique_ptr<vkrndr::vulkan_pipeline> tessellation_pipeline_;
+        float edge_pixels_{};
+        float viewport_height_{};
+
+        VkCommandPool recorded_command_pool_{VK_NULL_HANDLE};
+        // Zero is never current, frames start without a recording
+        uint64_t recorded_generation_{1};
 
         cppext::cycled_buffer<frame_resources> frame_data_;
     };
@@ -0,0 +1,244 @@
+#include <vertex_cache.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    // Modeled cache is larger than the simulated one, scores of vertices
+    // past the actual hardware cache size still favor reuse
+    constexpr size_t optimizer_cache_size{32};
+    constexpr float last_triangle_score{0.75f};
+    constexpr float cache_decay_power{1.5f};
+    constexpr float valence_boost_scale{2.0f};
+    constexpr float valence_boost_power{0.5f};
+
+    constexpr size_t no_triangle{std::numeric_limits<size_t>::max()};
+
+    [[nodiscard]] float vertex_score(int32_t const cache_position,
+        uint32_t const remaining_triangles)
+    {
+        if (remaining_triangles == 0)
+        {
+            return -1.0f;
+        }
+
+        float rv{};
+        if (cache_position >= 0)
+        {
+            if (cache_position < 3)
+            {
+                // Vertices of the last triangle get a fixed score, otherwise
+                // the optimizer would prefer triangles using them in a way
+                // that depends on their order
+                rv = last_triangle_score;
+            }
+            else
+            {
+                float const scale{
+                    1.0f / cppext::as_fp(optimizer_cache_size - 3)};
+                rv = std::pow(
+                    1.0f - cppext::as_fp(cache_position - 3) * scale,
+                    cache_decay_power);
+            }
+        }
+
+        // Vertices with few remaining triangles are boosted so that they get
+        // finished instead of leaving isolated triangles behind
+        rv += valence_boost_scale *
+            std::pow(cppext::as_fp(remaining_triangles), -valence_boost_power);
+
+        return rv;
+    }
+} // namespace
+
+void soil::optimize_vertex_cache(std::span<uint32_t> indices,
+    size_t const vertex_count)
+{
+    assert(indices.size() % 3 == 0);
+
+    size_t const triangle_count{indices.size() / 3};
+    if (triangle_count == 0)
+    {
+        return;
+    }
+
+    std::vector<uint32_t> remaining(vertex_count);
+    for (uint32_t const index : indices)
+    {
+        assert(index < vertex_count);
+        ++remaining[index];
+    }
+
+    // Triangles using each vertex, active ones are kept at the front of the
+    // range of the vertex
+    std::vector<size_t> adjacency_offsets(vertex_count + 1);
+    for (size_t vertex{}; vertex != vertex_count; ++vertex)
+    {
+        adjacency_offsets[vertex + 1] =
+            adjacency_offsets[vertex] + remaining[vertex];
+    }
+
+    std::vector<size_t> adjacency(indices.size());
+    {
+        std::vector<size_t> fill_offsets{adjacency_offsets};
+        for (size_t i{}; i != indices.size(); ++i)
+        {
+            adjacency[fill_offsets[indices[i]]++] = i / 3;
+        }
+    }
+
+    std::vector<int32_t> cache_positions(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for (size_t vertex{}; vertex != vertex_count; ++vertex)
+    {
+        vertex_scores[vertex] = vertex_score(-1, remaining[vertex]);
+    }
+
+    auto const triangle_score = [&](size_t const triangle)
+    {
+        return vertex_scores[indices[triangle * 3]] +
+            vertex_scores[indices[triangle * 3 + 1]] +
+            vertex_scores[indices[triangle * 3 + 2]];
+    };
+
+    std::vector<float> triangle_scores(triangle_count);
+    std::vector<bool> emitted(triangle_count);
+    for (size_t triangle{}; triangle != triangle_count; ++triangle)
+    {
+        triangle_scores[triangle] = triangle_score(triangle);
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    std::vector<uint32_t> cache;
+    cache.reserve(optimizer_cache_size + 3);
+    std::vector<uint32_t> next_cache;
+    next_cache.reserve(optimizer_cache_size + 3);
+
+    size_t best{no_triangle};
+    while (output.size() != indices.size())
+    {
+        if (best == no_triangle)
+        {
+            // None of the cached vertices has remaining triangles, restart
+            // from the best scored triangle overall
+            float best_score{std::numeric_limits<float>::lowest()};
+            for (size_t triangle{}; triangle != triangle_count; ++triangle)
+            {
+                if (!emitted[triangle] &&
+                    triangle_scores[triangle] > best_score)
+                {
+                    best = triangle;
+                    best_score = triangle_scores[triangle];
+                }
+            }
+        }
+        assert(best != no_triangle);
+
+        emitted[best] = true;
+
+        auto const* const triangle_vertices{&indices[best * 3]};
+        next_cache.assign(triangle_vertices, triangle_vertices + 3);
+        for (uint32_t const vertex : next_cache)
+        {
+            output.push_back(vertex);
+
+            auto const first{adjacency.begin() +
+                cppext::narrow<std::ptrdiff_t>(adjacency_offsets[vertex])};
+            auto const last{first + remaining[vertex]};
+            auto const it{std::find(first, last, best)};
+            assert(it != last);
+            std::iter_swap(it, last - 1);
+            --remaining[vertex];
+        }
+
+        for (uint32_t const vertex : cache)
+        {
+            if (std::ranges::find(next_cache, vertex) == next_cache.cend())
+            {
+                next_cache.push_back(vertex);
+            }
+        }
+
+        for (size_t i{}; i != next_cache.size(); ++i)
+        {
+            auto const vertex{next_cache[i]};
+            cache_positions[vertex] = i < optimizer_cache_size
+                ? cppext::narrow<int32_t>(i)
+                : -1;
+            vertex_scores[vertex] =
+                vertex_score(cache_positions[vertex], remaining[vertex]);
+        }
+
+        best = no_triangle;
+        float best_score{std::numeric_limits<float>::lowest()};
+        for (uint32_t const vertex : next_cache)
+        {
+            auto const first{adjacency_offsets[vertex]};
+            for (size_t i{first}; i != first + remaining[vertex]; ++i)
+            {
+                auto const triangle{adjacency[i]};
+                triangle_scores[triangle] = triangle_score(triangle);
+                if (triangle_scores[triangle] > best_score)
+                {
+                    best = triangle;
+                    best_score = triangle_scores[triangle];
+                }
+            }
+        }
+
+        next_cache.resize(std::min(next_cache.size(), optimizer_cache_size));
+        std::swap(cache, next_cache);
+    }
+
+    std::ranges::copy(output, indices.begin());
+}
+
+soil::vertex_cache_statistics soil::analyze_vertex_cache(
+    std::span<uint32_t const> indices,
+    size_t const vertex_count,
+    size_t const cache_size)
+{
+    assert(indices.size() % 3 == 0);
+    assert(cache_size > 0);
+
+    if (indices.empty())
+    {
+        return {};
+    }
+
+    // A vertex is in the FIFO cache if less than cache_size misses happened
+    // since it was inserted
+    constexpr size_t never_cached{std::numeric_limits<size_t>::max()};
+    std::vector<size_t> inserted_at(vertex_count, never_cached);
+
+    size_t misses{};
+    size_t unique_vertices{};
+    for (uint32_t const vertex : indices)
+    {
+        assert(vertex < vertex_count);
+
+        auto& inserted{inserted_at[vertex]};
+        if (inserted == never_cached)
+        {
+            ++unique_vertices;
+        }
+        else if (misses - inserted < cache_size)
+        {
+            continue;
+        }
+
+        inserted = misses;
+        ++misses;
+    }
+
+    return {.acmr = cppext::as_fp(misses) / cppext::as_fp(indices.size() / 3),
+        .atvr = cppext::as_fp(misses) / cppext::as_fp(unique_vertices)};
+}
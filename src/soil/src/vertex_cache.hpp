@@ -0,0 +1,35 @@
+#ifndef SOIL_VERTEX_CACHE_INCLUDED
+#define SOIL_VERTEX_CACHE_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace soil
+{
+    struct [[nodiscard]] vertex_cache_statistics final
+    {
+        // Average cache miss ratio, transformed vertices per triangle
+        float acmr{};
+        // Average transform to vertex ratio, transformed vertices per unique
+        // vertex, 1 is optimal
+        float atvr{};
+    };
+
+    // Simulated post-transform cache size used for statistics
+    constexpr size_t default_vertex_cache_size{16};
+
+    // Reorders triangles of an indexed triangle list in place to improve
+    // post-transform vertex cache hit rate, based on Tom Forsyth's linear-speed
+    // vertex cache optimisation. Winding of triangles is preserved.
+    void optimize_vertex_cache(std::span<uint32_t> indices,
+        size_t vertex_count);
+
+    // Simulates a FIFO post-transform cache of cache_size entries
+    [[nodiscard]] vertex_cache_statistics analyze_vertex_cache(
+        std::span<uint32_t const> indices,
+        size_t vertex_count,
+        size_t cache_size = default_vertex_cache_size);
+} // namespace soil
+
+#endif
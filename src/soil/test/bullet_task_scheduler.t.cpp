@@ -0,0 +1,191 @@
+#include <bullet_task_scheduler.hpp>
+#include <heightfield_collision.hpp>
+
+#include <cppext_numeric.hpp>
+#include <cppext_thread_pool.hpp>
+
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObject.h>
+#include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <BulletDynamics/Dynamics/btRigidBody.h>
+#include <LinearMath/btDefaultMotionState.h>
+#include <LinearMath/btQuaternion.h>
+#include <LinearMath/btThreads.h>
+#include <LinearMath/btTransform.h>
+#include <LinearMath/btVector3.h>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr size_t dimension{65};
+    constexpr float max_height{8.0f};
+
+    // Bodies per side of the lattice, dropped above the heightfield
+    constexpr size_t lattice{10};
+    constexpr size_t layers{5};
+
+    constexpr float step_interval{1.0f / 60.0f};
+
+    [[nodiscard]] std::vector<float> rolling_heights()
+    {
+        std::vector<float> rv(dimension * dimension);
+        for (size_t z{}; z != dimension; ++z)
+        {
+            for (size_t x{}; x != dimension; ++x)
+            {
+                auto const fx{cppext::as_fp(x)};
+                auto const fz{cppext::as_fp(z)};
+                rv[z * dimension + x] = max_height / 2.0f +
+                    max_height / 2.0f * std::sin(fx * 0.2f) *
+                        std::cos(fz * 0.15f);
+            }
+        }
+        return rv;
+    }
+
+    // Multithreaded world stepping a lattice of boxes on a heightfield, the
+    // way physics_engine sets it up
+    class [[nodiscard]] lattice_world final
+    {
+    public:
+        explicit lattice_world(cppext::thread_pool* const pool)
+            : heights_{rolling_heights()}
+            , terrain_shape_{dimension, heights_.data(), 0.0f, max_height}
+            , task_scheduler_{pool}
+            , dispatcher_{&collision_configuration_}
+            , solver_pool_{task_scheduler_.getNumThreads()}
+            , world_{&dispatcher_,
+                  &broadphase_,
+                  &solver_pool_,
+                  &solver_,
+                  &collision_configuration_}
+            , heightfield_collision_{&dispatcher_, &collision_configuration_}
+        {
+            btSetTaskScheduler(&task_scheduler_);
+            world_.setGravity({0, -9.81f, 0});
+
+            terrain_.setCollisionShape(&terrain_shape_);
+            world_.addCollisionObject(&terrain_);
+
+            btVector3 local_inertia{0, 0, 0};
+            box_shape_.calculateLocalInertia(1.0f, local_inertia);
+
+            auto const half_lattice{cppext::as_fp(lattice) / 2.0f};
+            for (size_t y{}; y != layers; ++y)
+            {
+                for (size_t z{}; z != lattice; ++z)
+                {
+                    for (size_t x{}; x != lattice; ++x)
+                    {
+                        btVector3 const origin{
+                            (cppext::as_fp(x) - half_lattice) * 1.5f,
+                            max_height + 1.0f + cppext::as_fp(y) * 1.5f,
+                            (cppext::as_fp(z) - half_lattice) * 1.5f};
+                        auto& motion_state{motion_states_.emplace_back(
+                            std::make_unique<btDefaultMotionState>(btTransform{
+                                btQuaternion::getIdentity(),
+                                origin}))};
+                        auto& body{bodies_.emplace_back(
+                            std::make_unique<btRigidBody>(
+                                btRigidBody::btRigidBodyConstructionInfo{1.0f,
+                                    motion_state.get(),
+                                    &box_shape_,
+                                    local_inertia}))};
+                        // Keeps the cost of a step steady once bodies rest
+                        body->setActivationState(DISABLE_DEACTIVATION);
+                        world_.addRigidBody(body.get());
+                    }
+                }
+            }
+        }
+
+        lattice_world(lattice_world const&) = delete;
+
+        lattice_world(lattice_world&&) noexcept = delete;
+
+    public:
+        ~lattice_world()
+        {
+            for (auto const& body : bodies_)
+            {
+                world_.removeRigidBody(body.get());
+            }
+            world_.removeCollisionObject(&terrain_);
+
+            btSetTaskScheduler(btGetSequentialTaskScheduler());
+        }
+
+    public:
+        void step() { world_.stepSimulation(step_interval, 0); }
+
+    public:
+        lattice_world& operator=(lattice_world const&) = delete;
+
+        lattice_world& operator=(lattice_world&&) noexcept = delete;
+
+    private:
+        std::vector<float> heights_;
+        soil::heightfield_shape terrain_shape_;
+        btBoxShape box_shape_{btVector3{0.5f, 0.5f, 0.5f}};
+
+        btDefaultCollisionConfiguration collision_configuration_;
+        soil::bullet_task_scheduler task_scheduler_;
+        btCollisionDispatcherMt dispatcher_;
+        btDbvtBroadphase broadphase_;
+        btConstraintSolverPoolMt solver_pool_;
+        btSequentialImpulseConstraintSolverMt solver_;
+        btDiscreteDynamicsWorldMt world_;
+        soil::heightfield_collision heightfield_collision_;
+
+        btCollisionObject terrain_;
+        std::vector<std::unique_ptr<btDefaultMotionState>> motion_states_;
+        std::vector<std::unique_ptr<btRigidBody>> bodies_;
+    };
+} // namespace
+
+TEST_CASE("bullet_task_scheduler step scaling",
+    "[soil][physics][.benchmark]")
+{
+    // Bullet gives every thread calling into it a new index below
+    // BT_MAX_THREAD_COUNT, indices of pools created one after another add up
+    constexpr unsigned max_threads{32};
+    unsigned const hardware{
+        std::clamp(std::thread::hardware_concurrency(), 1u, max_threads)};
+
+    std::vector<unsigned> thread_counts{1, 2, 4};
+    std::erase_if(thread_counts,
+        [hardware](unsigned const count) { return count >= hardware; });
+    thread_counts.push_back(hardware);
+
+    for (unsigned const threads : thread_counts)
+    {
+        cppext::thread_pool pool{threads};
+        lattice_world world{&pool};
+
+        // Bodies land on the terrain and pile up before measuring
+        for (int i{}; i != 120; ++i)
+        {
+            world.step();
+        }
+
+        BENCHMARK(std::to_string(lattice * lattice * layers) + " bodies, " +
+            std::to_string(threads) + " threads")
+        {
+            world.step();
+        };
+    }
+}
@@ -0,0 +1,144 @@
+#include <cdlod.hpp>
+#include <heightmap.hpp>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace
+{
+    // Levels of 16, 32, 64 and 128 quads, ranges of 32, 64 and 128
+    constexpr size_t dimension{129};
+    constexpr size_t leaf_size{16};
+
+    [[nodiscard]] soil::cdlod_node const* find_node(
+        std::span<soil::cdlod_node const> const selection,
+        glm::uvec2 const& origin,
+        uint32_t const level)
+    {
+        auto const it{std::ranges::find_if(selection,
+            [&](soil::cdlod_node const& node)
+            { return node.origin == origin && node.level == level; })};
+        return it == selection.end() ? nullptr : &*it;
+    }
+
+    // Drawn quadrants cover every half of a leaf node exactly once
+    [[nodiscard]] bool covers_once(
+        std::span<soil::cdlod_node const> const selection)
+    {
+        constexpr size_t half_leaf{leaf_size / 2};
+        constexpr size_t cells{(dimension - 1) / half_leaf};
+
+        std::vector<int> coverage(cells * cells);
+        for (soil::cdlod_node const& node : selection)
+        {
+            size_t const quadrant_cells{size_t{1} << node.level};
+            for (uint32_t quadrant{}; quadrant != 4; ++quadrant)
+            {
+                if ((node.quadrants & (1u << quadrant)) == 0)
+                {
+                    continue;
+                }
+
+                size_t const first_x{node.origin.x / half_leaf +
+                    (quadrant & 1) * quadrant_cells};
+                size_t const first_y{node.origin.y / half_leaf +
+                    (quadrant >> 1) * quadrant_cells};
+                for (size_t y{first_y}; y != first_y + quadrant_cells; ++y)
+                {
+                    for (size_t x{first_x}; x != first_x + quadrant_cells;
+                        ++x)
+                    {
+                        ++coverage[y * cells + x];
+                    }
+                }
+            }
+        }
+
+        return std::ranges::all_of(coverage,
+            [](int const count) { return count == 1; });
+    }
+} // namespace
+
+TEST_CASE("cdlod_quadtree selects by range", "[soil][cdlod]")
+{
+    soil::heightmap const heightmap{dimension};
+    soil::cdlod_quadtree quadtree{dimension, leaf_size};
+    REQUIRE(quadtree.levels() == 4);
+    quadtree.update(heightmap);
+
+    SECTION("Distant camera draws the root")
+    {
+        quadtree.select({64.0f, 1000.0f, 64.0f});
+
+        auto const selection{quadtree.selection()};
+        REQUIRE(selection.size() == 1);
+        CHECK(selection.front().origin == glm::uvec2{0, 0});
+        CHECK(selection.front().level == 3);
+        CHECK(selection.front().quadrants ==
+            soil::cdlod_quadtree::all_quadrants);
+    }
+
+    SECTION("Camera in a corner")
+    {
+        quadtree.select({4.0f, 0.0f, 4.0f});
+        auto const selection{quadtree.selection()};
+        CHECK(covers_once(selection));
+
+        // Leaves within 32 of the camera
+        for (glm::uvec2 const origin :
+            {glm::uvec2{0, 0}, glm::uvec2{16, 0}, glm::uvec2{32, 16}})
+        {
+            auto const* const leaf{find_node(selection, origin, 0)};
+            REQUIRE(leaf);
+            CHECK(leaf->quadrants == soil::cdlod_quadtree::all_quadrants);
+        }
+
+        // Right column of leaves is beyond 32, drawn by the parent
+        auto const* const partial{find_node(selection, {32, 0}, 1)};
+        REQUIRE(partial);
+        CHECK(partial->quadrants == 0b1010);
+
+        // Beyond 64 but within 128
+        auto const* const far{find_node(selection, {64, 64}, 2)};
+        REQUIRE(far);
+        CHECK(far->quadrants == soil::cdlod_quadtree::all_quadrants);
+
+        CHECK_FALSE(find_node(selection, {0, 0}, 3));
+    }
+}
+
+TEST_CASE("cdlod_quadtree height bounds", "[soil][cdlod]")
+{
+    soil::heightmap heightmap{dimension};
+    soil::cdlod_quadtree quadtree{dimension, leaf_size};
+
+    // Camera 41 above flat ground, 31 above the top of the bump
+    glm::vec3 const camera{40.0f, 41.0f, 20.0f};
+
+    quadtree.update(heightmap);
+    quadtree.select(camera);
+    CHECK(covers_once(quadtree.selection()));
+    CHECK_FALSE(find_node(quadtree.selection(), {32, 16}, 0));
+    CHECK(find_node(quadtree.selection(), {32, 0}, 1));
+
+    heightmap.data()[20 * dimension + 40] = 10.0f;
+    quadtree.update(heightmap);
+    quadtree.select(camera);
+    CHECK(covers_once(quadtree.selection()));
+
+    // Leaf containing the bump is within range, its siblings aren't
+    auto const* const leaf{find_node(quadtree.selection(), {32, 16}, 0)};
+    REQUIRE(leaf);
+    CHECK(leaf->quadrants == soil::cdlod_quadtree::all_quadrants);
+    auto const* const parent{find_node(quadtree.selection(), {32, 0}, 1)};
+    REQUIRE(parent);
+    CHECK(parent->quadrants == 0b1011);
+}
@@ -0,0 +1,58 @@
+#include <erosion.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+    constexpr size_t dimension{64};
+} // namespace
+
+TEST_CASE("cpu_erosion keeps flat terrain", "[soil][erosion]")
+{
+    soil::cpu_erosion erosion{dimension};
+
+    // Rain on level ground never flows, nothing is dissolved
+    std::vector<float> heights(dimension * dimension, 10.0f);
+    erosion.run(heights, {}, 50);
+
+    CHECK(std::ranges::all_of(heights,
+        [](float const h) { return h == 10.0f; }));
+}
+
+TEST_CASE("cpu_erosion conserves mass without water", "[soil][erosion]")
+{
+    soil::cpu_erosion erosion{dimension};
+
+    // Thermal weathering alone moves material between neighbours
+    std::vector<float> heights(dimension * dimension, 0.0f);
+    size_t const peak{dimension / 2 * dimension + dimension / 2};
+    heights[peak] = 100.0f;
+
+    soil::erosion_settings const settings{.rain_rate = 0.0f};
+    erosion.run(heights, settings, 100);
+
+    CHECK(heights[peak] < 100.0f);
+    CHECK(heights[peak + 1] > 0.0f);
+    CHECK(std::fabs(std::reduce(heights.begin(), heights.end(), 0.0) -
+              100.0) < 1e-3);
+
+    // Slopes settle towards the talus
+    erosion.run(heights, settings, 1000);
+    float steepest{};
+    for (size_t y{}; y != dimension; ++y)
+    {
+        for (size_t x{1}; x != dimension; ++x)
+        {
+            size_t const index{y * dimension + x};
+            steepest = std::max(steepest,
+                std::fabs(heights[index] - heights[index - 1]));
+        }
+    }
+    CHECK(steepest < settings.talus + 0.1f);
+}
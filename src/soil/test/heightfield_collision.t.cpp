@@ -0,0 +1,287 @@
+#include <heightfield_collision.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcher.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObject.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h>
+#include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+#include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
+#include <BulletCollision/CollisionShapes/btCapsuleShape.h>
+#include <BulletCollision/CollisionShapes/btCollisionShape.h>
+#include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
+#include <BulletCollision/CollisionShapes/btSphereShape.h>
+#include <BulletCollision/NarrowPhaseCollision/btManifoldPoint.h>
+#include <LinearMath/btQuaternion.h>
+#include <LinearMath/btScalar.h>
+#include <LinearMath/btTransform.h>
+#include <LinearMath/btVector3.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace
+{
+    constexpr size_t dimension{9};
+    constexpr float min_height{0.0f};
+    constexpr float max_height{4.0f};
+
+    // Slope with bumps, between min_height and max_height
+    [[nodiscard]] std::vector<float> sloped_heights()
+    {
+        std::vector<float> rv(dimension * dimension);
+        for (size_t z{}; z != dimension; ++z)
+        {
+            for (size_t x{}; x != dimension; ++x)
+            {
+                auto const fx{cppext::as_fp(x)};
+                auto const fz{cppext::as_fp(z)};
+                rv[z * dimension + x] = 1.0f + 0.2f * fx + 0.1f * fz +
+                    0.3f * std::sin(fx * 1.3f) * std::cos(fz * 0.7f);
+            }
+        }
+        return rv;
+    }
+
+    // Sharp ridge along X through the middle row, corners of a small box
+    // resting on it between two vertices stay above the slopes. The row
+    // after the ridge is at the shoulder height.
+    [[nodiscard]] std::vector<float> ridge_heights(
+        float const shoulder = min_height)
+    {
+        std::vector<float> rv(dimension * dimension, min_height);
+        for (size_t x{}; x != dimension; ++x)
+        {
+            rv[dimension / 2 * dimension + x] = 2.0f;
+            rv[(dimension / 2 + 1) * dimension + x] = shoulder;
+        }
+        return rv;
+    }
+
+    class [[nodiscard]] deepest_contact final
+        : public btCollisionWorld::ContactResultCallback
+    {
+    public:
+        btScalar addSingleResult(btManifoldPoint& cp,
+            [[maybe_unused]] btCollisionObjectWrapper const* colObj0Wrap,
+            [[maybe_unused]] int partId0,
+            [[maybe_unused]] int index0,
+            [[maybe_unused]] btCollisionObjectWrapper const* colObj1Wrap,
+            [[maybe_unused]] int partId1,
+            [[maybe_unused]] int index1) override
+        {
+            if (!found || cp.getDistance() < distance)
+            {
+                found = true;
+                distance = cp.getDistance();
+                normal = cp.m_normalWorldOnB;
+            }
+            return 0;
+        }
+
+    public:
+        bool found{};
+        btScalar distance{};
+        btVector3 normal{0, 0, 0};
+    };
+
+    // Deepest contact between the convex and the terrain, in the given
+    // order, with Bullet's algorithms or with heightfield_collision
+    [[nodiscard]] deepest_contact collide(std::vector<float> const& heights,
+        btCollisionShape* const convex,
+        btTransform const& transform,
+        bool const heightfield_narrowphase,
+        bool const terrain_first)
+    {
+        soil::heightfield_shape terrain_shape{dimension,
+            heights.data(),
+            min_height,
+            max_height};
+
+        btDefaultCollisionConfiguration configuration;
+        btCollisionDispatcher dispatcher{&configuration};
+        btDbvtBroadphase broadphase;
+        btCollisionWorld world{&dispatcher, &broadphase, &configuration};
+        soil::heightfield_collision collision{&dispatcher, &configuration};
+        collision.set_enabled(heightfield_narrowphase);
+
+        btCollisionObject terrain;
+        terrain.setCollisionShape(&terrain_shape);
+
+        btCollisionObject body;
+        body.setCollisionShape(convex);
+        body.setWorldTransform(transform);
+
+        deepest_contact rv;
+        if (terrain_first)
+        {
+            world.contactPairTest(&terrain, &body, rv);
+        }
+        else
+        {
+            world.contactPairTest(&body, &terrain, rv);
+        }
+        return rv;
+    }
+
+    void check_matches_bullet(btCollisionShape* const convex,
+        btTransform const& transform,
+        std::vector<float> const& heights = sloped_heights())
+    {
+        for (bool const terrain_first : {false, true})
+        {
+            deepest_contact const expected{
+                collide(heights, convex, transform, false, terrain_first)};
+            deepest_contact const actual{
+                collide(heights, convex, transform, true, terrain_first)};
+
+            REQUIRE(expected.found == actual.found);
+            if (expected.found)
+            {
+                CHECK(std::abs(expected.distance - actual.distance) < 0.01f);
+                CHECK(expected.normal.dot(actual.normal) > 0.95f);
+            }
+        }
+    }
+
+    // Deepest contact found by heightfield_collision, normal pointing
+    // towards the box
+    void check_contact(btCollisionShape* const convex,
+        btTransform const& transform,
+        std::vector<float> const& heights,
+        float const distance,
+        btVector3 const& normal)
+    {
+        for (bool const terrain_first : {false, true})
+        {
+            deepest_contact const actual{
+                collide(heights, convex, transform, true, terrain_first)};
+
+            REQUIRE(actual.found);
+            CHECK(std::abs(actual.distance - distance) < 0.001f);
+            CHECK((terrain_first ? -actual.normal : actual.normal)
+                      .dot(normal) > 0.999f);
+        }
+    }
+
+    [[nodiscard]] btTransform at(btVector3 const& origin,
+        btQuaternion const& rotation = btQuaternion::getIdentity())
+    {
+        return btTransform{rotation, origin};
+    }
+} // namespace
+
+TEST_CASE("heightfield_collision sphere", "[soil][physics]")
+{
+    btSphereShape sphere{0.5f};
+
+    // Local heights are offset by the middle of the height range, centers
+    // stay above the surface where Bullet's contacts are one sided
+    check_matches_bullet(&sphere, at({0.3f, 0.7f, -0.4f}));
+    check_matches_bullet(&sphere, at({-2.6f, -0.1f, 1.7f}));
+    check_matches_bullet(&sphere, at({1.4f, 0.9f, 2.2f}));
+
+    // Above the surface
+    check_matches_bullet(&sphere, at({0.3f, 3.0f, -0.4f}));
+}
+
+TEST_CASE("heightfield_collision capsule", "[soil][physics]")
+{
+    btCapsuleShape capsule{0.3f, 1.0f};
+
+    check_matches_bullet(&capsule, at({0.3f, 1.0f, -0.4f}));
+    check_matches_bullet(&capsule,
+        at({-1.2f, 0.35f, 0.6f}, btQuaternion{btVector3{0, 0, 1}, 1.3f}));
+    check_matches_bullet(&capsule,
+        at({2.1f, 0.9f, -1.8f}, btQuaternion{btVector3{1, 0, 1}, 0.7f}));
+
+    check_matches_bullet(&capsule, at({0.3f, 3.0f, -0.4f}));
+}
+
+TEST_CASE("heightfield_collision box", "[soil][physics]")
+{
+    btBoxShape box{btVector3{0.4f, 0.3f, 0.5f}};
+
+    // Lowest corners dip into the slope
+    check_matches_bullet(&box, at({0.3f, 0.5f, -0.4f}));
+    check_matches_bullet(&box, at({-2.2f, -0.1f, 1.4f}));
+
+    check_matches_bullet(&box, at({0.3f, 3.0f, -0.4f}));
+}
+
+TEST_CASE("heightfield_collision box on ridge", "[soil][physics]")
+{
+    btBoxShape box{btVector3{0.25f, 0.25f, 0.25f}};
+
+    // Ridge is at local height 0, the box spans it between two vertices
+    // and neither its corners nor grid vertices are inside of each other.
+    // Bullet collides each triangle on its own and pushes the box along the
+    // slopes, the ridge pushes it up.
+    std::vector<float> const heights{ridge_heights()};
+    btVector3 const up{0, 1, 0};
+    check_contact(&box, at({0.5f, 0.2f, 0.0f}), heights, -0.05f, up);
+    check_contact(&box,
+        at({-1.5f, 0.15f, 0.05f}, btQuaternion{up, 0.3f}),
+        heights,
+        -0.1f,
+        up);
+
+    // Tilted towards a gentle shoulder, lower corners touch it while the
+    // ridge is deeper below the bottom face
+    float const tilt{0.3f};
+    check_contact(&box,
+        at({0.5f, 0.2f, 0.1f}, btQuaternion{btVector3{1, 0, 0}, tilt}),
+        ridge_heights(1.6f),
+        0.2f * std::cos(tilt) + 0.1f * std::sin(tilt) - 0.25f,
+        btVector3{0, std::cos(tilt), std::sin(tilt)});
+
+    // Above the ridge
+    CHECK_FALSE(
+        collide(heights, &box, at({0.5f, 0.5f, 0.0f}), true, false).found);
+}
+
+TEST_CASE("heightfield_collision fallback", "[soil][physics]")
+{
+    btSphereShape sphere{0.5f};
+
+    std::vector<float> heights{sloped_heights()};
+    btHeightfieldTerrainShape terrain_shape{cppext::narrow<int>(dimension),
+        cppext::narrow<int>(dimension),
+        heights.data(),
+        min_height,
+        max_height,
+        1,
+        false};
+
+    btDefaultCollisionConfiguration configuration;
+    btCollisionDispatcher dispatcher{&configuration};
+    btDbvtBroadphase broadphase;
+    btCollisionWorld world{&dispatcher, &broadphase, &configuration};
+    soil::heightfield_collision collision{&dispatcher, &configuration};
+    CHECK(collision.enabled());
+
+    btCollisionObject terrain;
+    terrain.setCollisionShape(&terrain_shape);
+
+    btCollisionObject body;
+    body.setCollisionShape(&sphere);
+    body.setWorldTransform(at({0.3f, 0.7f, -0.4f}));
+
+    // Plain heightfields keep Bullet's algorithm
+    deepest_contact actual;
+    world.contactPairTest(&body, &terrain, actual);
+    deepest_contact const expected{collide(heights,
+        &sphere,
+        at({0.3f, 0.7f, -0.4f}),
+        false,
+        false)};
+
+    REQUIRE(actual.found);
+    REQUIRE(expected.found);
+    CHECK(std::abs(expected.distance - actual.distance) < 0.0001f);
+}
@@ -0,0 +1,94 @@
+#include <noise.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+TEST_CASE("generate_2d_noise range", "[soil][noise]")
+{
+    constexpr size_t dimension{64};
+
+    for (soil::noise_type const type :
+        {soil::noise_type::fbm, soil::noise_type::ridged})
+    {
+        soil::noise_settings const settings{.scale = 16.0f,
+            .octaves = 5,
+            .type = type,
+            .warp_strength = 8.0f};
+
+        std::vector<float> values(dimension * dimension);
+        soil::generate_2d_noise(values, dimension, dimension, settings);
+
+        CHECK(std::ranges::all_of(values,
+            [](float const v) { return v >= 0.0f && v <= 1.0f; }));
+        CHECK(std::ranges::max(values) > std::ranges::min(values));
+    }
+}
+
+TEST_CASE("generate_2d_noise regions", "[soil][noise]")
+{
+    // Large enough to be split across threads
+    constexpr size_t dimension{512};
+    constexpr size_t offset{100};
+    constexpr size_t tile{37};
+
+    soil::noise_settings const settings{.octaves = 4};
+
+    std::vector<float> whole(dimension * dimension);
+    soil::generate_2d_noise(whole, dimension, dimension, settings);
+
+    std::vector<float> again(dimension * dimension);
+    soil::generate_2d_noise(again, dimension, dimension, settings);
+    CHECK(whole == again);
+
+    // Tile at an origin matches the same samples of the whole region
+    std::vector<float> part(tile * tile);
+    soil::generate_2d_noise(part,
+        tile,
+        tile,
+        settings,
+        static_cast<float>(offset),
+        static_cast<float>(offset));
+    for (size_t y{}; y != tile; ++y)
+    {
+        for (size_t x{}; x != tile; ++x)
+        {
+            CHECK(part[y * tile + x] ==
+                whole[(y + offset) * dimension + x + offset]);
+        }
+    }
+
+    soil::noise_settings other_seed{settings};
+    other_seed.seed += 1;
+    std::vector<float> different(dimension * dimension);
+    soil::generate_2d_noise(different, dimension, dimension, other_seed);
+    CHECK(whole != different);
+}
+
+TEST_CASE("generate_2d_noise throughput", "[soil][noise][.benchmark]")
+{
+    for (size_t const dimension : {size_t{256}, size_t{1024}, size_t{4096}})
+    {
+        std::vector<float> values(dimension * dimension);
+        for (uint32_t const octaves : {1u, 8u})
+        {
+            soil::noise_settings const settings{.octaves = octaves};
+            BENCHMARK(std::to_string(dimension) + "x" +
+                std::to_string(dimension) + ", " + std::to_string(octaves) +
+                " octaves")
+            {
+                soil::generate_2d_noise(values,
+                    dimension,
+                    dimension,
+                    settings);
+                return values[dimension / 2];
+            };
+        }
+    }
+}
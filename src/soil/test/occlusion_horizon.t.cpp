@@ -0,0 +1,216 @@
+#include <noise.hpp>
+#include <occlusion_horizon.hpp>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr float chunk_size{32.0f};
+
+    struct [[nodiscard]] chunk final
+    {
+        glm::vec2 min;
+        float min_height;
+        float max_height;
+        bool visible{true};
+    };
+
+    // Square grid of chunks with the origin in the corner of the first one
+    [[nodiscard]] std::vector<chunk> chunk_grid(size_t const dimension,
+        auto const& heights)
+    {
+        std::vector<chunk> rv;
+        for (size_t z{}; z != dimension; ++z)
+        {
+            for (size_t x{}; x != dimension; ++x)
+            {
+                auto const [min_height, max_height] = heights(x, z);
+                rv.push_back({.min = {static_cast<float>(x) * chunk_size,
+                                  static_cast<float>(z) * chunk_size},
+                    .min_height = min_height,
+                    .max_height = max_height});
+            }
+        }
+        return rv;
+    }
+
+    // Same traversal as the terrain, front to back in the XZ plane. Returns
+    // the number of culled chunks.
+    size_t cull(soil::occlusion_horizon& horizon,
+        glm::vec3 const& camera,
+        std::span<chunk> const chunks)
+    {
+        glm::vec2 const camera_xz{camera.x, camera.z};
+
+        std::vector<std::pair<float, size_t>> front_to_back;
+        front_to_back.reserve(chunks.size());
+        for (size_t i{}; i != chunks.size(); ++i)
+        {
+            glm::vec2 const max{chunks[i].min + chunk_size};
+            front_to_back.emplace_back(
+                glm::distance(camera_xz,
+                    glm::clamp(camera_xz, chunks[i].min, max)),
+                i);
+        }
+        std::ranges::sort(front_to_back);
+
+        horizon.reset(camera);
+        size_t rv{};
+        for (auto const& [distance, index] : front_to_back)
+        {
+            chunk& c{chunks[index]};
+            glm::vec2 const max{c.min + chunk_size};
+            c.visible = !horizon.occluded({c.min.x, c.min_height, c.min.y},
+                {max.x, c.max_height, max.y});
+            if (!c.visible)
+            {
+                ++rv;
+                continue;
+            }
+            horizon.add_occluder(c.min, max, c.min_height);
+        }
+        return rv;
+    }
+} // namespace
+
+TEST_CASE("occlusion_horizon valley", "[soil][occlusion_horizon]")
+{
+    constexpr size_t dimension{16};
+    constexpr size_t center{8};
+
+    // Low valley floor inside of a ring of high chunks, hills beyond it
+    auto const ring_distance = [](size_t const x, size_t const z)
+    {
+        auto const distance = [](size_t const v)
+        { return v > center ? v - center : center - v; };
+        return std::max(distance(x), distance(z));
+    };
+    auto chunks{chunk_grid(dimension,
+        [&](size_t const x, size_t const z)
+        {
+            size_t const ring{ring_distance(x, z)};
+            if (ring < 2)
+            {
+                return std::pair{0.0f, 5.0f};
+            }
+            if (ring == 2)
+            {
+                return std::pair{100.0f, 110.0f};
+            }
+            return std::pair{0.0f, 50.0f};
+        })};
+
+    // Peak rising above the ring stays visible
+    chunk& peak{chunks[(center + 5) * dimension + center]};
+    peak.max_height = 400.0f;
+
+    soil::occlusion_horizon horizon{256};
+    glm::vec3 const camera{(center + 0.5f) * chunk_size,
+        10.0f,
+        (center + 0.5f) * chunk_size};
+    size_t const culled{cull(horizon, camera, chunks)};
+
+    for (size_t z{}; z != dimension; ++z)
+    {
+        for (size_t x{}; x != dimension; ++x)
+        {
+            chunk const& c{chunks[z * dimension + x]};
+            if (&c == &peak || ring_distance(x, z) <= 2)
+            {
+                CHECK(c.visible);
+            }
+            else
+            {
+                CHECK_FALSE(c.visible);
+            }
+        }
+    }
+    CHECK(culled == dimension * dimension - 5 * 5 - 1);
+
+    // Camera above the ring sees everything
+    glm::vec3 const high_camera{camera.x, 500.0f, camera.z};
+    CHECK(cull(horizon, high_camera, chunks) == 0);
+}
+
+TEST_CASE("occlusion_horizon wraps around", "[soil][occlusion_horizon]")
+{
+    soil::occlusion_horizon horizon{64};
+    horizon.reset({0.0f, 0.0f, 0.0f});
+
+    // Wall behind the camera, across the direction where azimuth wraps
+    horizon.add_occluder({-40.0f, -20.0f}, {-30.0f, 20.0f}, 50.0f);
+
+    CHECK(horizon.occluded({-100.0f, 0.0f, -5.0f}, {-90.0f, 10.0f, 5.0f}));
+    CHECK_FALSE(
+        horizon.occluded({-100.0f, 0.0f, -5.0f}, {-90.0f, 200.0f, 5.0f}));
+    CHECK_FALSE(
+        horizon.occluded({90.0f, 0.0f, -5.0f}, {100.0f, 10.0f, 5.0f}));
+    // Box around the camera is never occluded
+    CHECK_FALSE(
+        horizon.occluded({-10.0f, -50.0f, -10.0f}, {10.0f, -40.0f, 10.0f}));
+}
+
+TEST_CASE("occlusion_horizon culling", "[soil][occlusion_horizon][.benchmark]")
+{
+    constexpr size_t dimension{64};
+    constexpr size_t samples{8};
+    constexpr float height_scale{255.0f};
+
+    std::vector<float> heights(dimension * samples * dimension * samples);
+    soil::generate_2d_noise(heights,
+        dimension * samples,
+        dimension * samples,
+        {.scale = 128.0f, .octaves = 6});
+
+    auto chunks{chunk_grid(dimension,
+        [&](size_t const x, size_t const z)
+        {
+            float low{height_scale};
+            float high{0.0f};
+            for (size_t j{}; j != samples; ++j)
+            {
+                for (size_t i{}; i != samples; ++i)
+                {
+                    float const h{height_scale *
+                        heights[(z * samples + j) * dimension * samples +
+                            x * samples + i]};
+                    low = std::min(low, h);
+                    high = std::max(high, h);
+                }
+            }
+            return std::pair{low, high};
+        })};
+
+    soil::occlusion_horizon horizon{256};
+    float const center{static_cast<float>(dimension) * chunk_size / 2.0f};
+    for (float const elevation : {2.0f, 20.0f, 100.0f})
+    {
+        chunk const& below{
+            chunks[dimension * dimension / 2 + dimension / 2]};
+        glm::vec3 const camera{center, below.max_height + elevation, center};
+
+        size_t const culled{cull(horizon, camera, chunks)};
+        WARN("Camera " << elevation << " above ground: " << culled
+                       << " culled, " << chunks.size() - culled
+                       << " drawn");
+
+        BENCHMARK("Cull " + std::to_string(chunks.size()) + " chunks, " +
+            std::to_string(static_cast<int>(elevation)) + " above ground")
+        {
+            return cull(horizon, camera, chunks);
+        };
+    }
+}
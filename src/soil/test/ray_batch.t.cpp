@@ -0,0 +1,225 @@
+#include <heightfield_collision.hpp>
+#include <ray_batch.hpp>
+
+#include <cppext_numeric.hpp>
+#include <cppext_thread_pool.hpp>
+
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcher.h>
+#include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+#include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
+#include <BulletCollision/CollisionShapes/btSphereShape.h>
+#include <BulletDynamics/Dynamics/btRigidBody.h>
+#include <LinearMath/btQuaternion.h>
+#include <LinearMath/btTransform.h>
+#include <LinearMath/btVector3.h>
+
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr size_t dimension{257};
+    constexpr float max_height{32.0f};
+
+    [[nodiscard]] std::vector<float> rolling_heights()
+    {
+        std::vector<float> rv(dimension * dimension);
+        for (size_t z{}; z != dimension; ++z)
+        {
+            for (size_t x{}; x != dimension; ++x)
+            {
+                auto const fx{cppext::as_fp(x)};
+                auto const fz{cppext::as_fp(z)};
+                rv[z * dimension + x] = max_height / 2.0f +
+                    max_height / 2.0f * std::sin(fx * 0.05f) *
+                        std::cos(fz * 0.04f);
+            }
+        }
+        return rv;
+    }
+
+    // Static heightfield with a grid of spheres above it, bodies are rigid
+    // bodies so that hits report them
+    class [[nodiscard]] ray_world final
+    {
+    public:
+        ray_world()
+            : heights_{rolling_heights()}
+            , terrain_shape_{dimension, heights_.data(), 0.0f, max_height}
+            , dispatcher_{&collision_configuration_}
+            , world_{&dispatcher_, &broadphase_, &collision_configuration_}
+            , terrain_{0.0f, nullptr, &terrain_shape_}
+        {
+            world_.addCollisionObject(&terrain_);
+
+            for (int z{-6}; z <= 6; ++z)
+            {
+                for (int x{-6}; x <= 6; ++x)
+                {
+                    auto& sphere{spheres_.emplace_back(
+                        std::make_unique<btRigidBody>(0.0f,
+                            nullptr,
+                            &sphere_shape_))};
+                    sphere->setWorldTransform(
+                        btTransform{btQuaternion::getIdentity(),
+                            btVector3{cppext::as_fp(x) * 15.0f,
+                                max_height,
+                                cppext::as_fp(z) * 15.0f}});
+                    world_.addCollisionObject(sphere.get());
+                }
+            }
+
+            world_.updateAabbs();
+        }
+
+        ray_world(ray_world const&) = delete;
+
+        ray_world(ray_world&&) noexcept = delete;
+
+    public:
+        ~ray_world()
+        {
+            for (auto const& sphere : spheres_)
+            {
+                world_.removeCollisionObject(sphere.get());
+            }
+            world_.removeCollisionObject(&terrain_);
+        }
+
+    public:
+        void cast_rays(std::span<soil::ray const> const rays,
+            std::span<soil::ray_hit> const hits)
+        {
+            soil::cast_rays(broadphase_,
+                rays,
+                hits,
+                cppext::default_thread_pool());
+        }
+
+        [[nodiscard]] soil::ray_hit ray_test(soil::ray const& ray)
+        {
+            btVector3 const from{ray.from.x, ray.from.y, ray.from.z};
+            btVector3 const to{ray.to.x, ray.to.y, ray.to.z};
+
+            btCollisionWorld::ClosestRayResultCallback callback{from, to};
+            world_.rayTest(from, to, callback);
+            if (!callback.hasHit())
+            {
+                return {};
+            }
+
+            btVector3 const& position{callback.m_hitPointWorld};
+            btVector3 const& normal{callback.m_hitNormalWorld};
+            return {.body = btRigidBody::upcast(callback.m_collisionObject),
+                .position = {position.x(), position.y(), position.z()},
+                .normal = {normal.x(), normal.y(), normal.z()}};
+        }
+
+    public:
+        ray_world& operator=(ray_world const&) = delete;
+
+        ray_world& operator=(ray_world&&) noexcept = delete;
+
+    private:
+        std::vector<float> heights_;
+        soil::heightfield_shape terrain_shape_;
+        btSphereShape sphere_shape_{4.0f};
+
+        btDefaultCollisionConfiguration collision_configuration_;
+        btCollisionDispatcher dispatcher_;
+        btDbvtBroadphase broadphase_;
+        btCollisionWorld world_;
+
+        btRigidBody terrain_;
+        std::vector<std::unique_ptr<btRigidBody>> spheres_;
+    };
+
+    // Square grid of rays cast down over the middle of the terrain
+    [[nodiscard]] std::vector<soil::ray> ray_grid(size_t const rays_per_side,
+        float const spacing)
+    {
+        float const half_extent{cppext::as_fp(rays_per_side) * spacing / 2.0f};
+
+        std::vector<soil::ray> rv;
+        rv.reserve(rays_per_side * rays_per_side);
+        for (size_t z{}; z != rays_per_side; ++z)
+        {
+            for (size_t x{}; x != rays_per_side; ++x)
+            {
+                glm::vec3 const from{
+                    cppext::as_fp(x) * spacing - half_extent,
+                    2.0f * max_height,
+                    cppext::as_fp(z) * spacing - half_extent};
+                rv.push_back({.from = from,
+                    .to = from - glm::vec3{0.0f, 4.0f * max_height, 0.0f}});
+            }
+        }
+        return rv;
+    }
+} // namespace
+
+TEST_CASE("cast_rays matches rayTest", "[soil][physics]")
+{
+    ray_world world;
+
+    std::vector<soil::ray> const rays{ray_grid(64, 3.0f)};
+    std::vector<soil::ray_hit> hits(rays.size());
+    world.cast_rays(rays, hits);
+
+    size_t sphere_hits{};
+    for (size_t i{}; i != rays.size(); ++i)
+    {
+        soil::ray_hit const expected{world.ray_test(rays[i])};
+        REQUIRE(expected.body);
+        CHECK(hits[i].body == expected.body);
+        CHECK(glm::distance(hits[i].position, expected.position) < 1e-3f);
+        CHECK(glm::dot(hits[i].normal, expected.normal) > 0.999f);
+
+        if (expected.position.y > max_height)
+        {
+            ++sphere_hits;
+        }
+    }
+    CHECK(sphere_hits > 0);
+
+    // Rays missing everything
+    std::vector<soil::ray> const above{
+        {.from = {0.0f, 100.0f, 0.0f}, .to = {0.0f, 200.0f, 0.0f}}};
+    std::vector<soil::ray_hit> missed(1);
+    world.cast_rays(above, missed);
+    CHECK_FALSE(missed[0].body);
+}
+
+TEST_CASE("cast_rays throughput", "[soil][physics][.benchmark]")
+{
+    ray_world world;
+
+    std::vector<soil::ray> const rays{ray_grid(256, 0.5f)};
+    std::vector<soil::ray_hit> hits(rays.size());
+    std::string const count{std::to_string(rays.size())};
+
+    BENCHMARK("Batched " + count + " rays")
+    {
+        world.cast_rays(rays, hits);
+        return hits.front().body;
+    };
+
+    BENCHMARK("Single " + count + " rays")
+    {
+        for (size_t i{}; i != rays.size(); ++i)
+        {
+            hits[i] = world.ray_test(rays[i]);
+        }
+        return hits.front().body;
+    };
+}
@@ -0,0 +1,295 @@
+#include <heightfield_collision.hpp>
+#include <noise.hpp>
+#include <ray_batch.hpp>
+
+#include <cppext_numeric.hpp>
+#include <cppext_thread_pool.hpp>
+
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcher.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObject.h>
+#include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+#include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
+#include <BulletCollision/CollisionShapes/btSphereShape.h>
+#include <BulletCollision/NarrowPhaseCollision/btManifoldPoint.h>
+#include <BulletDynamics/Dynamics/btRigidBody.h>
+#include <LinearMath/btQuaternion.h>
+#include <LinearMath/btScalar.h>
+#include <LinearMath/btTransform.h>
+#include <LinearMath/btVector3.h>
+
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Window of 16 by 16 chunks as loaded by the terrain
+    constexpr size_t chunk_dimension{65};
+    constexpr size_t chunks_per_dimension{16};
+    constexpr size_t terrain_dimension{
+        (chunk_dimension - 1) * chunks_per_dimension + 1};
+
+    constexpr float max_height{255.0f};
+    constexpr float sphere_radius{0.5f};
+
+    [[nodiscard]] std::vector<float> terrain_heights()
+    {
+        std::vector<float> rv(terrain_dimension * terrain_dimension);
+        soil::generate_2d_noise(rv,
+            terrain_dimension,
+            terrain_dimension,
+            {.scale = 256.0f, .octaves = 6});
+        for (float& height : rv)
+        {
+            height *= max_height;
+        }
+        return rv;
+    }
+
+    class [[nodiscard]] contact_counter final
+        : public btCollisionWorld::ContactResultCallback
+    {
+    public:
+        btScalar addSingleResult([[maybe_unused]] btManifoldPoint& cp,
+            [[maybe_unused]] btCollisionObjectWrapper const* colObj0Wrap,
+            [[maybe_unused]] int partId0,
+            [[maybe_unused]] int index0,
+            [[maybe_unused]] btCollisionObjectWrapper const* colObj1Wrap,
+            [[maybe_unused]] int partId1,
+            [[maybe_unused]] int index1) override
+        {
+            ++contacts;
+            return btScalar{0};
+        }
+
+    public:
+        size_t contacts{};
+    };
+
+    // Terrain collided either as a heightfield per chunk with copied
+    // heights, or as a single heightfield reading all heights in place with
+    // its accelerator built, as the terrain does in both modes
+    class [[nodiscard]] collider_world final
+    {
+    public:
+        collider_world(std::vector<float> const& heights, bool const single)
+            : dispatcher_{&collision_configuration_}
+            , world_{&dispatcher_, &broadphase_, &collision_configuration_}
+        {
+            if (single)
+            {
+                add_collider(heights.data(), terrain_dimension, 0, 0);
+                shapes_.back()->buildAccelerator();
+            }
+            else
+            {
+                chunk_heights_.resize(
+                    chunks_per_dimension * chunks_per_dimension);
+                for (size_t z{}; z != chunks_per_dimension; ++z)
+                {
+                    for (size_t x{}; x != chunks_per_dimension; ++x)
+                    {
+                        auto& chunk{
+                            chunk_heights_[z * chunks_per_dimension + x]};
+                        chunk.resize(chunk_dimension * chunk_dimension);
+                        for (size_t j{}; j != chunk_dimension; ++j)
+                        {
+                            for (size_t i{}; i != chunk_dimension; ++i)
+                            {
+                                chunk[j * chunk_dimension + i] =
+                                    heights[(z * (chunk_dimension - 1) + j) *
+                                            terrain_dimension +
+                                        x * (chunk_dimension - 1) + i];
+                            }
+                        }
+                        add_collider(chunk.data(),
+                            chunk_dimension,
+                            x * (chunk_dimension - 1),
+                            z * (chunk_dimension - 1));
+                    }
+                }
+            }
+
+            world_.updateAabbs();
+        }
+
+        collider_world(collider_world const&) = delete;
+
+        collider_world(collider_world&&) noexcept = delete;
+
+    public:
+        ~collider_world()
+        {
+            for (auto const& body : bodies_)
+            {
+                world_.removeCollisionObject(body.get());
+            }
+        }
+
+    public:
+        void cast_rays(std::span<soil::ray const> const rays,
+            std::span<soil::ray_hit> const hits)
+        {
+            soil::cast_rays(broadphase_,
+                rays,
+                hits,
+                cppext::default_thread_pool());
+        }
+
+        // Tests spheres at the positions, returns the number of contacts
+        [[nodiscard]] size_t contact_test(
+            std::span<glm::vec3 const> const positions)
+        {
+            btSphereShape shape{sphere_radius};
+            btCollisionObject object;
+            object.setCollisionShape(&shape);
+
+            contact_counter counter;
+            for (glm::vec3 const& position : positions)
+            {
+                object.setWorldTransform(
+                    btTransform{btQuaternion::getIdentity(),
+                        btVector3{position.x, position.y, position.z}});
+                world_.contactTest(&object, counter);
+            }
+            return counter.contacts;
+        }
+
+    public:
+        collider_world& operator=(collider_world const&) = delete;
+
+        collider_world& operator=(collider_world&&) noexcept = delete;
+
+    private:
+        // Heights at (x, z) of the terrain are at (x, height, z) in world
+        // space
+        void add_collider(float const* const heights,
+            size_t const dimension,
+            size_t const x,
+            size_t const z)
+        {
+            auto& shape{shapes_.emplace_back(
+                std::make_unique<soil::heightfield_shape>(dimension,
+                    heights,
+                    0.0f,
+                    max_height))};
+
+            auto const half{cppext::as_fp(dimension - 1) / 2.0f};
+            auto& body{bodies_.emplace_back(
+                std::make_unique<btRigidBody>(0.0f, nullptr, shape.get()))};
+            body->setWorldTransform(btTransform{btQuaternion::getIdentity(),
+                btVector3{cppext::as_fp(x) + half,
+                    max_height / 2.0f,
+                    cppext::as_fp(z) + half}});
+            world_.addCollisionObject(body.get());
+        }
+
+    private:
+        std::vector<std::vector<float>> chunk_heights_;
+        std::vector<std::unique_ptr<soil::heightfield_shape>> shapes_;
+
+        btDefaultCollisionConfiguration collision_configuration_;
+        btCollisionDispatcher dispatcher_;
+        btDbvtBroadphase broadphase_;
+        btCollisionWorld world_;
+
+        std::vector<std::unique_ptr<btRigidBody>> bodies_;
+    };
+
+    // Square grid of rays cast down through the whole height range, off
+    // the vertices and edges of the cells
+    [[nodiscard]] std::vector<soil::ray> ray_grid(size_t const rays_per_side)
+    {
+        auto const extent{cppext::as_fp(terrain_dimension - 1)};
+        auto const spacing{extent / cppext::as_fp(rays_per_side)};
+
+        std::vector<soil::ray> rv;
+        rv.reserve(rays_per_side * rays_per_side);
+        for (size_t z{}; z != rays_per_side; ++z)
+        {
+            for (size_t x{}; x != rays_per_side; ++x)
+            {
+                float const px{cppext::as_fp(x) * spacing + 0.25f};
+                float const pz{cppext::as_fp(z) * spacing + 0.25f};
+                rv.push_back({.from = {px, max_height + 1.0f, pz},
+                    .to = {px, -1.0f, pz}});
+            }
+        }
+        return rv;
+    }
+
+    [[nodiscard]] std::vector<glm::vec3> hit_positions(
+        std::span<soil::ray_hit const> const hits)
+    {
+        std::vector<glm::vec3> rv;
+        for (soil::ray_hit const& hit : hits)
+        {
+            if (hit.body)
+            {
+                rv.push_back(hit.position);
+            }
+        }
+        return rv;
+    }
+} // namespace
+
+TEST_CASE("terrain colliders agree", "[soil][physics]")
+{
+    std::vector<float> const heights{terrain_heights()};
+    collider_world chunked{heights, false};
+    collider_world single{heights, true};
+
+    std::vector<soil::ray> const rays{ray_grid(64)};
+    std::vector<soil::ray_hit> chunked_hits(rays.size());
+    std::vector<soil::ray_hit> single_hits(rays.size());
+    chunked.cast_rays(rays, chunked_hits);
+    single.cast_rays(rays, single_hits);
+
+    for (size_t i{}; i != rays.size(); ++i)
+    {
+        REQUIRE(chunked_hits[i].body);
+        REQUIRE(single_hits[i].body);
+        CHECK(glm::distance(chunked_hits[i].position,
+                  single_hits[i].position) < 1e-2f);
+    }
+}
+
+TEST_CASE("terrain colliders", "[soil][physics][.benchmark]")
+{
+    std::vector<float> const heights{terrain_heights()};
+    std::vector<soil::ray> const rays{ray_grid(256)};
+    std::vector<soil::ray_hit> hits(rays.size());
+
+    for (bool const single : {false, true})
+    {
+        collider_world world{heights, single};
+        std::string const name{single ? "Single" : "Chunked"};
+
+        // Spheres at hit positions overlap the terrain
+        world.cast_rays(rays, hits);
+        std::vector<glm::vec3> const positions{hit_positions(hits)};
+        WARN(name << ": " << positions.size() << " hits, "
+                  << world.contact_test(positions) << " contacts");
+
+        BENCHMARK(name + " " + std::to_string(rays.size()) + " rays")
+        {
+            world.cast_rays(rays, hits);
+            return hits.front().body;
+        };
+
+        BENCHMARK(name + " " + std::to_string(positions.size()) +
+            " contact tests")
+        {
+            return world.contact_test(positions);
+        };
+    }
+}
@@ -0,0 +1,184 @@
+#include <noise.hpp>
+#include <terrain_lod.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t dimension{17};
+    constexpr uint32_t lod_levels{4};
+
+    // Twice the signed area of a triangle of grid vertices
+    [[nodiscard]] int64_t doubled_area(uint32_t const a,
+        uint32_t const b,
+        uint32_t const c)
+    {
+        auto const x = [](uint32_t const i)
+        { return static_cast<int64_t>(i % dimension); };
+        auto const z = [](uint32_t const i)
+        { return static_cast<int64_t>(i / dimension); };
+
+        return (x(b) - x(a)) * (z(c) - z(a)) - (x(c) - x(a)) * (z(b) - z(a));
+    }
+} // namespace
+
+TEST_CASE("chunk_lod_errors flat", "[soil][terrain_lod]")
+{
+    std::vector<float> const flat(dimension * dimension, 3.0f);
+    auto const errors{soil::chunk_lod_errors(flat, dimension, lod_levels)};
+
+    REQUIRE(errors.size() == lod_levels + 1);
+    for (float const error : errors)
+    {
+        CHECK(error == 0.0f);
+    }
+
+    // Triangles of every LOD lie in an inclined plane as well
+    std::vector<float> plane(dimension * dimension);
+    for (size_t z{}; z != dimension; ++z)
+    {
+        for (size_t x{}; x != dimension; ++x)
+        {
+            plane[z * dimension + x] =
+                0.5f * cppext::as_fp(x) + 0.25f * cppext::as_fp(z);
+        }
+    }
+    for (float const error :
+        soil::chunk_lod_errors(plane, dimension, lod_levels))
+    {
+        CHECK(error == 0.0f);
+    }
+}
+
+TEST_CASE("chunk_lod_errors bump", "[soil][terrain_lod]")
+{
+    // Vertex (2, 2) is kept by LOD 1, its neighbours between the vertices of
+    // LOD 1 are interpolated halfway up to it. LOD 2 drops it.
+    std::vector<float> heights(dimension * dimension);
+    heights[2 * dimension + 2] = 1.0f;
+
+    auto const errors{soil::chunk_lod_errors(heights, dimension, lod_levels)};
+    std::vector<float> const expected{0.0f, 0.5f, 1.0f, 1.0f, 1.0f};
+    CHECK(errors == expected);
+}
+
+TEST_CASE("chunk_lod_errors increase", "[soil][terrain_lod]")
+{
+    std::vector<float> heights(dimension * dimension);
+    soil::generate_2d_noise(heights,
+        dimension,
+        dimension,
+        {.scale = 8.0f, .octaves = 4});
+
+    auto const errors{soil::chunk_lod_errors(heights, dimension, lod_levels)};
+    REQUIRE(errors.size() == lod_levels + 1);
+    CHECK(errors[0] == 0.0f);
+    for (uint32_t lod{1}; lod <= lod_levels; ++lod)
+    {
+        CHECK(errors[lod] >= errors[lod - 1]);
+    }
+    CHECK(errors[lod_levels] > 0.0f);
+}
+
+TEST_CASE("chunk_lod_indices stitching", "[soil][terrain_lod]")
+{
+    constexpr int64_t whole_area{2 * (dimension - 1) * (dimension - 1)};
+
+    for (uint32_t lod{}; lod != 4; ++lod)
+    {
+        uint32_t const step{1u << lod};
+        auto const unstitched{soil::chunk_lod_indices(dimension, lod, 0)};
+
+        for (uint32_t edges{}; edges != soil::edge_combinations; ++edges)
+        {
+            auto const indices{soil::chunk_lod_indices(dimension, lod, edges)};
+            REQUIRE(indices.size() == unstitched.size());
+
+            // Triangles keep their winding and still cover the chunk
+            int64_t area{};
+            for (size_t i{}; i != indices.size(); i += 3)
+            {
+                int64_t const triangle{
+                    doubled_area(indices[i], indices[i + 1], indices[i + 2])};
+                CHECK(triangle <= 0);
+                area -= triangle;
+            }
+            CHECK(area == whole_area);
+
+            // Stitched edges use only vertices of the next coarser LOD
+            for (uint32_t const index : indices)
+            {
+                uint32_t const x{index % dimension};
+                uint32_t const z{index / dimension};
+                bool const min_x{x == 0 && (edges & soil::edge_min_x)};
+                bool const max_x{
+                    x == dimension - 1 && (edges & soil::edge_max_x)};
+                bool const min_z{z == 0 && (edges & soil::edge_min_z)};
+                bool const max_z{
+                    z == dimension - 1 && (edges & soil::edge_max_z)};
+
+                if (min_x || max_x)
+                {
+                    CHECK(z % (2 * step) == 0);
+                }
+                if (min_z || max_z)
+                {
+                    CHECK(x % (2 * step) == 0);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("limit_lod_difference", "[soil][terrain_lod]")
+{
+    // clang-format off
+    std::vector<uint32_t> lods{
+        0, 4, 4, 4,
+        4, 4, 4, 4,
+        4, 4, 4, 4,
+        4, 4, 4, 2};
+    // clang-format on
+
+    soil::limit_lod_difference(lods, 4);
+
+    // clang-format off
+    std::vector<uint32_t> const expected{
+        0, 1, 2, 3,
+        1, 2, 3, 4,
+        2, 3, 4, 3,
+        3, 4, 3, 2};
+    // clang-format on
+    CHECK(lods == expected);
+
+    for (size_t z{}; z != 4; ++z)
+    {
+        for (size_t x{}; x != 4; ++x)
+        {
+            uint32_t const lod{lods[z * 4 + x]};
+            if (x != 3)
+            {
+                CHECK(std::abs(static_cast<int>(lod) -
+                          static_cast<int>(lods[z * 4 + x + 1])) <= 1);
+            }
+            if (z != 3)
+            {
+                CHECK(std::abs(static_cast<int>(lod) -
+                          static_cast<int>(lods[(z + 1) * 4 + x])) <= 1);
+            }
+        }
+    }
+
+    CHECK(soil::stitched_edges(lods, 4, 0, 0) ==
+        (soil::edge_max_x | soil::edge_max_z));
+    CHECK(soil::stitched_edges(lods, 4, 3, 3) ==
+        (soil::edge_min_x | soil::edge_min_z));
+    CHECK(soil::stitched_edges(lods, 4, 2, 2) == 0);
+}
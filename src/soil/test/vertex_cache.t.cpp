@@ -0,0 +1,89 @@
+#include <terrain_lod.hpp>
+#include <vertex_cache.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t dimension{65};
+    constexpr uint32_t lod_levels{5};
+
+    using triangle = std::array<uint32_t, 3>;
+
+    // Triangles rotated to start at their smallest index, which keeps the
+    // winding, sorted
+    [[nodiscard]] std::vector<triangle> sorted_triangles(
+        std::vector<uint32_t> const& indices)
+    {
+        std::vector<triangle> rv;
+        for (size_t i{}; i != indices.size(); i += 3)
+        {
+            triangle t{indices[i], indices[i + 1], indices[i + 2]};
+            std::ranges::rotate(t, std::ranges::min_element(t));
+            rv.push_back(t);
+        }
+        std::ranges::sort(rv);
+        return rv;
+    }
+} // namespace
+
+TEST_CASE("optimize_vertex_cache keeps triangles", "[soil][vertex_cache]")
+{
+    for (uint32_t lod{}; lod != lod_levels; ++lod)
+    {
+        for (uint32_t edges{}; edges != soil::edge_combinations; ++edges)
+        {
+            auto const indices{soil::chunk_lod_indices(dimension, lod, edges)};
+            auto optimized{indices};
+            soil::optimize_vertex_cache(optimized, dimension * dimension);
+
+            REQUIRE(optimized.size() == indices.size());
+            CHECK(sorted_triangles(optimized) == sorted_triangles(indices));
+        }
+    }
+}
+
+TEST_CASE("optimize_vertex_cache improves terrain LODs",
+    "[soil][vertex_cache]")
+{
+    for (uint32_t lod{}; lod != lod_levels; ++lod)
+    {
+        CAPTURE(lod);
+
+        auto indices{soil::chunk_lod_indices(dimension, lod, 0)};
+        auto const before{
+            soil::analyze_vertex_cache(indices, dimension * dimension)};
+        soil::optimize_vertex_cache(indices, dimension * dimension);
+        auto const after{
+            soil::analyze_vertex_cache(indices, dimension * dimension)};
+
+        // Rows of the coarsest LODs fit into the cache, every vertex is
+        // already transformed once
+        if (before.atvr > 1.0f)
+        {
+            CHECK(after.acmr < before.acmr);
+        }
+        else
+        {
+            CHECK(after.acmr <= before.acmr);
+        }
+        CHECK(after.atvr >= 1.0f);
+    }
+}
+
+TEST_CASE("analyze_vertex_cache", "[soil][vertex_cache]")
+{
+    // Two triangles sharing an edge, then the first one again after a
+    // third triangle pushed its vertices out of a cache of four entries
+    std::vector<uint32_t> const indices{0, 1, 2, 2, 1, 3, 4, 5, 6, 0, 1, 2};
+    auto const statistics{soil::analyze_vertex_cache(indices, 7, 4)};
+
+    CHECK(statistics.acmr == 10.0f / 4.0f);
+    CHECK(statistics.atvr == 10.0f / 7.0f);
+}
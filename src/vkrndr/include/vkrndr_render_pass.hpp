@@ -43,8 +43,11 @@ namespace vkrndr
         ~render_pass() = default;
 
     public:
+        // Contents have to be recorded into secondary command buffers when
+        // VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT is set
         [[nodiscard]] render_pass_guard begin(VkCommandBuffer command_buffer,
-            VkRect2D const& render_area) const;
+            VkRect2D const& render_area,
+            VkRenderingFlags flags = 0) const;
 
         render_pass& with_color_attachment(VkAttachmentLoadOp load_operation,
             VkAttachmentStoreOp store_operation,
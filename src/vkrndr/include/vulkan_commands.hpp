@@ -13,6 +13,15 @@ namespace vkrndr
 
 namespace vkrndr
 {
+    // Attachments of a dynamic render pass which secondary command buffers
+    // continue
+    struct [[nodiscard]] rendering_inheritance final
+    {
+        VkFormat color_format{VK_FORMAT_UNDEFINED};
+        VkFormat depth_format{VK_FORMAT_UNDEFINED};
+        VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+    };
+
     void create_command_buffers(vkrndr::vulkan_device const* device,
         VkCommandPool command_pool,
         uint32_t count,
@@ -24,6 +33,13 @@ namespace vkrndr
         uint32_t count,
         std::span<VkCommandBuffer> buffers);
 
+    // Buffers which are executed more than once are begun without
+    // VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT in usage
+    void begin_secondary_command_buffer(VkCommandBuffer command_buffer,
+        rendering_inheritance const& inheritance,
+        VkCommandBufferUsageFlags usage =
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
     void end_single_time_commands(vulkan_device const* device,
         VkQueue queue,
         std::span<VkCommandBuffer> command_buffers,
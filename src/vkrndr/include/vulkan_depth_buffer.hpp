@@ -14,7 +14,8 @@ namespace vkrndr
 {
     vulkan_image create_depth_buffer(vulkan_device* device,
         VkExtent2D extent,
-        bool with_stencil_component);
+        bool with_stencil_component,
+        VkImageUsageFlags additional_usage = 0);
 
     [[nodiscard]] bool has_stencil_component(VkFormat format);
 } // namespace vkrndr
@@ -21,6 +21,7 @@ namespace vkrndr
         VkPhysicalDevice physical{VK_NULL_HANDLE};
         VkDevice logical{VK_NULL_HANDLE};
         VkSampleCountFlagBits max_msaa_samples{VK_SAMPLE_COUNT_1_BIT};
+        bool tessellation_shader{false};
         std::vector<vulkan_queue> queues;
         vulkan_queue* transfer_queue{nullptr};
         vulkan_queue* present_queue{nullptr};
@@ -20,6 +20,7 @@ namespace vkrndr
         VmaAllocation allocation{VK_NULL_HANDLE};
         VkImageView view{VK_NULL_HANDLE};
         VkFormat format{};
+        VkExtent2D extent{};
         uint32_t mip_levels{1};
     };
 
@@ -114,6 +114,10 @@ namespace vkrndr
         vulkan_pipeline_builder& with_primitive_topology(
             VkPrimitiveTopology primitive_topology);
 
+        // Requires VK_PRIMITIVE_TOPOLOGY_PATCH_LIST topology
+        vulkan_pipeline_builder& with_tessellation(
+            uint32_t patch_control_points);
+
         vulkan_pipeline_builder& with_color_blending(
             VkPipelineColorBlendAttachmentState color_blending);
 
@@ -142,6 +146,7 @@ namespace vkrndr
         VkPrimitiveTopology primitive_topology_{
             VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST};
         VkFormat image_format_{};
+        uint32_t patch_control_points_{};
         std::vector<
             std::tuple<VkShaderStageFlagBits, VkShaderModule, std::string>>
             shaders_;
@@ -155,6 +160,45 @@ namespace vkrndr
         std::optional<VkPipelineDepthStencilStateCreateInfo> depth_stencil_;
         std::vector<VkDynamicState> dynamic_states_;
     };
+
+    class [[nodiscard]] vulkan_compute_pipeline_builder final
+    {
+    public: // Construction
+        vulkan_compute_pipeline_builder(vulkan_device* device,
+            std::shared_ptr<VkPipelineLayout> pipeline_layout);
+
+        vulkan_compute_pipeline_builder(
+            vulkan_compute_pipeline_builder const&) = delete;
+
+        vulkan_compute_pipeline_builder(
+            vulkan_compute_pipeline_builder&&) noexcept = delete;
+
+    public: // Destruction
+        ~vulkan_compute_pipeline_builder();
+
+    public: // Interface
+        [[nodiscard]] vulkan_pipeline build();
+
+        vulkan_compute_pipeline_builder& with_shader(
+            std::filesystem::path const& path,
+            std::string_view entry_point);
+
+    public: // Operators
+        vulkan_compute_pipeline_builder& operator=(
+            vulkan_compute_pipeline_builder const&) = delete;
+
+        vulkan_compute_pipeline_builder& operator=(
+            vulkan_compute_pipeline_builder&&) noexcept = delete;
+
+    private: // Helpers
+        void cleanup();
+
+    private: // Data
+        vulkan_device* device_{};
+        std::shared_ptr<VkPipelineLayout> pipeline_layout_;
+        VkShaderModule shader_{VK_NULL_HANDLE};
+        std::string entry_point_;
+    };
 } // namespace vkrndr
 
 #endif // !VKRNDR_VULKAN_PIPELINE_INCLUDED
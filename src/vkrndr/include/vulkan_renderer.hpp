@@ -6,12 +6,14 @@
 #include <vulkan/vulkan_core.h>
 
 #include <gltf_manager.hpp>
+#include <vulkan_commands.hpp>
 #include <vulkan_font.hpp>
 #include <vulkan_image.hpp>
 
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <span>
 #include <vector>
@@ -59,12 +61,36 @@ namespace vkrndr
 
         void imgui_layer(bool state);
 
+        // Builds the ImGui frame drawn by the next draw call. Has to be called
+        // from the thread polling window events while no frame is drawn.
+        void build_imgui_frame(scene* scene);
+
         [[nodiscard]] bool begin_frame(scene* scene);
 
         void end_frame();
 
         void draw(scene* scene);
 
+        // Number of the frame recorded between begin_frame and end_frame,
+        // counts frames drawn so far
+        [[nodiscard]] uint64_t frame_number() const;
+
+        // True once the GPU has finished executing the frame
+        [[nodiscard]] bool frame_finished(uint64_t frame_number) const;
+
+        // Threads across which secondary command buffer recording is split
+        [[nodiscard]] uint32_t recording_threads() const;
+
+        // Records count secondary command buffers continuing the render pass
+        // of primary_buffer and executes them in order of their index. The
+        // render pass has to be begun with secondary command buffer contents.
+        // Callback is invoked concurrently from the default thread pool, each
+        // range of indices records into buffers from its own command pool.
+        void record_secondary(VkCommandBuffer primary_buffer,
+            rendering_inheritance const& inheritance,
+            uint32_t count,
+            std::function<void(VkCommandBuffer, uint32_t)> const& record);
+
         [[nodiscard]] vulkan_image load_texture(
             std::filesystem::path const& texture_path,
             VkFormat format);
@@ -96,6 +122,13 @@ namespace vkrndr
         vulkan_renderer& operator=(vulkan_renderer&&) noexcept = delete;
 
     private: // Types
+        struct [[nodiscard]] secondary_pool final
+        {
+            VkCommandPool command_pool{VK_NULL_HANDLE};
+            std::vector<VkCommandBuffer> command_buffers;
+            size_t used_command_buffers{};
+        };
+
         struct [[nodiscard]] frame_data final
         {
             vulkan_queue* present_queue{};
@@ -107,12 +140,18 @@ namespace vkrndr
             VkCommandPool transfer_command_pool{VK_NULL_HANDLE};
             std::vector<VkCommandBuffer> transfer_command_buffers;
             size_t used_transfer_command_buffers{};
+
+            // One pool per range of recorded indices
+            std::vector<secondary_pool> secondary_pools;
         };
 
     private:
         [[nodiscard]] VkCommandBuffer request_command_buffer(
             bool transfer_only);
 
+        [[nodiscard]] VkCommandBuffer request_secondary_command_buffer(
+            secondary_pool& pool);
+
     private: // Data
         vulkan_window* window_;
         vulkan_context* context_;
@@ -129,6 +168,8 @@ namespace vkrndr
         std::unique_ptr<gltf_manager> gltf_manager_;
 
         uint32_t image_index_{};
+        uint32_t recording_threads_{};
+        uint64_t frame_number_{};
     };
 } // namespace vkrndr
 
@@ -12,11 +12,6 @@
 
 #include <imgui.h>
 
-#include <spdlog/spdlog.h>
-
-#include <cassert>
-#include <utility>
-
 // IWYU pragma: no_include <span>
 
 namespace
@@ -104,6 +99,8 @@ vkrndr::imgui_render_layer::imgui_render_layer(
 
 vkrndr::imgui_render_layer::~imgui_render_layer()
 {
+    release_draw_data();
+
     ImGui_ImplVulkan_Shutdown();
     window_->shutdown_imgui();
     ImGui::DestroyContext();
@@ -113,13 +110,25 @@ vkrndr::imgui_render_layer::~imgui_render_layer()
 
 void vkrndr::imgui_render_layer::begin_frame()
 {
-    assert(std::exchange(frame_rendered_, false));
-
     ImGui_ImplVulkan_NewFrame();
     window_->new_imgui_frame();
     ImGui::NewFrame();
 }
 
+void vkrndr::imgui_render_layer::end_frame()
+{
+    ImGui::Render();
+
+    // Draw lists of the context are reset by the next frame, rendering
+    // thread records from copies
+    release_draw_data();
+    draw_data_ = *ImGui::GetDrawData();
+    for (ImDrawList*& list : draw_data_.CmdLists)
+    {
+        list = list->CloneOutput();
+    }
+}
+
 void vkrndr::imgui_render_layer::draw(VkCommandBuffer command_buffer,
     VkImage target_image,
     VkImageView target_image_view,
@@ -150,8 +159,10 @@ void vkrndr::imgui_render_layer::draw(VkCommandBuffer command_buffer,
 
     vkCmdBeginRendering(command_buffer, &render_info);
 
-    render();
-    ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), command_buffer);
+    if (draw_data_.Valid)
+    {
+        ImGui_ImplVulkan_RenderDrawData(&draw_data_, command_buffer);
+    }
 
     vkCmdEndRendering(command_buffer);
 
@@ -160,17 +171,11 @@ void vkrndr::imgui_render_layer::draw(VkCommandBuffer command_buffer,
     check_result(vkEndCommandBuffer(command_buffer));
 }
 
-void vkrndr::imgui_render_layer::end_frame()
+void vkrndr::imgui_render_layer::release_draw_data()
 {
-    if (!std::exchange(frame_rendered_, true))
+    for (ImDrawList* const list : draw_data_.CmdLists)
     {
-        spdlog::info("Ending ImGui frame without matching draw call");
-        render();
+        IM_DELETE(list);
     }
-}
-
-void vkrndr::imgui_render_layer::render()
-{
-    ImGui::Render();
-    frame_rendered_ = true;
+    draw_data_.Clear();
 }
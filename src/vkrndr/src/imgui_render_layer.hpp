@@ -1,6 +1,8 @@
 #ifndef VKRNDR_IMGUI_RENDER_LAYER_INCLUDED
 #define VKRNDR_IMGUI_RENDER_LAYER_INCLUDED
 
+#include <imgui.h>
+
 #include <vulkan/vulkan_core.h>
 
 namespace vkrndr
@@ -29,22 +31,27 @@ namespace vkrndr
         ~imgui_render_layer();
 
     public: // Interface
+        // Starts a new ImGui frame, called on the thread polling window
+        // events
         void begin_frame();
 
+        // Finishes the ImGui frame and keeps a copy of its draw data
+        void end_frame();
+
+        // Records the draw data copied by the last end_frame, can be called
+        // from another thread as long as it doesn't overlap end_frame
         void draw(VkCommandBuffer command_buffer,
             VkImage target_image,
             VkImageView target_image_view,
             VkExtent2D extent);
 
-        void end_frame();
-
     public:
         imgui_render_layer& operator=(imgui_render_layer const&) = delete;
 
         imgui_render_layer& operator=(imgui_render_layer&&) noexcept = delete;
 
     private:
-        void render();
+        void release_draw_data();
 
     private: // Data
         vulkan_window* window_;
@@ -52,7 +59,8 @@ namespace vkrndr
 
         VkDescriptorPool descriptor_pool_;
 
-        bool frame_rendered_{true};
+        // Owns cloned draw lists of the last finished frame
+        ImDrawData draw_data_;
     };
 } // namespace vkrndr
 
@@ -25,10 +25,12 @@ vkrndr::render_pass_guard::~render_pass_guard()
 
 vkrndr::render_pass_guard vkrndr::render_pass::begin(
     VkCommandBuffer command_buffer,
-    VkRect2D const& render_area) const
+    VkRect2D const& render_area,
+    VkRenderingFlags const flags) const
 {
     VkRenderingInfo render_info{};
     render_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    render_info.flags = flags;
     render_info.renderArea = render_area;
     render_info.layerCount = 1;
     render_info.colorAttachmentCount = count_cast(color_attachments_.size());
@@ -86,6 +86,31 @@ void vkrndr::begin_single_time_commands(vulkan_device const* const device,
     }
 }
 
+void vkrndr::begin_secondary_command_buffer(
+    VkCommandBuffer const command_buffer,
+    rendering_inheritance const& inheritance,
+    VkCommandBufferUsageFlags const usage)
+{
+    VkCommandBufferInheritanceRenderingInfo rendering_info{};
+    rendering_info.sType =
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+    rendering_info.colorAttachmentCount = 1;
+    rendering_info.pColorAttachmentFormats = &inheritance.color_format;
+    rendering_info.depthAttachmentFormat = inheritance.depth_format;
+    rendering_info.rasterizationSamples = inheritance.samples;
+
+    VkCommandBufferInheritanceInfo inheritance_info{};
+    inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_info.pNext = &rendering_info;
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = usage | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance_info;
+
+    check_result(vkBeginCommandBuffer(command_buffer, &begin_info));
+}
+
 void vkrndr::end_single_time_commands(vulkan_device const* const device,
     VkQueue const queue,
     std::span<VkCommandBuffer> const command_buffers,
@@ -84,7 +84,8 @@ bool vkrndr::has_stencil_component(VkFormat format)
 
 vkrndr::vulkan_image vkrndr::create_depth_buffer(vulkan_device* const device,
     VkExtent2D const extent,
-    bool const with_stencil_component)
+    bool const with_stencil_component,
+    VkImageUsageFlags const additional_usage)
 {
     VkFormat const depth_format{
         find_depth_format(device->physical, with_stencil_component)};
@@ -94,7 +95,7 @@ vkrndr::vulkan_image vkrndr::create_depth_buffer(vulkan_device* const device,
         device->max_msaa_samples,
         depth_format,
         VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | additional_usage,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         VK_IMAGE_ASPECT_DEPTH_BIT);
 }
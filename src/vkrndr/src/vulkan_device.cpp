@@ -152,6 +152,14 @@ vkrndr::vulkan_device vkrndr::create_device(vulkan_context const& context)
     rv.physical = *device_it;
     rv.max_msaa_samples = max_usable_sample_count(rv.physical);
 
+    // Optional features are enabled only when supported
+    VkPhysicalDeviceFeatures supported_features; // NOLINT
+    vkGetPhysicalDeviceFeatures(rv.physical, &supported_features);
+    VkPhysicalDeviceFeatures enabled_features{device_features};
+    enabled_features.tessellationShader =
+        supported_features.tessellationShader;
+    rv.tessellation_shader = supported_features.tessellationShader == VK_TRUE;
+
     auto const present_family{device_indices.present_family.value_or(0)};
     auto const transfer_family{
         device_indices.dedicated_transfer_family.value_or(present_family)};
@@ -177,7 +185,7 @@ vkrndr::vulkan_device vkrndr::create_device(vulkan_context const& context)
     create_info.enabledLayerCount = 0;
     create_info.enabledExtensionCount = count_cast(device_extensions.size());
     create_info.ppEnabledExtensionNames = device_extensions.data();
-    create_info.pEnabledFeatures = &device_features;
+    create_info.pEnabledFeatures = &enabled_features;
     create_info.pNext = &device_13_features;
 
     check_result(
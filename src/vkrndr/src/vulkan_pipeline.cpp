@@ -191,6 +191,11 @@ vkrndr::vulkan_pipeline vkrndr::vulkan_pipeline_builder::build()
     input_assembly.topology = primitive_topology_;
     input_assembly.primitiveRestartEnable = VK_FALSE;
 
+    VkPipelineTessellationStateCreateInfo tessellation_state{};
+    tessellation_state.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO;
+    tessellation_state.patchControlPoints = patch_control_points_;
+
     VkPipelineViewportStateCreateInfo viewport_state{};
     viewport_state.sType =
         VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -257,6 +262,10 @@ vkrndr::vulkan_pipeline vkrndr::vulkan_pipeline_builder::build()
     create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     create_info.pVertexInputState = &vertex_input_info;
     create_info.pInputAssemblyState = &input_assembly;
+    if (patch_control_points_ != 0)
+    {
+        create_info.pTessellationState = &tessellation_state;
+    }
     create_info.pRasterizationState = &rasterizer;
     create_info.pColorBlendState = &color_blending;
     create_info.pMultisampleState = &multisampling;
@@ -346,6 +355,16 @@ vkrndr::vulkan_pipeline_builder::with_primitive_topology(
     return *this;
 }
 
+vkrndr::vulkan_pipeline_builder&
+vkrndr::vulkan_pipeline_builder::with_tessellation(
+    uint32_t const patch_control_points)
+{
+    assert(patch_control_points > 0);
+    patch_control_points_ = patch_control_points;
+
+    return *this;
+}
+
 vkrndr::vulkan_pipeline_builder&
 vkrndr::vulkan_pipeline_builder::with_color_blending(
     VkPipelineColorBlendAttachmentState const color_blending)
@@ -452,3 +471,72 @@ void vkrndr::vulkan_pipeline_builder::cleanup()
 
     pipeline_layout_.reset();
 }
+
+vkrndr::vulkan_compute_pipeline_builder::vulkan_compute_pipeline_builder(
+    vulkan_device* const device,
+    std::shared_ptr<VkPipelineLayout> pipeline_layout)
+    : device_{device}
+    , pipeline_layout_{std::move(pipeline_layout)}
+{
+}
+
+vkrndr::vulkan_compute_pipeline_builder::~vulkan_compute_pipeline_builder()
+{
+    cleanup();
+}
+
+vkrndr::vulkan_pipeline vkrndr::vulkan_compute_pipeline_builder::build()
+{
+    assert(shader_ != VK_NULL_HANDLE);
+
+    VkPipelineShaderStageCreateInfo stage_info{};
+    stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stage_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    stage_info.module = shader_;
+    stage_info.pName = entry_point_.c_str();
+
+    VkComputePipelineCreateInfo create_info{};
+    create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    create_info.stage = stage_info;
+    create_info.layout = *pipeline_layout_;
+
+    VkPipeline pipeline; // NOLINT
+    check_result(vkCreateComputePipelines(device_->logical,
+        VK_NULL_HANDLE,
+        1,
+        &create_info,
+        nullptr,
+        &pipeline));
+
+    vulkan_pipeline rv{pipeline_layout_, pipeline};
+
+    cleanup();
+
+    return rv;
+}
+
+vkrndr::vulkan_compute_pipeline_builder&
+vkrndr::vulkan_compute_pipeline_builder::with_shader(
+    std::filesystem::path const& path,
+    std::string_view entry_point)
+{
+    if (shader_ != VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(device_->logical, shader_, nullptr);
+    }
+
+    shader_ = create_shader_module(device_->logical, read_file(path));
+    entry_point_ = entry_point;
+    return *this;
+}
+
+void vkrndr::vulkan_compute_pipeline_builder::cleanup()
+{
+    if (shader_ != VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(device_->logical, shader_, nullptr);
+        shader_ = VK_NULL_HANDLE;
+    }
+
+    pipeline_layout_.reset();
+}
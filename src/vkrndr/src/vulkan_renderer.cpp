@@ -18,17 +18,20 @@
 
 #include <cppext_cycled_buffer.hpp>
 #include <cppext_numeric.hpp>
+#include <cppext_thread_pool.hpp>
 
 #include <stb_image.h>
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <cstring>
+#include <functional>
 #include <span>
 #include <stdexcept>
 #include <utility>
 #include <vector>
 
-// IWYU pragma: no_include <functional>
 // IWYU pragma: no_include <unordered_map>
 
 namespace
@@ -41,27 +44,33 @@ namespace
 
         VkDescriptorPoolSize uniform_buffer_pool_size{};
         uniform_buffer_pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        uniform_buffer_pool_size.descriptorCount = 3 * count;
+        uniform_buffer_pool_size.descriptorCount = 4 * count;
 
         VkDescriptorPoolSize storage_buffer_pool_size{};
         storage_buffer_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        storage_buffer_pool_size.descriptorCount = 6 * count;
+        storage_buffer_pool_size.descriptorCount = 20 * count;
 
         VkDescriptorPoolSize texture_sampler_pool_size{};
         texture_sampler_pool_size.type =
             VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        texture_sampler_pool_size.descriptorCount = 2 * count;
+        texture_sampler_pool_size.descriptorCount = 4 * count;
+
+        // Each level of a depth pyramid uses its own set
+        VkDescriptorPoolSize storage_image_pool_size{};
+        storage_image_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        storage_image_pool_size.descriptorCount = 16 * count;
 
         std::array pool_sizes{uniform_buffer_pool_size,
             storage_buffer_pool_size,
-            texture_sampler_pool_size};
+            texture_sampler_pool_size,
+            storage_image_pool_size};
 
         VkDescriptorPoolCreateInfo pool_info{};
         pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
         pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
         pool_info.poolSizeCount = vkrndr::count_cast(pool_sizes.size());
         pool_info.pPoolSizes = pool_sizes.data();
-        pool_info.maxSets = 4 * count + count;
+        pool_info.maxSets = 24 * count;
 
         VkDescriptorPool rv{};
         vkrndr::check_result(
@@ -85,9 +94,18 @@ vkrndr::vulkan_renderer::vulkan_renderer(vulkan_window* const window,
     , descriptor_pool_{create_descriptor_pool(device)}
     , font_manager_{std::make_unique<font_manager>()}
     , gltf_manager_{std::make_unique<gltf_manager>(this)}
+    , recording_threads_{cppext::narrow<uint32_t>(
+          cppext::default_thread_pool().thread_count())}
 {
     for (frame_data& fd : frame_data_.as_span())
     {
+        fd.secondary_pools.resize(recording_threads_);
+        for (secondary_pool& pool : fd.secondary_pools)
+        {
+            pool.command_pool =
+                create_command_pool(device, device_->present_queue->family);
+        }
+
         fd.present_queue = device_->present_queue;
         fd.present_command_pool =
             create_command_pool(device, fd.present_queue->family);
@@ -112,6 +130,13 @@ vkrndr::vulkan_renderer::~vulkan_renderer()
 
     for (frame_data const& fd : frame_data_.as_span())
     {
+        for (secondary_pool const& pool : fd.secondary_pools)
+        {
+            vkDestroyCommandPool(device_->logical,
+                pool.command_pool,
+                nullptr);
+        }
+
         if (fd.present_queue != fd.transfer_queue)
         {
             vkDestroyCommandPool(device_->logical,
@@ -163,6 +188,16 @@ void vkrndr::vulkan_renderer::imgui_layer(bool const state)
     }
 }
 
+void vkrndr::vulkan_renderer::build_imgui_frame(scene* const scene)
+{
+    if (imgui_layer_)
+    {
+        imgui_layer_->begin_frame();
+        scene->draw_imgui();
+        imgui_layer_->end_frame();
+    }
+}
+
 bool vkrndr::vulkan_renderer::begin_frame(scene* const scene)
 {
     if (swap_chain_refresh.load())
@@ -195,27 +230,22 @@ bool vkrndr::vulkan_renderer::begin_frame(scene* const scene)
     wait_for_color_attachment_write(swap_chain_->image(image_index_),
         primary_buffer);
 
-    if (imgui_layer_)
-    {
-        imgui_layer_->begin_frame();
-    }
-
     return true;
 }
 
 void vkrndr::vulkan_renderer::end_frame()
 {
-    if (imgui_layer_)
-    {
-        imgui_layer_->end_frame();
-    }
-
     frame_data_.cycle(
         [](frame_data& fd, frame_data const&)
         {
             fd.used_present_command_buffers_ = 0;
             fd.used_transfer_command_buffers = 0;
+            for (secondary_pool& pool : fd.secondary_pools)
+            {
+                pool.used_command_buffers = 0;
+            }
         });
+    ++frame_number_;
 }
 
 void vkrndr::vulkan_renderer::draw(scene* const scene)
@@ -229,7 +259,6 @@ void vkrndr::vulkan_renderer::draw(scene* const scene)
 
     if (imgui_layer_)
     {
-        scene->draw_imgui();
         VkCommandBuffer imgui_command_buffer{request_command_buffer(false)};
         imgui_layer_->draw(imgui_command_buffer,
             swap_chain_->image(image_index_),
@@ -249,6 +278,74 @@ void vkrndr::vulkan_renderer::draw(scene* const scene)
         image_index_);
 }
 
+uint64_t vkrndr::vulkan_renderer::frame_number() const
+{
+    return frame_number_;
+}
+
+bool vkrndr::vulkan_renderer::frame_finished(
+    uint64_t const frame_number) const
+{
+    if (frame_number >= frame_number_)
+    {
+        return false;
+    }
+
+    // Frame using the same resources was begun and ended since, acquiring
+    // them waited for the frame
+    constexpr uint64_t frames{vulkan_swap_chain::max_frames_in_flight};
+    if (frame_number_ - frame_number > frames)
+    {
+        return true;
+    }
+
+    return swap_chain_->submission_finished(frame_number % frames);
+}
+
+uint32_t vkrndr::vulkan_renderer::recording_threads() const
+{
+    return recording_threads_;
+}
+
+void vkrndr::vulkan_renderer::record_secondary(VkCommandBuffer primary_buffer,
+    rendering_inheritance const& inheritance,
+    uint32_t const count,
+    std::function<void(VkCommandBuffer, uint32_t)> const& record)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::vector<VkCommandBuffer> buffers(count);
+
+    uint32_t const threads{std::min(count, recording_threads_)};
+    uint32_t const per_thread{(count + threads - 1) / threads};
+
+    // Ranges are recorded by whichever thread picks them up, a command pool
+    // belongs to a range instead of a thread
+    cppext::parallel_for(cppext::default_thread_pool(),
+        0,
+        count,
+        per_thread,
+        [&](size_t const first, size_t const last)
+        {
+            secondary_pool& pool{
+                frame_data_->secondary_pools[first / per_thread]};
+            for (size_t index{first}; index != last; ++index)
+            {
+                VkCommandBuffer const buffer{
+                    request_secondary_command_buffer(pool)};
+                begin_secondary_command_buffer(buffer, inheritance);
+                record(buffer, cppext::narrow<uint32_t>(index));
+                check_result(vkEndCommandBuffer(buffer));
+                buffers[index] = buffer;
+            }
+        });
+
+    vkCmdExecuteCommands(primary_buffer, count, buffers.data());
+}
+
 vkrndr::vulkan_image vkrndr::vulkan_renderer::load_texture(
     std::filesystem::path const& texture_path,
     VkFormat const format)
@@ -496,3 +593,22 @@ VkCommandBuffer vkrndr::vulkan_renderer::request_command_buffer(
     check_result(vkResetCommandBuffer(rv, 0));
     return rv;
 }
+
+VkCommandBuffer vkrndr::vulkan_renderer::request_secondary_command_buffer(
+    secondary_pool& pool)
+{
+    if (pool.used_command_buffers == pool.command_buffers.size())
+    {
+        pool.command_buffers.resize(pool.command_buffers.size() + 1);
+
+        create_command_buffers(device_,
+            pool.command_pool,
+            1,
+            VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            std::span{&pool.command_buffers.back(), 1});
+    }
+
+    VkCommandBuffer rv{pool.command_buffers[pool.used_command_buffers++]};
+    check_result(vkResetCommandBuffer(rv, 0));
+    return rv;
+}
@@ -184,6 +184,19 @@ void vkrndr::vulkan_swap_chain::submit_command_buffers(
     check_result(result);
 }
 
+bool vkrndr::vulkan_swap_chain::submission_finished(
+    size_t const current_frame) const
+{
+    VkResult const result{
+        vkGetFenceStatus(device_->logical, frames_[current_frame].in_flight)};
+    if (result == VK_NOT_READY)
+    {
+        return false;
+    }
+    check_result(result);
+    return true;
+}
+
 void vkrndr::vulkan_swap_chain::recreate()
 {
     cleanup();
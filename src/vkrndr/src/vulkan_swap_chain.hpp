@@ -86,6 +86,9 @@ namespace vkrndr
             size_t current_frame,
             uint32_t image_index);
 
+        // True if the last submission of the frame has finished executing
+        [[nodiscard]] bool submission_finished(size_t current_frame) const;
+
         void recreate();
 
     public: // Operators